@@ -0,0 +1,322 @@
+#!/usr/bin/env python3
+
+"""
+Benchmarks the three ways to read a file: the C api of libgedf (edf-bench),
+the GObject introspection bindings and the pure python edf.py.
+
+A reference set of edf and bdf files is generated first. Every
+implementation loads every file in a separate process, which reports its
+load times, its peak resident set size and a sha256 checksum of the digital
+samples of every channel. The checksums of all implementations must be
+equal. The results are written as json, when a baseline from an earlier run
+is given, a slowdown beyond the tolerance is reported as a regression.
+
+    benchmark.py --c-bench build/benchmark/edf-bench --edf-py . \\
+                 --output results.json [--baseline old.json]
+
+The exit status is 1 when the samples differ, an implementation fails or
+a regression is found. An implementation that isn't available, e.g. the
+bindings without a typelib, has to be left out with --exclude.
+"""
+
+import argparse
+import array
+import datetime
+import hashlib
+import importlib
+import json
+import os
+import platform
+import resource
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+
+# The reference file set: name, bdf, number of signals, sample rate in Hz
+# and duration in seconds. The quick set is for a smoke test.
+FILE_SET = [
+    ("eeg-small.edf",   False,  8,  256,   60),
+    ("eeg-medium.edf",  False, 32,  512,  120),
+    ("eeg-biosemi.bdf", True,  16, 2048,   30),
+]
+QUICK_FILE_SET = [
+    ("eeg-quick.edf",   False,  4,  128,   10),
+    ("eeg-quick.bdf",   True,   4,  256,   10),
+]
+
+# ************ generating files ************
+
+def _field(value, size : int) -> bytes:
+    text = str(value).encode("ascii")[:size]
+    return text + b" " * (size - len(text))
+
+def _sample(signal : int, i : int, bdf : bool) -> int:
+    """A deterministic digital sample within the digital range"""
+    value = (i * 7919 + signal * 104729) % 65521
+    if bdf:
+        return (value * 131) % 16777213 - 8388606
+    return value % 65535 - 32767
+
+def write_reference_file(path : str, bdf : bool, num_signals : int,
+                         rate : int, duration : int):
+    """Writes a file with one second records and a known pattern"""
+    dig_min, dig_max = (-8388608, 8388607) if bdf else (-32768, 32767)
+    sample_size = 3 if bdf else 2
+    header_size = 256 * (num_signals + 1)
+
+    header = b"\xffBIOSEMI" if bdf else _field(0, 8)
+    header += _field("X X X Benchmark", 80)
+    header += _field("Startdate 01-JAN-2024 X X gedf-benchmark", 80)
+    header += b"01.01.2401.00.00"
+    header += _field(header_size, 8)
+    header += _field("24BIT" if bdf else "", 44)
+    header += _field(duration, 8)
+    header += _field(1, 8)
+    header += _field(num_signals, 4)
+
+    signals = range(num_signals)
+    header += b"".join(_field("EEG %d" % s, 16) for s in signals)
+    header += b"".join(_field("AgAgCl electrode", 80) for s in signals)
+    header += b"".join(_field("uV", 8) for s in signals)
+    header += b"".join(_field(-262144 if bdf else -3200, 8) for s in signals)
+    header += b"".join(_field(262143 if bdf else 3200, 8) for s in signals)
+    header += b"".join(_field(dig_min, 8) for s in signals)
+    header += b"".join(_field(dig_max, 8) for s in signals)
+    header += b"".join(_field("HP:0.1Hz LP:100Hz", 80) for s in signals)
+    header += b"".join(_field(rate, 8) for s in signals)
+    header += b"".join(_field("", 32) for s in signals)
+    assert len(header) == header_size
+
+    with open(path, "wb") as f:
+        f.write(header)
+        for record in range(duration):
+            for signal in signals:
+                first = record * rate
+                f.write(b"".join(
+                    _sample(signal, i, bdf).to_bytes(sample_size, "little", signed=True)
+                    for i in range(first, first + rate)
+                ))
+
+def generate_file_set(data_dir : str, quick : bool):
+    """Writes the reference files that don't exist yet"""
+    files = []
+    for name, bdf, num_signals, rate, duration in (QUICK_FILE_SET if quick else FILE_SET):
+        path = os.path.join(data_dir, name)
+        sample_size = 3 if bdf else 2
+        size = 256 * (num_signals + 1) + num_signals * rate * duration * sample_size
+        if not os.path.exists(path) or os.path.getsize(path) != size:
+            print("generating", path, file=sys.stderr)
+            write_reference_file(path, bdf, num_signals, rate, duration)
+        files.append({
+            "name" : name,
+            "path" : path,
+            "size" : size,
+            "num_signals" : num_signals,
+            "num_samples" : num_signals * rate * duration,
+        })
+    return files
+
+# ************ implementations, these run in a child process ************
+
+def _checksum(values) -> str:
+    samples = array.array("i", values)
+    if sys.byteorder == "big":
+        samples.byteswap()
+    return hashlib.sha256(samples.tobytes()).hexdigest()
+
+def _peak_rss_kb() -> int:
+    rss = resource.getrusage(resource.RUSAGE_SELF).ru_maxrss
+    # macOS reports bytes, Linux kilobytes
+    return rss // 1024 if sys.platform == "darwin" else rss
+
+def _measure(load, repeat : int):
+    """Calls load repeat times, it returns the digital samples per channel"""
+    seconds = []
+    channels = None
+    for i in range(repeat):
+        channels = None
+        start = time.perf_counter()
+        channels = load()
+        seconds.append(time.perf_counter() - start)
+    return seconds, channels
+
+def run_gi(path : str, repeat : int, gi_version : str):
+    import gi
+    gi.require_version("Edf", gi_version)
+    from gi.repository import Edf
+
+    def load():
+        f = Edf.File(path=path)
+        f.read()
+        return [(s, s.get_values()) for s in f.get_signals()]
+
+    seconds, signals = _measure(load, repeat)
+    # The bindings return physical values, the digital ones are recovered
+    # outside of the measurement
+    channels = []
+    for signal, values in signals:
+        gain, offset = signal.get_gain(), signal.get_offset()
+        channels.append([round((v - offset) / gain) for v in values])
+    return seconds, channels
+
+def run_edfpy(path : str, repeat : int, memmap : bool):
+    edf = importlib.import_module("edf")
+    if memmap:
+        import numpy as np
+        load = lambda: [np.asarray(view) for view in
+                        edf.EdfFile.from_file(path, memmap=True).samples]
+    else:
+        load = lambda: edf.EdfFile.from_file(path).samples
+    return _measure(load, repeat)
+
+def run_child(args):
+    """Loads one file with a python implementation and prints the result"""
+    if args.run == "gi":
+        seconds, channels = run_gi(args.file, args.repeat, args.gi_version)
+    else:
+        sys.path.insert(0, args.edf_py)
+        seconds, channels = run_edfpy(args.file, args.repeat, args.run == "edf.py-memmap")
+
+    print(json.dumps({
+        "implementation" : args.run,
+        "load_seconds" : seconds,
+        "peak_rss_kb" : _peak_rss_kb(),
+        "num_samples" : sum(len(c) for c in channels),
+        "checksums" : [_checksum(c) for c in channels],
+    }))
+
+# ************ driver ************
+
+def implementations(args):
+    """The command line of every implementation, without the file"""
+    impls = []
+    if args.c_bench:
+        for api in ("file", "reader"):
+            impls.append(("c-" + api, [args.c_bench, "--api", api,
+                                       "--repeat", str(args.repeat)]))
+    me = [sys.executable, os.path.abspath(__file__), "--repeat", str(args.repeat),
+          "--gi-version", args.gi_version, "--edf-py", args.edf_py]
+    for name in ("gi", "edf.py", "edf.py-memmap"):
+        impls.append((name, me + ["--run", name]))
+    return [(name, command) for name, command in impls if name not in args.exclude]
+
+def run_implementation(name : str, command, file):
+    proc = subprocess.run(command + [file["path"]], capture_output=True, text=True)
+    if proc.returncode != 0:
+        reason = proc.stderr.strip().splitlines()
+        return {"implementation" : name, "failed" : reason[-1] if reason else "failed"}
+
+    result = json.loads(proc.stdout)
+    load = statistics.median(result["load_seconds"])
+    result["implementation"] = name
+    result["file"] = file["name"]
+    result["median_seconds"] = load
+    result["samples_per_second"] = result["num_samples"] / load if load > 0 else None
+    return result
+
+def find_regressions(results, baseline, tolerance : float):
+    """Compares the median load times with those of an earlier run"""
+    old = {(r["file"], r["implementation"]) : r for r in baseline["results"]
+           if "median_seconds" in r}
+    regressions = []
+    for r in results:
+        prev = old.get((r.get("file"), r["implementation"]))
+        if prev and "median_seconds" in r and \
+           r["median_seconds"] > prev["median_seconds"] * (1 + tolerance):
+            regressions.append({
+                "file" : r["file"],
+                "implementation" : r["implementation"],
+                "baseline_seconds" : prev["median_seconds"],
+                "median_seconds" : r["median_seconds"],
+            })
+    return regressions
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Compares libgedf, its python bindings and edf.py"
+    )
+    parser.add_argument("--c-bench", help="the edf-bench executable")
+    parser.add_argument("--edf-py", default=".", help="the directory of edf.py")
+    parser.add_argument("--gi-version", default="1.0", help="the version of the Edf typelib")
+    parser.add_argument("--data-dir", help="where the reference files are kept")
+    parser.add_argument("--output", default="benchmark.json", help="the json results")
+    parser.add_argument("--baseline", help="the json results of an earlier run")
+    parser.add_argument("--tolerance", type=float, default=0.25,
+                        help="the relative slowdown that counts as a regression")
+    parser.add_argument("--repeat", type=int, default=3, help="loads per file")
+    parser.add_argument("--quick", action="store_true", help="use small files")
+    parser.add_argument("--exclude", action="append", default=[],
+                        choices=("c-file", "c-reader", "gi", "edf.py", "edf.py-memmap"),
+                        help="an implementation that is not run")
+    parser.add_argument("--run", help=argparse.SUPPRESS)
+    parser.add_argument("file", nargs="?", help=argparse.SUPPRESS)
+    args = parser.parse_args()
+
+    if args.run:
+        run_child(args)
+        return 0
+
+    args.edf_py = os.path.abspath(args.edf_py)
+    data_dir = args.data_dir or os.path.join(tempfile.gettempdir(), "gedf-benchmark")
+    os.makedirs(data_dir, exist_ok=True)
+    files = generate_file_set(data_dir, args.quick)
+
+    results = []
+    identical = True
+    for file in files:
+        reference = None
+        for name, command in implementations(args):
+            result = run_implementation(name, command, file)
+            result["file"] = file["name"]
+            results.append(result)
+            # A failed implementation can't confirm the samples
+            if "failed" in result:
+                result["identical"] = False
+                identical = False
+                print("%-16s %-14s FAILED: %s" % (file["name"], name, result["failed"]),
+                      file=sys.stderr)
+                continue
+
+            # The first implementation that ran, c-file when it is built
+            if reference is None:
+                reference = result["checksums"]
+            result["identical"] = result["checksums"] == reference
+            identical = identical and result["identical"]
+            print("%-16s %-14s %8.3f s %10.0f samples/s %8d kB%s" % (
+                file["name"], name, result["median_seconds"],
+                result["samples_per_second"] or 0, result["peak_rss_kb"],
+                "" if result["identical"] else "  SAMPLES DIFFER"
+            ), file=sys.stderr)
+
+    report = {
+        "date" : datetime.datetime.now(datetime.timezone.utc).isoformat(),
+        "machine" : {
+            "system" : platform.system(),
+            "machine" : platform.machine(),
+            "processor" : platform.processor(),
+            "python" : platform.python_version(),
+        },
+        "repeat" : args.repeat,
+        "files" : files,
+        "excluded" : args.exclude,
+        "results" : results,
+        "identical" : identical,
+    }
+
+    if args.baseline:
+        with open(args.baseline) as f:
+            report["regressions"] = find_regressions(results, json.load(f), args.tolerance)
+        for r in report["regressions"]:
+            print("regression: %s %s %.3f s -> %.3f s" % (
+                r["file"], r["implementation"], r["baseline_seconds"], r["median_seconds"]
+            ), file=sys.stderr)
+
+    with open(args.output, "w") as f:
+        json.dump(report, f, indent=2)
+
+    return 0 if identical and not report.get("regressions") else 1
+
+if __name__ == "__main__":
+    sys.exit(main())
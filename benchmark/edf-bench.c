@@ -0,0 +1,209 @@
+
+#include <gedf.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+
+/*
+ * edf-bench loads a file with the C api and prints the time it took, the
+ * peak resident set size and a checksum of the digital samples of every
+ * channel as json. benchmark.py compares this with the other
+ * implementations.
+ */
+
+/* ************ options ************ */
+
+static gchar       *opt_api = NULL;
+static gint         opt_repeat = 3;
+
+static GOptionEntry entries[] = {
+    {"api", 'a', 0, G_OPTION_ARG_STRING, &opt_api,
+        "\"file\" to load an EdfFile or \"reader\" to stream with an EdfReader", "API"},
+    {"repeat", 'n', 0, G_OPTION_ARG_INT, &opt_repeat,
+        "The number of times the file is loaded", "N"},
+    {NULL}
+};
+
+/* The digital samples of every channel of the last load */
+typedef struct {
+    GPtrArray  *channels;       /* of GArray of gint32 */
+    guint64     num_samples;
+} Samples;
+
+static void
+samples_init(Samples* samples)
+{
+    samples->channels = g_ptr_array_new_with_free_func((GDestroyNotify) g_array_unref);
+    samples->num_samples = 0;
+}
+
+static void
+samples_clear(Samples* samples)
+{
+    g_clear_pointer(&samples->channels, g_ptr_array_unref);
+}
+
+/* ************ loading ************ */
+
+static gboolean
+load_file(const gchar* path, Samples* samples, GError** error)
+{
+    EdfFile* file = edf_file_new_for_path(path);
+
+    edf_file_read(file, error);
+    if (*error) {
+        g_object_unref(file);
+        return FALSE;
+    }
+    edf_file_freeze(file);
+
+    GPtrArray* signals = edf_file_get_signals(file);
+    for (guint i = 0; i < signals->len; i++) {
+        EdfSignalCursor cursor;
+        edf_signal_cursor_init(&cursor, g_ptr_array_index(signals, i));
+
+        guint64 n = edf_signal_cursor_get_num_samples(&cursor);
+        GArray* values = g_array_sized_new(FALSE, FALSE, sizeof(gint32), n);
+        g_array_set_size(values, n);
+        edf_signal_cursor_read_digital(&cursor, (gint32*) values->data, n);
+        edf_signal_cursor_clear(&cursor);
+
+        g_ptr_array_add(samples->channels, values);
+        samples->num_samples += n;
+    }
+
+    g_object_unref(file);
+    return TRUE;
+}
+
+static gboolean
+load_reader(const gchar* path, Samples* samples, GError** error)
+{
+    EdfReader* reader = edf_reader_open(path, error);
+    if (!reader)
+        return FALSE;
+
+    guint num_channels = edf_reader_get_num_channels(reader);
+    for (guint i = 0; i < num_channels; i++)
+        g_ptr_array_add(samples->channels, g_array_new(FALSE, FALSE, sizeof(gint32)));
+
+    while (edf_reader_next_record(reader, error)) {
+        for (guint i = 0; i < num_channels; i++) {
+            GArray* values = g_ptr_array_index(samples->channels, i);
+            guint ns = edf_reader_get_channel(reader, i)->ns;
+            guint len = values->len;
+
+            g_array_set_size(values, len + ns);
+            edf_reader_get_digital(reader, i, &g_array_index(values, gint32, len));
+            samples->num_samples += ns;
+        }
+    }
+
+    edf_reader_free(reader);
+    return *error == NULL;
+}
+
+/* ************ output ************ */
+
+/* The same checksum as benchmark.py: sha256 of the little endian int32s */
+static gchar*
+channel_checksum(GArray* values)
+{
+    GChecksum* checksum = g_checksum_new(G_CHECKSUM_SHA256);
+
+    for (guint i = 0; i < values->len; i++) {
+        gint32 v = GINT32_TO_LE(g_array_index(values, gint32, i));
+        g_checksum_update(checksum, (const guchar*) &v, sizeof(v));
+    }
+
+    gchar* hex = g_strdup(g_checksum_get_string(checksum));
+    g_checksum_free(checksum);
+    return hex;
+}
+
+static void
+print_result(const Samples* samples, GArray* seconds)
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    g_print("{\"implementation\": \"c-%s\", ", opt_api);
+
+    g_print("\"load_seconds\": [");
+    for (guint i = 0; i < seconds->len; i++)
+        g_print("%s%.6f", i ? ", " : "", g_array_index(seconds, gdouble, i));
+    g_print("], ");
+
+    // ru_maxrss is in kilobytes on Linux
+    g_print("\"peak_rss_kb\": %ld, ", usage.ru_maxrss);
+    g_print("\"num_samples\": %" G_GUINT64_FORMAT ", ", samples->num_samples);
+
+    g_print("\"checksums\": [");
+    for (guint i = 0; i < samples->channels->len; i++) {
+        gchar* hex = channel_checksum(g_ptr_array_index(samples->channels, i));
+        g_print("%s\"%s\"", i ? ", " : "", hex);
+        g_free(hex);
+    }
+    g_print("]}\n");
+}
+
+int
+main(int argc, char** argv)
+{
+    GError* error = NULL;
+    GArray* seconds = g_array_new(FALSE, FALSE, sizeof(gdouble));
+    Samples samples = {NULL, 0};
+    int status = EXIT_FAILURE;
+
+    GOptionContext* context = g_option_context_new("FILE");
+    g_option_context_set_summary(
+            context,
+            "Loads FILE with the C api and prints the load time, the peak\n"
+            "memory use and a checksum per channel as json."
+            );
+    g_option_context_add_main_entries(context, entries, NULL);
+
+    if (!g_option_context_parse(context, &argc, &argv, &error)) {
+        g_printerr("edf-bench: %s\n", error->message);
+        g_error_free(error);
+        goto done;
+    }
+
+    if (!opt_api)
+        opt_api = g_strdup("file");
+
+    if (argc != 2 || opt_repeat < 1 ||
+        (g_strcmp0(opt_api, "file") != 0 && g_strcmp0(opt_api, "reader") != 0)) {
+        gchar* help = g_option_context_get_help(context, TRUE, NULL);
+        g_printerr("%s", help);
+        g_free(help);
+        goto done;
+    }
+
+    for (gint i = 0; i < opt_repeat; i++) {
+        samples_clear(&samples);
+        samples_init(&samples);
+
+        gint64 start = g_get_monotonic_time();
+        gboolean loaded = g_strcmp0(opt_api, "file") == 0 ?
+                          load_file(argv[1], &samples, &error) :
+                          load_reader(argv[1], &samples, &error);
+        gdouble elapsed = (g_get_monotonic_time() - start) / (gdouble) G_USEC_PER_SEC;
+
+        if (!loaded) {
+            g_printerr("edf-bench: %s\n", error->message);
+            g_error_free(error);
+            goto done;
+        }
+        g_array_append_val(seconds, elapsed);
+    }
+
+    print_result(&samples, seconds);
+    status = EXIT_SUCCESS;
+
+done:
+    samples_clear(&samples);
+    g_array_unref(seconds);
+    g_free(opt_api);
+    g_option_context_free(context);
+    return status;
+}
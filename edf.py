@@ -30,6 +30,17 @@ import typing
 import time
 import datetime
 import struct
+import os
+
+try:
+    import numpy as np
+except ImportError:
+    # numpy is optional, it enables the memory mapped and vectorised paths
+    np = None
+
+def _require_numpy(feature : str):
+    if np is None:
+        raise ImportError("numpy is required for " + feature)
 
 class EdfDate(datetime.datetime):
 
@@ -103,6 +114,23 @@ class EdfHeader:
     def is_biosemi(self):
         return self.version == 255
 
+    def sample_size(self) -> int:
+        """The number of bytes of one sample, 3 for BioSemi otherwise 2"""
+        return 3 if self.is_biosemi() else 2
+
+    def record_size(self) -> int:
+        """The number of bytes of one data record of all signals"""
+        return sum(self.num_samples_per_record) * self.sample_size()
+
+    def signal_offsets(self) -> typing.List[int]:
+        """The byte offset of each signal inside a data record"""
+        offsets = []
+        offset = 0
+        for ns in self.num_samples_per_record:
+            offsets.append(offset)
+            offset += ns * self.sample_size()
+        return offsets
+
     def from_file(self, fileobj: typing.BinaryIO):
         '''Read the header from a file that is already opened.
 
@@ -292,32 +320,158 @@ class EdfHeader:
 def _read_2byte_samples(fileobj : typing.BinaryIO, num_samples):
     """Read values from a regular edf file"""
     for i in range(num_samples):
-        yield int.from_bytes(fileobj.read(2), 'little')
+        yield int.from_bytes(fileobj.read(2), 'little', signed=True)
 
 def _read_3byte_samples(fileobj : typing.BinaryIO, num_samples):
     """Read values from a regular edf file"""
     for i in range(num_samples):
-        yield int.from_bytes(fileobj.read(3), 'little')
+        yield int.from_bytes(fileobj.read(3), 'little', signed=True)
 
-def _read_bdf_trigstatus(fileobj : typing.BinaryIO, num_samples : int):
-    for i in range(num_samples):
-        triglow = int.from_bytes(fileobj.read(1), 'little', signed=False)
-        trighigh = int.from_bytes(fileobj.read(1), 'little', signed=False)
-        status = int.from_bytes(fileobj.read(1), 'little', signed=False)
-        yield triglow | (trighigh << 8)
-        yield status
+def _decode_samples(raw, sample_size : int):
+    """Decode a numpy array of raw little endian bytes into int32 samples.
+
+    @param raw a uint8 array whose length is a multiple of sample_size
+    @param sample_size 2 for edf and 3 for bdf files
+    """
+    raw = np.ascontiguousarray(raw, dtype=np.uint8)
+    if sample_size == 2:
+        return raw.view('<i2').astype(np.int32)
+    triplets = raw.reshape(-1, 3).astype(np.int32)
+    values = triplets[:, 0] | (triplets[:, 1] << 8) | (triplets[:, 2] << 16)
+    # sign extend the 24 bit two's complement values
+    return (values ^ 0x800000) - 0x800000
+
+class EdfChannelView:
+    """A lazily decoded view on one channel of a memory mapped file.
+
+    The samples of one channel are not contiguous in a file, every data record
+    holds a chunk of them. The view knows where the chunks are and only
+    decodes the samples of the records that are touched by an index or slice.
+    Indexing with an int returns an int, indexing with a slice returns a
+    numpy array of int32.
+    """
+
+    def __init__(self, data, offset : int, num_samples : int, sample_size : int):
+        """
+        @param data     a numpy uint8 array of shape (num_records, record_size)
+        @param offset   the byte offset of this channel in a record
+        @param num_samples the number of samples per record of this channel
+        @param sample_size the number of bytes of a sample
+        """
+        self._data = data
+        self._offset = offset
+        self._ns = num_samples
+        self._sample_size = sample_size
+
+    def __len__(self) -> int:
+        return self._data.shape[0] * self._ns
+
+    def _decode_range(self, start : int, stop : int):
+        """Decode the samples in [start, stop) of this channel"""
+        first_rec = start // self._ns
+        last_rec = (stop - 1) // self._ns + 1
+        nbytes = self._ns * self._sample_size
+        raw = self._data[first_rec:last_rec, self._offset:self._offset + nbytes]
+        samples = _decode_samples(raw.reshape(-1), self._sample_size)
+        begin = start - first_rec * self._ns
+        return samples[begin:begin + stop - start]
+
+    def __getitem__(self, key):
+        length = len(self)
+        if isinstance(key, slice):
+            start, stop, step = key.indices(length)
+            indices = range(start, stop, step)
+            if len(indices) == 0:
+                return np.empty(0, dtype=np.int32)
+            low = min(indices[0], indices[-1])
+            high = max(indices[0], indices[-1]) + 1
+            samples = self._decode_range(low, high)
+            if step > 0:
+                return samples[::step]
+            return samples[::-1][::-step]
+        index = int(key)
+        if index < 0:
+            index += length
+        if index < 0 or index >= length:
+            raise IndexError("sample index out of range")
+        return int(self._decode_range(index, index + 1)[0])
+
+    def __array__(self, dtype=None, copy=None):
+        samples = self[:]
+        return samples if dtype is None else samples.astype(dtype)
+
+    def __repr__(self) -> str:
+        return "EdfChannelView(len={})".format(len(self))
+
+def _decode_bdf_trigstatus(raw : bytes, use_numpy : bool = True):
+    """Split the raw bytes of the BioSemi "Triggers and Status" channel
+
+    Every sample consists of 3 bytes, the first two form the 16 bit trigger
+    word and the third is the status byte. All samples in raw are decoded at
+    once.
+
+    @param raw the bytes of a whole number of trigger/status samples
+    @param use_numpy use numpy when it is available
+    @return a tuple of (triggers, status), numpy arrays when numpy is used,
+            lists of int otherwise
+    """
+    if use_numpy and np is not None:
+        triplets = np.frombuffer(raw, dtype=np.uint8).reshape(-1, 3)
+        triggers = triplets[:, 0].astype(np.uint16)
+        triggers |= triplets[:, 1].astype(np.uint16) << 8
+        return triggers, triplets[:, 2].copy()
+    raw = memoryview(raw)
+    triggers = [low | (high << 8) for low, high in zip(raw[0::3], raw[1::3])]
+    return triggers, list(raw[2::3])
+
+def _read_bdf_trigstatus(
+        fileobj : typing.BinaryIO,
+        num_samples : int,
+        use_numpy : bool = True
+        ):
+    """Read num_samples of the trigger/status channel in one read call"""
+    raw = fileobj.read(3 * num_samples)
+    if len(raw) != 3 * num_samples:
+        raise ValueError("Unexpected end of file in trigger/status channel")
+    return _decode_bdf_trigstatus(raw, use_numpy)
+
+def trigger_events(values, first_index : int = 0, previous : int = 0):
+    """Compute the edges in a sequence of trigger or status values
+
+    Only the samples at which the value changes are reported, which is a lot
+    more compact than one value per sample.
+
+    @param values a sequence of trigger/status values
+    @param first_index the sample index of values[0]
+    @param previous the value before values[0], 0 for the start of a file
+    @return a list of (sample index, old value, new value) tuples
+    """
+    if np is not None and isinstance(values, np.ndarray):
+        values = values.astype(np.int64)
+        before = np.concatenate(([previous], values[:-1]))
+        changed = np.flatnonzero(values != before)
+        return [
+            (first_index + int(i), int(before[i]), int(values[i]))
+            for i in changed
+        ]
+    events = []
+    for i, value in enumerate(values):
+        if value != previous:
+            events.append((first_index + i, previous, value))
+            previous = value
+    return events
 
 class EdfFile:
     '''
     Represents a EdfFile
     '''
 
-    def __init__(self, header : EdfHeader = EdfHeader(), samples=[[]]):
+    def __init__(self, header : EdfHeader = None, samples=None):
         """Initializes an empty Edf class containing a header with default
         values.
         """
-        self.header = header 
-        self.samples= samples
+        self.header = header if header is not None else EdfHeader()
+        self.samples = samples if samples is not None else [[]]
 
     def _read_samples(self, fileobj: typing.BinaryIO):
         """ Read the samples base upon the header information
@@ -336,68 +490,212 @@ class EdfFile:
                 output[signal].extend(samples)
         self.samples = output
 
+    def _map_samples(self, filename : str):
+        """Map the data section of filename and create a view per channel
+
+        Nothing is read from the data section here, the samples are decoded
+        when a channel view is indexed.
+        """
+        _require_numpy("memory mapped files")
+        record_size = self.header.record_size()
+        if record_size == 0:
+            raise ValueError(
+                "{} has no samples in its data records".format(filename)
+            )
+        data_size = os.path.getsize(filename) - self.header.num_header_bytes
+        num_records = self.header.num_data_records
+        if num_records < 0 or num_records * record_size > data_size:
+            # still recording or truncated, only map the complete records
+            num_records = max(data_size, 0) // record_size
+        if num_records == 0:
+            data = np.zeros((0, record_size), dtype=np.uint8)
+        else:
+            data = np.memmap(
+                filename,
+                dtype=np.uint8,
+                mode='r',
+                offset=self.header.num_header_bytes,
+                shape=(num_records, record_size)
+            )
+        sample_size = self.header.sample_size()
+        self.samples = [
+            EdfChannelView(data, offset, ns, sample_size)
+            for offset, ns in zip(
+                self.header.signal_offsets(),
+                self.header.num_samples_per_record
+            )
+        ]
+
     @classmethod
     def from_fileobj(cls, fileobj: typing.BinaryIO):
         """Read a EdfFile from a file"""
-        edfinstance = EdfFile()
+        edfinstance = cls(EdfHeader())
         edfinstance.header.from_file(fileobj)
         edfinstance._read_samples(fileobj)
         return edfinstance
  
     @classmethod
-    def from_file(cls, filename: str):
-        """Read a EdfFile from a file"""
-        fileobj = open(filename, 'rb')
-        return cls.from_fileobj(fileobj)
+    def from_file(cls, filename: str, memmap : bool = False):
+        """Read a EdfFile from a file
+
+        @param filename the name of the file to open
+        @param memmap when True the data section of the file is memory mapped
+                      and the samples are EdfChannelView's that decode the
+                      samples on demand, this requires numpy. Otherwise all
+                      samples are read into lists.
+        """
+        with open(filename, 'rb') as fileobj:
+            if not memmap:
+                return cls.from_fileobj(fileobj)
+            edfinstance = cls(EdfHeader())
+            edfinstance.header.from_file(fileobj)
+        edfinstance._map_samples(filename)
+        return edfinstance
     
     def __repr__(self) -> str:
         return "EdfFile({}, {})".format(repr(self.header), repr(self.samples))
 
+class _TrigStatusView:
+    """Lazily decoded trigger or status values of a memory mapped bdf file"""
+
+    def __init__(self, view : EdfChannelView, shift : int, mask : int):
+        self._view = view
+        self._shift = shift
+        self._mask = mask
+
+    def __len__(self) -> int:
+        return len(self._view)
+
+    def __getitem__(self, key):
+        values = self._view[key]
+        return (values >> self._shift) & self._mask
+
+    def __array__(self, dtype=None, copy=None):
+        values = self[:]
+        return values if dtype is None else values.astype(dtype)
+
 class BdfFile(EdfFile):
     ''' The biosemi bdf flavor of European Data Format '''
     LABEL_TRIGSTATUS = "Triggers and Status"
     
-    def __init__(self, header : EdfHeader = EdfHeader(), samples=[[]], triggers=[], status=[]):
+    def __init__(
+            self,
+            header : EdfHeader = None,
+            samples=None,
+            triggers=None,
+            status=None,
+            edges_only : bool = False
+            ):
         """Initializes an empty Edf class containing a header with default
         values.
+
+        When edges_only is True, the triggers and status are not stored per
+        sample, but only the changes are stored in trigger_edges and
+        status_edges as returned by trigger_events().
         """
         super().__init__(header, samples)
-        self.triggers = triggers
-        self.status = status
+        self.triggers = triggers if triggers is not None else []
+        self.status = status if status is not None else []
+        self.edges_only = edges_only
+        self.trigger_edges = []
+        self.status_edges = []
+
+    def _trigstatus_index(self) -> int:
+        """Returns the index of the trigger/status channel or -1"""
+        for i, transducer in enumerate(self.header.tranducer):
+            if transducer == BdfFile.LABEL_TRIGSTATUS:
+                return i
+        return -1
     
     def _read_samples(self, fileobj: typing.BinaryIO):
         """ Read the samples base upon the header information
         """
         num_records = self.header.num_data_records
         num_signals = self.header.num_signals
-
-        # -1 because the last signal is for triggers and status
-        # which are stored seperately
-        output = [[] for i in range(num_signals - 1)]
-        self.signals = []
-        self.status = []
+        trigindex = self._trigstatus_index()
+
+        # The trigger and status signal is stored separately
+        output = [[] for i in range(num_signals) if i != trigindex]
+        triggers = []
+        status = []
+        last_trigger = 0
+        last_status = 0
+        num_read = 0
         for record in range(num_records):
             for signal in range(num_signals):
                 num_samples = self.header.num_samples_per_record[signal]
-                samples = None
-                if self.header.tranducer[signal] == BdfFile.LABEL_TRIGSTATUS:
-                    trigstatus = list(_read_bdf_trigstatus(fileobj, num_samples))
-                    triggers = trigstatus[::2]
-                    status = trigstatus[1::2]
-                    self.triggers.extend(triggers)
-                    self.status.extend(status)
+                if signal == trigindex:
+                    trig, stat = _read_bdf_trigstatus(fileobj, num_samples)
+                    if self.edges_only:
+                        self.trigger_edges.extend(
+                            trigger_events(trig, num_read, last_trigger)
+                        )
+                        self.status_edges.extend(
+                            trigger_events(stat, num_read, last_status)
+                        )
+                        if len(trig):
+                            last_trigger = int(trig[-1])
+                            last_status = int(stat[-1])
+                    else:
+                        triggers.append(trig)
+                        status.append(stat)
+                    num_read += num_samples
                 else:
                     samples = list(_read_3byte_samples(fileobj, num_samples))
-                    output[signal].extend(samples)
+                    out = signal if trigindex < 0 or signal < trigindex else signal - 1
+                    output[out].extend(samples)
+        if triggers and np is not None and isinstance(triggers[0], np.ndarray):
+            self.triggers = np.concatenate(triggers)
+            self.status = np.concatenate(status)
+        else:
+            self.triggers = [value for chunk in triggers for value in chunk]
+            self.status = [value for chunk in status for value in chunk]
         self.samples = output
 
+    def _map_samples(self, filename : str):
+        """Map the file, the trigger and status values are decoded lazily"""
+        super()._map_samples(filename)
+        trigindex = self._trigstatus_index()
+        if trigindex < 0:
+            return
+        view = self.samples.pop(trigindex)
+        self.triggers = _TrigStatusView(view, 0, 0xFFFF)
+        self.status = _TrigStatusView(view, 16, 0xFF)
+
     @classmethod
-    def from_fileobj(cls, fileobj: typing.BinaryIO):
-        """Read a BdfFile from a file"""
-        bdfinstance = BdfFile()
+    def from_fileobj(cls, fileobj: typing.BinaryIO, edges_only : bool = False):
+        """Read a BdfFile from a file
+
+        @param edges_only only store the changes of the trigger and status
+                          values, see trigger_events()
+        """
+        bdfinstance = BdfFile(edges_only=edges_only)
         bdfinstance.header.from_file(fileobj)
         bdfinstance._read_samples(fileobj)
         return bdfinstance
+
+    @classmethod
+    def from_file(
+            cls,
+            filename : str,
+            memmap : bool = False,
+            edges_only : bool = False
+            ):
+        """Read a BdfFile from a file
+
+        @param filename the name of the file to open
+        @param memmap map the data section of the file, see EdfFile.from_file
+        @param edges_only only store the changes of the trigger and status
+                          values, see trigger_events(). This can't be
+                          combined with memmap, as the mapped triggers and
+                          status are decoded lazily already.
+        """
+        if memmap:
+            if edges_only:
+                raise ValueError("edges_only can't be combined with memmap")
+            return super().from_file(filename, memmap=True)
+        with open(filename, 'rb') as fileobj:
+            return cls.from_fileobj(fileobj, edges_only=edges_only)
     
     def __repr__(self) -> str:
         return "BdfFile({}, {})".format(repr(self.header), repr(self.samples))
@@ -407,12 +705,17 @@ if __name__ == "__main__":
     import os.path as ospath
     parser = ap.ArgumentParser()
     parser.add_argument("input_file", help="File to open", type=str)
+    parser.add_argument(
+            "--memmap",
+            help="map the file instead of reading all samples",
+            action="store_true"
+            )
     args = parser.parse_args()
 
     print("Opening {}".format(args.input_file))
 
     filename = ospath.abspath(args.input_file)
 
-    edffile = EdfFile.from_file(filename)
+    edffile = EdfFile.from_file(filename, memmap=args.memmap)
     print(edffile.header)
     print("is biosemi", edffile.header.is_biosemi())
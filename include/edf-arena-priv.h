@@ -0,0 +1,57 @@
+
+#ifndef EDF_ARENA_PRIV_H
+#define EDF_ARENA_PRIV_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/*
+ * A reference counted bump allocator. Memory is handed out from a few
+ * large chunks and is only released, all at once, when the last reference
+ * to the arena is dropped. An EdfFile shares one arena with its signals so
+ * that the samples of a file are stored in a few large blocks instead of
+ * one allocation per record.
+ *
+ * Allocating is serialized by a mutex, so signals that share an arena may
+ * be filled from different threads.
+ */
+typedef struct _EdfArena EdfArena;
+
+EdfArena*
+edf_arena_new(void);
+
+EdfArena*
+edf_arena_ref(EdfArena* arena);
+
+void
+edf_arena_unref(EdfArena* arena);
+
+/*
+ * Makes sure that the next size bytes that are allocated come from one
+ * chunk, this avoids a number of growing chunks when the total size is
+ * known in advance, e.g. when a file is read. The size of the allocations
+ * should be counted with edf_arena_alloc_size().
+ */
+void
+edf_arena_reserve(EdfArena* arena, gsize size);
+
+/* The number of bytes of a chunk that an allocation of size takes */
+gsize
+edf_arena_alloc_size(gsize size);
+
+/* Returns size uninitialized bytes aligned for any type */
+gpointer
+edf_arena_alloc(EdfArena* arena, gsize size);
+
+/* Returns size zeroed bytes aligned for any type */
+gpointer
+edf_arena_alloc0(EdfArena* arena, gsize size);
+
+/* The total number of bytes of the chunks of the arena */
+gsize
+edf_arena_get_capacity(EdfArena* arena);
+
+G_END_DECLS
+
+#endif
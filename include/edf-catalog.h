@@ -0,0 +1,102 @@
+
+#ifndef EDF_CATALOG_H
+#define EDF_CATALOG_H
+
+#include <glib-object.h>
+#include <gmodule.h>
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+#define EDF_CATALOG_ERROR edf_catalog_error_quark()
+
+/**
+ * EdfCatalogError:
+ * @EDF_CATALOG_ERROR_FORMAT: A catalogue file is invalid
+ * @EDF_CATALOG_ERROR_FAILED: An unspecific error occurred.
+ *
+ * An error code returned by an operation on an instance of
+ * EdfCatalog
+ */
+typedef enum {
+    EDF_CATALOG_ERROR_FORMAT,
+    EDF_CATALOG_ERROR_FAILED,
+} EdfCatalogError;
+
+/**
+ * EdfCatalogChannel:
+ * @label: The label of the signal
+ * @unit: The physical dimension of the signal
+ * @sample_rate: The number of samples per second
+ *
+ * The description of one signal of a catalogued file.
+ */
+typedef struct _EdfCatalogChannel {
+    gchar      *label;
+    gchar      *unit;
+    gdouble     sample_rate;
+} EdfCatalogChannel;
+
+/**
+ * EdfCatalogEntry:
+ * @path: The path of the file
+ * @mtime: The modification time of the file in microseconds since the epoch
+ * @size: The size of the file in bytes
+ * @start_time: The start of the recording in seconds since the epoch
+ * @duration: The duration of the recording in seconds or -1 when it is
+ *            unknown, as for a compressed file whose header doesn't state
+ *            the number of records
+ * @num_channels: The number of channels
+ * @channels:(array length=num_channels): The channels of the file
+ *
+ * The summary of the header of one file in an #EdfCatalog.
+ */
+typedef struct _EdfCatalogEntry {
+    gchar              *path;
+    gint64              mtime;
+    guint64             size;
+    gint64              start_time;
+    gdouble             duration;
+    guint               num_channels;
+    EdfCatalogChannel  *channels;
+} EdfCatalogEntry;
+
+#define EDF_TYPE_CATALOG edf_catalog_get_type()
+G_MODULE_EXPORT
+G_DECLARE_DERIVABLE_TYPE(EdfCatalog, edf_catalog, EDF, CATALOG, GObject)
+
+struct _EdfCatalogClass {
+    GObjectClass parent_class;
+};
+
+G_MODULE_EXPORT GQuark
+edf_catalog_error_quark(void);
+
+G_MODULE_EXPORT EdfCatalog*
+edf_catalog_new(void);
+
+G_MODULE_EXPORT EdfCatalog*
+edf_catalog_load(const gchar* path, GError** error);
+
+G_MODULE_EXPORT gboolean
+edf_catalog_save(EdfCatalog* catalog, const gchar* path, GError** error);
+
+G_MODULE_EXPORT gboolean
+edf_catalog_scan(EdfCatalog* catalog, const gchar* root, GError** error);
+
+G_MODULE_EXPORT guint
+edf_catalog_get_num_entries(EdfCatalog* catalog);
+
+G_MODULE_EXPORT const EdfCatalogEntry*
+edf_catalog_get_entry(EdfCatalog* catalog, guint index);
+
+G_MODULE_EXPORT const EdfCatalogEntry*
+edf_catalog_lookup(EdfCatalog* catalog, const gchar* path);
+
+G_MODULE_EXPORT GPtrArray*
+edf_catalog_find(EdfCatalog* catalog, const gchar* label, gdouble min_sample_rate);
+
+G_END_DECLS
+
+// #ifndef EDF_CATALOG_H
+#endif
@@ -0,0 +1,48 @@
+
+#ifndef EDF_CODEC_PRIV_H
+#define EDF_CODEC_PRIV_H
+
+#include <gio/gio.h>
+#include "edf-codec.h"
+
+G_BEGIN_DECLS
+
+/*
+ * Compressed containers start with these bytes
+ */
+#define EDF_CODEC_MAGIC         "GEDFBLK1"
+#define EDF_CODEC_MAGIC_SIZE    8
+
+/*
+ * Files whose name ends with one of these are written as compressed
+ * container by EdfFile.
+ */
+#define EDF_CODEC_EDF_SUFFIX    ".edfz"
+#define EDF_CODEC_BDF_SUFFIX    ".bdfz"
+
+gboolean
+edf_codec_has_magic(const guint8* bytes, gsize size);
+
+gboolean
+edf_codec_is_codec_path(const gchar* path);
+
+/*
+ * Returns a stream that yields the original edf/bdf bytes of the container
+ * in base. The records are decompressed one at a time while they are
+ * read. base has to be seekable and positioned at the start of the
+ * container.
+ */
+GInputStream*
+edf_codec_input_stream_new(GInputStream* base, GError** error);
+
+/*
+ * Returns a stream that compresses the edf/bdf bytes written to it into a
+ * container in base. The stream has to be closed in order to finish the
+ * container.
+ */
+GOutputStream*
+edf_codec_output_stream_new(GOutputStream* base);
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,68 @@
+
+#ifndef EDF_CODEC_H
+#define EDF_CODEC_H
+
+#include <glib-object.h>
+#include <gmodule.h>
+
+#include <edf-header.h>
+
+G_BEGIN_DECLS
+
+#define EDF_CODEC_ERROR edf_codec_error_quark()
+
+/**
+ * EdfCodecError:
+ * @EDF_CODEC_ERROR_FORMAT: The data is not a valid compressed container
+ * @EDF_CODEC_ERROR_RANGE: The requested samples are not in the file
+ * @EDF_CODEC_ERROR_FAILED: An unspecific error occurred.
+ *
+ * An error code returned by the functions that read or write compressed
+ * containers.
+ */
+typedef enum {
+    EDF_CODEC_ERROR_FORMAT,
+    EDF_CODEC_ERROR_RANGE,
+    EDF_CODEC_ERROR_FAILED,
+} EdfCodecError;
+
+#define EDF_TYPE_CODEC_READER edf_codec_reader_get_type()
+G_MODULE_EXPORT
+G_DECLARE_DERIVABLE_TYPE(EdfCodecReader, edf_codec_reader, EDF, CODEC_READER, GObject)
+
+struct _EdfCodecReaderClass {
+    GObjectClass parent_class;
+};
+
+G_MODULE_EXPORT GQuark
+edf_codec_error_quark(void);
+
+G_MODULE_EXPORT gboolean
+edf_codec_compress(const gchar* source_path, const gchar* dest_path, GError** error);
+
+G_MODULE_EXPORT gboolean
+edf_codec_decompress(const gchar* source_path, const gchar* dest_path, GError** error);
+
+G_MODULE_EXPORT EdfCodecReader*
+edf_codec_reader_new_for_path(const gchar* path, GError** error);
+
+G_MODULE_EXPORT EdfHeader*
+edf_codec_reader_get_header(EdfCodecReader* reader);
+
+G_MODULE_EXPORT guint64
+edf_codec_reader_get_num_records(EdfCodecReader* reader);
+
+G_MODULE_EXPORT gboolean
+edf_codec_reader_read_range(
+        EdfCodecReader *reader,
+        guint           signal,
+        guint64         first_sample,
+        gint32         *samples,
+        gsize           num_samples,
+        GError        **error
+        );
+
+G_END_DECLS
+
+// #ifndef EDF_CODEC_H
+#endif
@@ -0,0 +1,96 @@
+
+#ifndef EDF_EPOCHER_H
+#define EDF_EPOCHER_H
+
+#include <glib-object.h>
+#include <gmodule.h>
+
+#include <edf-header.h>
+
+G_BEGIN_DECLS
+
+#define EDF_EPOCHER_ERROR edf_epocher_error_quark()
+
+/**
+ * EdfEpocherError:
+ * @EDF_EPOCHER_ERROR_CHANNEL: A channel doesn't exist or no channels are selected
+ * @EDF_EPOCHER_ERROR_SAMPLE_RATE: The selected channels differ in sample rate
+ * @EDF_EPOCHER_ERROR_WINDOW: The window or baseline interval is invalid
+ * @EDF_EPOCHER_ERROR_TENSOR_SIZE: The output tensor is too small
+ * @EDF_EPOCHER_ERROR_FAILED: An unspecific error occurred.
+ *
+ * An error code returned by an operation on an instance of
+ * EdfEpocher
+ */
+typedef enum {
+    EDF_EPOCHER_ERROR_CHANNEL,
+    EDF_EPOCHER_ERROR_SAMPLE_RATE,
+    EDF_EPOCHER_ERROR_WINDOW,
+    EDF_EPOCHER_ERROR_TENSOR_SIZE,
+    EDF_EPOCHER_ERROR_FAILED,
+} EdfEpocherError;
+
+#define EDF_TYPE_EPOCHER edf_epocher_get_type()
+G_MODULE_EXPORT
+G_DECLARE_DERIVABLE_TYPE(EdfEpocher, edf_epocher, EDF, EPOCHER, GObject)
+
+struct _EdfEpocherClass {
+    GObjectClass parent_class;
+};
+
+G_MODULE_EXPORT GQuark
+edf_epocher_error_quark(void);
+
+G_MODULE_EXPORT EdfEpocher*
+edf_epocher_new_for_path(const gchar* path, GError** error);
+
+G_MODULE_EXPORT EdfHeader*
+edf_epocher_get_header(EdfEpocher* epocher);
+
+G_MODULE_EXPORT gboolean
+edf_epocher_select_channels(
+        EdfEpocher     *epocher,
+        const guint    *channels,
+        guint           num_channels,
+        GError        **error
+        );
+
+G_MODULE_EXPORT gboolean
+edf_epocher_select_channels_by_label(
+        EdfEpocher         *epocher,
+        const gchar* const *labels,
+        GError            **error
+        );
+
+G_MODULE_EXPORT guint
+edf_epocher_get_num_channels(EdfEpocher* epocher);
+
+G_MODULE_EXPORT void
+edf_epocher_set_window(EdfEpocher* epocher, guint pre_samples, guint post_samples);
+
+G_MODULE_EXPORT guint
+edf_epocher_get_num_samples(EdfEpocher* epocher);
+
+G_MODULE_EXPORT void
+edf_epocher_set_baseline(EdfEpocher* epocher, gint64 start, gint64 end);
+
+G_MODULE_EXPORT void
+edf_epocher_set_baseline_correction(EdfEpocher* epocher, gboolean enabled);
+
+G_MODULE_EXPORT gsize
+edf_epocher_get_tensor_size(EdfEpocher* epocher, gsize num_events);
+
+G_MODULE_EXPORT gboolean
+edf_epocher_extract(
+        EdfEpocher     *epocher,
+        const guint64  *events,
+        gsize           num_events,
+        gfloat         *tensor,
+        gsize           tensor_size,
+        GError        **error
+        );
+
+G_END_DECLS
+
+// #ifndef EDF_EPOCHER_H
+#endif
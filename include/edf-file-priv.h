@@ -0,0 +1,26 @@
+
+#ifndef EDF_FILE_PRIV_H
+#define EDF_FILE_PRIV_H
+
+#include <glib.h>
+#include "edf-file.h"
+
+G_BEGIN_DECLS
+
+/*
+ * Returns whether bytes, the start of a file, are the gzip magic bytes.
+ */
+gboolean
+edf_file_has_gzip_magic(const guint8* bytes, gsize size);
+
+/*
+ * Returns whether bytes, the start of a file, belong to a gzip compressed
+ * file or a compressed container. Such a file can only be read as a stream
+ * from edf_file_open_input_stream().
+ */
+gboolean
+edf_file_is_compressed(const guint8* bytes, gsize size);
+
+G_END_DECLS
+
+#endif
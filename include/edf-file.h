@@ -5,12 +5,59 @@
 
 #include <glib-object.h>
 #include <gmodule.h>
+#include <gio/gio.h>
 
 #include <edf-signal.h>
 #include <edf-header.h>
 
 G_BEGIN_DECLS
 
+#define EDF_FILE_ERROR edf_file_error_quark()
+
+/**
+ * EdfFileError:
+ * @EDF_FILE_ERROR_TRUNCATED: The file ends in the middle of a record or
+ *                            contains fewer records than its header declares
+ * @EDF_FILE_ERROR_NUM_RECORDS: The header doesn't declare the number of
+ *                              records that the file contains
+ * @EDF_FILE_ERROR_UNSUPPORTED: The operation isn't possible on a compressed
+ *                              file
+ * @EDF_FILE_ERROR_FAILED: An unspecific error occurred.
+ *
+ * An error code returned by an operation on an instance of EdfFile
+ */
+typedef enum {
+    EDF_FILE_ERROR_TRUNCATED,
+    EDF_FILE_ERROR_NUM_RECORDS,
+    EDF_FILE_ERROR_UNSUPPORTED,
+    EDF_FILE_ERROR_FAILED,
+} EdfFileError;
+
+/**
+ * EdfFileReport:
+ * @header_size: The size of the header in bytes
+ * @record_size: The size of one data record in bytes
+ * @declared_num_records: The number of records in the header, -1 when
+ *                        the recording wasn't closed properly
+ * @file_size: The size of the file in bytes
+ * @num_records: The number of complete records in the file
+ * @trailing_bytes: The size of the incomplete record at the end of the file
+ * @num_lost_records: The number of declared records that are missing,
+ *                    including the incomplete one
+ *
+ * What edf_file_validate() and edf_file_read_recover() found out about the
+ * structure of a file.
+ */
+typedef struct _EdfFileReport {
+    gsize       header_size;
+    gsize       record_size;
+    gint64      declared_num_records;
+    guint64     file_size;
+    guint64     num_records;
+    gsize       trailing_bytes;
+    guint64     num_lost_records;
+} EdfFileReport;
+
 #define EDF_TYPE_FILE edf_file_get_type()
 G_MODULE_EXPORT
 G_DECLARE_DERIVABLE_TYPE(EdfFile, edf_file, EDF, FILE, GObject)
@@ -19,6 +66,9 @@ struct _EdfFileClass {
     GObjectClass parent_class;
 };
 
+G_MODULE_EXPORT GQuark
+edf_file_error_quark(void);
+
 G_MODULE_EXPORT EdfFile*
 edf_file_new();
 
@@ -34,9 +84,18 @@ edf_file_get_path(EdfFile* file);
 G_MODULE_EXPORT void
 edf_file_set_path(EdfFile* file, const gchar* path);
 
-G_MODULE_EXPORT gsize
+G_MODULE_EXPORT guint64
 edf_file_read(EdfFile* self, GError** error);
 
+G_MODULE_EXPORT guint64
+edf_file_read_recover(EdfFile* self, EdfFileReport* report, GError** error);
+
+G_MODULE_EXPORT gboolean
+edf_file_validate(EdfFile* self, EdfFileReport* report, GError** error);
+
+G_MODULE_EXPORT gboolean
+edf_file_repair(EdfFile* self, EdfFileReport* report, GError** error);
+
 G_MODULE_EXPORT void
 edf_file_create(EdfFile* self, GError** error);
 
@@ -58,6 +117,24 @@ edf_file_get_num_signals(EdfFile* file);
 G_MODULE_EXPORT EdfHeader*
 edf_file_header(EdfFile* file);
 
+G_MODULE_EXPORT void
+edf_file_freeze(EdfFile* file);
+
+G_MODULE_EXPORT gboolean
+edf_file_is_frozen(EdfFile* file);
+
+G_MODULE_EXPORT void
+edf_file_set_use_header_cache(EdfFile* file, gboolean use_cache);
+
+G_MODULE_EXPORT gboolean
+edf_file_get_use_header_cache(EdfFile* file);
+
+G_MODULE_EXPORT GInputStream*
+edf_file_open_input_stream(GFile* file, GError** error);
+
+G_MODULE_EXPORT GOutputStream*
+edf_file_open_output_stream(GFile* file, gboolean replace, GError** error);
+
 G_END_DECLS
 
 #endif
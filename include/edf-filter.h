@@ -0,0 +1,110 @@
+
+#ifndef EDF_FILTER_H
+#define EDF_FILTER_H
+
+#include <glib-object.h>
+#include <gmodule.h>
+
+G_BEGIN_DECLS
+
+#define EDF_FILTER_ERROR edf_filter_error_quark()
+
+/**
+ * EdfFilterError:
+ * @EDF_FILTER_ERROR_FREQUENCY: A frequency isn't between 0 and the Nyquist frequency
+ * @EDF_FILTER_ERROR_DESIGN: The order or quality factor of a design is invalid
+ * @EDF_FILTER_ERROR_FAILED: An unspecific error occurred.
+ *
+ * An error code returned by an operation on an instance of
+ * EdfFilter
+ */
+typedef enum {
+    EDF_FILTER_ERROR_FREQUENCY,
+    EDF_FILTER_ERROR_DESIGN,
+    EDF_FILTER_ERROR_FAILED,
+} EdfFilterError;
+
+#define EDF_TYPE_FILTER edf_filter_get_type()
+G_MODULE_EXPORT
+G_DECLARE_DERIVABLE_TYPE(EdfFilter, edf_filter, EDF, FILTER, GObject)
+
+struct _EdfFilterClass {
+    GObjectClass parent_class;
+};
+
+G_MODULE_EXPORT GQuark
+edf_filter_error_quark(void);
+
+G_MODULE_EXPORT EdfFilter*
+edf_filter_new(gdouble sample_rate, guint num_channels);
+
+G_MODULE_EXPORT gdouble
+edf_filter_get_sample_rate(EdfFilter* filter);
+
+G_MODULE_EXPORT guint
+edf_filter_get_num_channels(EdfFilter* filter);
+
+G_MODULE_EXPORT guint
+edf_filter_get_num_sections(EdfFilter* filter);
+
+G_MODULE_EXPORT void
+edf_filter_add_section(
+        EdfFilter  *filter,
+        gdouble     b0,
+        gdouble     b1,
+        gdouble     b2,
+        gdouble     a1,
+        gdouble     a2
+        );
+
+G_MODULE_EXPORT gboolean
+edf_filter_add_lowpass(
+        EdfFilter  *filter,
+        gdouble     cutoff,
+        guint       order,
+        GError    **error
+        );
+
+G_MODULE_EXPORT gboolean
+edf_filter_add_highpass(
+        EdfFilter  *filter,
+        gdouble     cutoff,
+        guint       order,
+        GError    **error
+        );
+
+G_MODULE_EXPORT gboolean
+edf_filter_add_notch(
+        EdfFilter  *filter,
+        gdouble     frequency,
+        gdouble     q,
+        GError    **error
+        );
+
+G_MODULE_EXPORT gdouble
+edf_filter_get_magnitude(EdfFilter* filter, gdouble frequency);
+
+G_MODULE_EXPORT void
+edf_filter_reset(EdfFilter* filter);
+
+G_MODULE_EXPORT void
+edf_filter_process(EdfFilter* filter, gdouble* const* channels, gsize num_samples);
+
+G_MODULE_EXPORT void
+edf_filter_process_interleaved(EdfFilter* filter, gdouble* samples, gsize num_frames);
+
+G_MODULE_EXPORT void
+edf_filter_process_channel(
+        EdfFilter  *filter,
+        guint       channel,
+        gdouble    *samples,
+        gsize       num_samples
+        );
+
+G_MODULE_EXPORT void
+edf_filter_process_zero_phase(EdfFilter* filter, gdouble* samples, gsize num_samples);
+
+G_END_DECLS
+
+// #ifndef EDF_FILTER_H
+#endif
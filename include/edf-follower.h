@@ -0,0 +1,75 @@
+
+#ifndef EDF_FOLLOWER_H
+#define EDF_FOLLOWER_H
+
+#include <glib-object.h>
+#include <gmodule.h>
+#include <gio/gio.h>
+
+#include <edf-header.h>
+
+G_BEGIN_DECLS
+
+#define EDF_FOLLOWER_ERROR edf_follower_error_quark()
+
+/**
+ * EdfFollowerError:
+ * @EDF_FOLLOWER_ERROR_UNSUPPORTED: The file is compressed, it can't be
+ *                                  followed while it grows
+ * @EDF_FOLLOWER_ERROR_SHRUNK: The file became shorter than the part that was
+ *                            already read, e.g. it was replaced
+ * @EDF_FOLLOWER_ERROR_FAILED: An unspecific error occurred.
+ *
+ * An error code returned by an operation on an instance of
+ * EdfFollower
+ */
+typedef enum {
+    EDF_FOLLOWER_ERROR_UNSUPPORTED,
+    EDF_FOLLOWER_ERROR_SHRUNK,
+    EDF_FOLLOWER_ERROR_FAILED,
+} EdfFollowerError;
+
+#define EDF_TYPE_FOLLOWER edf_follower_get_type()
+G_MODULE_EXPORT
+G_DECLARE_DERIVABLE_TYPE(EdfFollower, edf_follower, EDF, FOLLOWER, GObject)
+
+/**
+ * EdfFollowerClass:
+ * @parent_class: The parent class
+ * @records_added: The default handler of #EdfFollower::records-added
+ */
+struct _EdfFollowerClass {
+    GObjectClass parent_class;
+
+    void (*records_added) (
+            EdfFollower    *follower,
+            guint64         first_record,
+            guint           num_records
+            );
+};
+
+G_MODULE_EXPORT GQuark
+edf_follower_error_quark(void);
+
+G_MODULE_EXPORT EdfFollower*
+edf_follower_new(const gchar* path);
+
+G_MODULE_EXPORT EdfHeader*
+edf_follower_get_header(EdfFollower* follower);
+
+G_MODULE_EXPORT guint64
+edf_follower_get_num_records(EdfFollower* follower);
+
+G_MODULE_EXPORT guint
+edf_follower_poll(EdfFollower* follower, GError** error);
+
+G_MODULE_EXPORT gboolean
+edf_follower_start(EdfFollower* follower, GError** error);
+
+G_MODULE_EXPORT void
+edf_follower_stop(EdfFollower* follower);
+
+G_END_DECLS
+
+// #ifndef EDF_FOLLOWER_H
+#endif
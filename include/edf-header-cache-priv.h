@@ -0,0 +1,48 @@
+
+#ifndef EDF_HEADER_CACHE_PRIV_H
+#define EDF_HEADER_CACHE_PRIV_H
+
+#include <gio/gio.h>
+#include "edf-header-cache.h"
+#include "edf-parse-priv.h"
+
+G_BEGIN_DECLS
+
+/*
+ * Identifies the contents of a file on disk, a cached header is only used
+ * while the path, size and modification time of the file are unchanged.
+ */
+typedef struct {
+    gchar      *path;
+    guint64     size;
+    guint64     mtime;
+    guint32     mtime_usec;
+} EdfHeaderCacheKey;
+
+/*
+ * Obtains the key of file, FALSE when file isn't a local file or it cannot
+ * be queried. The cache is skipped then.
+ */
+gboolean
+edf_header_cache_key_init(EdfHeaderCacheKey* key, GFile* file);
+
+void
+edf_header_cache_key_clear(EdfHeaderCacheKey* key);
+
+/*
+ * Fills header from the cache, FALSE when there is no valid entry for key.
+ * header->signals must be freed with edf_parsed_header_clear().
+ */
+gboolean
+edf_header_cache_lookup(const EdfHeaderCacheKey* key, EdfParsedHeader* header);
+
+/*
+ * Stores header for key, failing to write the cache isn't an error as the
+ * header is parsed again the next time.
+ */
+void
+edf_header_cache_store(const EdfHeaderCacheKey* key, const EdfParsedHeader* header);
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,22 @@
+
+#ifndef EDF_HEADER_CACHE_H
+#define EDF_HEADER_CACHE_H
+
+#include <glib.h>
+#include <gmodule.h>
+
+G_BEGIN_DECLS
+
+G_MODULE_EXPORT gchar*
+edf_header_cache_get_dir(void);
+
+G_MODULE_EXPORT void
+edf_header_cache_set_dir(const gchar* dir);
+
+G_MODULE_EXPORT gboolean
+edf_header_cache_clear(GError** error);
+
+G_END_DECLS
+
+// #ifndef EDF_HEADER_CACHE_H
+#endif
@@ -0,0 +1,61 @@
+
+#ifndef EDF_HEADER_PRIV_H
+#define EDF_HEADER_PRIV_H
+
+#include "edf-header.h"
+#include "edf-parse-priv.h"
+
+G_BEGIN_DECLS
+
+/*
+ * Reads a header and its signal descriptions from istream without an
+ * EdfFile, for the parts of the library that stream over the records
+ * themselves. The stream is positioned at the first record afterwards.
+ */
+EdfHeader*
+edf_header_new_from_input_stream(GInputStream* istream, GError** error);
+
+/*
+ * The number of records as stated in the header, this is -1 while a file
+ * is being recorded.
+ */
+gint64
+edf_header_get_declared_num_records(EdfHeader* header);
+
+/*
+ * Sets the number of records of header to that of its first signal, as
+ * writing the header does.
+ */
+void
+edf_header_update_num_records(EdfHeader* header);
+
+/*
+ * The size in bytes of one data record of the signals in header.
+ */
+gsize
+edf_header_get_record_size(EdfHeader* header);
+
+/*
+ * Makes header and its signals read only, so that they may be shared by
+ * reading threads. The header is updated one last time before.
+ */
+void
+edf_header_freeze(EdfHeader* header);
+
+/*
+ * Fills header and its signals from a parsed header, e.g. one taken from
+ * the header cache, instead of reading them from a stream.
+ */
+void
+edf_header_set_parsed(EdfHeader* header, const EdfParsedHeader* parsed);
+
+/*
+ * The counterpart of edf_header_set_parsed(), parsed->signals must be
+ * freed with edf_parsed_header_clear().
+ */
+void
+edf_header_get_parsed(EdfHeader* header, EdfParsedHeader* parsed);
+
+G_END_DECLS
+
+#endif
@@ -22,6 +22,9 @@ typedef enum {
     EDF_HEADER_INVALID_VALUE,
 }EdfHeaderError;
 
+G_MODULE_EXPORT GQuark
+edf_header_error_quark(void);
+
 /*
  * Type Declaration
  */
@@ -68,14 +71,14 @@ edf_header_destroy(EdfHeader* header);
 G_MODULE_EXPORT gboolean
 edf_header_set_signals(EdfHeader* hdr, GPtrArray* signals);
 
-gsize
+G_MODULE_EXPORT gsize
 edf_header_write_to_ostream (
         EdfHeader         *hdr,
         GOutputStream     *ostream,
         GError           **error
         );
 
-gsize
+G_MODULE_EXPORT gsize
 edf_header_read_from_input_stream(
         EdfHeader     *hdr,
         GInputStream  *inputStream,
@@ -112,9 +115,12 @@ edf_header_get_reserved(EdfHeader* header);
 G_MODULE_EXPORT gboolean
 edf_header_set_reserved(EdfHeader* header, const gchar* reserved);
 
-G_MODULE_EXPORT gint
+G_MODULE_EXPORT gint64
 edf_header_get_num_records(EdfHeader* header);
 
+G_MODULE_EXPORT void
+edf_header_set_expected_num_records(EdfHeader* header, gint64 num_records);
+
 G_MODULE_EXPORT gdouble
 edf_header_get_record_duration(EdfHeader* header);
 
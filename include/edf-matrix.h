@@ -0,0 +1,77 @@
+
+#ifndef EDF_MATRIX_H
+#define EDF_MATRIX_H
+
+#include <glib.h>
+#include <gmodule.h>
+
+#include <edf-file.h>
+
+G_BEGIN_DECLS
+
+#define EDF_MATRIX_ERROR edf_matrix_error_quark()
+
+/**
+ * EdfMatrixError:
+ * @EDF_MATRIX_ERROR_CHANNEL: A channel doesn't exist or there are no channels
+ * @EDF_MATRIX_ERROR_SAMPLE_RATE: The channels differ in sample rate and
+ *                                %EDF_MATRIX_RESAMPLE isn't set
+ * @EDF_MATRIX_ERROR_SIZE: The output matrix is too small
+ * @EDF_MATRIX_ERROR_FAILED: An unspecific error occurred.
+ *
+ * An error code returned by edf_file_to_matrix()
+ */
+typedef enum {
+    EDF_MATRIX_ERROR_CHANNEL,
+    EDF_MATRIX_ERROR_SAMPLE_RATE,
+    EDF_MATRIX_ERROR_SIZE,
+    EDF_MATRIX_ERROR_FAILED,
+} EdfMatrixError;
+
+/**
+ * EdfMatrixFlags:
+ * @EDF_MATRIX_FLAGS_NONE: A row major matrix of floats, the channels must
+ *                         have equal sample rates
+ * @EDF_MATRIX_COLUMN_MAJOR: The samples of all channels at one point in time
+ *                           are adjacent, instead of the samples of one channel
+ * @EDF_MATRIX_FLOAT64: The matrix holds doubles instead of floats
+ * @EDF_MATRIX_RESAMPLE: Channels with a lower sample rate are resampled to
+ *                       the highest rate of the selection
+ *
+ * How edf_file_to_matrix() lays out the matrix.
+ */
+typedef enum {
+    EDF_MATRIX_FLAGS_NONE   = 0,
+    EDF_MATRIX_COLUMN_MAJOR = 1 << 0,
+    EDF_MATRIX_FLOAT64      = 1 << 1,
+    EDF_MATRIX_RESAMPLE     = 1 << 2,
+} EdfMatrixFlags;
+
+G_MODULE_EXPORT GQuark
+edf_matrix_error_quark(void);
+
+G_MODULE_EXPORT gboolean
+edf_file_get_matrix_shape(
+        EdfFile        *file,
+        const guint    *channels,
+        guint           num_channels,
+        EdfMatrixFlags  flags,
+        guint64        *num_samples,
+        GError        **error
+        );
+
+G_MODULE_EXPORT gboolean
+edf_file_to_matrix(
+        EdfFile        *file,
+        const guint    *channels,
+        guint           num_channels,
+        EdfMatrixFlags  flags,
+        gpointer        matrix,
+        gsize           matrix_size,
+        GError        **error
+        );
+
+G_END_DECLS
+
+// #ifndef EDF_MATRIX_H
+#endif
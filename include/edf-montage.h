@@ -0,0 +1,107 @@
+
+#ifndef EDF_MONTAGE_H
+#define EDF_MONTAGE_H
+
+#include <glib-object.h>
+#include <gmodule.h>
+
+#include <edf-file.h>
+#include <edf-reader.h>
+
+G_BEGIN_DECLS
+
+#define EDF_MONTAGE_ERROR edf_montage_error_quark()
+
+/**
+ * EdfMontageError:
+ * @EDF_MONTAGE_ERROR_CHANNEL: A label of the montage isn't a channel of the input
+ * @EDF_MONTAGE_ERROR_SAMPLE_RATE: The inputs of a derivation differ in sample rate
+ * @EDF_MONTAGE_ERROR_EMPTY: The montage has no derivations
+ * @EDF_MONTAGE_ERROR_FAILED: An unspecific error occurred.
+ *
+ * An error code returned by an operation on an instance of
+ * EdfMontage
+ */
+typedef enum {
+    EDF_MONTAGE_ERROR_CHANNEL,
+    EDF_MONTAGE_ERROR_SAMPLE_RATE,
+    EDF_MONTAGE_ERROR_EMPTY,
+    EDF_MONTAGE_ERROR_FAILED,
+} EdfMontageError;
+
+#define EDF_TYPE_MONTAGE edf_montage_get_type()
+G_MODULE_EXPORT
+G_DECLARE_DERIVABLE_TYPE(EdfMontage, edf_montage, EDF, MONTAGE, GObject)
+
+struct _EdfMontageClass {
+    GObjectClass parent_class;
+};
+
+G_MODULE_EXPORT GQuark
+edf_montage_error_quark(void);
+
+G_MODULE_EXPORT EdfMontage*
+edf_montage_new(void);
+
+G_MODULE_EXPORT void
+edf_montage_add_derivation(
+        EdfMontage         *montage,
+        const gchar        *label,
+        const gchar* const *inputs,
+        const gdouble      *weights,
+        guint               num_inputs
+        );
+
+G_MODULE_EXPORT void
+edf_montage_add_bipolar(EdfMontage* montage, const gchar* active, const gchar* reference);
+
+G_MODULE_EXPORT void
+edf_montage_add_reference(
+        EdfMontage         *montage,
+        const gchar* const *channels,
+        guint               num_channels,
+        const gchar* const *references,
+        guint               num_references,
+        const gchar        *reference_name
+        );
+
+G_MODULE_EXPORT void
+edf_montage_add_average_reference(
+        EdfMontage         *montage,
+        const gchar* const *channels,
+        guint               num_channels
+        );
+
+G_MODULE_EXPORT guint
+edf_montage_get_num_outputs(EdfMontage* montage);
+
+G_MODULE_EXPORT const gchar*
+edf_montage_get_output_label(EdfMontage* montage, guint output);
+
+G_MODULE_EXPORT gboolean
+edf_montage_bind_reader(EdfMontage* montage, EdfReader* reader, GError** error);
+
+G_MODULE_EXPORT guint
+edf_montage_get_output_ns(EdfMontage* montage, guint output);
+
+G_MODULE_EXPORT gsize
+edf_montage_get_record_samples(EdfMontage* montage);
+
+G_MODULE_EXPORT void
+edf_montage_apply_record(EdfMontage* montage, EdfReader* reader, gdouble* samples);
+
+G_MODULE_EXPORT EdfFile*
+edf_montage_apply_to_file(EdfMontage* montage, EdfFile* file, GError** error);
+
+G_MODULE_EXPORT gboolean
+edf_montage_convert(
+        EdfMontage     *montage,
+        const gchar    *input_path,
+        const gchar    *output_path,
+        GError        **error
+        );
+
+G_END_DECLS
+
+// #ifndef EDF_MONTAGE_H
+#endif
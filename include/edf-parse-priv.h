@@ -0,0 +1,108 @@
+
+#ifndef EDF_PARSE_PRIV_H
+#define EDF_PARSE_PRIV_H
+
+#include <gio/gio.h>
+#include "edf-size-priv.h"
+
+G_BEGIN_DECLS
+
+/*
+ * A compact parser of edf/bdf headers that fills plain structs instead of
+ * GObjects. It is meant for code that handles many headers, such as
+ * scanning an archive, where creating an EdfHeader and EdfSignals per file
+ * is too expensive. Errors are reported in the EDF_HEADER_ERROR domain.
+ */
+
+/* The fields of one signal of a header, strings are stripped */
+typedef struct {
+    gchar       label[EDF_LABEL_SZ + 1];
+    gchar       transducer[EDF_TRANDUCER_TYPE_SZ + 1];
+    gchar       physical_dimension[EDF_PHYSICAL_DIMENSION_SZ + 1];
+    gdouble     physical_min;
+    gdouble     physical_max;
+    gint        digital_min;
+    gint        digital_max;
+    gchar       prefiltering[EDF_PREFILTERING_SZ + 1];
+    guint       ns;
+    guint       sample_size;
+    gchar       reserved[EDF_NS_RESERVED_SZ + 1];
+} EdfParsedSignal;
+
+/* The fields of a header */
+typedef struct {
+    gint             version;
+    gchar            patient[EDF_LOCAL_PATIENT_SZ + 1];
+    gchar            recording[EDF_LOCAL_RECORDING_SZ + 1];
+    gint             year, month, day;
+    gint             hour, minute, second;
+    gsize            header_size;
+    gchar            reserved[EDF_RESERVED_SZ + 1];
+    gint64           num_records;
+    gdouble          record_duration;
+    guint            num_signals;
+    EdfParsedSignal *signals;
+} EdfParsedHeader;
+
+/*
+ * Parses the EDF_BASE_HEADER_SIZE bytes at the start of a file. Afterwards
+ * header->num_signals tells how many bytes edf_parsed_header_parse_signals
+ * needs.
+ */
+gboolean
+edf_parsed_header_parse_base(
+        EdfParsedHeader    *header,
+        const guint8       *bytes,
+        GError            **error
+        );
+
+/*
+ * Parses the num_signals * EDF_SIGNAL_HEADER_SIZE bytes that follow the
+ * base header and allocates header->signals.
+ */
+gboolean
+edf_parsed_header_parse_signals(
+        EdfParsedHeader    *header,
+        const guint8       *bytes,
+        GError            **error
+        );
+
+/*
+ * Reads and parses a complete header from istream. The stream is positioned
+ * at the first record afterwards.
+ */
+gboolean
+edf_parsed_header_read(
+        EdfParsedHeader    *header,
+        GInputStream       *istream,
+        GError            **error
+        );
+
+/* Frees the signals of header */
+void
+edf_parsed_header_clear(EdfParsedHeader* header);
+
+/* The size in bytes of one data record */
+gsize
+edf_parsed_header_get_record_size(const EdfParsedHeader* header);
+
+/*
+ * The start of the recording in seconds since the epoch, the header stores
+ * it without a time zone so it is interpreted as UTC.
+ */
+gint64
+edf_parsed_header_get_start_time(const EdfParsedHeader* header);
+
+/* Helpers to parse a fixed size ascii field of a header */
+void
+edf_parse_string(gchar* dest, const guint8* field, gsize size);
+
+gboolean
+edf_parse_int(const guint8* field, gsize size, gint* value);
+
+gboolean
+edf_parse_double(const guint8* field, gsize size, gdouble* value);
+
+G_END_DECLS
+
+#endif
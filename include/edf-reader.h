@@ -0,0 +1,126 @@
+
+#ifndef EDF_READER_H
+#define EDF_READER_H
+
+#include <glib.h>
+#include <gmodule.h>
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+#define EDF_READER_ERROR edf_reader_error_quark()
+
+/**
+ * EdfReaderError:
+ * @EDF_READER_ERROR_TRUNCATED: The file ends in the middle of a record
+ * @EDF_READER_ERROR_NOT_SEEKABLE: The reader cannot seek in its stream
+ * @EDF_READER_ERROR_OUT_OF_RANGE: A record beyond the end of the file is requested
+ * @EDF_READER_ERROR_FAILED: An unspecific error occurred.
+ *
+ * An error code returned by an operation on an #EdfReader
+ */
+typedef enum {
+    EDF_READER_ERROR_TRUNCATED,
+    EDF_READER_ERROR_NOT_SEEKABLE,
+    EDF_READER_ERROR_OUT_OF_RANGE,
+    EDF_READER_ERROR_FAILED,
+} EdfReaderError;
+
+/**
+ * EdfReaderChannel:
+ * @label: The label of the signal
+ * @transducer: The transducer of the signal
+ * @physical_dimension: The unit of the signal
+ * @prefiltering: The prefiltering of the signal
+ * @physical_min: The physical minimum
+ * @physical_max: The physical maximum
+ * @digital_min: The digital minimum
+ * @digital_max: The digital maximum
+ * @ns: The number of samples of the channel in one record
+ * @sample_size: The number of bytes of one sample, 2 for edf, 3 for bdf
+ * @offset: The offset in bytes of the first sample of the channel in a record
+ * @gain: A digital sample d is gain * d + @phys_offset in physical units
+ * @phys_offset: The physical value of a digital 0
+ *
+ * The description of one signal of the file of an #EdfReader. The
+ * strings are owned by the reader.
+ */
+typedef struct _EdfReaderChannel {
+    const gchar    *label;
+    const gchar    *transducer;
+    const gchar    *physical_dimension;
+    const gchar    *prefiltering;
+    gdouble         physical_min;
+    gdouble         physical_max;
+    gint            digital_min;
+    gint            digital_max;
+    guint           ns;
+    guint           sample_size;
+    gsize           offset;
+    gdouble         gain;
+    gdouble         phys_offset;
+} EdfReaderChannel;
+
+typedef struct _EdfReader EdfReader;
+
+G_MODULE_EXPORT GQuark
+edf_reader_error_quark(void);
+
+G_MODULE_EXPORT EdfReader*
+edf_reader_open(const gchar* path, GError** error);
+
+G_MODULE_EXPORT EdfReader*
+edf_reader_new_for_stream(GInputStream* istream, GError** error);
+
+G_MODULE_EXPORT void
+edf_reader_free(EdfReader* reader);
+
+G_MODULE_EXPORT guint
+edf_reader_get_num_channels(const EdfReader* reader);
+
+G_MODULE_EXPORT const EdfReaderChannel*
+edf_reader_get_channel(const EdfReader* reader, guint channel);
+
+G_MODULE_EXPORT gint
+edf_reader_find_channel(const EdfReader* reader, const gchar* label);
+
+G_MODULE_EXPORT const gchar*
+edf_reader_get_patient(const EdfReader* reader);
+
+G_MODULE_EXPORT const gchar*
+edf_reader_get_recording(const EdfReader* reader);
+
+G_MODULE_EXPORT gint64
+edf_reader_get_start_time(const EdfReader* reader);
+
+G_MODULE_EXPORT gint64
+edf_reader_get_num_records(const EdfReader* reader);
+
+G_MODULE_EXPORT gdouble
+edf_reader_get_record_duration(const EdfReader* reader);
+
+G_MODULE_EXPORT gsize
+edf_reader_get_record_size(const EdfReader* reader);
+
+G_MODULE_EXPORT gint64
+edf_reader_get_record_index(const EdfReader* reader);
+
+G_MODULE_EXPORT gboolean
+edf_reader_next_record(EdfReader* reader, GError** error);
+
+G_MODULE_EXPORT gboolean
+edf_reader_seek_record(EdfReader* reader, guint64 record, GError** error);
+
+G_MODULE_EXPORT const guint8*
+edf_reader_get_record_bytes(const EdfReader* reader);
+
+G_MODULE_EXPORT void
+edf_reader_get_digital(const EdfReader* reader, guint channel, gint32* samples);
+
+G_MODULE_EXPORT void
+edf_reader_get_physical(const EdfReader* reader, guint channel, gdouble* samples);
+
+G_END_DECLS
+
+// #ifndef EDF_READER_H
+#endif
@@ -0,0 +1,68 @@
+
+#ifndef EDF_RECORD_QUEUE_H
+#define EDF_RECORD_QUEUE_H
+
+#include <glib.h>
+#include <gmodule.h>
+#include <gio/gio.h>
+
+#include <edf-header.h>
+
+G_BEGIN_DECLS
+
+typedef struct _EdfRecordQueue EdfRecordQueue;
+typedef struct _EdfRecordWriter EdfRecordWriter;
+
+G_MODULE_EXPORT EdfRecordQueue*
+edf_record_queue_new(gsize record_size, guint capacity);
+
+G_MODULE_EXPORT EdfRecordQueue*
+edf_record_queue_new_for_header(EdfHeader* header, guint capacity);
+
+G_MODULE_EXPORT void
+edf_record_queue_free(EdfRecordQueue* queue);
+
+G_MODULE_EXPORT gsize
+edf_record_queue_get_record_size(const EdfRecordQueue* queue);
+
+G_MODULE_EXPORT guint
+edf_record_queue_get_capacity(const EdfRecordQueue* queue);
+
+G_MODULE_EXPORT guint8*
+edf_record_queue_acquire(EdfRecordQueue* queue);
+
+G_MODULE_EXPORT void
+edf_record_queue_publish(EdfRecordQueue* queue);
+
+G_MODULE_EXPORT gboolean
+edf_record_queue_push(EdfRecordQueue* queue, const guint8* record);
+
+G_MODULE_EXPORT const guint8*
+edf_record_queue_peek(EdfRecordQueue* queue, guint* num_records);
+
+G_MODULE_EXPORT void
+edf_record_queue_release(EdfRecordQueue* queue, guint num_records);
+
+G_MODULE_EXPORT guint
+edf_record_queue_get_num_queued(EdfRecordQueue* queue);
+
+G_MODULE_EXPORT guint
+edf_record_queue_get_high_water(EdfRecordQueue* queue);
+
+G_MODULE_EXPORT guint
+edf_record_queue_get_num_dropped(EdfRecordQueue* queue);
+
+G_MODULE_EXPORT EdfRecordWriter*
+edf_record_writer_new(EdfRecordQueue* queue, GOutputStream* ostream);
+
+G_MODULE_EXPORT gboolean
+edf_record_writer_finish(
+        EdfRecordWriter    *writer,
+        guint64            *num_written,
+        GError            **error
+        );
+
+G_END_DECLS
+
+// #ifndef EDF_RECORD_QUEUE_H
+#endif
@@ -0,0 +1,68 @@
+
+#ifndef EDF_RESAMPLER_H
+#define EDF_RESAMPLER_H
+
+#include <glib-object.h>
+#include <gmodule.h>
+
+G_BEGIN_DECLS
+
+#define EDF_RESAMPLER_ERROR edf_resampler_error_quark()
+
+/**
+ * EdfResamplerError:
+ * @EDF_RESAMPLER_ERROR_RATIO: The ratio of the sample rates isn't supported
+ * @EDF_RESAMPLER_ERROR_FAILED: An unspecific error occurred.
+ *
+ * An error code returned by an operation on an instance of
+ * EdfResampler
+ */
+typedef enum {
+    EDF_RESAMPLER_ERROR_RATIO,
+    EDF_RESAMPLER_ERROR_FAILED,
+} EdfResamplerError;
+
+#define EDF_TYPE_RESAMPLER edf_resampler_get_type()
+G_MODULE_EXPORT
+G_DECLARE_DERIVABLE_TYPE(EdfResampler, edf_resampler, EDF, RESAMPLER, GObject)
+
+struct _EdfResamplerClass {
+    GObjectClass parent_class;
+};
+
+G_MODULE_EXPORT GQuark
+edf_resampler_error_quark(void);
+
+G_MODULE_EXPORT EdfResampler*
+edf_resampler_new(guint up, guint down, GError** error);
+
+G_MODULE_EXPORT guint
+edf_resampler_get_up(EdfResampler* resampler);
+
+G_MODULE_EXPORT guint
+edf_resampler_get_down(EdfResampler* resampler);
+
+G_MODULE_EXPORT guint
+edf_resampler_get_num_taps(EdfResampler* resampler);
+
+G_MODULE_EXPORT gsize
+edf_resampler_get_max_output(EdfResampler* resampler, gsize num_input);
+
+G_MODULE_EXPORT gsize
+edf_resampler_process(
+        EdfResampler   *resampler,
+        const gdouble  *input,
+        gsize           num_input,
+        gdouble        *output
+        );
+
+G_MODULE_EXPORT gsize
+edf_resampler_flush(EdfResampler* resampler, gdouble* output);
+
+G_MODULE_EXPORT void
+edf_resampler_reset(EdfResampler* resampler);
+
+G_END_DECLS
+
+// #ifndef EDF_RESAMPLER_H
+#endif
@@ -0,0 +1,91 @@
+
+#ifndef EDF_SAMPLE_PRIV_H
+#define EDF_SAMPLE_PRIV_H
+
+#include <glib.h>
+#include "edf-size-priv.h"
+
+/*
+ * Samples are stored as little endian two's complement integers of
+ * EDF_SAMPLE_SIZE (edf) or BDF_SAMPLE_SIZE (bdf) bytes. These helpers
+ * convert them from/to native integers.
+ */
+
+static inline gint32
+edf_sample_decode(const guint8* bytes, guint sample_size)
+{
+    if (sample_size == BDF_SAMPLE_SIZE) {
+        guint32 v = bytes[0] | (bytes[1] << 8) | ((guint32) bytes[2] << 16);
+        // sign extend the 24 bit value
+        return (gint32) (v ^ 0x800000u) - 0x800000;
+    }
+    return (gint16) (guint16) (bytes[0] | (bytes[1] << 8));
+}
+
+static inline void
+edf_sample_encode(guint8* bytes, guint sample_size, gint32 value)
+{
+    guint32 v = (guint32) value;
+    bytes[0] = v & 0xff;
+    bytes[1] = (v >> 8) & 0xff;
+    if (sample_size == BDF_SAMPLE_SIZE)
+        bytes[2] = (v >> 16) & 0xff;
+}
+
+/*
+ * Decode n samples at once.
+ */
+static inline void
+edf_samples_decode(
+        const guint8   *bytes,
+        guint           sample_size,
+        gsize           n,
+        gint32         *out
+        )
+{
+    if (sample_size == BDF_SAMPLE_SIZE) {
+        for (gsize i = 0; i < n; i++) {
+            const guint8* b = &bytes[i * BDF_SAMPLE_SIZE];
+            guint32 v = b[0] | (b[1] << 8) | ((guint32) b[2] << 16);
+            out[i] = (gint32) (v ^ 0x800000u) - 0x800000;
+        }
+    }
+    else {
+        for (gsize i = 0; i < n; i++) {
+            const guint8* b = &bytes[i * EDF_SAMPLE_SIZE];
+            out[i] = (gint16) (guint16) (b[0] | (b[1] << 8));
+        }
+    }
+}
+
+/*
+ * Encode n samples at once, the counterpart of edf_samples_decode().
+ */
+static inline void
+edf_samples_encode(
+        guint8         *bytes,
+        guint           sample_size,
+        gsize           n,
+        const gint32   *in
+        )
+{
+    if (sample_size == BDF_SAMPLE_SIZE) {
+        for (gsize i = 0; i < n; i++) {
+            guint8* b = &bytes[i * BDF_SAMPLE_SIZE];
+            guint32 v = (guint32) in[i];
+            b[0] = v & 0xff;
+            b[1] = (v >> 8) & 0xff;
+            b[2] = (v >> 16) & 0xff;
+        }
+    }
+    else {
+        for (gsize i = 0; i < n; i++) {
+            guint8* b = &bytes[i * EDF_SAMPLE_SIZE];
+            guint32 v = (guint32) in[i];
+            b[0] = v & 0xff;
+            b[1] = (v >> 8) & 0xff;
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,54 @@
+
+#ifndef EDF_SIGNAL_CURSOR_H
+#define EDF_SIGNAL_CURSOR_H
+
+#include <glib.h>
+#include <gmodule.h>
+
+#include <edf-signal.h>
+
+G_BEGIN_DECLS
+
+/**
+ * EdfSignalCursor:
+ *
+ * A position in the samples of a frozen #EdfSignal. A cursor is meant to
+ * be allocated on the stack of the thread that uses it, all members are
+ * private.
+ */
+typedef struct _EdfSignalCursor {
+    /*< private >*/
+    EdfSignal  *signal;
+    guint64     position;
+    guint64     num_samples;
+    guint       ns;
+    guint       sample_size;
+    gdouble     gain;
+    gdouble     offset;
+} EdfSignalCursor;
+
+G_MODULE_EXPORT void
+edf_signal_cursor_init(EdfSignalCursor* cursor, EdfSignal* signal);
+
+G_MODULE_EXPORT void
+edf_signal_cursor_clear(EdfSignalCursor* cursor);
+
+G_MODULE_EXPORT guint64
+edf_signal_cursor_get_position(const EdfSignalCursor* cursor);
+
+G_MODULE_EXPORT guint64
+edf_signal_cursor_get_num_samples(const EdfSignalCursor* cursor);
+
+G_MODULE_EXPORT gboolean
+edf_signal_cursor_seek(EdfSignalCursor* cursor, guint64 position);
+
+G_MODULE_EXPORT gsize
+edf_signal_cursor_read(EdfSignalCursor* cursor, gdouble* values, gsize n);
+
+G_MODULE_EXPORT gsize
+edf_signal_cursor_read_digital(EdfSignalCursor* cursor, gint32* values, gsize n);
+
+G_END_DECLS
+
+// #ifndef EDF_SIGNAL_CURSOR_H
+#endif
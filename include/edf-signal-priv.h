@@ -0,0 +1,52 @@
+
+#ifndef EDF_SIGNAL_PRIV_H
+#define EDF_SIGNAL_PRIV_H
+
+#include "edf-signal.h"
+#include "edf-arena-priv.h"
+
+G_BEGIN_DECLS
+
+/*
+ * Access to the raw stored samples of a signal, for the parts of the
+ * library that work on the little endian samples directly.
+ */
+const guint8*
+edf_signal_get_record_bytes(EdfSignal* signal, guint64 nrec);
+
+guint
+edf_signal_get_record_num_stored(EdfSignal* signal, guint64 nrec);
+
+/*
+ * Appends a complete record of encoded samples to signal, bytes holds
+ * num_samples_per_record samples of sample_size bytes. The last record of
+ * signal must be complete.
+ */
+void
+edf_signal_append_record(EdfSignal* signal, const guint8* bytes);
+
+/*
+ * Drops the records from num_records on, e.g. the incomplete last record of
+ * a truncated file.
+ */
+void
+edf_signal_truncate_records(EdfSignal* signal, guint64 num_records);
+
+/*
+ * Lets signal allocate the bytes of its records from arena, a reference
+ * to arena is taken. This has no effect when the signal already contains
+ * records.
+ */
+void
+edf_signal_set_arena(EdfSignal* signal, EdfArena* arena);
+
+/*
+ * Makes signal read only, the setters and everything that adds or drops
+ * records refuse to modify it afterwards.
+ */
+void
+edf_signal_freeze(EdfSignal* signal);
+
+G_END_DECLS
+
+#endif
@@ -27,6 +27,18 @@ typedef enum {
     EDF_SIGNAL_ERROR_FAILED,
 }EdfSignalError;
 
+/**
+ * EdfSignalSpan:
+ * @bytes: The raw little endian samples
+ * @num_samples: The number of samples in @bytes
+ *
+ * A contiguous part of the samples that a signal stores, see
+ * edf_signal_get_latest_spans().
+ */
+typedef struct _EdfSignalSpan {
+    const guint8   *bytes;
+    gsize           num_samples;
+} EdfSignalSpan;
 
 /*
  * Type Declaration
@@ -109,8 +121,8 @@ edf_signal_get_prefiltering(EdfSignal* signal);
 G_MODULE_EXPORT void
 edf_signal_set_prefiltering(EdfSignal* signal, const gchar* prefilter);
 
- G_MODULE_EXPORT gint
- edf_signal_get_num_samples_per_record(EdfSignal* signal);
+G_MODULE_EXPORT guint
+edf_signal_get_num_samples_per_record(EdfSignal* signal);
 
 G_MODULE_EXPORT void
 edf_signal_set_num_samples_per_record(EdfSignal* signal, guint num_samples);
@@ -121,19 +133,72 @@ edf_signal_get_reserved(EdfSignal* signal);
 G_MODULE_EXPORT void
 edf_signal_set_reserved(EdfSignal* signal, const gchar* reserved);
 
-G_MODULE_EXPORT guint
+G_MODULE_EXPORT guint64
 edf_signal_get_num_records(EdfSignal* signal);
 
+G_MODULE_EXPORT guint64
+edf_signal_get_num_samples(EdfSignal* signal);
+
+G_MODULE_EXPORT guint
+edf_signal_get_sample_size(EdfSignal* signal);
+
+G_MODULE_EXPORT gdouble
+edf_signal_get_gain(EdfSignal* signal);
+
+G_MODULE_EXPORT gdouble
+edf_signal_get_offset(EdfSignal* signal);
+
 G_MODULE_EXPORT void
 edf_signal_append_digital(EdfSignal* signal, gint value, GError** error);
 
-GArray*
+G_MODULE_EXPORT EdfSignal*
+edf_signal_resample(EdfSignal* signal, guint ns, GError** error);
+
+G_MODULE_EXPORT gboolean
+edf_signal_is_frozen(EdfSignal* signal);
+
+G_MODULE_EXPORT void
+edf_signal_set_ring_capacity(EdfSignal* signal, guint num_records);
+
+G_MODULE_EXPORT guint
+edf_signal_get_ring_capacity(EdfSignal* signal);
+
+G_MODULE_EXPORT guint64
+edf_signal_get_num_dropped_records(EdfSignal* signal);
+
+G_MODULE_EXPORT guint
+edf_signal_get_latest_spans(
+        EdfSignal      *signal,
+        gsize           num_samples,
+        EdfSignalSpan   spans[2]
+        );
+
+G_MODULE_EXPORT gsize
+edf_signal_copy_latest(EdfSignal* signal, gsize num_samples, gdouble* values);
+
+G_MODULE_EXPORT gsize
+edf_signal_copy_values_f32(
+        EdfSignal  *signal,
+        guint64     first,
+        gsize       num_samples,
+        gfloat     *values
+        );
+
+G_MODULE_EXPORT gsize
+edf_signal_copy_values_f64(
+        EdfSignal  *signal,
+        guint64     first,
+        gsize       num_samples,
+        gdouble    *values
+        );
+
+G_MODULE_EXPORT GArray*
 edf_signal_get_values(EdfSignal* signal);
 
 void edf_signal_write_record_to_ostream(
         EdfSignal      *signal,
         GOutputStream  *ostream,
-        guint           nrec,
+        guint64         nrec,
         GError        **error
         );
 
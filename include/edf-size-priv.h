@@ -53,5 +53,23 @@
         EDF_NS_RESERVED_SZ                \
 )
 
+// BioSemi (bdf) files mark their version field with 0xFF followed by this id
+#define EDF_BIOSEMI_ID                  "BIOSEMI"
+#define EDF_BIOSEMI_VERSION             255
+
+// the largest number of records that fits in the header
+#define EDF_MAX_NUM_RECORDS             99999999
+
+// number of bytes of one sample
+#define EDF_SAMPLE_SIZE                 2
+#define BDF_SAMPLE_SIZE                 3
+
+// the range of the digital values that fit in a 16 bit edf sample
+#define EDF_DIGITAL_MIN                 (-32768)
+#define EDF_DIGITAL_MAX                 32767
+
+// the range of the digital values that fit in a 24 bit bdf sample
+#define BDF_DIGITAL_MIN                 (-8388608)
+#define BDF_DIGITAL_MAX                 8388607
 
 #endif
@@ -0,0 +1,101 @@
+
+#ifndef EDF_STATS_H
+#define EDF_STATS_H
+
+#include <glib.h>
+#include <gmodule.h>
+
+#include <edf-file.h>
+#include <edf-signal.h>
+
+G_BEGIN_DECLS
+
+/**
+ * EDF_STATS_HISTOGRAM_BINS:
+ *
+ * The number of bins of the histogram of an #EdfSignalStats, the digital
+ * range of the signal is divided into bins of equal width.
+ */
+#define EDF_STATS_HISTOGRAM_BINS 64
+
+/**
+ * EdfSignalStats:
+ * @num_samples: The number of samples
+ * @digital_min: The smallest digital sample
+ * @digital_max: The largest digital sample
+ * @min: The smallest sample in physical units
+ * @max: The largest sample in physical units
+ * @mean: The mean in physical units, the DC offset
+ * @variance: The variance in physical units squared
+ * @rms: The root mean square in physical units
+ * @num_at_digital_min: The number of samples at or below the digital minimum
+ *                      of the header, e.g. a saturated amplifier
+ * @num_at_digital_max: The number of samples at or above the digital maximum
+ *                      of the header
+ * @longest_flat_run: The largest number of consecutive equal samples, a
+ *                    disconnected electrode often shows a flat line
+ * @histogram: The number of samples per bin of the digital range
+ *
+ * The statistics of one signal. They are computed on the digital samples
+ * in one pass, the physical values follow from the gain and offset of the
+ * signal.
+ */
+typedef struct _EdfSignalStats {
+    guint64     num_samples;
+    gint32      digital_min;
+    gint32      digital_max;
+    gdouble     min;
+    gdouble     max;
+    gdouble     mean;
+    gdouble     variance;
+    gdouble     rms;
+    guint64     num_at_digital_min;
+    guint64     num_at_digital_max;
+    guint64     longest_flat_run;
+    guint64     histogram[EDF_STATS_HISTOGRAM_BINS];
+
+    /*< private >*/
+    gint32      range_min;
+    gint32      range_max;
+    gdouble     gain;
+    gdouble     offset;
+    gdouble     digital_mean;
+    gdouble     digital_m2;
+    gint32      last;
+    guint64     run;
+} EdfSignalStats;
+
+G_MODULE_EXPORT void
+edf_signal_stats_init(
+        EdfSignalStats *stats,
+        gint            digital_min,
+        gint            digital_max,
+        gdouble         gain,
+        gdouble         offset
+        );
+
+G_MODULE_EXPORT void
+edf_signal_stats_add_digital(
+        EdfSignalStats *stats,
+        const gint32   *samples,
+        gsize           num_samples
+        );
+
+G_MODULE_EXPORT void
+edf_signal_stats_add_bytes(
+        EdfSignalStats *stats,
+        const guint8   *bytes,
+        gsize           num_samples,
+        guint           sample_size
+        );
+
+G_MODULE_EXPORT void
+edf_signal_compute_stats(EdfSignal* signal, EdfSignalStats* stats);
+
+G_MODULE_EXPORT EdfSignalStats*
+edf_file_compute_stats(EdfFile* file, guint* num_signals);
+
+G_END_DECLS
+
+// #ifndef EDF_STATS_H
+#endif
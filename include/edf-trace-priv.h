@@ -0,0 +1,43 @@
+
+#ifndef EDF_TRACE_PRIV_H
+#define EDF_TRACE_PRIV_H
+
+/*
+ * Static tracepoints (USDT) for perf, bpftrace and SystemTap, e.g.
+ *
+ *     bpftrace -e 'usdt:/usr/lib/libgedf.so:gedf:records__read { @[arg0] = count(); }'
+ *
+ * They are compiled in when meson finds <sys/sdt.h>, see the usdt option.
+ * A probe is a single nop until a tracer attaches to it, so the arguments
+ * must be values that are at hand anyway. Otherwise the macros expand to
+ * nothing, the arguments are only named in sizeof, so they are never
+ * evaluated and don't leave unused variables behind.
+ *
+ * The probes of provider "gedf":
+ *
+ *     header__parse__start()
+ *     header__parse__done(num_bytes, num_signals)
+ *     records__read(num_records, num_bytes)
+ *     records__write(num_records, num_bytes)
+ *     storage__alloc(num_bytes)
+ *     convert__start(num_samples)
+ *     convert__done(num_samples)
+ */
+
+#ifdef EDF_ENABLE_USDT
+
+#include <sys/sdt.h>
+
+#define EDF_TRACE(name)                 DTRACE_PROBE(gedf, name)
+#define EDF_TRACE1(name, a)             DTRACE_PROBE1(gedf, name, a)
+#define EDF_TRACE2(name, a, b)          DTRACE_PROBE2(gedf, name, a, b)
+
+#else
+
+#define EDF_TRACE(name)                 do {} while (0)
+#define EDF_TRACE1(name, a)             do { (void) sizeof(a); } while (0)
+#define EDF_TRACE2(name, a, b)          do { (void) sizeof(a); (void) sizeof(b); } while (0)
+
+#endif
+
+#endif
@@ -0,0 +1,119 @@
+
+#ifndef EDF_TRIGGER_INDEX_H
+#define EDF_TRIGGER_INDEX_H
+
+#include <glib-object.h>
+#include <gmodule.h>
+#include <gio/gio.h>
+
+#include <edf-signal.h>
+
+G_BEGIN_DECLS
+
+#define EDF_TRIGGER_INDEX_ERROR edf_trigger_index_error_quark()
+
+/**
+ * EdfTriggerIndexError:
+ * @EDF_TRIGGER_INDEX_ERROR_NO_TRIGGER_SIGNAL: The file has no trigger/status signal
+ * @EDF_TRIGGER_INDEX_ERROR_SIDECAR: A sidecar file is invalid or out of date
+ * @EDF_TRIGGER_INDEX_ERROR_FAILED: An unspecific error occurred.
+ *
+ * An error code returned by an operation on an instance of
+ * EdfTriggerIndex
+ */
+typedef enum {
+    EDF_TRIGGER_INDEX_ERROR_NO_TRIGGER_SIGNAL,
+    EDF_TRIGGER_INDEX_ERROR_SIDECAR,
+    EDF_TRIGGER_INDEX_ERROR_FAILED,
+} EdfTriggerIndexError;
+
+/**
+ * EDF_TRIGGER_ANY_CODE:
+ *
+ * Pass this as code to the lookup functions in order to obtain the events
+ * of all codes.
+ */
+#define EDF_TRIGGER_ANY_CODE G_MAXUINT32
+
+/**
+ * EdfTriggerEvent:
+ * @sample: The index of the sample at which the code changed
+ * @code: The trigger code from @sample onward
+ *
+ * One edge in the trigger signal.
+ */
+typedef struct _EdfTriggerEvent {
+    guint64 sample;
+    guint32 code;
+} EdfTriggerEvent;
+
+#define EDF_TYPE_TRIGGER_INDEX edf_trigger_index_get_type()
+G_MODULE_EXPORT
+G_DECLARE_DERIVABLE_TYPE(EdfTriggerIndex, edf_trigger_index, EDF, TRIGGER_INDEX, GObject)
+
+struct _EdfTriggerIndexClass {
+    GObjectClass parent_class;
+};
+
+G_MODULE_EXPORT GQuark
+edf_trigger_index_error_quark(void);
+
+G_MODULE_EXPORT EdfTriggerIndex*
+edf_trigger_index_new(void);
+
+G_MODULE_EXPORT EdfTriggerIndex*
+edf_trigger_index_new_for_signal(EdfSignal* signal, gdouble record_duration);
+
+G_MODULE_EXPORT EdfTriggerIndex*
+edf_trigger_index_scan(const gchar* path, GError** error);
+
+G_MODULE_EXPORT EdfTriggerIndex*
+edf_trigger_index_new_for_path(const gchar* path, GError** error);
+
+G_MODULE_EXPORT EdfTriggerIndex*
+edf_trigger_index_load(
+        const gchar    *sidecar_path,
+        const gchar    *source_path,
+        GError        **error
+        );
+
+G_MODULE_EXPORT gboolean
+edf_trigger_index_save(
+        EdfTriggerIndex    *index,
+        const gchar        *sidecar_path,
+        const gchar        *source_path,
+        GError            **error
+        );
+
+G_MODULE_EXPORT gchar*
+edf_trigger_index_sidecar_path(const gchar* path);
+
+G_MODULE_EXPORT guint
+edf_trigger_index_get_num_events(EdfTriggerIndex* index);
+
+G_MODULE_EXPORT GArray*
+edf_trigger_index_get_events(EdfTriggerIndex* index);
+
+G_MODULE_EXPORT gdouble
+edf_trigger_index_get_sample_rate(EdfTriggerIndex* index);
+
+G_MODULE_EXPORT GArray*
+edf_trigger_index_lookup(
+        EdfTriggerIndex    *index,
+        guint32             code,
+        guint64             first_sample,
+        guint64             last_sample
+        );
+
+G_MODULE_EXPORT GArray*
+edf_trigger_index_lookup_time(
+        EdfTriggerIndex    *index,
+        guint32             code,
+        gdouble             start,
+        gdouble             end
+        );
+
+G_END_DECLS
+
+// #ifndef EDF_TRIGGER_INDEX_H
+#endif
@@ -2,8 +2,22 @@
 #ifndef G_EDF_H
 #define G_EDF_H
 
+#include "edf-catalog.h"
+#include "edf-codec.h"
+#include "edf-epocher.h"
 #include "edf-file.h"
+#include "edf-filter.h"
+#include "edf-follower.h"
 #include "edf-header.h"
+#include "edf-header-cache.h"
+#include "edf-matrix.h"
+#include "edf-montage.h"
+#include "edf-reader.h"
+#include "edf-record-queue.h"
+#include "edf-resampler.h"
 #include "edf-signal.h"
+#include "edf-signal-cursor.h"
+#include "edf-stats.h"
+#include "edf-trigger-index.h"
 
 #endif
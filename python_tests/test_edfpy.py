@@ -0,0 +1,113 @@
+import os
+import os.path
+import sys
+import tempfile
+import unittest
+
+import numpy as np
+
+# edf.py lives in the root of the source tree
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), ".."))
+import edf
+
+def _field(value, size : int) -> bytes:
+    text = str(value).encode("ascii")
+    return text + b" " * (size - len(text))
+
+def _header(bdf : bool, num_records : int, signals) -> bytes:
+    """signals is a list of (label, transducer, num_samples_per_record)"""
+    dig_min, dig_max = (-8388608, 8388607) if bdf else (-32768, 32767)
+    header = b"\xffBIOSEMI" if bdf else _field(0, 8)
+    header += _field("X", 80) + _field("X", 80)
+    header += b"01.01.2401.00.00"
+    header += _field(256 * (len(signals) + 1), 8)
+    header += _field("24BIT" if bdf else "", 44)
+    header += _field(num_records, 8) + _field(1, 8) + _field(len(signals), 4)
+    header += b"".join(_field(s[0], 16) for s in signals)
+    header += b"".join(_field(s[1], 80) for s in signals)
+    header += b"".join(_field("uV", 8) for s in signals)
+    header += b"".join(_field(-1000, 8) for s in signals)
+    header += b"".join(_field(1000, 8) for s in signals)
+    header += b"".join(_field(dig_min, 8) for s in signals)
+    header += b"".join(_field(dig_max, 8) for s in signals)
+    header += b"".join(_field("", 80) for s in signals)
+    header += b"".join(_field(s[2], 8) for s in signals)
+    header += b"".join(_field("", 32) for s in signals)
+    return header
+
+class TestEdfPy (unittest.TestCase):
+
+    def setUp(self):
+        self.tempdir = tempfile.TemporaryDirectory()
+
+    def tearDown(self):
+        self.tempdir.cleanup()
+
+    def write(self, name : str, data : bytes) -> str:
+        path = os.path.join(self.tempdir.name, name)
+        with open(path, "wb") as f:
+            f.write(data)
+        return path
+
+    def test_memmap_equals_lists(self):
+        samples = [-32768, -1, 0, 1, 32767, 1234]
+        data = _header(False, 2, [("EEG", "", 3)])
+        data += b"".join(v.to_bytes(2, "little", signed=True) for v in samples)
+        path = self.write("signed.edf", data)
+
+        listed = edf.EdfFile.from_file(path)
+        mapped = edf.EdfFile.from_file(path, memmap=True)
+
+        self.assertEqual(listed.samples[0], samples)
+        self.assertEqual(list(np.asarray(mapped.samples[0])), samples)
+
+    def test_memmap_without_samples(self):
+        path = self.write("empty.edf", _header(False, 0, []))
+        with self.assertRaises(ValueError):
+            edf.EdfFile.from_file(path, memmap=True)
+
+    def test_trigger_edges(self):
+        trigstatus = edf.BdfFile.LABEL_TRIGSTATUS
+        triggers = [0, 0, 5, 5, 5, 0]
+        data = _header(True, 2, [("Status", trigstatus, 3)])
+        data += b"".join(bytes([t, 0, 1]) for t in triggers)
+        path = self.write("triggers.bdf", data)
+
+        bdf = edf.BdfFile.from_file(path)
+        self.assertEqual(list(bdf.triggers), triggers)
+
+        bdf = edf.BdfFile.from_file(path, edges_only=True)
+        self.assertEqual(
+            [tuple(int(v) for v in edge) for edge in bdf.trigger_edges],
+            [(2, 0, 5), (5, 5, 0)]
+        )
+        self.assertEqual(
+            [tuple(int(v) for v in edge) for edge in bdf.status_edges],
+            [(0, 0, 1)]
+        )
+
+        with self.assertRaises(ValueError):
+            edf.BdfFile.from_file(path, memmap=True, edges_only=True)
+
+    def test_trigger_edges_without_samples(self):
+        trigstatus = edf.BdfFile.LABEL_TRIGSTATUS
+        signals = [("EEG", "", 1), ("Status", trigstatus, 0)]
+        data = _header(True, 2, signals) + bytes(2 * 3)
+        path = self.write("notriggers.bdf", data)
+
+        bdf = edf.BdfFile.from_file(path, edges_only=True)
+        self.assertEqual(bdf.trigger_edges, [])
+        self.assertEqual(bdf.samples, [[0, 0]])
+
+    def test_defaults_are_not_shared(self):
+        bdf1 = edf.BdfFile()
+        bdf2 = edf.BdfFile()
+        bdf1.triggers.append(1)
+        bdf1.samples[0].append(1)
+
+        self.assertEqual(bdf2.triggers, [])
+        self.assertEqual(bdf2.samples, [[]])
+        self.assertIsNot(bdf1.header, bdf2.header)
+
+if __name__ == "__main__":
+    unittest.main()
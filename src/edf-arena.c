@@ -0,0 +1,155 @@
+
+#include "edf-arena-priv.h"
+#include "edf-trace-priv.h"
+
+#include <string.h>
+
+/* The size of the first chunk, every next chunk is twice as large */
+#define ARENA_MIN_CHUNK_SIZE    (64 * 1024)
+/* Chunks don't grow beyond this size, unless a single request is larger */
+#define ARENA_MAX_CHUNK_SIZE    (16 * 1024 * 1024)
+/* All allocations are aligned to this */
+#define ARENA_ALIGN             16
+
+typedef struct _ArenaChunk ArenaChunk;
+
+struct _ArenaChunk {
+    ArenaChunk *next;
+    gsize       size;   /* the number of bytes in data */
+    gsize       used;   /* the number of bytes handed out */
+    /* The data follows the header, aligned to ARENA_ALIGN */
+};
+
+struct _EdfArena {
+    gint        ref_count;
+    GMutex      lock;
+    ArenaChunk *chunks;         /* the current chunk, it links to the older ones */
+    gsize       next_size;
+    gsize       capacity;
+};
+
+#define ARENA_CHUNK_HEADER_SIZE \
+    ((sizeof(ArenaChunk) + ARENA_ALIGN - 1) & ~((gsize) ARENA_ALIGN - 1))
+
+static inline guint8*
+chunk_data(ArenaChunk* chunk)
+{
+    return (guint8*) chunk + ARENA_CHUNK_HEADER_SIZE;
+}
+
+static inline gsize
+align_size(gsize size)
+{
+    return (size + ARENA_ALIGN - 1) & ~((gsize) ARENA_ALIGN - 1);
+}
+
+/* Expects the lock to be held */
+static void
+arena_add_chunk(EdfArena* arena, gsize size)
+{
+    gsize chunk_size = MAX(arena->next_size, align_size(size));
+    ArenaChunk* chunk = g_malloc(ARENA_CHUNK_HEADER_SIZE + chunk_size);
+
+    chunk->size = chunk_size;
+    chunk->used = 0;
+    chunk->next = arena->chunks;
+    arena->chunks = chunk;
+    arena->capacity += chunk_size;
+
+    arena->next_size = MIN(arena->next_size * 2, ARENA_MAX_CHUNK_SIZE);
+    EDF_TRACE1(storage__alloc, chunk_size);
+}
+
+EdfArena*
+edf_arena_new(void)
+{
+    EdfArena* arena = g_new0(EdfArena, 1);
+    arena->ref_count = 1;
+    arena->next_size = ARENA_MIN_CHUNK_SIZE;
+    g_mutex_init(&arena->lock);
+    return arena;
+}
+
+EdfArena*
+edf_arena_ref(EdfArena* arena)
+{
+    g_return_val_if_fail(arena != NULL, NULL);
+    g_atomic_int_inc(&arena->ref_count);
+    return arena;
+}
+
+void
+edf_arena_unref(EdfArena* arena)
+{
+    g_return_if_fail(arena != NULL);
+
+    if (!g_atomic_int_dec_and_test(&arena->ref_count))
+        return;
+
+    ArenaChunk* chunk = arena->chunks;
+    while (chunk) {
+        ArenaChunk* next = chunk->next;
+        g_free(chunk);
+        chunk = next;
+    }
+    g_mutex_clear(&arena->lock);
+    g_free(arena);
+}
+
+void
+edf_arena_reserve(EdfArena* arena, gsize size)
+{
+    g_return_if_fail(arena != NULL);
+
+    g_mutex_lock(&arena->lock);
+    ArenaChunk* chunk = arena->chunks;
+    if (!chunk || chunk->size - chunk->used < size)
+        arena_add_chunk(arena, size);
+    g_mutex_unlock(&arena->lock);
+}
+
+gsize
+edf_arena_alloc_size(gsize size)
+{
+    return align_size(size);
+}
+
+gpointer
+edf_arena_alloc(EdfArena* arena, gsize size)
+{
+    g_return_val_if_fail(arena != NULL, NULL);
+
+    gsize aligned = align_size(size);
+
+    g_mutex_lock(&arena->lock);
+    ArenaChunk* chunk = arena->chunks;
+    if (!chunk || chunk->size - chunk->used < aligned) {
+        arena_add_chunk(arena, aligned);
+        chunk = arena->chunks;
+    }
+    gpointer mem = chunk_data(chunk) + chunk->used;
+    chunk->used += aligned;
+    g_mutex_unlock(&arena->lock);
+
+    return mem;
+}
+
+gpointer
+edf_arena_alloc0(EdfArena* arena, gsize size)
+{
+    gpointer mem = edf_arena_alloc(arena, size);
+    if (mem)
+        memset(mem, 0, size);
+    return mem;
+}
+
+gsize
+edf_arena_get_capacity(EdfArena* arena)
+{
+    g_return_val_if_fail(arena != NULL, 0);
+
+    g_mutex_lock(&arena->lock);
+    gsize capacity = arena->capacity;
+    g_mutex_unlock(&arena->lock);
+    return capacity;
+}
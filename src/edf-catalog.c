@@ -0,0 +1,906 @@
+
+#include "edf-catalog.h"
+#include "edf-codec-priv.h"
+#include "edf-file-priv.h"
+#include "edf-parse-priv.h"
+
+#include <gio/gio.h>
+#include <string.h>
+
+/**
+ * SECTION:edf-catalog
+ * @short_description: a catalogue of the headers of many edf/bdf files
+ * @see_also: #EdfFile, #EdfHeader
+ * @include: gedf.h
+ *
+ * Questions about an archive of recordings, such as which sessions contain
+ * a channel at a given sample rate, only need the headers of the files.
+ * #EdfCatalog walks a directory tree and parses the header of every edf or
+ * bdf file on a pool of worker threads, without creating an #EdfFile per
+ * file. The result is a list of #EdfCatalogEntry s that can be stored in a
+ * compact binary file.
+ *
+ * Scanning a directory that is already catalogued only parses the files
+ * whose size or modification time changed, entries of files that have been
+ * removed are dropped.
+ */
+
+G_DEFINE_QUARK(edf_catalog_error_quark, edf_catalog_error)
+
+/* layout of a catalogue file, all numbers are little endian */
+static const gchar catalog_magic[8] = "GEDFCAT1";
+
+static const gchar* catalog_suffixes[] = {
+    ".edf", ".bdf", ".edf.gz", ".bdf.gz",
+    EDF_CODEC_EDF_SUFFIX, EDF_CODEC_BDF_SUFFIX,
+    NULL
+};
+
+#define SCAN_ATTRIBUTES                         \
+    G_FILE_ATTRIBUTE_STANDARD_NAME ","          \
+    G_FILE_ATTRIBUTE_STANDARD_TYPE ","          \
+    G_FILE_ATTRIBUTE_STANDARD_SIZE ","          \
+    G_FILE_ATTRIBUTE_TIME_MODIFIED ","          \
+    G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC
+
+typedef struct _EdfCatalogPrivate {
+    GPtrArray  *entries;
+    GHashTable *paths;      // path -> EdfCatalogEntry
+    guint       num_threads;
+
+    /* statistics of the last scan */
+    guint       num_parsed;
+    guint       num_skipped;
+    guint       num_failed;
+} EdfCatalogPrivate;
+
+G_DEFINE_TYPE_WITH_PRIVATE(EdfCatalog, edf_catalog, G_TYPE_OBJECT)
+
+typedef enum {
+    PROP_NUM_ENTRIES = 1,
+    PROP_NUM_THREADS,
+    PROP_NUM_PARSED,
+    PROP_NUM_SKIPPED,
+    PROP_NUM_FAILED,
+    N_PROPERTIES
+} EdfCatalogProperty;
+
+/* A file that is parsed by a worker thread */
+typedef struct {
+    gchar              *path;
+    gint64              mtime;
+    guint64             size;
+    gboolean            compressed;
+    EdfCatalogEntry    *entry;  // the result
+    GError             *error;
+} ScanJob;
+
+/* ************ entries ************ */
+
+static void
+catalog_entry_free(EdfCatalogEntry* entry)
+{
+    for (guint i = 0; i < entry->num_channels; i++) {
+        g_free(entry->channels[i].label);
+        g_free(entry->channels[i].unit);
+    }
+    g_free(entry->channels);
+    g_free(entry->path);
+    g_free(entry);
+}
+
+static EdfCatalogEntry*
+catalog_entry_new_from_header(const ScanJob* job, const EdfParsedHeader* header)
+{
+    EdfCatalogEntry* entry = g_new0(EdfCatalogEntry, 1);
+    gdouble duration = header->record_duration;
+    gint64 num_records = header->num_records;
+
+    /*
+     * A file that is still being recorded doesn't state its length. It is
+     * estimated from the size of a plain file, the size of a compressed
+     * file says nothing about the number of records.
+     */
+    if (num_records < 0 && !job->compressed) {
+        gsize record_size = edf_parsed_header_get_record_size(header);
+        num_records = record_size > 0 && job->size > header->header_size ?
+                      (job->size - header->header_size) / record_size : 0;
+    }
+
+    entry->path = g_strdup(job->path);
+    entry->mtime = job->mtime;
+    entry->size = job->size;
+    entry->start_time = edf_parsed_header_get_start_time(header);
+    entry->duration = num_records < 0 ? -1 : num_records * duration;
+    entry->num_channels = header->num_signals;
+    entry->channels = g_new0(EdfCatalogChannel, header->num_signals);
+
+    for (guint i = 0; i < header->num_signals; i++) {
+        const EdfParsedSignal* sig = &header->signals[i];
+        entry->channels[i].label = g_strdup(sig->label);
+        entry->channels[i].unit = g_strdup(sig->physical_dimension);
+        entry->channels[i].sample_rate = duration > 0 ? sig->ns / duration : 0;
+    }
+    return entry;
+}
+
+static void
+catalog_add_entry(EdfCatalog* catalog, EdfCatalogEntry* entry)
+{
+    EdfCatalogPrivate* priv = edf_catalog_get_instance_private(catalog);
+    EdfCatalogEntry* old = g_hash_table_lookup(priv->paths, entry->path);
+
+    // The old path is the key in the table, so it has to go first
+    if (old) {
+        g_hash_table_remove(priv->paths, old->path);
+        g_ptr_array_remove_fast(priv->entries, old);
+    }
+
+    g_ptr_array_add(priv->entries, entry);
+    g_hash_table_insert(priv->paths, entry->path, entry);
+}
+
+static gint
+compare_entries(gconstpointer a, gconstpointer b)
+{
+    const EdfCatalogEntry* entry1 = *(EdfCatalogEntry* const*) a;
+    const EdfCatalogEntry* entry2 = *(EdfCatalogEntry* const*) b;
+    return strcmp(entry1->path, entry2->path);
+}
+
+/* ************ scanning ************ */
+
+static gboolean
+is_catalog_path(const gchar* name)
+{
+    gchar* lower = g_ascii_strdown(name, -1);
+    gboolean result = FALSE;
+
+    for (const gchar** suffix = catalog_suffixes; *suffix && !result; suffix++)
+        result = g_str_has_suffix(lower, *suffix);
+
+    g_free(lower);
+    return result;
+}
+
+/*
+ * Parses the header of a file. Plain files are read directly, only the
+ * header is read from the disk. Compressed files need the streams of
+ * EdfFile.
+ */
+static gboolean
+scan_job_parse(ScanJob* job, EdfParsedHeader* header)
+{
+    guint8 base[EDF_BASE_HEADER_SIZE];
+    guint8* bytes = NULL;
+    gsize nread = 0, size;
+    gboolean result = FALSE;
+
+    GFile* file = g_file_new_for_path(job->path);
+    GInputStream* istream = G_INPUT_STREAM(g_file_read(file, NULL, &job->error));
+    if (!istream)
+        goto done;
+
+    if (!g_input_stream_read_all(istream, base, sizeof(base), &nread, NULL, &job->error))
+        goto done;
+
+    if (edf_file_is_compressed(base, nread)) {
+        job->compressed = TRUE;
+        g_clear_object(&istream);
+        istream = edf_file_open_input_stream(file, &job->error);
+        if (istream)
+            result = edf_parsed_header_read(header, istream, &job->error);
+        goto done;
+    }
+
+    if (nread != sizeof(base)) {
+        g_set_error(
+                &job->error,
+                EDF_HEADER_ERROR,
+                EDF_HEADER_ERROR_PARSE,
+                "The file is too short for an edf header"
+                );
+        goto done;
+    }
+
+    if (!edf_parsed_header_parse_base(header, base, &job->error))
+        goto done;
+
+    size = header->header_size - EDF_BASE_HEADER_SIZE;
+    bytes = g_malloc(size);
+    if (g_input_stream_read_all(istream, bytes, size, &nread, NULL, &job->error)) {
+        if (nread == size)
+            result = edf_parsed_header_parse_signals(header, bytes, &job->error);
+        else
+            g_set_error(
+                    &job->error,
+                    EDF_HEADER_ERROR,
+                    EDF_HEADER_ERROR_PARSE,
+                    "The file is too short for its header"
+                    );
+    }
+
+done:
+    g_free(bytes);
+    g_clear_object(&istream);
+    g_object_unref(file);
+    return result;
+}
+
+/* Runs on a worker thread, a job is only touched by one thread at a time */
+static void
+scan_job_run(gpointer data, gpointer user_data)
+{
+    ScanJob* job = data;
+    EdfParsedHeader header = {0,};
+    (void) user_data;
+
+    if (scan_job_parse(job, &header))
+        job->entry = catalog_entry_new_from_header(job, &header);
+
+    edf_parsed_header_clear(&header);
+}
+
+static void
+scan_job_free(ScanJob* job)
+{
+    g_free(job->path);
+    if (job->entry)
+        catalog_entry_free(job->entry);
+    g_clear_error(&job->error);
+    g_free(job);
+}
+
+/*
+ * Walks the tree below dir, files that are new or changed are handed to
+ * the pool.
+ */
+static void
+scan_directory(
+        EdfCatalog     *catalog,
+        GFile          *dir,
+        GThreadPool    *pool,
+        GPtrArray      *jobs,
+        GHashTable     *seen,
+        GError        **error
+        )
+{
+    EdfCatalogPrivate* priv = edf_catalog_get_instance_private(catalog);
+    GFileInfo* info;
+
+    GFileEnumerator* enumerator = g_file_enumerate_children(
+            dir, SCAN_ATTRIBUTES, G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, NULL, error
+            );
+    if (!enumerator)
+        return;
+
+    while ((info = g_file_enumerator_next_file(enumerator, NULL, error))) {
+        const gchar* name = g_file_info_get_name(info);
+        GFile* child = g_file_get_child(dir, name);
+
+        if (g_file_info_get_file_type(info) == G_FILE_TYPE_DIRECTORY) {
+            // An unreadable subdirectory shouldn't stop the scan
+            GError* dir_error = NULL;
+            scan_directory(catalog, child, pool, jobs, seen, &dir_error);
+            if (dir_error) {
+                g_debug("Skipping directory: %s", dir_error->message);
+                g_error_free(dir_error);
+            }
+        }
+        else if (g_file_info_get_file_type(info) == G_FILE_TYPE_REGULAR &&
+                 is_catalog_path(name)) {
+            gchar* path = g_file_get_path(child);
+            gint64 mtime = (gint64) g_file_info_get_attribute_uint64(
+                    info, G_FILE_ATTRIBUTE_TIME_MODIFIED
+                    ) * G_USEC_PER_SEC + g_file_info_get_attribute_uint32(
+                    info, G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC
+                    );
+            guint64 size = g_file_info_get_size(info);
+            EdfCatalogEntry* entry = g_hash_table_lookup(priv->paths, path);
+
+            g_hash_table_add(seen, path);
+            if (entry && entry->mtime == mtime && entry->size == size) {
+                priv->num_skipped++;
+            }
+            else {
+                ScanJob* job = g_new0(ScanJob, 1);
+                job->path = g_strdup(path);
+                job->mtime = mtime;
+                job->size = size;
+                g_ptr_array_add(jobs, job);
+                g_thread_pool_push(pool, job, NULL);
+            }
+        }
+
+        g_object_unref(child);
+        g_object_unref(info);
+    }
+
+    g_object_unref(enumerator);
+}
+
+/* ************ serialization ************ */
+
+static void
+put_u8(GByteArray* array, guint8 value)
+{
+    g_byte_array_append(array, &value, sizeof(value));
+}
+
+static void
+put_u32(GByteArray* array, guint32 value)
+{
+    value = GUINT32_TO_LE(value);
+    g_byte_array_append(array, (const guint8*) &value, sizeof(value));
+}
+
+static void
+put_u64(GByteArray* array, guint64 value)
+{
+    value = GUINT64_TO_LE(value);
+    g_byte_array_append(array, (const guint8*) &value, sizeof(value));
+}
+
+static void
+put_double(GByteArray* array, gdouble value)
+{
+    guint64 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    put_u64(array, bits);
+}
+
+/* Strings of the header are short, the length is stored in a byte */
+static void
+put_short_string(GByteArray* array, const gchar* str)
+{
+    gsize len = MIN(strlen(str), G_MAXUINT8);
+    put_u8(array, len);
+    g_byte_array_append(array, (const guint8*) str, len);
+}
+
+/* Reads from a catalogue, after an error all reads return zeros */
+typedef struct {
+    const guint8   *bytes;
+    gsize           size;
+    gsize           pos;
+    gboolean        valid;
+} CatalogReader;
+
+static const guint8*
+get_bytes(CatalogReader* reader, gsize n)
+{
+    static const guint8 zeros[sizeof(guint64)] = {0,};
+
+    if (!reader->valid || n > reader->size - reader->pos) {
+        reader->valid = FALSE;
+        return zeros;
+    }
+    const guint8* bytes = &reader->bytes[reader->pos];
+    reader->pos += n;
+    return bytes;
+}
+
+static guint8
+get_u8(CatalogReader* reader)
+{
+    return *get_bytes(reader, sizeof(guint8));
+}
+
+static guint32
+get_u32(CatalogReader* reader)
+{
+    guint32 value;
+    memcpy(&value, get_bytes(reader, sizeof(value)), sizeof(value));
+    return GUINT32_FROM_LE(value);
+}
+
+static guint64
+get_u64(CatalogReader* reader)
+{
+    guint64 value;
+    memcpy(&value, get_bytes(reader, sizeof(value)), sizeof(value));
+    return GUINT64_FROM_LE(value);
+}
+
+static gdouble
+get_double(CatalogReader* reader)
+{
+    guint64 bits = get_u64(reader);
+    gdouble value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static gchar*
+get_string(CatalogReader* reader, gsize len)
+{
+    if (!reader->valid || len > reader->size - reader->pos) {
+        reader->valid = FALSE;
+        return g_strdup("");
+    }
+    gchar* str = g_strndup((const gchar*) &reader->bytes[reader->pos], len);
+    reader->pos += len;
+    return str;
+}
+
+/* ************ GObject ************ */
+
+static void
+edf_catalog_init(EdfCatalog* self)
+{
+    EdfCatalogPrivate* priv = edf_catalog_get_instance_private(self);
+
+    priv->entries = g_ptr_array_new_with_free_func(
+            (GDestroyNotify) catalog_entry_free
+            );
+    priv->paths = g_hash_table_new(g_str_hash, g_str_equal);
+    priv->num_threads = 0;
+}
+
+static void
+edf_catalog_finalize(GObject* gobject)
+{
+    EdfCatalogPrivate* priv = edf_catalog_get_instance_private(
+            EDF_CATALOG(gobject)
+            );
+
+    g_hash_table_unref(priv->paths);
+    g_ptr_array_unref(priv->entries);
+
+    G_OBJECT_CLASS(edf_catalog_parent_class)->finalize(gobject);
+}
+
+static void
+edf_catalog_set_property(
+        GObject        *object,
+        guint32         propid,
+        const GValue   *value,
+        GParamSpec     *spec
+        )
+{
+    EdfCatalog* self = EDF_CATALOG(object);
+    EdfCatalogPrivate* priv = edf_catalog_get_instance_private(self);
+
+    switch ((EdfCatalogProperty) propid) {
+        case PROP_NUM_THREADS:
+            priv->num_threads = g_value_get_uint(value);
+            break;
+        case PROP_NUM_ENTRIES: // read only
+        case PROP_NUM_PARSED:  // read only
+        case PROP_NUM_SKIPPED: // read only
+        case PROP_NUM_FAILED:  // read only
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID(object, propid, spec);
+    }
+}
+
+static void
+edf_catalog_get_property(
+        GObject        *object,
+        guint32         propid,
+        GValue         *value,
+        GParamSpec     *spec
+        )
+{
+    EdfCatalog* self = EDF_CATALOG(object);
+    EdfCatalogPrivate* priv = edf_catalog_get_instance_private(self);
+
+    switch ((EdfCatalogProperty) propid) {
+        case PROP_NUM_ENTRIES:
+            g_value_set_uint(value, priv->entries->len);
+            break;
+        case PROP_NUM_THREADS:
+            g_value_set_uint(value, priv->num_threads);
+            break;
+        case PROP_NUM_PARSED:
+            g_value_set_uint(value, priv->num_parsed);
+            break;
+        case PROP_NUM_SKIPPED:
+            g_value_set_uint(value, priv->num_skipped);
+            break;
+        case PROP_NUM_FAILED:
+            g_value_set_uint(value, priv->num_failed);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID(object, propid, spec);
+    }
+}
+
+static GParamSpec* edf_catalog_properties[N_PROPERTIES] = {NULL,};
+
+static void
+edf_catalog_class_init(EdfCatalogClass* klass)
+{
+    GObjectClass* object_class = G_OBJECT_CLASS(klass);
+
+    object_class->set_property = edf_catalog_set_property;
+    object_class->get_property = edf_catalog_get_property;
+    object_class->finalize = edf_catalog_finalize;
+
+    /**
+     * EdfCatalog:num-entries:
+     *
+     * The number of files in the catalogue.
+     */
+    edf_catalog_properties[PROP_NUM_ENTRIES] = g_param_spec_uint(
+            "num-entries",
+            "Number of entries",
+            "The number of catalogued files",
+            0,
+            G_MAXUINT,
+            0,
+            G_PARAM_READABLE
+            );
+
+    /**
+     * EdfCatalog:num-threads:
+     *
+     * The number of threads that parse headers while scanning, 0 uses one
+     * thread per processor.
+     */
+    edf_catalog_properties[PROP_NUM_THREADS] = g_param_spec_uint(
+            "num-threads",
+            "Number of threads",
+            "The number of threads that parse headers",
+            0,
+            G_MAXUINT,
+            0,
+            G_PARAM_READWRITE
+            );
+
+    /**
+     * EdfCatalog:num-parsed:
+     *
+     * The number of files that were parsed by the last scan.
+     */
+    edf_catalog_properties[PROP_NUM_PARSED] = g_param_spec_uint(
+            "num-parsed",
+            "Number of parsed files",
+            "The number of files parsed by the last scan",
+            0,
+            G_MAXUINT,
+            0,
+            G_PARAM_READABLE
+            );
+
+    /**
+     * EdfCatalog:num-skipped:
+     *
+     * The number of files that were unchanged since they were catalogued
+     * during the last scan.
+     */
+    edf_catalog_properties[PROP_NUM_SKIPPED] = g_param_spec_uint(
+            "num-skipped",
+            "Number of skipped files",
+            "The number of unchanged files during the last scan",
+            0,
+            G_MAXUINT,
+            0,
+            G_PARAM_READABLE
+            );
+
+    /**
+     * EdfCatalog:num-failed:
+     *
+     * The number of files whose header could not be parsed during the last
+     * scan.
+     */
+    edf_catalog_properties[PROP_NUM_FAILED] = g_param_spec_uint(
+            "num-failed",
+            "Number of failed files",
+            "The number of invalid files during the last scan",
+            0,
+            G_MAXUINT,
+            0,
+            G_PARAM_READABLE
+            );
+
+    g_object_class_install_properties(
+            object_class, N_PROPERTIES, edf_catalog_properties
+            );
+}
+
+/* ************* public functions ***************** */
+
+/**
+ * edf_catalog_new:(constructor)
+ *
+ * Create a new empty catalogue.
+ *
+ * Returns:(transfer full): a new #EdfCatalog
+ */
+EdfCatalog*
+edf_catalog_new(void)
+{
+    return g_object_new(EDF_TYPE_CATALOG, NULL);
+}
+
+/**
+ * edf_catalog_scan:
+ * @catalog: the #EdfCatalog to update
+ * @root: the directory to scan
+ * @error:(out): An error is returned here when @root cannot be read
+ *
+ * Catalogues the edf and bdf files below @root, including compressed
+ * ones. Files that are catalogued with the same size and modification
+ * time are not parsed again, entries below @root whose file doesn't exist
+ * anymore are removed. Files that cannot be parsed are left out, the
+ * #EdfCatalog:num-failed property tells how many there were.
+ *
+ * Returns: TRUE when @root was scanned.
+ */
+gboolean
+edf_catalog_scan(EdfCatalog* catalog, const gchar* root, GError** error)
+{
+    g_return_val_if_fail(EDF_IS_CATALOG(catalog), FALSE);
+    g_return_val_if_fail(root != NULL, FALSE);
+    g_return_val_if_fail(error != NULL && *error == NULL, FALSE);
+
+    EdfCatalogPrivate* priv = edf_catalog_get_instance_private(catalog);
+    guint num_threads = priv->num_threads ? priv->num_threads : g_get_num_processors();
+
+    GThreadPool* pool = g_thread_pool_new(
+            scan_job_run, catalog, num_threads, FALSE, error
+            );
+    if (!pool)
+        return FALSE;
+
+    GFile* dir = g_file_new_for_path(root);
+    gchar* root_path = g_file_get_path(dir);
+    GPtrArray* jobs = g_ptr_array_new_with_free_func((GDestroyNotify) scan_job_free);
+    GHashTable* seen = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+
+    priv->num_parsed = priv->num_skipped = priv->num_failed = 0;
+
+    scan_directory(catalog, dir, pool, jobs, seen, error);
+
+    // Wait for the workers, the results are merged on this thread
+    g_thread_pool_free(pool, FALSE, TRUE);
+
+    if (*error)
+        goto done;
+
+    for (guint i = 0; i < jobs->len; i++) {
+        ScanJob* job = g_ptr_array_index(jobs, i);
+        if (job->entry) {
+            catalog_add_entry(catalog, job->entry);
+            job->entry = NULL;
+            priv->num_parsed++;
+        }
+        else {
+            g_debug("Unable to catalogue %s: %s",
+                    job->path,
+                    job->error ? job->error->message : "unknown error"
+                    );
+            g_hash_table_remove(seen, job->path);
+            priv->num_failed++;
+        }
+    }
+
+    // Drop the entries of files below root that are gone or broken now
+    gchar* prefix = g_str_has_suffix(root_path, G_DIR_SEPARATOR_S) ?
+                    g_strdup(root_path) : g_strconcat(root_path, G_DIR_SEPARATOR_S, NULL);
+    for (guint i = priv->entries->len; i > 0; i--) {
+        EdfCatalogEntry* entry = g_ptr_array_index(priv->entries, i - 1);
+        if (g_str_has_prefix(entry->path, prefix) &&
+            !g_hash_table_contains(seen, entry->path)) {
+            g_hash_table_remove(priv->paths, entry->path);
+            g_ptr_array_remove_index_fast(priv->entries, i - 1);
+        }
+    }
+    g_free(prefix);
+
+    g_ptr_array_sort(priv->entries, compare_entries);
+
+done:
+    g_hash_table_unref(seen);
+    g_ptr_array_unref(jobs);
+    g_free(root_path);
+    g_object_unref(dir);
+    return *error == NULL;
+}
+
+/**
+ * edf_catalog_save:
+ * @catalog: the #EdfCatalog to store
+ * @path: the path of the catalogue file
+ * @error:(out): An error is returned here when the file cannot be written
+ *
+ * Stores @catalog in a compact binary file.
+ *
+ * Returns: TRUE when the catalogue was written.
+ */
+gboolean
+edf_catalog_save(EdfCatalog* catalog, const gchar* path, GError** error)
+{
+    g_return_val_if_fail(EDF_IS_CATALOG(catalog), FALSE);
+    g_return_val_if_fail(path != NULL, FALSE);
+    g_return_val_if_fail(error != NULL && *error == NULL, FALSE);
+
+    EdfCatalogPrivate* priv = edf_catalog_get_instance_private(catalog);
+    GByteArray* data = g_byte_array_new();
+    gboolean result;
+
+    g_byte_array_append(data, (const guint8*) catalog_magic, sizeof(catalog_magic));
+    put_u32(data, priv->entries->len);
+
+    for (guint i = 0; i < priv->entries->len; i++) {
+        EdfCatalogEntry* entry = g_ptr_array_index(priv->entries, i);
+        gsize path_len = strlen(entry->path);
+
+        put_u32(data, path_len);
+        g_byte_array_append(data, (const guint8*) entry->path, path_len);
+        put_u64(data, entry->mtime);
+        put_u64(data, entry->size);
+        put_u64(data, entry->start_time);
+        put_double(data, entry->duration);
+        put_u32(data, entry->num_channels);
+        for (guint c = 0; c < entry->num_channels; c++) {
+            put_short_string(data, entry->channels[c].label);
+            put_short_string(data, entry->channels[c].unit);
+            put_double(data, entry->channels[c].sample_rate);
+        }
+    }
+
+    result = g_file_set_contents(path, (const gchar*) data->data, data->len, error);
+    g_byte_array_unref(data);
+    return result;
+}
+
+/**
+ * edf_catalog_load:(constructor)
+ * @path: the path of a file made by edf_catalog_save()
+ * @error:(out): An error is returned here when the file cannot be read
+ *
+ * Loads a catalogue, it can be updated with edf_catalog_scan().
+ *
+ * Returns:(transfer full): a new #EdfCatalog or NULL
+ */
+EdfCatalog*
+edf_catalog_load(const gchar* path, GError** error)
+{
+    g_return_val_if_fail(path != NULL, NULL);
+    g_return_val_if_fail(error != NULL && *error == NULL, NULL);
+
+    gchar* contents = NULL;
+    gsize length = 0;
+
+    if (!g_file_get_contents(path, &contents, &length, error))
+        return NULL;
+
+    CatalogReader reader = {(const guint8*) contents, length, 0, TRUE};
+    EdfCatalog* catalog = edf_catalog_new();
+
+    if (memcmp(get_bytes(&reader, sizeof(catalog_magic)),
+               catalog_magic,
+               sizeof(catalog_magic)) != 0)
+        goto invalid;
+
+    guint32 num_entries = get_u32(&reader);
+    for (guint32 i = 0; i < num_entries && reader.valid; i++) {
+        EdfCatalogEntry* entry = g_new0(EdfCatalogEntry, 1);
+
+        entry->path = get_string(&reader, get_u32(&reader));
+        entry->mtime = get_u64(&reader);
+        entry->size = get_u64(&reader);
+        entry->start_time = get_u64(&reader);
+        entry->duration = get_double(&reader);
+
+        guint32 num_channels = get_u32(&reader);
+        // every channel takes at least 10 bytes
+        if (num_channels > (reader.size - reader.pos) / 10) {
+            catalog_entry_free(entry);
+            goto invalid;
+        }
+
+        entry->num_channels = num_channels;
+        entry->channels = g_new0(EdfCatalogChannel, num_channels);
+        for (guint32 c = 0; c < num_channels; c++) {
+            entry->channels[c].label = get_string(&reader, get_u8(&reader));
+            entry->channels[c].unit = get_string(&reader, get_u8(&reader));
+            entry->channels[c].sample_rate = get_double(&reader);
+        }
+        catalog_add_entry(catalog, entry);
+    }
+
+    if (!reader.valid || reader.pos != reader.size)
+        goto invalid;
+
+    g_free(contents);
+    return catalog;
+
+invalid:
+    g_set_error(
+            error,
+            EDF_CATALOG_ERROR,
+            EDF_CATALOG_ERROR_FORMAT,
+            "'%s' isn't a valid catalogue",
+            path
+            );
+    g_object_unref(catalog);
+    g_free(contents);
+    return NULL;
+}
+
+/**
+ * edf_catalog_get_num_entries:
+ * @catalog: the #EdfCatalog
+ *
+ * Returns: the number of catalogued files.
+ */
+guint
+edf_catalog_get_num_entries(EdfCatalog* catalog)
+{
+    g_return_val_if_fail(EDF_IS_CATALOG(catalog), 0);
+    EdfCatalogPrivate* priv = edf_catalog_get_instance_private(catalog);
+    return priv->entries->len;
+}
+
+/**
+ * edf_catalog_get_entry:
+ * @catalog: the #EdfCatalog
+ * @index: the index of the entry, the entries are sorted by path after a scan
+ *
+ * Returns:(transfer none): the entry at @index, it is valid until the
+ *                          catalogue is modified.
+ */
+const EdfCatalogEntry*
+edf_catalog_get_entry(EdfCatalog* catalog, guint index)
+{
+    g_return_val_if_fail(EDF_IS_CATALOG(catalog), NULL);
+    EdfCatalogPrivate* priv = edf_catalog_get_instance_private(catalog);
+    g_return_val_if_fail(index < priv->entries->len, NULL);
+
+    return g_ptr_array_index(priv->entries, index);
+}
+
+/**
+ * edf_catalog_lookup:
+ * @catalog: the #EdfCatalog
+ * @path: the path of a file as found by edf_catalog_scan()
+ *
+ * Returns:(transfer none)(nullable): the entry of @path or NULL when it
+ *                                    isn't catalogued.
+ */
+const EdfCatalogEntry*
+edf_catalog_lookup(EdfCatalog* catalog, const gchar* path)
+{
+    g_return_val_if_fail(EDF_IS_CATALOG(catalog), NULL);
+    g_return_val_if_fail(path != NULL, NULL);
+    EdfCatalogPrivate* priv = edf_catalog_get_instance_private(catalog);
+
+    return g_hash_table_lookup(priv->paths, path);
+}
+
+/**
+ * edf_catalog_find:
+ * @catalog: the #EdfCatalog
+ * @label: the label of a channel
+ * @min_sample_rate: the minimal sample rate of the channel
+ *
+ * Finds the files that have a channel labelled @label with a sample rate of
+ * at least @min_sample_rate.
+ *
+ * Returns:(transfer container)(element-type EdfCatalogEntry): the entries
+ *          of the matching files.
+ */
+GPtrArray*
+edf_catalog_find(EdfCatalog* catalog, const gchar* label, gdouble min_sample_rate)
+{
+    g_return_val_if_fail(EDF_IS_CATALOG(catalog), NULL);
+    g_return_val_if_fail(label != NULL, NULL);
+    EdfCatalogPrivate* priv = edf_catalog_get_instance_private(catalog);
+    GPtrArray* result = g_ptr_array_new();
+
+    for (guint i = 0; i < priv->entries->len; i++) {
+        EdfCatalogEntry* entry = g_ptr_array_index(priv->entries, i);
+        for (guint c = 0; c < entry->num_channels; c++) {
+            if (strcmp(entry->channels[c].label, label) == 0 &&
+                entry->channels[c].sample_rate >= min_sample_rate) {
+                g_ptr_array_add(result, entry);
+                break;
+            }
+        }
+    }
+    return result;
+}
@@ -0,0 +1,1442 @@
+
+#include "edf-codec.h"
+#include "edf-codec-priv.h"
+#include "edf-file.h"
+#include "edf-header-priv.h"
+#include "edf-sample-priv.h"
+#include "edf-size-priv.h"
+
+#include <gio/gio.h>
+#include <string.h>
+
+/**
+ * SECTION:edf-codec
+ * @short_description: lossless compression of edf and bdf files with random access
+ * @see_also: #EdfFile
+ * @include: gedf.h
+ *
+ * The samples of biological signals change slowly, so the difference
+ * between a sample and a prediction from the previous samples is small.
+ * The codec stores such residuals with the minimal number of bits for every
+ * signal in every data record. The compressed records are preceded by the
+ * original header and followed by an index of the records, so a range of
+ * samples can be decoded with #EdfCodecReader without decompressing the
+ * whole file.
+ *
+ * The compression is lossless, edf_codec_decompress() reproduces the
+ * original file byte for byte. #EdfFile reads compressed containers
+ * transparently and writes them when its path ends with ".edfz" or ".bdfz".
+ *
+ * The layout of a container, all numbers are little endian:
+ * |[
+ * magic "GEDFBLK1", u32 header size, u32 record size
+ * the original header
+ * for every record: u32 size, for every signal a chunk
+ * the bytes after the last complete record of the original
+ * the index: u64 offset of every record
+ * u64 num records, u64 index offset, u64 trailer offset,
+ * u64 trailer size, magic "GEDFBLK1"
+ * ]|
+ * A chunk starts with a byte for the predictor and a byte with the number
+ * of bits of the residuals. The first 1 or 2 samples are stored as i32 and
+ * the zigzag coded residuals of the others are packed in an lsb first
+ * bitstream.
+ */
+
+G_DEFINE_QUARK(edf_codec_error_quark, edf_codec_error)
+
+#define CODEC_PREAMBLE_SIZE     (EDF_CODEC_MAGIC_SIZE + 2 * sizeof(guint32))
+#define CODEC_FOOTER_SIZE       (4 * sizeof(guint64) + EDF_CODEC_MAGIC_SIZE)
+#define CODEC_CHUNK_HEADER_SIZE 2
+#define CODEC_WARMUP_SIZE       sizeof(gint32)
+
+/*
+ * The bit unpacking reads 8 bytes at once, so the buffers with encoded
+ * data have this many bytes of slack.
+ */
+#define CODEC_PADDING           sizeof(guint64)
+
+typedef enum {
+    CODEC_MODE_RAW,     // the samples are stored as is
+    CODEC_MODE_DELTA1,  // prediction x[i-1]
+    CODEC_MODE_DELTA2,  // prediction 2x[i-1] - x[i-2]
+    CODEC_MODE_LAST = CODEC_MODE_DELTA2
+} CodecMode;
+
+/* The layout of the records of a file */
+typedef struct {
+    guint       num_signals;
+    guint      *ns;
+    guint      *sample_size;
+    gsize      *offset;
+    gsize       record_size;
+    guint       max_ns;
+
+    /* scratch space of max_ns samples */
+    gint32     *samples;
+    guint32    *residuals;
+} CodecLayout;
+
+/* What is known from the start and the end of a container */
+typedef struct {
+    guint8     *header_bytes;
+    gsize       header_size;
+    EdfHeader  *header;
+    CodecLayout layout;
+    guint64     container_size;
+    guint64     num_records;
+    guint64     index_offset;
+    guint64     trailer_offset;
+    guint64     trailer_size;
+} CodecInfo;
+
+/* ************ byte order helpers ************ */
+
+static void
+put_u32(guint8* bytes, guint32 value)
+{
+    value = GUINT32_TO_LE(value);
+    memcpy(bytes, &value, sizeof(value));
+}
+
+static void
+put_u64(guint8* bytes, guint64 value)
+{
+    value = GUINT64_TO_LE(value);
+    memcpy(bytes, &value, sizeof(value));
+}
+
+static guint32
+get_u32(const guint8* bytes)
+{
+    guint32 value;
+    memcpy(&value, bytes, sizeof(value));
+    return GUINT32_FROM_LE(value);
+}
+
+static guint64
+get_u64(const guint8* bytes)
+{
+    guint64 value;
+    memcpy(&value, bytes, sizeof(value));
+    return GUINT64_FROM_LE(value);
+}
+
+/* ************ kernels ************ */
+
+static inline guint32
+zigzag_encode(gint32 value)
+{
+    return ((guint32) value << 1) ^ (guint32) (value >> 31);
+}
+
+static inline gint32
+zigzag_decode(guint32 value)
+{
+    return (gint32) (value >> 1) ^ -(gint32) (value & 1);
+}
+
+/*
+ * Computes the zigzag coded residuals of n samples for a predictor of
+ * order 1 or 2. Returns the bitwise or of all residuals.
+ */
+static guint32
+codec_residuals(const gint32* x, gsize n, guint order, guint32* res)
+{
+    guint32 acc = 0;
+
+    if (order == 1) {
+        for (gsize i = 1; i < n; i++) {
+            res[i - 1] = zigzag_encode(x[i] - x[i - 1]);
+            acc |= res[i - 1];
+        }
+    }
+    else {
+        for (gsize i = 2; i < n; i++) {
+            res[i - 2] = zigzag_encode(x[i] - 2 * x[i - 1] + x[i - 2]);
+            acc |= res[i - 2];
+        }
+    }
+    return acc;
+}
+
+static void
+codec_reconstruct(const guint32* res, gsize n, guint order, gint32* x)
+{
+    // unsigned arithmetic, corrupt data may overflow
+    guint32* ux = (guint32*) x;
+
+    if (order == 1) {
+        for (gsize i = 1; i < n; i++)
+            ux[i] = ux[i - 1] + (guint32) zigzag_decode(res[i - 1]);
+    }
+    else {
+        for (gsize i = 2; i < n; i++)
+            ux[i] = 2 * ux[i - 1] - ux[i - 2] + (guint32) zigzag_decode(res[i - 2]);
+    }
+}
+
+static gsize
+packed_size(gsize n, guint bits)
+{
+    return (n * bits + 7) / 8;
+}
+
+static void
+pack_bits(const guint32* values, gsize n, guint bits, guint8* out)
+{
+    guint64 acc = 0;
+    guint filled = 0;
+
+    for (gsize i = 0; i < n; i++) {
+        acc |= (guint64) values[i] << filled;
+        filled += bits;
+        while (filled >= 8) {
+            *out++ = acc & 0xff;
+            acc >>= 8;
+            filled -= 8;
+        }
+    }
+    if (filled > 0)
+        *out = acc & 0xff;
+}
+
+/*
+ * Every value is read with one unaligned 64 bit load, this requires
+ * CODEC_PADDING readable bytes after the packed data.
+ */
+static void
+unpack_bits(const guint8* in, gsize n, guint bits, guint32* out)
+{
+    const guint64 mask = (G_GUINT64_CONSTANT(1) << bits) - 1;
+
+    for (gsize i = 0; i < n; i++) {
+        gsize pos = i * bits;
+        guint64 word;
+        memcpy(&word, &in[pos >> 3], sizeof(word));
+        out[i] = (GUINT64_FROM_LE(word) >> (pos & 7)) & mask;
+    }
+}
+
+/* ************ record layout ************ */
+
+static void
+codec_layout_init(CodecLayout* layout, EdfHeader* header)
+{
+    GPtrArray* signals = edf_header_get_signals(header);
+
+    layout->num_signals = signals->len;
+    layout->ns = g_new(guint, signals->len);
+    layout->sample_size = g_new(guint, signals->len);
+    layout->offset = g_new(gsize, signals->len);
+    layout->record_size = 0;
+    layout->max_ns = 0;
+
+    for (guint i = 0; i < signals->len; i++) {
+        EdfSignal* signal = g_ptr_array_index(signals, i);
+        layout->ns[i] = edf_signal_get_num_samples_per_record(signal);
+        layout->sample_size[i] = edf_signal_get_sample_size(signal);
+        layout->offset[i] = layout->record_size;
+        layout->record_size += (gsize) layout->ns[i] * layout->sample_size[i];
+        layout->max_ns = MAX(layout->max_ns, layout->ns[i]);
+    }
+
+    layout->samples = g_new(gint32, layout->max_ns);
+    layout->residuals = g_new(guint32, layout->max_ns);
+}
+
+static void
+codec_layout_clear(CodecLayout* layout)
+{
+    g_clear_pointer(&layout->ns, g_free);
+    g_clear_pointer(&layout->sample_size, g_free);
+    g_clear_pointer(&layout->offset, g_free);
+    g_clear_pointer(&layout->samples, g_free);
+    g_clear_pointer(&layout->residuals, g_free);
+}
+
+static EdfHeader*
+codec_parse_header(const guint8* bytes, gsize size, GError** error)
+{
+    GInputStream* istream = g_memory_input_stream_new_from_data(bytes, size, NULL);
+    EdfHeader* header = edf_header_new_from_input_stream(istream, error);
+    g_object_unref(istream);
+    return header;
+}
+
+/* ************ chunks ************ */
+
+/*
+ * Appends the compressed samples of one signal of a record to out.
+ */
+static void
+codec_encode_chunk(
+        CodecLayout    *layout,
+        guint           signal,
+        const guint8   *record,
+        GByteArray     *out
+        )
+{
+    guint ns = layout->ns[signal];
+    guint ss = layout->sample_size[signal];
+    const guint8* raw = &record[layout->offset[signal]];
+    guint8 mode = CODEC_MODE_RAW, bits = 0;
+    gsize size = CODEC_CHUNK_HEADER_SIZE + (gsize) ns * ss;
+
+    edf_samples_decode(raw, ss, ns, layout->samples);
+
+    for (guint order = 1; order <= 2; order++) {
+        if (ns <= order)
+            break;
+        guint32 acc = codec_residuals(layout->samples, ns, order, layout->residuals);
+        guint nbits = acc ? g_bit_storage(acc) : 0;
+        gsize nsize = CODEC_CHUNK_HEADER_SIZE + order * CODEC_WARMUP_SIZE +
+                      packed_size(ns - order, nbits);
+        if (nsize < size) {
+            size = nsize;
+            mode = order;
+            bits = nbits;
+        }
+    }
+
+    guint pos = out->len;
+    g_byte_array_set_size(out, out->len + size);
+    guint8* chunk = &out->data[pos];
+    chunk[0] = mode;
+    chunk[1] = bits;
+    chunk += CODEC_CHUNK_HEADER_SIZE;
+
+    if (mode == CODEC_MODE_RAW) {
+        memcpy(chunk, raw, (gsize) ns * ss);
+        return;
+    }
+
+    for (guint i = 0; i < mode; i++)
+        put_u32(&chunk[i * CODEC_WARMUP_SIZE], (guint32) layout->samples[i]);
+    chunk += mode * CODEC_WARMUP_SIZE;
+
+    // The residuals of the other predictor may be in the scratch space
+    if (mode != 2)
+        codec_residuals(layout->samples, ns, mode, layout->residuals);
+    pack_bits(layout->residuals, ns - mode, bits, chunk);
+}
+
+/*
+ * Checks the chunk of signal at the start of bytes and returns its size
+ * or 0 when it is invalid.
+ */
+static gsize
+codec_chunk_size(CodecLayout* layout, guint signal, const guint8* bytes, gsize avail)
+{
+    guint ns = layout->ns[signal];
+    guint mode, bits;
+    gsize size;
+
+    if (avail < CODEC_CHUNK_HEADER_SIZE)
+        return 0;
+    mode = bytes[0];
+    bits = bytes[1];
+
+    if (mode > CODEC_MODE_LAST || bits > 32)
+        return 0;
+
+    if (mode == CODEC_MODE_RAW)
+        size = CODEC_CHUNK_HEADER_SIZE + (gsize) ns * layout->sample_size[signal];
+    else if (ns <= mode)
+        return 0;
+    else
+        size = CODEC_CHUNK_HEADER_SIZE + mode * CODEC_WARMUP_SIZE +
+               packed_size(ns - mode, bits);
+
+    return size <= avail ? size : 0;
+}
+
+/*
+ * Decodes a valid chunk into the samples of the layout.
+ */
+static void
+codec_decode_chunk(CodecLayout* layout, guint signal, const guint8* chunk)
+{
+    guint ns = layout->ns[signal];
+    guint mode = chunk[0];
+    guint bits = chunk[1];
+
+    chunk += CODEC_CHUNK_HEADER_SIZE;
+    if (mode == CODEC_MODE_RAW) {
+        edf_samples_decode(chunk, layout->sample_size[signal], ns, layout->samples);
+        return;
+    }
+
+    for (guint i = 0; i < mode; i++)
+        layout->samples[i] = (gint32) get_u32(&chunk[i * CODEC_WARMUP_SIZE]);
+    chunk += mode * CODEC_WARMUP_SIZE;
+
+    unpack_bits(chunk, ns - mode, bits, layout->residuals);
+    codec_reconstruct(layout->residuals, ns, mode, layout->samples);
+}
+
+/*
+ * Decodes a block of size bytes into the original bytes of the record.
+ * The block must be followed by CODEC_PADDING bytes.
+ */
+static gboolean
+codec_decode_block(
+        CodecLayout    *layout,
+        const guint8   *block,
+        gsize           size,
+        guint8         *record,
+        GError        **error
+        )
+{
+    for (guint signal = 0; signal < layout->num_signals; signal++) {
+        gsize chunk_size = codec_chunk_size(layout, signal, block, size);
+        if (chunk_size == 0) {
+            g_set_error(
+                    error,
+                    EDF_CODEC_ERROR,
+                    EDF_CODEC_ERROR_FORMAT,
+                    "Invalid compressed data of signal %u",
+                    signal
+                    );
+            return FALSE;
+        }
+
+        guint8* raw = &record[layout->offset[signal]];
+        guint ss = layout->sample_size[signal];
+        if (block[0] == CODEC_MODE_RAW) {
+            memcpy(raw, &block[CODEC_CHUNK_HEADER_SIZE], (gsize) layout->ns[signal] * ss);
+        }
+        else {
+            codec_decode_chunk(layout, signal, block);
+            edf_samples_encode(raw, ss, layout->ns[signal], layout->samples);
+        }
+
+        block += chunk_size;
+        size -= chunk_size;
+    }
+    return TRUE;
+}
+
+/*
+ * Reads the u32 size and the block at the current position of istream into
+ * block, followed by CODEC_PADDING zeros. The records of the container end
+ * at offset end, a block that doesn't fit is invalid.
+ */
+static gboolean
+codec_read_block(
+        GInputStream   *istream,
+        guint64         end,
+        GByteArray     *block,
+        GError        **error
+        )
+{
+    guint8 size_bytes[sizeof(guint32)];
+    gsize nread = 0;
+    guint64 pos = g_seekable_tell(G_SEEKABLE(istream));
+
+    if (pos + sizeof(size_bytes) > end) {
+        g_set_error(
+                error,
+                G_IO_ERROR,
+                G_IO_ERROR_INVALID_DATA,
+                "A compressed record starts beyond the records of the container"
+                );
+        return FALSE;
+    }
+
+    if (!g_input_stream_read_all(
+                istream, size_bytes, sizeof(size_bytes), &nread, NULL, error
+                )
+       )
+        return FALSE;
+
+    if (nread != sizeof(size_bytes))
+        goto truncated;
+
+    guint32 size = get_u32(size_bytes);
+    if (size > end - pos - sizeof(size_bytes)) {
+        g_set_error(
+                error,
+                G_IO_ERROR,
+                G_IO_ERROR_INVALID_DATA,
+                "The size of a compressed record exceeds the container"
+                );
+        return FALSE;
+    }
+
+    g_byte_array_set_size(block, size + CODEC_PADDING);
+    memset(&block->data[size], 0, CODEC_PADDING);
+
+    if (!g_input_stream_read_all(istream, block->data, size, &nread, NULL, error))
+        return FALSE;
+
+    if (nread != size)
+        goto truncated;
+
+    g_byte_array_set_size(block, size);
+    return TRUE;
+
+truncated:
+    g_set_error(
+            error,
+            EDF_CODEC_ERROR,
+            EDF_CODEC_ERROR_FORMAT,
+            "The compressed data is truncated"
+            );
+    return FALSE;
+}
+
+/* ************ containers ************ */
+
+static void
+codec_info_clear(CodecInfo* info)
+{
+    g_clear_pointer(&info->header_bytes, g_free);
+    g_clear_object(&info->header);
+    codec_layout_clear(&info->layout);
+}
+
+/*
+ * Checks that the parts the footer points to are in their place within the
+ * container, so they can be read without trusting the numbers in it.
+ */
+static gboolean
+codec_info_validate(const CodecInfo* info, GError** error)
+{
+    guint64 records_offset = CODEC_PREAMBLE_SIZE + info->header_size;
+    guint64 index_end = info->container_size - CODEC_FOOTER_SIZE;
+
+    if (info->index_offset < records_offset || info->index_offset > index_end ||
+        info->num_records != (index_end - info->index_offset) / sizeof(guint64) ||
+        (index_end - info->index_offset) % sizeof(guint64) != 0 ||
+        info->trailer_offset < records_offset ||
+        info->trailer_offset > info->index_offset ||
+        info->trailer_size != info->index_offset - info->trailer_offset) {
+        g_set_error(
+                error,
+                G_IO_ERROR,
+                G_IO_ERROR_INVALID_DATA,
+                "The footer of the compressed container is inconsistent with "
+                "its size of %" G_GUINT64_FORMAT " bytes",
+                info->container_size
+                );
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/*
+ * Reads the preamble, header and footer of the container in istream, the
+ * stream is positioned at the first record afterwards.
+ */
+static gboolean
+codec_info_read(CodecInfo* info, GInputStream* istream, GError** error)
+{
+    guint8 preamble[CODEC_PREAMBLE_SIZE];
+    guint8 footer[CODEC_FOOTER_SIZE];
+    gsize nread = 0;
+    gsize record_size;
+
+    memset(info, 0, sizeof(CodecInfo));
+
+    if (!G_IS_SEEKABLE(istream) || !g_seekable_can_seek(G_SEEKABLE(istream))) {
+        g_set_error(
+                error,
+                EDF_CODEC_ERROR,
+                EDF_CODEC_ERROR_FAILED,
+                "A compressed container can only be read from a seekable stream"
+                );
+        return FALSE;
+    }
+
+    if (!g_input_stream_read_all(
+                istream, preamble, sizeof(preamble), &nread, NULL, error
+                )
+       )
+        return FALSE;
+
+    if (nread != sizeof(preamble) || !edf_codec_has_magic(preamble, nread))
+        goto invalid;
+
+    if (!g_seekable_seek(G_SEEKABLE(istream), 0, G_SEEK_END, NULL, error))
+        goto fail;
+    info->container_size = g_seekable_tell(G_SEEKABLE(istream));
+    if (!g_seekable_seek(G_SEEKABLE(istream), sizeof(preamble), G_SEEK_SET, NULL, error))
+        goto fail;
+
+    info->header_size = get_u32(&preamble[EDF_CODEC_MAGIC_SIZE]);
+    record_size = get_u32(&preamble[EDF_CODEC_MAGIC_SIZE + sizeof(guint32)]);
+    if (info->header_size < EDF_BASE_HEADER_SIZE)
+        goto invalid;
+
+    if (info->container_size < CODEC_PREAMBLE_SIZE + CODEC_FOOTER_SIZE ||
+        info->header_size >
+        info->container_size - CODEC_PREAMBLE_SIZE - CODEC_FOOTER_SIZE) {
+        g_set_error(
+                error,
+                G_IO_ERROR,
+                G_IO_ERROR_INVALID_DATA,
+                "The header of %" G_GSIZE_FORMAT " bytes exceeds the compressed container",
+                info->header_size
+                );
+        goto fail;
+    }
+
+    info->header_bytes = g_malloc(info->header_size);
+    if (!g_input_stream_read_all(
+                istream, info->header_bytes, info->header_size, &nread, NULL, error
+                )
+       )
+        goto fail;
+
+    if (nread != info->header_size)
+        goto invalid;
+
+    info->header = codec_parse_header(info->header_bytes, info->header_size, error);
+    if (!info->header)
+        goto fail;
+
+    codec_layout_init(&info->layout, info->header);
+    if (info->layout.record_size != record_size)
+        goto invalid;
+
+    if (!g_seekable_seek(
+                G_SEEKABLE(istream), -(goffset) sizeof(footer), G_SEEK_END, NULL, error
+                )
+       )
+        goto fail;
+
+    if (!g_input_stream_read_all(
+                istream, footer, sizeof(footer), &nread, NULL, error
+                )
+       )
+        goto fail;
+
+    if (nread != sizeof(footer) ||
+        !edf_codec_has_magic(&footer[4 * sizeof(guint64)], EDF_CODEC_MAGIC_SIZE))
+        goto invalid;
+
+    info->num_records = get_u64(&footer[0]);
+    info->index_offset = get_u64(&footer[8]);
+    info->trailer_offset = get_u64(&footer[16]);
+    info->trailer_size = get_u64(&footer[24]);
+
+    if (!codec_info_validate(info, error))
+        goto fail;
+
+    if (!g_seekable_seek(
+                G_SEEKABLE(istream),
+                CODEC_PREAMBLE_SIZE + info->header_size,
+                G_SEEK_SET,
+                NULL,
+                error
+                )
+       )
+        goto fail;
+
+    return TRUE;
+
+invalid:
+    g_set_error(
+            error,
+            EDF_CODEC_ERROR,
+            EDF_CODEC_ERROR_FORMAT,
+            "The data is not a valid compressed edf container"
+            );
+fail:
+    codec_info_clear(info);
+    return FALSE;
+}
+
+/* ************ the decompressing input stream ************ */
+
+#define EDF_TYPE_CODEC_INPUT_STREAM edf_codec_input_stream_get_type()
+G_DECLARE_FINAL_TYPE(
+        EdfCodecInputStream,
+        edf_codec_input_stream,
+        EDF,
+        CODEC_INPUT_STREAM,
+        GInputStream
+        )
+
+struct _EdfCodecInputStream {
+    GInputStream    parent_instance;
+
+    GInputStream   *base;
+    CodecInfo       info;
+    guint64         next_record;
+    gboolean        trailer_done;
+
+    GByteArray     *block;
+    GByteArray     *out;    // original bytes that are not yet read
+    gsize           out_pos;
+};
+
+G_DEFINE_TYPE(EdfCodecInputStream, edf_codec_input_stream, G_TYPE_INPUT_STREAM)
+
+static void
+edf_codec_input_stream_init(EdfCodecInputStream* self)
+{
+    self->block = g_byte_array_new();
+    self->out = g_byte_array_new();
+}
+
+static void
+edf_codec_input_stream_finalize(GObject* object)
+{
+    EdfCodecInputStream* self = EDF_CODEC_INPUT_STREAM(object);
+
+    g_clear_object(&self->base);
+    codec_info_clear(&self->info);
+    g_byte_array_unref(self->block);
+    g_byte_array_unref(self->out);
+
+    G_OBJECT_CLASS(edf_codec_input_stream_parent_class)->finalize(object);
+}
+
+/*
+ * Puts the next part of the original file in self->out, returns FALSE on
+ * error. At the end of the file self->out remains empty.
+ */
+static gboolean
+codec_input_stream_fill(EdfCodecInputStream* self, GError** error)
+{
+    CodecInfo* info = &self->info;
+    gsize nread = 0;
+
+    g_byte_array_set_size(self->out, 0);
+    self->out_pos = 0;
+
+    if (self->next_record < info->num_records) {
+        if (!codec_read_block(self->base, info->trailer_offset, self->block, error))
+            return FALSE;
+
+        g_byte_array_set_size(self->out, info->layout.record_size);
+        if (!codec_decode_block(
+                    &info->layout,
+                    self->block->data,
+                    self->block->len,
+                    self->out->data,
+                    error
+                    )
+           )
+            return FALSE;
+        self->next_record++;
+    }
+    else if (!self->trailer_done) {
+        self->trailer_done = TRUE;
+        if (info->trailer_size == 0)
+            return TRUE;
+
+        g_byte_array_set_size(self->out, info->trailer_size);
+        if (!g_input_stream_read_all(
+                    self->base, self->out->data, info->trailer_size, &nread, NULL, error
+                    )
+           )
+            return FALSE;
+
+        if (nread != info->trailer_size) {
+            g_set_error(
+                    error,
+                    EDF_CODEC_ERROR,
+                    EDF_CODEC_ERROR_FORMAT,
+                    "The compressed data is truncated"
+                    );
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+static gssize
+edf_codec_input_stream_read(
+        GInputStream   *stream,
+        void           *buffer,
+        gsize           count,
+        GCancellable   *cancellable,
+        GError        **error
+        )
+{
+    EdfCodecInputStream* self = EDF_CODEC_INPUT_STREAM(stream);
+    (void) cancellable;
+
+    if (self->out_pos == self->out->len) {
+        if (!codec_input_stream_fill(self, error))
+            return -1;
+        if (self->out->len == 0)
+            return 0;
+    }
+
+    gsize n = MIN(count, self->out->len - self->out_pos);
+    memcpy(buffer, &self->out->data[self->out_pos], n);
+    self->out_pos += n;
+    return n;
+}
+
+static gboolean
+edf_codec_input_stream_close(
+        GInputStream   *stream,
+        GCancellable   *cancellable,
+        GError        **error
+        )
+{
+    EdfCodecInputStream* self = EDF_CODEC_INPUT_STREAM(stream);
+    return g_input_stream_close(self->base, cancellable, error);
+}
+
+static void
+edf_codec_input_stream_class_init(EdfCodecInputStreamClass* klass)
+{
+    GObjectClass* object_class = G_OBJECT_CLASS(klass);
+    GInputStreamClass* stream_class = G_INPUT_STREAM_CLASS(klass);
+
+    object_class->finalize = edf_codec_input_stream_finalize;
+    stream_class->read_fn = edf_codec_input_stream_read;
+    stream_class->close_fn = edf_codec_input_stream_close;
+}
+
+GInputStream*
+edf_codec_input_stream_new(GInputStream* base, GError** error)
+{
+    g_return_val_if_fail(G_IS_INPUT_STREAM(base), NULL);
+    g_return_val_if_fail(error != NULL && *error == NULL, NULL);
+
+    EdfCodecInputStream* self = g_object_new(EDF_TYPE_CODEC_INPUT_STREAM, NULL);
+    self->base = g_object_ref(base);
+
+    if (!codec_info_read(&self->info, base, error)) {
+        g_object_unref(self);
+        return NULL;
+    }
+
+    // The header is the first part of the original file
+    g_byte_array_append(self->out, self->info.header_bytes, self->info.header_size);
+    return G_INPUT_STREAM(self);
+}
+
+/* ************ the compressing output stream ************ */
+
+#define EDF_TYPE_CODEC_OUTPUT_STREAM edf_codec_output_stream_get_type()
+G_DECLARE_FINAL_TYPE(
+        EdfCodecOutputStream,
+        edf_codec_output_stream,
+        EDF,
+        CODEC_OUTPUT_STREAM,
+        GOutputStream
+        )
+
+struct _EdfCodecOutputStream {
+    GOutputStream   parent_instance;
+
+    GOutputStream  *base;
+    GByteArray     *pending;    // written bytes that are not yet compressed
+    gsize           header_size;
+    EdfHeader      *header;
+    CodecLayout     layout;
+
+    GByteArray     *block;
+    GArray         *index;
+    guint64         offset;     // the number of bytes written to base
+};
+
+G_DEFINE_TYPE(EdfCodecOutputStream, edf_codec_output_stream, G_TYPE_OUTPUT_STREAM)
+
+static void
+edf_codec_output_stream_init(EdfCodecOutputStream* self)
+{
+    self->pending = g_byte_array_new();
+    self->block = g_byte_array_new();
+    self->index = g_array_new(FALSE, FALSE, sizeof(guint64));
+}
+
+static void
+edf_codec_output_stream_finalize(GObject* object)
+{
+    EdfCodecOutputStream* self = EDF_CODEC_OUTPUT_STREAM(object);
+
+    g_clear_object(&self->base);
+    g_clear_object(&self->header);
+    codec_layout_clear(&self->layout);
+    g_byte_array_unref(self->pending);
+    g_byte_array_unref(self->block);
+    g_array_unref(self->index);
+
+    G_OBJECT_CLASS(edf_codec_output_stream_parent_class)->finalize(object);
+}
+
+static gboolean
+codec_output_stream_put(
+        EdfCodecOutputStream   *self,
+        const void             *bytes,
+        gsize                   size,
+        GError                **error
+        )
+{
+    if (!g_output_stream_write_all(self->base, bytes, size, NULL, NULL, error))
+        return FALSE;
+    self->offset += size;
+    return TRUE;
+}
+
+/*
+ * Writes the preamble and the header once the complete header is pending.
+ */
+static gboolean
+codec_output_stream_write_header(EdfCodecOutputStream* self, GError** error)
+{
+    guint8 preamble[CODEC_PREAMBLE_SIZE];
+
+    if (self->header_size == 0) {
+        if (self->pending->len < EDF_BASE_HEADER_SIZE)
+            return TRUE;
+
+        gchar field[EDF_NUM_SIGNALS_SZ + 1] = {0,};
+        memcpy(field,
+               &self->pending->data[EDF_BASE_HEADER_SIZE - EDF_NUM_SIGNALS_SZ],
+               EDF_NUM_SIGNALS_SZ
+               );
+        self->header_size = edf_compute_header_size(
+                (guint) g_ascii_strtoull(field, NULL, 10)
+                );
+    }
+
+    if (self->pending->len < self->header_size)
+        return TRUE;
+
+    self->header = codec_parse_header(
+            self->pending->data, self->header_size, error
+            );
+    if (!self->header)
+        return FALSE;
+    codec_layout_init(&self->layout, self->header);
+
+    memcpy(preamble, EDF_CODEC_MAGIC, EDF_CODEC_MAGIC_SIZE);
+    put_u32(&preamble[EDF_CODEC_MAGIC_SIZE], self->header_size);
+    put_u32(&preamble[EDF_CODEC_MAGIC_SIZE + sizeof(guint32)], self->layout.record_size);
+
+    if (!codec_output_stream_put(self, preamble, sizeof(preamble), error))
+        return FALSE;
+    if (!codec_output_stream_put(self, self->pending->data, self->header_size, error))
+        return FALSE;
+
+    g_byte_array_remove_range(self->pending, 0, self->header_size);
+    return TRUE;
+}
+
+static gssize
+edf_codec_output_stream_write(
+        GOutputStream  *stream,
+        const void     *buffer,
+        gsize           count,
+        GCancellable   *cancellable,
+        GError        **error
+        )
+{
+    EdfCodecOutputStream* self = EDF_CODEC_OUTPUT_STREAM(stream);
+    gsize record_size, consumed = 0;
+    (void) cancellable;
+
+    g_byte_array_append(self->pending, buffer, count);
+
+    if (!self->header) {
+        if (!codec_output_stream_write_header(self, error))
+            return -1;
+        if (!self->header)
+            return count;
+    }
+
+    record_size = self->layout.record_size;
+    while (record_size > 0 && self->pending->len - consumed >= record_size) {
+        g_byte_array_set_size(self->block, sizeof(guint32));
+        for (guint signal = 0; signal < self->layout.num_signals; signal++)
+            codec_encode_chunk(
+                    &self->layout,
+                    signal,
+                    &self->pending->data[consumed],
+                    self->block
+                    );
+        put_u32(self->block->data, self->block->len - sizeof(guint32));
+
+        g_array_append_val(self->index, self->offset);
+        if (!codec_output_stream_put(self, self->block->data, self->block->len, error))
+            return -1;
+        consumed += record_size;
+    }
+    g_byte_array_remove_range(self->pending, 0, consumed);
+
+    return count;
+}
+
+static gboolean
+edf_codec_output_stream_close(
+        GOutputStream  *stream,
+        GCancellable   *cancellable,
+        GError        **error
+        )
+{
+    EdfCodecOutputStream* self = EDF_CODEC_OUTPUT_STREAM(stream);
+    guint8 footer[CODEC_FOOTER_SIZE];
+    guint64 trailer_offset = self->offset;
+    guint64 index_offset;
+    gboolean result = FALSE;
+
+    if (!self->header) {
+        g_set_error(
+                error,
+                EDF_CODEC_ERROR,
+                EDF_CODEC_ERROR_FORMAT,
+                "The stream was closed before a complete header was written"
+                );
+        goto close_base;
+    }
+
+    if (!codec_output_stream_put(self, self->pending->data, self->pending->len, error))
+        goto close_base;
+
+    index_offset = self->offset;
+    for (guint i = 0; i < self->index->len; i++) {
+        guint8 entry[sizeof(guint64)];
+        put_u64(entry, g_array_index(self->index, guint64, i));
+        if (!codec_output_stream_put(self, entry, sizeof(entry), error))
+            goto close_base;
+    }
+
+    put_u64(&footer[0], self->index->len);
+    put_u64(&footer[8], index_offset);
+    put_u64(&footer[16], trailer_offset);
+    put_u64(&footer[24], self->pending->len);
+    memcpy(&footer[32], EDF_CODEC_MAGIC, EDF_CODEC_MAGIC_SIZE);
+    if (!codec_output_stream_put(self, footer, sizeof(footer), error))
+        goto close_base;
+
+    result = TRUE;
+
+close_base:
+    if (result)
+        return g_output_stream_close(self->base, cancellable, error);
+    g_output_stream_close(self->base, cancellable, NULL);
+    return FALSE;
+}
+
+static void
+edf_codec_output_stream_class_init(EdfCodecOutputStreamClass* klass)
+{
+    GObjectClass* object_class = G_OBJECT_CLASS(klass);
+    GOutputStreamClass* stream_class = G_OUTPUT_STREAM_CLASS(klass);
+
+    object_class->finalize = edf_codec_output_stream_finalize;
+    stream_class->write_fn = edf_codec_output_stream_write;
+    stream_class->close_fn = edf_codec_output_stream_close;
+}
+
+GOutputStream*
+edf_codec_output_stream_new(GOutputStream* base)
+{
+    g_return_val_if_fail(G_IS_OUTPUT_STREAM(base), NULL);
+
+    EdfCodecOutputStream* self = g_object_new(EDF_TYPE_CODEC_OUTPUT_STREAM, NULL);
+    self->base = g_object_ref(base);
+    return G_OUTPUT_STREAM(self);
+}
+
+/* ************ private functions ************ */
+
+gboolean
+edf_codec_has_magic(const guint8* bytes, gsize size)
+{
+    return size >= EDF_CODEC_MAGIC_SIZE &&
+           memcmp(bytes, EDF_CODEC_MAGIC, EDF_CODEC_MAGIC_SIZE) == 0;
+}
+
+gboolean
+edf_codec_is_codec_path(const gchar* path)
+{
+    return path && (g_str_has_suffix(path, EDF_CODEC_EDF_SUFFIX) ||
+                    g_str_has_suffix(path, EDF_CODEC_BDF_SUFFIX));
+}
+
+/* ************ public functions ************ */
+
+static gboolean
+codec_splice(GInputStream* istream, GOutputStream* ostream, GError** error)
+{
+    gssize n = g_output_stream_splice(
+            ostream,
+            istream,
+            G_OUTPUT_STREAM_SPLICE_CLOSE_SOURCE | G_OUTPUT_STREAM_SPLICE_CLOSE_TARGET,
+            NULL,
+            error
+            );
+    return n >= 0;
+}
+
+/**
+ * edf_codec_compress:
+ * @source_path: the path of an edf or bdf file
+ * @dest_path: the path of the compressed container
+ * @error:(out): An error is returned here when the file cannot be compressed
+ *
+ * Compresses the file at @source_path into a container at @dest_path. The
+ * source may be gzip compressed, @dest_path is replaced when it exists.
+ *
+ * Returns: TRUE when the file is compressed.
+ */
+gboolean
+edf_codec_compress(const gchar* source_path, const gchar* dest_path, GError** error)
+{
+    g_return_val_if_fail(source_path != NULL && dest_path != NULL, FALSE);
+    g_return_val_if_fail(error != NULL && *error == NULL, FALSE);
+
+    GFile* source = g_file_new_for_path(source_path);
+    GFile* dest = g_file_new_for_path(dest_path);
+    GInputStream* istream = NULL;
+    GFileOutputStream* ofstream = NULL;
+    GOutputStream* ostream = NULL;
+    gboolean result = FALSE;
+
+    istream = edf_file_open_input_stream(source, error);
+    if (!istream)
+        goto done;
+
+    ofstream = g_file_replace(dest, NULL, FALSE, G_FILE_CREATE_NONE, NULL, error);
+    if (!ofstream)
+        goto done;
+
+    ostream = edf_codec_output_stream_new(G_OUTPUT_STREAM(ofstream));
+    result = codec_splice(istream, ostream, error);
+
+done:
+    g_clear_object(&ostream);
+    g_clear_object(&ofstream);
+    g_clear_object(&istream);
+    g_object_unref(dest);
+    g_object_unref(source);
+    return result;
+}
+
+/**
+ * edf_codec_decompress:
+ * @source_path: the path of a compressed container
+ * @dest_path: the path of the edf or bdf file
+ * @error:(out): An error is returned here when the file cannot be
+ *               decompressed
+ *
+ * Restores the original file of the container at @source_path to
+ * @dest_path, @dest_path is replaced when it exists.
+ *
+ * Returns: TRUE when the file is decompressed.
+ */
+gboolean
+edf_codec_decompress(const gchar* source_path, const gchar* dest_path, GError** error)
+{
+    g_return_val_if_fail(source_path != NULL && dest_path != NULL, FALSE);
+    g_return_val_if_fail(error != NULL && *error == NULL, FALSE);
+
+    GFile* source = g_file_new_for_path(source_path);
+    GFile* dest = g_file_new_for_path(dest_path);
+    GInputStream* istream = NULL;
+    GOutputStream* ostream = NULL;
+    gboolean result = FALSE;
+
+    GFileInputStream* ifstream = g_file_read(source, NULL, error);
+    if (!ifstream)
+        goto done;
+
+    istream = edf_codec_input_stream_new(G_INPUT_STREAM(ifstream), error);
+    g_object_unref(ifstream);
+    if (!istream)
+        goto done;
+
+    // The destination may be gzip compressed by its name
+    ostream = edf_file_open_output_stream(dest, TRUE, error);
+    if (!ostream)
+        goto done;
+
+    result = codec_splice(istream, ostream, error);
+
+done:
+    g_clear_object(&ostream);
+    g_clear_object(&istream);
+    g_object_unref(dest);
+    g_object_unref(source);
+    return result;
+}
+
+/* ************ random access ************ */
+
+typedef struct _EdfCodecReaderPrivate {
+    GInputStream   *istream;
+    CodecInfo       info;
+    guint64        *index;
+
+    /* the last read block */
+    GByteArray     *block;
+    gint64          block_record;
+} EdfCodecReaderPrivate;
+
+G_DEFINE_TYPE_WITH_PRIVATE(EdfCodecReader, edf_codec_reader, G_TYPE_OBJECT)
+
+static void
+edf_codec_reader_init(EdfCodecReader* self)
+{
+    EdfCodecReaderPrivate* priv = edf_codec_reader_get_instance_private(self);
+    priv->block = g_byte_array_new();
+    priv->block_record = -1;
+}
+
+static void
+edf_codec_reader_finalize(GObject* object)
+{
+    EdfCodecReaderPrivate* priv = edf_codec_reader_get_instance_private(
+            EDF_CODEC_READER(object)
+            );
+
+    g_clear_object(&priv->istream);
+    codec_info_clear(&priv->info);
+    g_free(priv->index);
+    g_byte_array_unref(priv->block);
+
+    G_OBJECT_CLASS(edf_codec_reader_parent_class)->finalize(object);
+}
+
+static void
+edf_codec_reader_class_init(EdfCodecReaderClass* klass)
+{
+    GObjectClass* object_class = G_OBJECT_CLASS(klass);
+    object_class->finalize = edf_codec_reader_finalize;
+}
+
+/**
+ * edf_codec_reader_new_for_path:(constructor)
+ * @path: the path of a compressed container
+ * @error:(out): An error is returned here when the container cannot be read
+ *
+ * Opens a container for random access. Only the header and the index of the
+ * records are read.
+ *
+ * Returns:(transfer full): a new #EdfCodecReader or NULL
+ */
+EdfCodecReader*
+edf_codec_reader_new_for_path(const gchar* path, GError** error)
+{
+    g_return_val_if_fail(path != NULL, NULL);
+    g_return_val_if_fail(error != NULL && *error == NULL, NULL);
+
+    GFile* file = g_file_new_for_path(path);
+    GFileInputStream* ifstream = g_file_read(file, NULL, error);
+    g_object_unref(file);
+    if (!ifstream)
+        return NULL;
+
+    EdfCodecReader* reader = g_object_new(EDF_TYPE_CODEC_READER, NULL);
+    EdfCodecReaderPrivate* priv = edf_codec_reader_get_instance_private(reader);
+    CodecInfo* info = &priv->info;
+    gsize nread = 0, index_size;
+
+    priv->istream = G_INPUT_STREAM(ifstream);
+    if (!codec_info_read(info, priv->istream, error))
+        goto fail;
+
+    // codec_info_read() checked that the index fits in the container
+    if (info->num_records > G_MAXSIZE / sizeof(guint64))
+        goto invalid;
+
+    index_size = info->num_records * sizeof(guint64);
+    priv->index = g_malloc(index_size);
+
+    if (!g_seekable_seek(
+                G_SEEKABLE(priv->istream), info->index_offset, G_SEEK_SET, NULL, error
+                )
+       )
+        goto fail;
+
+    if (!g_input_stream_read_all(
+                priv->istream, priv->index, index_size, &nread, NULL, error
+                )
+       )
+        goto fail;
+
+    if (nread != index_size)
+        goto invalid;
+
+    for (guint64 i = 0; i < info->num_records; i++) {
+        priv->index[i] = get_u64((const guint8*) &priv->index[i]);
+        if (priv->index[i] < CODEC_PREAMBLE_SIZE + info->header_size ||
+            priv->index[i] >= info->trailer_offset) {
+            g_set_error(
+                    error,
+                    G_IO_ERROR,
+                    G_IO_ERROR_INVALID_DATA,
+                    "The offset of record %" G_GUINT64_FORMAT " in '%s' is "
+                    "outside of its records",
+                    i,
+                    path
+                    );
+            goto fail;
+        }
+    }
+
+    return reader;
+
+invalid:
+    g_set_error(
+            error,
+            EDF_CODEC_ERROR,
+            EDF_CODEC_ERROR_FORMAT,
+            "The index of '%s' is invalid",
+            path
+            );
+fail:
+    g_object_unref(reader);
+    return NULL;
+}
+
+/**
+ * edf_codec_reader_get_header:
+ * @reader: the #EdfCodecReader
+ *
+ * Returns:(transfer none): the header of the compressed file.
+ */
+EdfHeader*
+edf_codec_reader_get_header(EdfCodecReader* reader)
+{
+    g_return_val_if_fail(EDF_IS_CODEC_READER(reader), NULL);
+    EdfCodecReaderPrivate* priv = edf_codec_reader_get_instance_private(reader);
+    return priv->info.header;
+}
+
+/**
+ * edf_codec_reader_get_num_records:
+ * @reader: the #EdfCodecReader
+ *
+ * Returns: the number of complete records in the container.
+ */
+guint64
+edf_codec_reader_get_num_records(EdfCodecReader* reader)
+{
+    g_return_val_if_fail(EDF_IS_CODEC_READER(reader), 0);
+    EdfCodecReaderPrivate* priv = edf_codec_reader_get_instance_private(reader);
+    return priv->info.num_records;
+}
+
+static gboolean
+codec_reader_load_block(EdfCodecReader* reader, guint64 nrec, GError** error)
+{
+    EdfCodecReaderPrivate* priv = edf_codec_reader_get_instance_private(reader);
+
+    if (priv->block_record == (gint64) nrec)
+        return TRUE;
+
+    priv->block_record = -1;
+    if (!g_seekable_seek(
+                G_SEEKABLE(priv->istream), priv->index[nrec], G_SEEK_SET, NULL, error
+                )
+       )
+        return FALSE;
+
+    if (!codec_read_block(priv->istream, priv->info.trailer_offset, priv->block, error))
+        return FALSE;
+
+    priv->block_record = nrec;
+    return TRUE;
+}
+
+/**
+ * edf_codec_reader_read_range:
+ * @reader: the #EdfCodecReader
+ * @signal: the index of the signal
+ * @first_sample: the index of the first sample to read
+ * @samples:(array length=num_samples)(out caller-allocates): the output
+ * @num_samples: the number of samples to read
+ * @error:(out): An error is returned here when the samples cannot be read
+ *
+ * Reads the digital values of a range of samples of one signal. Only the
+ * records that contain the range are read and only the chunks of @signal
+ * are decompressed.
+ *
+ * Returns: TRUE when the samples are read.
+ */
+gboolean
+edf_codec_reader_read_range(
+        EdfCodecReader *reader,
+        guint           signal,
+        guint64         first_sample,
+        gint32         *samples,
+        gsize           num_samples,
+        GError        **error
+        )
+{
+    g_return_val_if_fail(EDF_IS_CODEC_READER(reader), FALSE);
+    g_return_val_if_fail(samples != NULL || num_samples == 0, FALSE);
+    g_return_val_if_fail(error != NULL && *error == NULL, FALSE);
+
+    EdfCodecReaderPrivate* priv = edf_codec_reader_get_instance_private(reader);
+    CodecLayout* layout = &priv->info.layout;
+
+    if (signal >= layout->num_signals) {
+        g_set_error(
+                error,
+                EDF_CODEC_ERROR,
+                EDF_CODEC_ERROR_RANGE,
+                "Signal %u doesn't exist, the file has %u signals",
+                signal,
+                layout->num_signals
+                );
+        return FALSE;
+    }
+
+    guint64 ns = layout->ns[signal];
+    guint64 total = priv->info.num_records * ns;
+    if (first_sample > total || num_samples > total - first_sample) {
+        g_set_error(
+                error,
+                EDF_CODEC_ERROR,
+                EDF_CODEC_ERROR_RANGE,
+                "The range [%" G_GUINT64_FORMAT ", %" G_GUINT64_FORMAT
+                ") exceeds the %" G_GUINT64_FORMAT " samples of signal %u",
+                first_sample,
+                first_sample + num_samples,
+                total,
+                signal
+                );
+        return FALSE;
+    }
+
+    guint64 pos = first_sample, end = first_sample + num_samples;
+    while (pos < end) {
+        guint64 nrec = pos / ns;
+        guint64 rec_start = nrec * ns;
+        gsize n = MIN(end, rec_start + ns) - pos;
+
+        if (!codec_reader_load_block(reader, nrec, error))
+            return FALSE;
+
+        const guint8* chunk = priv->block->data;
+        gsize avail = priv->block->len;
+        gsize size = 0;
+        for (guint i = 0; i <= signal; i++) {
+            chunk += size;
+            avail -= size;
+            size = codec_chunk_size(layout, i, chunk, avail);
+            if (size == 0) {
+                g_set_error(
+                        error,
+                        EDF_CODEC_ERROR,
+                        EDF_CODEC_ERROR_FORMAT,
+                        "Invalid compressed data in record %" G_GUINT64_FORMAT,
+                        nrec
+                        );
+                return FALSE;
+            }
+        }
+
+        codec_decode_chunk(layout, signal, chunk);
+        memcpy(&samples[pos - first_sample],
+               &layout->samples[pos - rec_start],
+               n * sizeof(gint32)
+               );
+        pos += n;
+    }
+
+    return TRUE;
+}
@@ -0,0 +1,852 @@
+
+#include "edf-epocher.h"
+#include "edf-header-priv.h"
+#include "edf-sample-priv.h"
+#include "edf-signal.h"
+
+#include <gio/gio.h>
+#include <math.h>
+
+/**
+ * SECTION:edf-epocher
+ * @short_description: cuts windows around events out of a file on disk
+ * @see_also: #EdfTriggerIndex, #EdfFile
+ * @include: gedf.h
+ *
+ * Event related analysis cuts a fixed window around every event out of a
+ * number of channels. #EdfEpocher does this directly on a file on disk.
+ * Only the header of the file is read when the epocher is created, for
+ * every window only the records that it overlaps are read. The samples are
+ * converted to physical units and written into one contiguous float tensor
+ * of trials × channels × samples provided by the caller, optionally with the
+ * mean of a baseline interval subtracted from each trial.
+ *
+ * The event positions are sample indices at the sample rate of the
+ * selected channels, e.g. the samples of the #EdfTriggerEvent s found by an
+ * #EdfTriggerIndex. Hence all selected channels must have the same sample
+ * rate. Samples of a window that fall before the start or after the end of
+ * the recording are set to NAN.
+ *
+ * The records are accessed randomly, hence the file may not be compressed.
+ *
+ * An #EdfEpocher keeps the file open and caches the last record it read,
+ * so it should not be used from multiple threads at the same time.
+ */
+
+G_DEFINE_QUARK(edf_epocher_error_quark, edf_epocher_error)
+
+typedef struct _EdfEpocherChannel {
+    guint       index;
+    gsize       offset;     // offset of the samples within the span
+    gdouble     gain;
+    gdouble     phys_offset;
+} EdfEpocherChannel;
+
+typedef struct _EdfEpocherPrivate {
+    GInputStream   *istream;
+    EdfHeader      *header;
+    goffset         data_offset;
+    gsize           record_size;
+    gint64          num_records;
+
+    /* the selected channels */
+    GArray         *channels;
+    guint           ns;
+    guint           sample_size;
+
+    /* the window around an event */
+    guint           pre_samples;
+    guint           post_samples;
+    gboolean        baseline_correction;
+    gint64          baseline_start;
+    gint64          baseline_end;
+
+    /*
+     * The bytes of the last read record, only the part between the first
+     * and the last selected channel is read.
+     */
+    guint8         *span;
+    gsize           span_start;
+    gsize           span_size;
+    gint64          span_record;
+    gint32         *decoded;
+} EdfEpocherPrivate;
+
+G_DEFINE_TYPE_WITH_PRIVATE(EdfEpocher, edf_epocher, G_TYPE_OBJECT)
+
+typedef enum {
+    PROP_PRE_SAMPLES = 1,
+    PROP_POST_SAMPLES,
+    PROP_BASELINE_CORRECTION,
+    PROP_BASELINE_START,
+    PROP_BASELINE_END,
+    N_PROPERTIES
+} EdfEpocherProperty;
+
+static void
+edf_epocher_init(EdfEpocher* self)
+{
+    EdfEpocherPrivate* priv = edf_epocher_get_instance_private(self);
+
+    priv->channels = g_array_new(FALSE, FALSE, sizeof(EdfEpocherChannel));
+    priv->span_record = -1;
+}
+
+static void
+edf_epocher_dispose(GObject* gobject)
+{
+    EdfEpocherPrivate* priv = edf_epocher_get_instance_private(
+            EDF_EPOCHER(gobject)
+            );
+
+    g_clear_object(&priv->istream);
+    g_clear_object(&priv->header);
+
+    G_OBJECT_CLASS(edf_epocher_parent_class)->dispose(gobject);
+}
+
+static void
+edf_epocher_finalize(GObject* gobject)
+{
+    EdfEpocherPrivate* priv = edf_epocher_get_instance_private(
+            EDF_EPOCHER(gobject)
+            );
+
+    g_array_unref(priv->channels);
+    g_free(priv->span);
+    g_free(priv->decoded);
+
+    G_OBJECT_CLASS(edf_epocher_parent_class)->finalize(gobject);
+}
+
+static void
+edf_epocher_set_property(
+        GObject        *object,
+        guint32         propid,
+        const GValue   *value,
+        GParamSpec     *spec
+        )
+{
+    EdfEpocher* self = EDF_EPOCHER(object);
+    EdfEpocherPrivate* priv = edf_epocher_get_instance_private(self);
+
+    switch ((EdfEpocherProperty) propid) {
+        case PROP_PRE_SAMPLES:
+            priv->pre_samples = g_value_get_uint(value);
+            break;
+        case PROP_POST_SAMPLES:
+            priv->post_samples = g_value_get_uint(value);
+            break;
+        case PROP_BASELINE_CORRECTION:
+            priv->baseline_correction = g_value_get_boolean(value);
+            break;
+        case PROP_BASELINE_START:
+            priv->baseline_start = g_value_get_int64(value);
+            break;
+        case PROP_BASELINE_END:
+            priv->baseline_end = g_value_get_int64(value);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID(object, propid, spec);
+    }
+}
+
+static void
+edf_epocher_get_property(
+        GObject        *object,
+        guint32         propid,
+        GValue         *value,
+        GParamSpec     *spec
+        )
+{
+    EdfEpocher* self = EDF_EPOCHER(object);
+    EdfEpocherPrivate* priv = edf_epocher_get_instance_private(self);
+
+    switch ((EdfEpocherProperty) propid) {
+        case PROP_PRE_SAMPLES:
+            g_value_set_uint(value, priv->pre_samples);
+            break;
+        case PROP_POST_SAMPLES:
+            g_value_set_uint(value, priv->post_samples);
+            break;
+        case PROP_BASELINE_CORRECTION:
+            g_value_set_boolean(value, priv->baseline_correction);
+            break;
+        case PROP_BASELINE_START:
+            g_value_set_int64(value, priv->baseline_start);
+            break;
+        case PROP_BASELINE_END:
+            g_value_set_int64(value, priv->baseline_end);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID(object, propid, spec);
+    }
+}
+
+static GParamSpec* edf_epocher_properties[N_PROPERTIES] = {NULL,};
+
+static void
+edf_epocher_class_init(EdfEpocherClass* klass)
+{
+    GObjectClass* object_class = G_OBJECT_CLASS(klass);
+
+    object_class->set_property = edf_epocher_set_property;
+    object_class->get_property = edf_epocher_get_property;
+    object_class->dispose = edf_epocher_dispose;
+    object_class->finalize = edf_epocher_finalize;
+
+    /**
+     * EdfEpocher:pre-samples:
+     *
+     * The number of samples of a window before the event.
+     */
+    edf_epocher_properties[PROP_PRE_SAMPLES] = g_param_spec_uint(
+            "pre-samples",
+            "Pre samples",
+            "The number of samples before the event",
+            0,
+            G_MAXINT,
+            0,
+            G_PARAM_READWRITE
+            );
+
+    /**
+     * EdfEpocher:post-samples:
+     *
+     * The number of samples of a window from the event onward, the sample
+     * of the event itself is included.
+     */
+    edf_epocher_properties[PROP_POST_SAMPLES] = g_param_spec_uint(
+            "post-samples",
+            "Post samples",
+            "The number of samples from the event onward",
+            0,
+            G_MAXINT,
+            0,
+            G_PARAM_READWRITE
+            );
+
+    /**
+     * EdfEpocher:baseline-correction:
+     *
+     * Whether the mean of the baseline interval is subtracted from each
+     * channel of each trial.
+     */
+    edf_epocher_properties[PROP_BASELINE_CORRECTION] = g_param_spec_boolean(
+            "baseline-correction",
+            "Baseline correction",
+            "Subtract the mean of the baseline interval",
+            FALSE,
+            G_PARAM_READWRITE
+            );
+
+    /**
+     * EdfEpocher:baseline-start:
+     *
+     * The first sample of the baseline interval relative to the event,
+     * typically a negative number.
+     */
+    edf_epocher_properties[PROP_BASELINE_START] = g_param_spec_int64(
+            "baseline-start",
+            "Baseline start",
+            "The start of the baseline relative to the event",
+            G_MININT,
+            G_MAXINT,
+            0,
+            G_PARAM_READWRITE
+            );
+
+    /**
+     * EdfEpocher:baseline-end:
+     *
+     * The end of the baseline interval relative to the event, this sample
+     * is not part of the baseline.
+     */
+    edf_epocher_properties[PROP_BASELINE_END] = g_param_spec_int64(
+            "baseline-end",
+            "Baseline end",
+            "The end of the baseline relative to the event",
+            G_MININT,
+            G_MAXINT,
+            0,
+            G_PARAM_READWRITE
+            );
+
+    g_object_class_install_properties(
+            object_class, N_PROPERTIES, edf_epocher_properties
+            );
+}
+
+/* ************* utility functions ************** */
+
+static gboolean
+epocher_select(
+        EdfEpocher     *epocher,
+        const guint    *channels,
+        guint           num_channels,
+        GError        **error
+        )
+{
+    EdfEpocherPrivate* priv = edf_epocher_get_instance_private(epocher);
+    GPtrArray* signals = edf_header_get_signals(priv->header);
+    gsize span_start = G_MAXSIZE, span_end = 0;
+    guint ns = 0, sample_size = 0;
+
+    if (num_channels == 0) {
+        g_set_error(
+                error,
+                EDF_EPOCHER_ERROR,
+                EDF_EPOCHER_ERROR_CHANNEL,
+                "No channels selected"
+                );
+        return FALSE;
+    }
+
+    GArray* selected = g_array_sized_new(
+            FALSE, FALSE, sizeof(EdfEpocherChannel), num_channels
+            );
+
+    for (guint i = 0; i < num_channels; i++) {
+        if (channels[i] >= signals->len) {
+            g_set_error(
+                    error,
+                    EDF_EPOCHER_ERROR,
+                    EDF_EPOCHER_ERROR_CHANNEL,
+                    "Channel %u doesn't exist, the file has %u channels",
+                    channels[i],
+                    signals->len
+                    );
+            g_array_unref(selected);
+            return FALSE;
+        }
+
+        EdfSignal* signal = g_ptr_array_index(signals, channels[i]);
+        if (i == 0) {
+            ns = edf_signal_get_num_samples_per_record(signal);
+            sample_size = edf_signal_get_sample_size(signal);
+        }
+        else if (edf_signal_get_num_samples_per_record(signal) != ns) {
+            g_set_error(
+                    error,
+                    EDF_EPOCHER_ERROR,
+                    EDF_EPOCHER_ERROR_SAMPLE_RATE,
+                    "Channel '%s' differs in sample rate from channel '%s'",
+                    edf_signal_get_label(signal),
+                    edf_signal_get_label(g_ptr_array_index(signals, channels[0]))
+                    );
+            g_array_unref(selected);
+            return FALSE;
+        }
+
+        gsize offset = 0;
+        for (guint j = 0; j < channels[i]; j++) {
+            EdfSignal* sig = g_ptr_array_index(signals, j);
+            offset += (gsize) edf_signal_get_num_samples_per_record(sig) *
+                      edf_signal_get_sample_size(sig);
+        }
+
+        EdfEpocherChannel channel = {
+            .index = channels[i],
+            .offset = offset,
+            .gain = edf_signal_get_gain(signal),
+            .phys_offset = edf_signal_get_offset(signal)
+        };
+        g_array_append_val(selected, channel);
+
+        span_start = MIN(span_start, offset);
+        span_end = MAX(span_end, offset + (gsize) ns * sample_size);
+    }
+
+    // Make the channel offsets relative to the start of the span
+    for (guint i = 0; i < selected->len; i++)
+        g_array_index(selected, EdfEpocherChannel, i).offset -= span_start;
+
+    g_array_unref(priv->channels);
+    priv->channels = selected;
+    priv->ns = ns;
+    priv->sample_size = sample_size;
+
+    priv->span_start = span_start;
+    priv->span_size = span_end - span_start;
+    priv->span = g_realloc(priv->span, priv->span_size);
+    priv->span_record = -1;
+    priv->decoded = g_renew(gint32, priv->decoded, ns);
+
+    return TRUE;
+}
+
+/*
+ * Makes sure that priv->span contains the selected channels of record nrec.
+ */
+static gboolean
+epocher_load_record(EdfEpocher* epocher, gint64 nrec, GError** error)
+{
+    EdfEpocherPrivate* priv = edf_epocher_get_instance_private(epocher);
+    gsize nread = 0;
+
+    if (priv->span_record == nrec)
+        return TRUE;
+
+    priv->span_record = -1;
+    goffset pos = priv->data_offset +
+                  (goffset) nrec * priv->record_size +
+                  priv->span_start;
+
+    if (!g_seekable_seek(G_SEEKABLE(priv->istream), pos, G_SEEK_SET, NULL, error))
+        return FALSE;
+
+    if (!g_input_stream_read_all(
+                priv->istream, priv->span, priv->span_size, &nread, NULL, error
+                )
+       )
+        return FALSE;
+
+    if (nread != priv->span_size) {
+        g_set_error(
+                error,
+                EDF_EPOCHER_ERROR,
+                EDF_EPOCHER_ERROR_FAILED,
+                "Unexpected end of file in record %" G_GINT64_FORMAT,
+                nrec
+                );
+        return FALSE;
+    }
+
+    priv->span_record = nrec;
+    return TRUE;
+}
+
+/*
+ * Subtracts the mean of [start, end) from the n samples of one channel of one
+ * trial, samples outside of the recording are not part of the mean.
+ */
+static void
+subtract_baseline(gfloat* samples, gsize n, gsize start, gsize end)
+{
+    gdouble sum = 0;
+    gsize count = 0;
+
+    for (gsize i = start; i < end; i++) {
+        if (!isnan(samples[i])) {
+            sum += samples[i];
+            count++;
+        }
+    }
+    if (count == 0)
+        return;
+
+    gfloat mean = (gfloat)(sum / count);
+    for (gsize i = 0; i < n; i++)
+        samples[i] -= mean;
+}
+
+/* ************* public functions ***************** */
+
+/**
+ * edf_epocher_new_for_path:(constructor)
+ * @path: the path of an edf or bdf file
+ * @error:(out): An error is returned here when the file cannot be opened.
+ *
+ * Opens the file at @path and reads its header. If all channels of the file
+ * have the same sample rate they are all selected, otherwise select the
+ * channels with edf_epocher_select_channels() before extracting epochs.
+ *
+ * Returns:(transfer full): a new #EdfEpocher or NULL
+ */
+EdfEpocher*
+edf_epocher_new_for_path(const gchar* path, GError** error)
+{
+    g_return_val_if_fail(path != NULL, NULL);
+    g_return_val_if_fail(error != NULL && *error == NULL, NULL);
+
+    GFile* file = g_file_new_for_path(path);
+    GFileInputStream* ifstream = g_file_read(file, NULL, error);
+    g_object_unref(file);
+    if (!ifstream)
+        return NULL;
+
+    EdfHeader* header = edf_header_new_from_input_stream(
+            G_INPUT_STREAM(ifstream), error
+            );
+    if (!header) {
+        g_object_unref(ifstream);
+        return NULL;
+    }
+
+    GFileInfo* info = g_file_input_stream_query_info(
+            ifstream, G_FILE_ATTRIBUTE_STANDARD_SIZE, NULL, error
+            );
+    if (!info) {
+        g_object_unref(header);
+        g_object_unref(ifstream);
+        return NULL;
+    }
+    goffset file_size = g_file_info_get_size(info);
+    g_object_unref(info);
+
+    EdfEpocher* epocher = g_object_new(EDF_TYPE_EPOCHER, NULL);
+    EdfEpocherPrivate* priv = edf_epocher_get_instance_private(epocher);
+
+    priv->istream = G_INPUT_STREAM(ifstream);
+    priv->header = header;
+    priv->data_offset = edf_header_get_num_bytes(header);
+    priv->record_size = edf_header_get_record_size(header);
+
+    // Trust the size of the file over a missing or stale number of records
+    gint64 available = 0;
+    if (priv->record_size > 0 && file_size > priv->data_offset)
+        available = (file_size - priv->data_offset) / priv->record_size;
+    priv->num_records = edf_header_get_declared_num_records(header);
+    if (priv->num_records < 0 || priv->num_records > available)
+        priv->num_records = available;
+
+    guint num_signals = edf_header_get_signals(header)->len;
+    guint* all = g_new(guint, num_signals);
+    for (guint i = 0; i < num_signals; i++)
+        all[i] = i;
+
+    GError* select_error = NULL;
+    if (!epocher_select(epocher, all, num_signals, &select_error)) {
+        g_debug("Not all channels selected: %s", select_error->message);
+        g_error_free(select_error);
+    }
+    g_free(all);
+
+    return epocher;
+}
+
+/**
+ * edf_epocher_get_header:
+ * @epocher: the #EdfEpocher
+ *
+ * Returns:(transfer none): the header of the file that is epoched
+ */
+EdfHeader*
+edf_epocher_get_header(EdfEpocher* epocher)
+{
+    g_return_val_if_fail(EDF_IS_EPOCHER(epocher), NULL);
+    EdfEpocherPrivate* priv = edf_epocher_get_instance_private(epocher);
+    return priv->header;
+}
+
+/**
+ * edf_epocher_select_channels:
+ * @epocher: the #EdfEpocher
+ * @channels:(array length=num_channels): the indices of the channels
+ * @num_channels: the number of channels
+ * @error:(out): An error is returned here when a channel doesn't exist or
+ *               the channels differ in sample rate.
+ *
+ * Selects the channels of the epochs in the order in which they appear in the
+ * output tensor. The previous selection remains when an error occurs.
+ *
+ * Returns: TRUE when the channels are selected.
+ */
+gboolean
+edf_epocher_select_channels(
+        EdfEpocher     *epocher,
+        const guint    *channels,
+        guint           num_channels,
+        GError        **error
+        )
+{
+    g_return_val_if_fail(EDF_IS_EPOCHER(epocher), FALSE);
+    g_return_val_if_fail(channels != NULL || num_channels == 0, FALSE);
+    g_return_val_if_fail(error != NULL && *error == NULL, FALSE);
+
+    return epocher_select(epocher, channels, num_channels, error);
+}
+
+/**
+ * edf_epocher_select_channels_by_label:
+ * @epocher: the #EdfEpocher
+ * @labels:(array zero-terminated=1): the labels of the channels
+ * @error:(out): An error is returned here when a label doesn't exist or
+ *               the channels differ in sample rate.
+ *
+ * Selects channels by their label, see edf_epocher_select_channels().
+ *
+ * Returns: TRUE when the channels are selected.
+ */
+gboolean
+edf_epocher_select_channels_by_label(
+        EdfEpocher         *epocher,
+        const gchar* const *labels,
+        GError            **error
+        )
+{
+    g_return_val_if_fail(EDF_IS_EPOCHER(epocher), FALSE);
+    g_return_val_if_fail(labels != NULL, FALSE);
+    g_return_val_if_fail(error != NULL && *error == NULL, FALSE);
+
+    EdfEpocherPrivate* priv = edf_epocher_get_instance_private(epocher);
+    GPtrArray* signals = edf_header_get_signals(priv->header);
+    guint num_channels = g_strv_length((gchar**) labels);
+    guint* channels = g_new(guint, num_channels);
+    gboolean result;
+
+    for (guint i = 0; i < num_channels; i++) {
+        guint j;
+        for (j = 0; j < signals->len; j++) {
+            EdfSignal* signal = g_ptr_array_index(signals, j);
+            if (g_strcmp0(edf_signal_get_label(signal), labels[i]) == 0)
+                break;
+        }
+        if (j == signals->len) {
+            g_set_error(
+                    error,
+                    EDF_EPOCHER_ERROR,
+                    EDF_EPOCHER_ERROR_CHANNEL,
+                    "There is no channel labeled '%s'",
+                    labels[i]
+                    );
+            g_free(channels);
+            return FALSE;
+        }
+        channels[i] = j;
+    }
+
+    result = epocher_select(epocher, channels, num_channels, error);
+    g_free(channels);
+    return result;
+}
+
+/**
+ * edf_epocher_get_num_channels:
+ * @epocher: the #EdfEpocher
+ *
+ * Returns: the number of selected channels
+ */
+guint
+edf_epocher_get_num_channels(EdfEpocher* epocher)
+{
+    g_return_val_if_fail(EDF_IS_EPOCHER(epocher), 0);
+    EdfEpocherPrivate* priv = edf_epocher_get_instance_private(epocher);
+    return priv->channels->len;
+}
+
+/**
+ * edf_epocher_set_window:
+ * @epocher: the #EdfEpocher
+ * @pre_samples: the number of samples before the event
+ * @post_samples: the number of samples from the event onward
+ *
+ * Sets the window of the epochs to [event - @pre_samples, event + @post_samples).
+ */
+void
+edf_epocher_set_window(EdfEpocher* epocher, guint pre_samples, guint post_samples)
+{
+    g_return_if_fail(EDF_IS_EPOCHER(epocher));
+    g_object_set(
+            epocher,
+            "pre-samples", pre_samples,
+            "post-samples", post_samples,
+            NULL
+            );
+}
+
+/**
+ * edf_epocher_get_num_samples:
+ * @epocher: the #EdfEpocher
+ *
+ * Returns: the number of samples of one channel of one epoch.
+ */
+guint
+edf_epocher_get_num_samples(EdfEpocher* epocher)
+{
+    g_return_val_if_fail(EDF_IS_EPOCHER(epocher), 0);
+    EdfEpocherPrivate* priv = edf_epocher_get_instance_private(epocher);
+    return priv->pre_samples + priv->post_samples;
+}
+
+/**
+ * edf_epocher_set_baseline:
+ * @epocher: the #EdfEpocher
+ * @start: the start of the baseline relative to the event
+ * @end: the end of the baseline relative to the event, not included.
+ *
+ * Sets the baseline interval and enables the baseline correction. For
+ * example a @start of -pre-samples and an @end of 0 takes the part of the
+ * window before the event as baseline.
+ */
+void
+edf_epocher_set_baseline(EdfEpocher* epocher, gint64 start, gint64 end)
+{
+    g_return_if_fail(EDF_IS_EPOCHER(epocher));
+    g_object_set(
+            epocher,
+            "baseline-start", start,
+            "baseline-end", end,
+            "baseline-correction", TRUE,
+            NULL
+            );
+}
+
+/**
+ * edf_epocher_set_baseline_correction:
+ * @epocher: the #EdfEpocher
+ * @enabled: whether to subtract the baseline
+ *
+ * Enables or disables the baseline correction.
+ */
+void
+edf_epocher_set_baseline_correction(EdfEpocher* epocher, gboolean enabled)
+{
+    g_return_if_fail(EDF_IS_EPOCHER(epocher));
+    g_object_set(epocher, "baseline-correction", enabled, NULL);
+}
+
+/**
+ * edf_epocher_get_tensor_size:
+ * @epocher: the #EdfEpocher
+ * @num_events: the number of events
+ *
+ * Returns: the number of floats that are needed to hold the epochs of
+ *          @num_events events.
+ */
+gsize
+edf_epocher_get_tensor_size(EdfEpocher* epocher, gsize num_events)
+{
+    g_return_val_if_fail(EDF_IS_EPOCHER(epocher), 0);
+    EdfEpocherPrivate* priv = edf_epocher_get_instance_private(epocher);
+    return num_events * priv->channels->len *
+           (priv->pre_samples + priv->post_samples);
+}
+
+/**
+ * edf_epocher_extract:
+ * @epocher: the #EdfEpocher
+ * @events:(array length=num_events): the sample indices of the events
+ * @num_events: the number of events
+ * @tensor:(array length=tensor_size): the output
+ * @tensor_size: the number of floats in @tensor, at least
+ *               edf_epocher_get_tensor_size()
+ * @error:(out): An error is returned here when the epochs cannot be obtained.
+ *
+ * Writes the epochs around @events in physical units to @tensor. The layout
+ * of @tensor is [event][channel][sample], so the samples of channel c of
+ * event e start at (e * num_channels + c) * num_samples.
+ *
+ * Returns: TRUE when the epochs are extracted.
+ */
+gboolean
+edf_epocher_extract(
+        EdfEpocher     *epocher,
+        const guint64  *events,
+        gsize           num_events,
+        gfloat         *tensor,
+        gsize           tensor_size,
+        GError        **error
+        )
+{
+    g_return_val_if_fail(EDF_IS_EPOCHER(epocher), FALSE);
+    g_return_val_if_fail(events != NULL || num_events == 0, FALSE);
+    g_return_val_if_fail(tensor != NULL || tensor_size == 0, FALSE);
+    g_return_val_if_fail(error != NULL && *error == NULL, FALSE);
+
+    EdfEpocherPrivate* priv = edf_epocher_get_instance_private(epocher);
+    guint num_channels = priv->channels->len;
+    gsize num_samples = priv->pre_samples + priv->post_samples;
+    gint64 ns = priv->ns;
+    gint64 total = priv->num_records * ns;
+
+    if (num_channels == 0 || ns == 0) {
+        g_set_error(
+                error,
+                EDF_EPOCHER_ERROR,
+                EDF_EPOCHER_ERROR_CHANNEL,
+                num_channels == 0 ? "No channels selected" :
+                                    "The selected channels contain no samples"
+                );
+        return FALSE;
+    }
+    if (num_samples == 0) {
+        g_set_error(
+                error,
+                EDF_EPOCHER_ERROR,
+                EDF_EPOCHER_ERROR_WINDOW,
+                "The window of the epochs is empty"
+                );
+        return FALSE;
+    }
+
+    gint64 bstart = priv->pre_samples + priv->baseline_start;
+    gint64 bend = priv->pre_samples + priv->baseline_end;
+    if (priv->baseline_correction &&
+        (bstart < 0 || bend > (gint64) num_samples || bstart >= bend)) {
+        g_set_error(
+                error,
+                EDF_EPOCHER_ERROR,
+                EDF_EPOCHER_ERROR_WINDOW,
+                "The baseline [%" G_GINT64_FORMAT ", %" G_GINT64_FORMAT
+                ") is not within the window",
+                priv->baseline_start,
+                priv->baseline_end
+                );
+        return FALSE;
+    }
+
+    if (tensor_size < edf_epocher_get_tensor_size(epocher, num_events)) {
+        g_set_error(
+                error,
+                EDF_EPOCHER_ERROR,
+                EDF_EPOCHER_ERROR_TENSOR_SIZE,
+                "The tensor holds %" G_GSIZE_FORMAT " floats, but %"
+                G_GSIZE_FORMAT " are required",
+                tensor_size,
+                edf_epocher_get_tensor_size(epocher, num_events)
+                );
+        return FALSE;
+    }
+
+    for (gsize e = 0; e < num_events; e++) {
+        gfloat* trial = tensor + e * num_channels * num_samples;
+        gint64 first = (gint64) events[e] - priv->pre_samples;
+        gint64 last = first + num_samples;
+        gint64 begin = MAX(first, 0);
+        gint64 end = MIN(last, total);
+
+        if (begin > end) // the window is entirely outside of the recording
+            begin = end = first;
+
+        for (guint c = 0; c < num_channels; c++) {
+            gfloat* out = trial + c * num_samples;
+            for (gint64 i = first; i < begin; i++)
+                out[i - first] = NAN;
+            for (gint64 i = end; i < last; i++)
+                out[i - first] = NAN;
+        }
+
+        for (gint64 nrec = begin / ns; begin < end; nrec++) {
+            gint64 rec_end = MIN(end, (nrec + 1) * ns);
+            gsize n = rec_end - begin;
+
+            if (!epocher_load_record(epocher, nrec, error))
+                return FALSE;
+
+            for (guint c = 0; c < num_channels; c++) {
+                EdfEpocherChannel* channel = &g_array_index(
+                        priv->channels, EdfEpocherChannel, c
+                        );
+                const guint8* bytes = priv->span + channel->offset +
+                        (begin - nrec * ns) * priv->sample_size;
+                gfloat* out = trial + c * num_samples + (begin - first);
+
+                edf_samples_decode(bytes, priv->sample_size, n, priv->decoded);
+                for (gsize i = 0; i < n; i++)
+                    out[i] = (gfloat)(channel->gain * priv->decoded[i] +
+                                      channel->phys_offset);
+            }
+            begin = rec_end;
+        }
+
+        if (priv->baseline_correction) {
+            for (guint c = 0; c < num_channels; c++)
+                subtract_baseline(
+                        trial + c * num_samples, num_samples, bstart, bend
+                        );
+        }
+    }
+
+    return TRUE;
+}
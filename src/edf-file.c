@@ -1,8 +1,16 @@
 
 #include "edf-file.h"
+#include "edf-file-priv.h"
+#include "edf-codec-priv.h"
 #include "edf-header.h"
+#include "edf-header-priv.h"
+#include "edf-header-cache-priv.h"
+#include "edf-parse-priv.h"
 #include "edf-signal.h"
+#include "edf-signal-priv.h"
+#include "edf-trace-priv.h"
 #include <gio/gio.h>
+#include <string.h>
 
 /**
  * SECTION:edf-file
@@ -14,21 +22,72 @@
  * The header describes how many and what kind of signals are embedded in this
  * file. More information about the Edf format can be obtained from:
  * <ulink url="https://www.edfplus.info/specs/edf.html">edfplus.info</ulink>
+ *
+ * Files compressed with gzip are read and written transparently. A file is
+ * decompressed while its records are read when it starts with the gzip magic
+ * bytes and it is compressed while it is written when its path ends with
+ * ".gz", e.g. "recording.bdf.gz". In the same way files in the lossless
+ * container of #EdfCodecReader are recognized by their magic bytes and
+ * written when the path ends with ".edfz" or ".bdfz".
+ *
+ * A recording that was interrupted, e.g. by a crash of the acquisition
+ * software, often ends in the middle of a record and its header declares -1
+ * or a stale number of records. edf_file_validate() checks the structure of
+ * a file from its header and its size without reading the samples.
+ * edf_file_read() fails on such a file with %EDF_FILE_ERROR_TRUNCATED,
+ * edf_file_read_recover() loads the complete records instead and
+ * edf_file_repair() fixes the file on disk:
+ *
+ * |[<!-- language="C" -->
+ * EdfFileReport report;
+ *
+ * if (!edf_file_validate(file, &report, &error)) {
+ *     g_printerr("%s\n", error->message);
+ *     g_clear_error(&error);
+ *     edf_file_read_recover(file, &report, &error);
+ * }
+ * ]|
  */
 
+/* The size of the buffer between the file and the (de)compressor */
+#define EDF_STREAM_BUFFER_SIZE (64 * 1024)
+#define EDF_GZIP_SUFFIX ".gz"
+
+static const guint8 gzip_magic[2] = {0x1f, 0x8b};
+
+/* The offset and width of the number of records in the header */
+#define EDF_NUM_DATA_REC_OFFSET (                                           \
+        EDF_VERSION_SZ + EDF_LOCAL_PATIENT_SZ + EDF_LOCAL_RECORDING_SZ +    \
+        EDF_START_DATE_SZ + EDF_START_TIME_SZ + EDF_NUM_BYTES_IN_HEADER_SZ +\
+        EDF_RESERVED_SZ                                                     \
+        )
+
+G_DEFINE_QUARK(edf_file_error_quark, edf_file_error)
+
 typedef struct _EdfFilePrivate {
     GFile*      file;
     EdfHeader*  header;
     GPtrArray*  signals;
+    EdfArena*   arena;      /* shared with the signals for their samples */
+    gboolean    frozen;     /* read only, shared by reading threads */
+    gboolean    use_header_cache;
 }EdfFilePrivate;
 
 G_DEFINE_TYPE_WITH_PRIVATE(EdfFile, edf_file, G_TYPE_OBJECT)
 
+static gboolean
+file_is_mutable(EdfFile* file)
+{
+    EdfFilePrivate* priv = edf_file_get_instance_private(file);
+    return !priv->frozen;
+}
+
 typedef enum {
     PROP_FILENAME = 1,
     PROP_HEADER,
     PROP_SIGNALS,
     PROP_NUM_SIGNALS,
+    PROP_USE_HEADER_CACHE,
     N_PROPS
 } EdfFileProperties;
 
@@ -39,6 +98,7 @@ edf_file_init(EdfFile* file)
     priv->file = g_file_new_for_path("");
     priv->header = edf_header_new();
     priv->signals = g_ptr_array_new_full(0, g_object_unref);
+    priv->arena = edf_arena_new();
     edf_header_set_signals(priv->header, priv->signals);
 }
 
@@ -60,7 +120,9 @@ static void
 edf_file_finalize(GObject* object)
 {
     EdfFilePrivate* priv = edf_file_get_instance_private(EDF_FILE(object));
-    (void) priv;
+
+    // Signals that outlive the file keep their own reference
+    edf_arena_unref(priv->arena);
 
     G_OBJECT_CLASS(edf_file_parent_class)->finalize(object);
 }
@@ -73,7 +135,7 @@ edf_file_write_records_to_ostream(
         )
 {
     EdfFilePrivate* priv = edf_file_get_instance_private(file);
-    gint num_records_expected;
+    guint64 num_records_expected;
 
     g_assert(priv->signals->len > 0);
     EdfSignal* signal = g_ptr_array_index(priv->signals, 0);
@@ -81,7 +143,7 @@ edf_file_write_records_to_ostream(
 
     /* Make sure that every signal has an equal number of records.*/
     for (gsize n = 1; n < priv->signals->len; n++) {
-        gint num_records;
+        guint64 num_records;
         signal = g_ptr_array_index(priv->signals, n);
         num_records = edf_signal_get_num_records(signal);
         if (num_records != num_records_expected) {
@@ -94,7 +156,7 @@ edf_file_write_records_to_ostream(
     }
 
     /* Write every record to disk. */
-    for (gint nrec = 0; nrec < num_records_expected; nrec++) {
+    for (guint64 nrec = 0; nrec < num_records_expected; nrec++) {
         for (gsize nsig = 0; nsig < priv->signals->len; nsig++) {
             signal = g_ptr_array_index(priv->signals, nsig);
             edf_signal_write_record_to_ostream(
@@ -107,6 +169,11 @@ edf_file_write_records_to_ostream(
                 return;
         }
     }
+    EDF_TRACE2(
+            records__write,
+            num_records_expected,
+            num_records_expected * edf_header_get_record_size(priv->header)
+            );
 }
 
 static void
@@ -128,6 +195,163 @@ edf_file_write_to_output_stream(
     edf_file_write_records_to_ostream(file, ostream, error);
 }
 
+/* ************ streams ************ */
+
+gboolean
+edf_file_has_gzip_magic(const guint8* bytes, gsize size)
+{
+    return size >= sizeof(gzip_magic) &&
+           memcmp(bytes, gzip_magic, sizeof(gzip_magic)) == 0;
+}
+
+gboolean
+edf_file_is_compressed(const guint8* bytes, gsize size)
+{
+    return edf_file_has_gzip_magic(bytes, size) ||
+           edf_codec_has_magic(bytes, size);
+}
+
+/**
+ * edf_file_open_input_stream:
+ * @file: the file to read
+ * @error:(out): An error is returned here when the file cannot be opened
+ *
+ * Opens @file for reading with the same transparent decompression as
+ * edf_file_read(). This allows to stream over the records of large files
+ * with edf_header_read_from_input_stream() without holding them in memory.
+ *
+ * Returns:(transfer full): a stream that yields the bytes of the edf/bdf
+ *                          file or NULL
+ */
+GInputStream*
+edf_file_open_input_stream(GFile* file, GError** error)
+{
+    g_return_val_if_fail(G_IS_FILE(file), NULL);
+    g_return_val_if_fail(error != NULL && *error == NULL, NULL);
+
+    gsize available = 0;
+    GFileInputStream* ifstream = g_file_read(file, NULL, error);
+    if (!ifstream)
+        return NULL;
+
+    GInputStream* buffered = g_buffered_input_stream_new_sized(
+            G_INPUT_STREAM(ifstream), EDF_STREAM_BUFFER_SIZE
+            );
+    g_object_unref(ifstream);
+
+    if (g_buffered_input_stream_fill(
+                G_BUFFERED_INPUT_STREAM(buffered), -1, NULL, error
+                ) < 0) {
+        g_object_unref(buffered);
+        return NULL;
+    }
+
+    const guint8* head = g_buffered_input_stream_peek_buffer(
+            G_BUFFERED_INPUT_STREAM(buffered), &available
+            );
+    if (edf_codec_has_magic(head, available)) {
+        GInputStream* istream = edf_codec_input_stream_new(buffered, error);
+        g_object_unref(buffered);
+        return istream;
+    }
+
+    if (!edf_file_has_gzip_magic(head, available))
+        return buffered;
+
+    GZlibDecompressor* decompressor = g_zlib_decompressor_new(
+            G_ZLIB_COMPRESSOR_FORMAT_GZIP
+            );
+    GInputStream* istream = g_converter_input_stream_new(
+            buffered, G_CONVERTER(decompressor)
+            );
+    g_object_unref(decompressor);
+    g_object_unref(buffered);
+
+    return istream;
+}
+
+/**
+ * edf_file_open_output_stream:
+ * @file: the file to write
+ * @replace: whether an existing file may be replaced
+ * @error:(out): An error is returned here when the file cannot be opened
+ *
+ * Creates or replaces @file with the same transparent compression as
+ * edf_file_replace(). The stream should be closed explicitly in order to
+ * notice errors while the compressor is flushed.
+ *
+ * Returns:(transfer full): a stream that accepts the bytes of the edf/bdf
+ *                          file or NULL
+ */
+GOutputStream*
+edf_file_open_output_stream(GFile* file, gboolean replace, GError** error)
+{
+    g_return_val_if_fail(G_IS_FILE(file), NULL);
+    g_return_val_if_fail(error != NULL && *error == NULL, NULL);
+
+    GFileOutputStream* ofstream;
+    if (replace)
+        ofstream = g_file_replace(
+                file, NULL, TRUE, G_FILE_CREATE_NONE, NULL, error
+                );
+    else
+        ofstream = g_file_create(file, G_FILE_CREATE_NONE, NULL, error);
+
+    if (!ofstream)
+        return NULL;
+
+    gchar* basename = g_file_get_basename(file);
+    gboolean compress = basename && g_str_has_suffix(basename, EDF_GZIP_SUFFIX);
+    gboolean codec = edf_codec_is_codec_path(basename);
+    g_free(basename);
+
+    if (codec) {
+        GOutputStream* ostream = edf_codec_output_stream_new(
+                G_OUTPUT_STREAM(ofstream)
+                );
+        g_object_unref(ofstream);
+        return ostream;
+    }
+
+    if (!compress)
+        return G_OUTPUT_STREAM(ofstream);
+
+    GZlibCompressor* compressor = g_zlib_compressor_new(
+            G_ZLIB_COMPRESSOR_FORMAT_GZIP, -1
+            );
+    GOutputStream* ostream = g_converter_output_stream_new(
+            G_OUTPUT_STREAM(ofstream), G_CONVERTER(compressor)
+            );
+    g_object_unref(compressor);
+    g_object_unref(ofstream);
+
+    return ostream;
+}
+
+static void
+edf_file_write_to_path(EdfFile* file, gboolean replace, GError** error)
+{
+    EdfFilePrivate* priv = edf_file_get_instance_private(file);
+
+    GOutputStream* ostream = edf_file_open_output_stream(
+            priv->file, replace, error
+            );
+    if (!ostream) {
+        g_assert(*error);
+        return;
+    }
+
+    edf_file_write_to_output_stream(file, ostream, error);
+
+    // Closing flushes the compressor, so it may fail as well.
+    if (*error)
+        g_output_stream_close(ostream, NULL, NULL);
+    else
+        g_output_stream_close(ostream, NULL, error);
+
+    g_object_unref(ostream);
+}
+
 static void
 edf_file_set_property(
     GObject*        object,
@@ -147,6 +371,9 @@ edf_file_set_property(
         case PROP_SIGNALS:
             edf_file_set_signals(file, g_value_get_boxed (value));
             break;
+        case PROP_USE_HEADER_CACHE:
+            edf_file_set_use_header_cache(file, g_value_get_boolean(value));
+            break;
         case PROP_HEADER: // Read only
         case PROP_NUM_SIGNALS:
         default:
@@ -178,6 +405,9 @@ edf_file_get_property(
         case PROP_NUM_SIGNALS:
             g_value_set_uint(value, priv->signals->len);
             break;
+        case PROP_USE_HEADER_CACHE:
+            g_value_set_boolean(value, priv->use_header_cache);
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID(object, propid, spec);
     }
@@ -258,6 +488,20 @@ edf_file_class_init(EdfFileClass* klass)
         G_PARAM_READABLE
     );
 
+    /**
+     * EdfFile:use-header-cache:
+     *
+     * Whether edf_file_read() and edf_file_read_recover() take the header
+     * from the on disk header cache when the file is unchanged since it
+     * was cached, and store it there otherwise. See #edf-header-cache.
+     */
+    edf_file_properties[PROP_USE_HEADER_CACHE] = g_param_spec_boolean(
+        "use-header-cache",
+        "Use header cache",
+        "Take the header from the header cache when possible",
+        FALSE,
+        G_PARAM_READWRITE
+    );
 
     g_object_class_install_properties(
             object_class, N_PROPS, edf_file_properties
@@ -344,6 +588,7 @@ edf_file_set_path(EdfFile* file, const char* path)
 {
     g_return_if_fail(file != NULL);
     g_return_if_fail(EDF_IS_FILE(file));
+    g_return_if_fail(file_is_mutable(file));
     g_return_if_fail(path != NULL);
     
     EdfFilePrivate* priv = edf_file_get_instance_private(file);
@@ -354,42 +599,202 @@ edf_file_set_path(EdfFile* file, const char* path)
 }
 
 
+/*
+ * The number of bytes after the header of a plain file, the records can't
+ * take more. It is 0 for a compressed file, whose size isn't known before
+ * it has been read.
+ */
+static guint64
+file_data_size(EdfFilePrivate* priv, GInputStream* istream, guint64 header_size)
+{
+    if (!G_IS_BUFFERED_INPUT_STREAM(istream))
+        return 0;
+
+    GFileInfo* info = g_file_query_info(
+            priv->file, G_FILE_ATTRIBUTE_STANDARD_SIZE, G_FILE_QUERY_INFO_NONE,
+            NULL, NULL
+            );
+    if (!info)
+        return 0;
+    guint64 size = g_file_info_get_size(info);
+    g_object_unref(info);
+    return size > header_size ? size - header_size : 0;
+}
+
+/*
+ * Lets the signals allocate their records from the arena of the file. Space
+ * is reserved for the records that data_size bytes hold, but not for more
+ * than num_records unless it is negative. The header alone isn't trusted,
+ * a truncated file may declare many more records than it holds.
+ *
+ * Returns: the size of one record
+ */
+static gsize
+file_prepare_records(EdfFilePrivate* priv, gint64 num_records, guint64 data_size)
+{
+    // Store all samples of the file in one block of the arena
+    gsize record_size = 0, reserve_size = 0;
+    for (guint signal = 0; signal < priv->signals->len; signal++) {
+        EdfSignal* sig = g_ptr_array_index(priv->signals, signal);
+        gsize size = (gsize) edf_signal_get_num_samples_per_record(sig) *
+                     edf_signal_get_sample_size(sig);
+        edf_signal_set_arena(sig, priv->arena);
+        record_size += size;
+        reserve_size += edf_arena_alloc_size(size);
+    }
+    if (record_size == 0)
+        return 0;
+
+    guint64 num_reserved = data_size / record_size;
+    if (num_records >= 0)
+        num_reserved = MIN(num_reserved, (guint64) num_records);
+    if (num_reserved > 0)
+        edf_arena_reserve(priv->arena, reserve_size * (gsize) num_reserved);
+
+    return record_size;
+}
+
+/*
+ * Reads at most max_records records, or until the end of the stream when
+ * max_records is negative. A record that is cut off by the end of the
+ * stream is dropped from all signals, its size is returned in trailing.
+ */
+static guint64
+file_read_records(
+        EdfFilePrivate *priv,
+        GInputStream   *istream,
+        gsize           record_size,
+        gint64          max_records,
+        guint64        *num_records,
+        gsize          *trailing,
+        GError        **error
+        )
+{
+    guint64 num_bytes_tot = 0;
+    guint64 rec = 0;
+
+    *trailing = 0;
+    for (; record_size > 0 && (max_records < 0 || rec < (guint64) max_records); rec++) {
+        gsize record_read = 0;
+        for (guint signal = 0; signal < priv->signals->len; signal++) {
+            EdfSignal* sig = g_ptr_array_index(priv->signals, signal);
+            gsize size = (gsize) edf_signal_get_num_samples_per_record(sig) *
+                         edf_signal_get_sample_size(sig);
+            gsize nread = edf_signal_read_record_from_istream(sig, istream, error);
+            record_read += nread;
+            if (*error || nread < size)
+                break;
+        }
+        num_bytes_tot += record_read;
+
+        if (*error || record_read < record_size) {
+            // A ring buffer numbers its records from its oldest record
+            for (guint signal = 0; signal < priv->signals->len; signal++) {
+                EdfSignal* sig = g_ptr_array_index(priv->signals, signal);
+                guint64 dropped = edf_signal_get_num_dropped_records(sig);
+                edf_signal_truncate_records(sig, rec > dropped ? rec - dropped : 0);
+            }
+            *trailing = record_read;
+            break;
+        }
+    }
+
+    *num_records = rec;
+    EDF_TRACE2(records__read, rec, num_bytes_tot);
+    return num_bytes_tot;
+}
+
+/*
+ * Reads the header of the file from istream. With the header cache a
+ * header that is cached for the unchanged file is skipped in istream
+ * instead of being parsed.
+ */
+static guint64
+file_read_header(EdfFilePrivate* priv, GInputStream* istream, GError** error)
+{
+    EdfHeaderCacheKey key;
+    EdfParsedHeader parsed = {0};
+    guint64 nread = 0;
+
+    if (!priv->use_header_cache || !edf_header_cache_key_init(&key, priv->file))
+        return edf_header_read_from_input_stream(priv->header, istream, error);
+
+    if (edf_header_cache_lookup(&key, &parsed)) {
+        // A decompressing stream may skip fewer bytes at once
+        while (nread < parsed.header_size) {
+            gssize n = g_input_stream_skip(
+                    istream, parsed.header_size - nread, NULL, error
+                    );
+            if (n <= 0)
+                break;
+            nread += n;
+        }
+        if (!*error && nread < parsed.header_size)
+            g_set_error(
+                    error, EDF_HEADER_ERROR, EDF_HEADER_ERROR_PARSE,
+                    "The header is truncated after %" G_GUINT64_FORMAT " bytes",
+                    nread
+                    );
+        if (!*error)
+            edf_header_set_parsed(priv->header, &parsed);
+    }
+    else {
+        nread = edf_header_read_from_input_stream(priv->header, istream, error);
+        if (!*error) {
+            edf_header_get_parsed(priv->header, &parsed);
+            edf_header_cache_store(&key, &parsed);
+        }
+    }
+
+    edf_parsed_header_clear(&parsed);
+    edf_header_cache_key_clear(&key);
+    return nread;
+}
+
+static guint64
+file_num_lost_records(gint64 declared, guint64 num_records, gsize trailing)
+{
+    if (declared >= 0 && (guint64) declared > num_records)
+        return declared - num_records;
+    return trailing > 0 ? 1 : 0;
+}
+
 /**
  * edf_file_read:
  * @self the EdfFile
  * @error:(out): If an error occurs it is returned here.
  *
  * Opens the file for reading. The property fn should be
- * set to a path of a valid edf file. Otherwise havoc will
+ * set to a path of a valid (possibly gzip compressed) edf file. Otherwise havoc will
  * occur.
+ *
+ * When the file contains fewer records than its header declares
+ * %EDF_FILE_ERROR_TRUNCATED is returned, the complete records are loaded
+ * nonetheless. See edf_file_read_recover().
+ *
+ * Returns: the number of bytes read
  */
-gsize
+guint64
 edf_file_read(EdfFile* file, GError** error)
 {
-    gsize num_bytes_tot = 0, nread;
-    guint num_signals;
-    gint num_records;
+    guint64 num_bytes_tot = 0;
+    gsize nread, trailing;
+    guint64 num_read = 0;
+    gint64 num_records;
     EdfFilePrivate *priv;
 
     g_return_val_if_fail(EDF_IS_FILE(file), 0);
     g_return_val_if_fail(error != NULL && *error == NULL, 0);
 
+    g_return_val_if_fail(file_is_mutable(file), 0);
+
     priv = edf_file_get_instance_private(file);
 
-    GFileInputStream *ifstream = g_file_read(
-            priv->file,
-            NULL,
-            error
-            );
-    if(*error)
-        goto fail;
-    GInputStream *istream = G_INPUT_STREAM(ifstream);
+    GInputStream *istream = edf_file_open_input_stream(priv->file, error);
+    if (!istream)
+        return 0;
 
-    nread = edf_header_read_from_input_stream (
-            priv->header,
-            G_INPUT_STREAM(istream),
-            error
-            );
+    nread = file_read_header(priv, istream, error);
     num_bytes_tot += nread;
     if (*error)
         goto fail;
@@ -397,24 +802,307 @@ edf_file_read(EdfFile* file, GError** error)
     g_object_get(
         priv->header,
         "num-data-records", &num_records,
-        "num-signals", &num_signals,
         NULL
     );
 
-    for (gint rec = 0; rec < num_records; rec++) {
-        for (gsize signal = 0; signal < num_signals; signal++) {
-            EdfSignal* sig = g_ptr_array_index(priv->signals, signal);
-            nread = edf_signal_read_record_from_istream(sig, istream, error);
-            num_bytes_tot += nread;
-            if (*error)
-                goto fail;
-        }
+    gsize record_size = file_prepare_records(
+            priv, MAX(num_records, 0), file_data_size(priv, istream, nread)
+            );
+
+    num_bytes_tot += file_read_records(
+            priv, istream, record_size, MAX(num_records, 0), &num_read, &trailing, error
+            );
+    if (*error)
+        goto fail;
+
+    if (num_records > 0 && num_read < (guint64) num_records)
+        g_set_error(
+                error, EDF_FILE_ERROR, EDF_FILE_ERROR_TRUNCATED,
+                "The file contains %" G_GUINT64_FORMAT " of %" G_GINT64_FORMAT " records",
+                num_read,
+                num_records
+                );
+fail:
+    g_object_unref(istream);
+    return num_bytes_tot;
+}
+
+/**
+ * edf_file_read_recover:
+ * @self: the EdfFile
+ * @report:(out caller-allocates)(nullable): What was recovered
+ * @error:(out): If an error occurs it is returned here.
+ *
+ * Reads a file whose recording was interrupted. In contrast to
+ * edf_file_read() all complete records up to the end of the file are loaded,
+ * regardless of the number of records in the header. An incomplete record
+ * at the end is dropped. Afterwards #EdfHeader:num-data-records matches the
+ * loaded records, so the file can be written again with edf_file_replace().
+ *
+ * This works on compressed files too, file_size in @report is the size of
+ * the decompressed data then.
+ *
+ * Returns: the number of bytes read
+ */
+guint64
+edf_file_read_recover(EdfFile* file, EdfFileReport* report, GError** error)
+{
+    guint64 num_bytes_tot = 0;
+    gsize trailing = 0;
+    guint64 num_read = 0;
+    gint64 declared;
+
+    g_return_val_if_fail(EDF_IS_FILE(file), 0);
+    g_return_val_if_fail(file_is_mutable(file), 0);
+    g_return_val_if_fail(error != NULL && *error == NULL, 0);
+
+    EdfFilePrivate *priv = edf_file_get_instance_private(file);
+
+    GInputStream *istream = edf_file_open_input_stream(priv->file, error);
+    if (!istream)
+        return 0;
+
+    num_bytes_tot = file_read_header(priv, istream, error);
+    if (*error)
+        goto fail;
+
+    declared = edf_header_get_declared_num_records(priv->header);
+    // Only what the file holds, the declared number may be far off
+    gsize record_size = file_prepare_records(
+            priv, -1, file_data_size(priv, istream, num_bytes_tot)
+            );
+
+    num_bytes_tot += file_read_records(
+            priv, istream, record_size, -1, &num_read, &trailing, error
+            );
+    if (*error)
+        goto fail;
+
+    if (num_read > EDF_MAX_NUM_RECORDS) {
+        g_set_error(
+                error, EDF_FILE_ERROR, EDF_FILE_ERROR_NUM_RECORDS,
+                "The file contains too many records (%" G_GUINT64_FORMAT ")",
+                num_read
+                );
+        goto fail;
+    }
+    edf_header_update_num_records(priv->header);
+
+    if (report) {
+        report->header_size = edf_header_get_num_bytes(priv->header);
+        report->record_size = record_size;
+        report->declared_num_records = declared;
+        report->file_size = num_bytes_tot;
+        report->num_records = num_read;
+        report->trailing_bytes = trailing;
+        report->num_lost_records = file_num_lost_records(declared, num_read, trailing);
     }
 fail:
-    g_object_unref(ifstream);
+    g_object_unref(istream);
     return num_bytes_tot;
 }
 
+/**
+ * edf_file_validate:
+ * @self: the EdfFile
+ * @report:(out caller-allocates)(nullable): The structure of the file
+ * @error:(out): The first problem that was found is returned here.
+ *
+ * Checks the structure of the file on disk from its header and its size,
+ * without reading the samples. This is much faster than edf_file_read(),
+ * so it is suited to check a large archive. The file must not be
+ * compressed, otherwise %EDF_FILE_ERROR_UNSUPPORTED is returned.
+ *
+ * %EDF_FILE_ERROR_TRUNCATED is returned when the file ends in the middle
+ * of a record or contains fewer records than declared,
+ * %EDF_FILE_ERROR_NUM_RECORDS when the header declares -1 or fewer records
+ * than the file contains. Errors in the header are returned in the
+ * EDF_HEADER_ERROR domain. @report is filled in as far as the file could be
+ * examined.
+ *
+ * Returns: TRUE when the file is structurally valid
+ */
+gboolean
+edf_file_validate(EdfFile* file, EdfFileReport* report, GError** error)
+{
+    EdfParsedHeader parsed = {0};
+    EdfFileReport local;
+    gsize available = 0;
+    gboolean result = FALSE;
+
+    g_return_val_if_fail(EDF_IS_FILE(file), FALSE);
+    g_return_val_if_fail(error != NULL && *error == NULL, FALSE);
+
+    EdfFilePrivate *priv = edf_file_get_instance_private(file);
+
+    if (!report)
+        report = &local;
+    memset(report, 0, sizeof(EdfFileReport));
+
+    GFileInfo* info = g_file_query_info(
+            priv->file, G_FILE_ATTRIBUTE_STANDARD_SIZE, G_FILE_QUERY_INFO_NONE,
+            NULL, error
+            );
+    if (!info)
+        return FALSE;
+    report->file_size = g_file_info_get_size(info);
+    g_object_unref(info);
+
+    GFileInputStream* ifstream = g_file_read(priv->file, NULL, error);
+    if (!ifstream)
+        return FALSE;
+
+    GInputStream* buffered = g_buffered_input_stream_new_sized(
+            G_INPUT_STREAM(ifstream), EDF_BASE_HEADER_SIZE
+            );
+    g_object_unref(ifstream);
+
+    if (g_buffered_input_stream_fill(
+                G_BUFFERED_INPUT_STREAM(buffered), -1, NULL, error
+                ) < 0)
+        goto fail;
+
+    const guint8* head = g_buffered_input_stream_peek_buffer(
+            G_BUFFERED_INPUT_STREAM(buffered), &available
+            );
+    if (edf_file_is_compressed(head, available)) {
+        g_set_error(
+                error, EDF_FILE_ERROR, EDF_FILE_ERROR_UNSUPPORTED,
+                "Compressed files can't be validated without decompressing them"
+                );
+        goto fail;
+    }
+
+    if (!edf_parsed_header_read(&parsed, buffered, error))
+        goto fail;
+
+    report->header_size = parsed.header_size;
+    report->record_size = edf_parsed_header_get_record_size(&parsed);
+    report->declared_num_records = parsed.num_records;
+
+    if (report->record_size > 0) {
+        guint64 data_size = report->file_size - report->header_size;
+        report->num_records = data_size / report->record_size;
+        report->trailing_bytes = data_size % report->record_size;
+    }
+    report->num_lost_records = file_num_lost_records(
+            parsed.num_records, report->num_records, report->trailing_bytes
+            );
+
+    if (report->trailing_bytes > 0) {
+        g_set_error(
+                error, EDF_FILE_ERROR, EDF_FILE_ERROR_TRUNCATED,
+                "The file ends %" G_GSIZE_FORMAT " bytes into record %" G_GUINT64_FORMAT,
+                report->trailing_bytes,
+                report->num_records
+                );
+    }
+    else if (parsed.num_records >= 0 &&
+             (guint64) parsed.num_records > report->num_records) {
+        g_set_error(
+                error, EDF_FILE_ERROR, EDF_FILE_ERROR_TRUNCATED,
+                "The file contains %" G_GUINT64_FORMAT " of %" G_GINT64_FORMAT " records",
+                report->num_records,
+                parsed.num_records
+                );
+    }
+    else if (parsed.num_records < 0 ||
+             (guint64) parsed.num_records < report->num_records) {
+        g_set_error(
+                error, EDF_FILE_ERROR, EDF_FILE_ERROR_NUM_RECORDS,
+                "The header declares %" G_GINT64_FORMAT " records, the file contains %" G_GUINT64_FORMAT,
+                parsed.num_records,
+                report->num_records
+                );
+    }
+    else {
+        result = TRUE;
+    }
+
+fail:
+    edf_parsed_header_clear(&parsed);
+    g_object_unref(buffered);
+    return result;
+}
+
+/**
+ * edf_file_repair:
+ * @self: the EdfFile
+ * @report:(out caller-allocates)(nullable): The structure of the file
+ *                                           before it was repaired
+ * @error:(out): If an error occurs it is returned here.
+ *
+ * Repairs the structure of the file on disk in place: an incomplete record
+ * at the end is cut off and the number of records in the header is set to
+ * the number of complete records. The samples aren't touched, so this is
+ * cheap for large files. Compressed files can't be repaired, use
+ * edf_file_read_recover() and write them again.
+ *
+ * Returns: TRUE when the file is valid afterwards
+ */
+gboolean
+edf_file_repair(EdfFile* file, EdfFileReport* report, GError** error)
+{
+    EdfFileReport local;
+    gchar field[EDF_NUM_DATA_REC_SZ + 1];
+
+    g_return_val_if_fail(EDF_IS_FILE(file), FALSE);
+    g_return_val_if_fail(error != NULL && *error == NULL, FALSE);
+
+    EdfFilePrivate *priv = edf_file_get_instance_private(file);
+
+    if (!report)
+        report = &local;
+
+    if (edf_file_validate(file, report, error))
+        return TRUE;
+    if (!g_error_matches(*error, EDF_FILE_ERROR, EDF_FILE_ERROR_TRUNCATED) &&
+        !g_error_matches(*error, EDF_FILE_ERROR, EDF_FILE_ERROR_NUM_RECORDS))
+        return FALSE;
+    g_clear_error(error);
+
+    if (report->num_records > EDF_MAX_NUM_RECORDS) {
+        g_set_error(
+                error, EDF_FILE_ERROR, EDF_FILE_ERROR_NUM_RECORDS,
+                "%" G_GUINT64_FORMAT " records don't fit in the header",
+                report->num_records
+                );
+        return FALSE;
+    }
+    g_snprintf(
+            field, sizeof(field), "%-8" G_GUINT64_FORMAT, report->num_records
+            );
+
+    GFileIOStream* iostream = g_file_open_readwrite(priv->file, NULL, error);
+    if (!iostream)
+        return FALSE;
+
+    GSeekable* seekable = G_SEEKABLE(iostream);
+    GOutputStream* ostream = g_io_stream_get_output_stream(G_IO_STREAM(iostream));
+    gboolean result = TRUE;
+
+    if (report->trailing_bytes > 0)
+        result = g_seekable_truncate(
+                seekable,
+                report->header_size + report->num_records * report->record_size,
+                NULL,
+                error
+                );
+    if (result)
+        result = g_seekable_seek(
+                seekable, EDF_NUM_DATA_REC_OFFSET, G_SEEK_SET, NULL, error
+                );
+    if (result)
+        result = g_output_stream_write_all(
+                ostream, field, EDF_NUM_DATA_REC_SZ, NULL, NULL, error
+                );
+    if (result)
+        result = g_io_stream_close(G_IO_STREAM(iostream), NULL, error);
+
+    g_object_unref(iostream);
+    return result;
+}
+
 /**
  * edf_file_create:
  * @error:(out): An error will be returned here when the
@@ -430,21 +1118,7 @@ edf_file_create(EdfFile* file, GError**error)
     g_return_if_fail(EDF_IS_FILE(file));
     g_return_if_fail(error != NULL && *error == NULL);
 
-    EdfFilePrivate* priv = edf_file_get_instance_private(file);
-
-    GFileOutputStream* outstream = g_file_create(
-            priv->file,
-            G_FILE_CREATE_NONE,
-            NULL,
-            error
-            );
-    if (!outstream) {
-        g_assert(*error);
-        return;
-    }
-
-    edf_file_write_to_output_stream(file, G_OUTPUT_STREAM(outstream), error);
-    g_object_unref(outstream);
+    edf_file_write_to_path(file, FALSE, error);
 }
 
 /**
@@ -461,23 +1135,7 @@ edf_file_replace(EdfFile* file, GError**error)
     g_return_if_fail(EDF_IS_FILE(file));
     g_return_if_fail(error != NULL && *error == NULL);
 
-    EdfFilePrivate* priv = edf_file_get_instance_private(file);
-
-    GFileOutputStream* outstream = g_file_replace(
-            priv->file,
-            NULL,
-            TRUE,
-            G_FILE_CREATE_NONE,
-            NULL,
-            error
-            );
-    if (!outstream) {
-        g_assert(*error);
-        return;
-    }
-
-    edf_file_write_to_output_stream(file, G_OUTPUT_STREAM(outstream), error);
-    g_object_unref(outstream);
+    edf_file_write_to_path(file, TRUE, error);
 }
 
 /**
@@ -493,10 +1151,12 @@ void
 edf_file_add_signal(EdfFile* file, EdfSignal* signal)
 {
     g_return_if_fail(EDF_IS_FILE(file));
+    g_return_if_fail(file_is_mutable(file));
     g_return_if_fail(EDF_IS_SIGNAL(signal));
 
     EdfFilePrivate* priv = edf_file_get_instance_private(file);
 
+    edf_signal_set_arena(signal, priv->arena);
     g_ptr_array_add(priv->signals, g_object_ref(signal));
 }
 
@@ -508,6 +1168,7 @@ edf_file_add_signal(EdfFile* file, EdfSignal* signal)
 void
 edf_file_set_signals(EdfFile* file, GPtrArray* signals) {
     g_return_if_fail(EDF_IS_FILE(file));
+    g_return_if_fail(file_is_mutable(file));
     g_return_if_fail(signals != NULL);
 
     g_ptr_array_ref(signals);
@@ -517,6 +1178,8 @@ edf_file_set_signals(EdfFile* file, GPtrArray* signals) {
         g_ptr_array_unref(priv->signals);
 
     edf_header_set_signals(priv->header, signals);
+    for (guint i = 0; i < signals->len; i++)
+        edf_signal_set_arena(g_ptr_array_index(signals, i), priv->arena);
 
     priv->signals = signals;    
 }
@@ -565,3 +1228,79 @@ edf_file_header(EdfFile* file)
     return priv->header;
 }
 
+/**
+ * edf_file_freeze:
+ * @file: the #EdfFile to make read only
+ *
+ * Makes @file, its header and its signals read only. Afterwards all
+ * functions that only inspect the file, e.g. edf_signal_get_values(),
+ * edf_signal_compute_stats() or an #EdfSignalCursor, may be called from
+ * several threads at the same time without locking. Everything that
+ * modifies the file refuses to do so with a critical warning.
+ *
+ * The file must be frozen before it is shared with the other threads,
+ * typically right after edf_file_read(). A file can't be thawed.
+ */
+void
+edf_file_freeze(EdfFile* file)
+{
+    g_return_if_fail(EDF_IS_FILE(file));
+    EdfFilePrivate* priv = edf_file_get_instance_private(file);
+
+    if (priv->frozen)
+        return;
+
+    edf_header_freeze(priv->header);
+    for (guint i = 0; i < priv->signals->len; i++)
+        edf_signal_freeze(g_ptr_array_index(priv->signals, i));
+    priv->frozen = TRUE;
+}
+
+/**
+ * edf_file_is_frozen:
+ * @file: the input #EdfFile
+ *
+ * Returns: TRUE when edf_file_freeze() has been called on @file
+ */
+gboolean
+edf_file_is_frozen(EdfFile* file)
+{
+    g_return_val_if_fail(EDF_IS_FILE(file), FALSE);
+    return !file_is_mutable(file);
+}
+
+/**
+ * edf_file_set_use_header_cache:
+ * @file: the input #EdfFile
+ * @use_cache: whether to use the header cache
+ *
+ * Sets #EdfFile:use-header-cache.
+ */
+void
+edf_file_set_use_header_cache(EdfFile* file, gboolean use_cache)
+{
+    g_return_if_fail(EDF_IS_FILE(file));
+    EdfFilePrivate* priv = edf_file_get_instance_private(file);
+
+    use_cache = use_cache != FALSE;
+    if (priv->use_header_cache == use_cache)
+        return;
+    priv->use_header_cache = use_cache;
+    g_object_notify_by_pspec(
+            G_OBJECT(file), edf_file_properties[PROP_USE_HEADER_CACHE]
+            );
+}
+
+/**
+ * edf_file_get_use_header_cache:
+ * @file: the input #EdfFile
+ *
+ * Returns: the value of #EdfFile:use-header-cache
+ */
+gboolean
+edf_file_get_use_header_cache(EdfFile* file)
+{
+    g_return_val_if_fail(EDF_IS_FILE(file), FALSE);
+    EdfFilePrivate* priv = edf_file_get_instance_private(file);
+    return priv->use_header_cache;
+}
@@ -0,0 +1,779 @@
+
+#include "edf-filter.h"
+
+#include <math.h>
+#include <string.h>
+
+/**
+ * SECTION:edf-filter
+ * @short_description: a bank of IIR filters that runs while records are read
+ * @see_also: #EdfReader, #EdfMontage
+ * @include: gedf.h
+ *
+ * An #EdfFilter applies a cascade of second order sections (biquads) to a
+ * number of channels with the same sample rate. The sections are designed
+ * from cutoff frequencies: Butterworth low and high pass filters of any
+ * order and notch filters for line noise. Sections with other coefficients
+ * may be added with edf_filter_add_section().
+ *
+ * The filter keeps the state of every section for every channel, so a
+ * recording may be processed in pieces, e.g. record by record from an
+ * #EdfReader, with the same result as processing it at once. The state of
+ * all channels is stored per section in one array.
+ *
+ * |[<!-- language="C" -->
+ * EdfFilter* filter = edf_filter_new(512, num_channels);
+ * edf_filter_add_highpass(filter, 0.5, 2, &error);
+ * edf_filter_add_notch(filter, 50, 30, &error);
+ *
+ * while (edf_reader_next_record(reader, &error)) {
+ *     for (guint c = 0; c < num_channels; c++)
+ *         edf_reader_get_physical(reader, channels[c], rows[c]);
+ *     edf_filter_process(filter, rows, ns);
+ *     ...
+ * }
+ * ]|
+ *
+ * For offline analysis edf_filter_process_zero_phase() filters a complete
+ * signal forward and backward, which cancels the phase shift of the filter
+ * and squares its magnitude response.
+ */
+
+G_DEFINE_QUARK(edf_filter_error_quark, edf_filter_error)
+
+// The largest order of a designed low or high pass filter
+#define MAX_ORDER       32
+// Number of frames that edf_filter_process interleaves at once
+#define BLOCK_FRAMES    256
+
+/* The coefficients of one section, normalized so that a0 == 1 */
+typedef struct {
+    gdouble b0, b1, b2, a1, a2;
+} EdfBiquad;
+
+typedef struct _EdfFilterPrivate {
+    gdouble     sample_rate;
+    guint       num_channels;
+    GArray     *sections;       // EdfBiquad
+    /*
+     * The state of the transposed direct form II of every section,
+     * z1[s * num_channels + c] belongs to section s of channel c.
+     */
+    gdouble    *z1;
+    gdouble    *z2;
+    gdouble    *block;
+} EdfFilterPrivate;
+
+G_DEFINE_TYPE_WITH_PRIVATE(EdfFilter, edf_filter, G_TYPE_OBJECT)
+
+typedef enum {
+    PROP_SAMPLE_RATE = 1,
+    PROP_NUM_CHANNELS,
+    PROP_NUM_SECTIONS,
+    N_PROPERTIES
+} EdfFilterProperty;
+
+static void
+edf_filter_init(EdfFilter* self)
+{
+    EdfFilterPrivate* priv = edf_filter_get_instance_private(self);
+
+    priv->sample_rate = 1.0;
+    priv->num_channels = 1;
+    priv->sections = g_array_new(FALSE, FALSE, sizeof(EdfBiquad));
+}
+
+static void
+edf_filter_finalize(GObject* gobject)
+{
+    EdfFilterPrivate* priv = edf_filter_get_instance_private(EDF_FILTER(gobject));
+
+    g_array_unref(priv->sections);
+    g_free(priv->z1);
+    g_free(priv->z2);
+    g_free(priv->block);
+
+    G_OBJECT_CLASS(edf_filter_parent_class)->finalize(gobject);
+}
+
+static void
+edf_filter_set_property(
+        GObject        *object,
+        guint32         propid,
+        const GValue   *value,
+        GParamSpec     *spec
+        )
+{
+    EdfFilterPrivate* priv = edf_filter_get_instance_private(EDF_FILTER(object));
+
+    switch ((EdfFilterProperty) propid) {
+        case PROP_SAMPLE_RATE:
+            priv->sample_rate = g_value_get_double(value);
+            break;
+        case PROP_NUM_CHANNELS:
+            priv->num_channels = g_value_get_uint(value);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID(object, propid, spec);
+    }
+}
+
+static void
+edf_filter_get_property(
+        GObject    *object,
+        guint32     propid,
+        GValue     *value,
+        GParamSpec *spec
+        )
+{
+    EdfFilterPrivate* priv = edf_filter_get_instance_private(EDF_FILTER(object));
+
+    switch ((EdfFilterProperty) propid) {
+        case PROP_SAMPLE_RATE:
+            g_value_set_double(value, priv->sample_rate);
+            break;
+        case PROP_NUM_CHANNELS:
+            g_value_set_uint(value, priv->num_channels);
+            break;
+        case PROP_NUM_SECTIONS:
+            g_value_set_uint(value, priv->sections->len);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID(object, propid, spec);
+    }
+}
+
+static GParamSpec* filter_properties[N_PROPERTIES] = {NULL, };
+
+static void
+edf_filter_class_init(EdfFilterClass* klass)
+{
+    GObjectClass* object_class = G_OBJECT_CLASS(klass);
+
+    object_class->set_property = edf_filter_set_property;
+    object_class->get_property = edf_filter_get_property;
+    object_class->finalize = edf_filter_finalize;
+
+    /**
+     * EdfFilter:sample-rate:
+     *
+     * The sample rate of the channels in Hz.
+     */
+    filter_properties[PROP_SAMPLE_RATE] = g_param_spec_double(
+            "sample-rate",
+            "Sample rate",
+            "The sample rate of the channels in Hz",
+            G_MINDOUBLE,
+            G_MAXDOUBLE,
+            1.0,
+            G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY
+            );
+
+    /**
+     * EdfFilter:num-channels:
+     *
+     * The number of channels that are filtered.
+     */
+    filter_properties[PROP_NUM_CHANNELS] = g_param_spec_uint(
+            "num-channels",
+            "Number of channels",
+            "The number of channels that are filtered",
+            1,
+            G_MAXUINT16,
+            1,
+            G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY
+            );
+
+    /**
+     * EdfFilter:num-sections:
+     *
+     * The number of second order sections of the cascade.
+     */
+    filter_properties[PROP_NUM_SECTIONS] = g_param_spec_uint(
+            "num-sections",
+            "Number of sections",
+            "The number of second order sections",
+            0,
+            G_MAXUINT,
+            0,
+            G_PARAM_READABLE
+            );
+
+    g_object_class_install_properties(
+            object_class, N_PROPERTIES, filter_properties
+            );
+}
+
+/**
+ * edf_filter_new:(constructor)
+ * @sample_rate: the sample rate of the channels in Hz
+ * @num_channels: the number of channels, at least 1
+ *
+ * Returns: a new #EdfFilter without sections, it passes the samples
+ *          unchanged.
+ */
+EdfFilter*
+edf_filter_new(gdouble sample_rate, guint num_channels)
+{
+    g_return_val_if_fail(sample_rate > 0, NULL);
+    g_return_val_if_fail(num_channels > 0, NULL);
+
+    return g_object_new(
+            EDF_TYPE_FILTER,
+            "sample-rate", sample_rate,
+            "num-channels", num_channels,
+            NULL
+            );
+}
+
+/**
+ * edf_filter_get_sample_rate:
+ * @filter: the filter
+ *
+ * Returns: the sample rate of the channels in Hz
+ */
+gdouble
+edf_filter_get_sample_rate(EdfFilter* filter)
+{
+    g_return_val_if_fail(EDF_IS_FILTER(filter), 0);
+    EdfFilterPrivate* priv = edf_filter_get_instance_private(filter);
+    return priv->sample_rate;
+}
+
+/**
+ * edf_filter_get_num_channels:
+ * @filter: the filter
+ *
+ * Returns: the number of channels that are filtered
+ */
+guint
+edf_filter_get_num_channels(EdfFilter* filter)
+{
+    g_return_val_if_fail(EDF_IS_FILTER(filter), 0);
+    EdfFilterPrivate* priv = edf_filter_get_instance_private(filter);
+    return priv->num_channels;
+}
+
+/**
+ * edf_filter_get_num_sections:
+ * @filter: the filter
+ *
+ * Returns: the number of second order sections of the cascade
+ */
+guint
+edf_filter_get_num_sections(EdfFilter* filter)
+{
+    g_return_val_if_fail(EDF_IS_FILTER(filter), 0);
+    EdfFilterPrivate* priv = edf_filter_get_instance_private(filter);
+    return priv->sections->len;
+}
+
+/* ************ design ************ */
+
+static void
+filter_append(EdfFilterPrivate* priv, const EdfBiquad* section)
+{
+    g_array_append_vals(priv->sections, section, 1);
+
+    // the state of the new section is zero, the rest is lost as well
+    gsize n = priv->sections->len * priv->num_channels;
+    g_free(priv->z1);
+    g_free(priv->z2);
+    priv->z1 = g_new0(gdouble, n);
+    priv->z2 = g_new0(gdouble, n);
+}
+
+static void
+filter_append_normalized(
+        EdfFilterPrivate   *priv,
+        gdouble             b0,
+        gdouble             b1,
+        gdouble             b2,
+        gdouble             a0,
+        gdouble             a1,
+        gdouble             a2
+        )
+{
+    EdfBiquad section = {
+        .b0 = b0 / a0,
+        .b1 = b1 / a0,
+        .b2 = b2 / a0,
+        .a1 = a1 / a0,
+        .a2 = a2 / a0
+    };
+    filter_append(priv, &section);
+}
+
+static gboolean
+filter_check_frequency(EdfFilterPrivate* priv, gdouble frequency, GError** error)
+{
+    if (!(frequency > 0 && frequency < priv->sample_rate / 2)) {
+        g_set_error(
+                error,
+                EDF_FILTER_ERROR,
+                EDF_FILTER_ERROR_FREQUENCY,
+                "The frequency %g Hz isn't between 0 and the Nyquist frequency %g Hz",
+                frequency,
+                priv->sample_rate / 2
+                );
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static gboolean
+filter_check_order(guint order, GError** error)
+{
+    if (order < 1 || order > MAX_ORDER) {
+        g_set_error(
+                error,
+                EDF_FILTER_ERROR,
+                EDF_FILTER_ERROR_DESIGN,
+                "The order %u isn't between 1 and %d",
+                order,
+                MAX_ORDER
+                );
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/*
+ * A Butterworth filter of order n is a cascade of n / 2 biquads whose
+ * quality factors follow from the angles of the poles, plus a first order
+ * section when n is odd. The sections are obtained with the bilinear
+ * transform, prewarped at the cutoff.
+ */
+static void
+filter_add_butterworth(
+        EdfFilterPrivate   *priv,
+        gdouble             cutoff,
+        guint               order,
+        gboolean            highpass
+        )
+{
+    gdouble w0 = 2 * G_PI * cutoff / priv->sample_rate;
+    gdouble cosw = cos(w0);
+    gdouble sinw = sin(w0);
+
+    if (order % 2) {
+        gdouble k = tan(w0 / 2);
+        if (highpass)
+            filter_append_normalized(priv, 1, -1, 0, 1 + k, k - 1, 0);
+        else
+            filter_append_normalized(priv, k, k, 0, 1 + k, k - 1, 0);
+    }
+
+    for (guint i = 1; i <= order / 2; i++) {
+        gdouble q = 1 / (2 * sin(G_PI * (2 * i - 1) / (2 * order)));
+        gdouble alpha = sinw / (2 * q);
+
+        if (highpass)
+            filter_append_normalized(
+                    priv,
+                    (1 + cosw) / 2, -(1 + cosw), (1 + cosw) / 2,
+                    1 + alpha, -2 * cosw, 1 - alpha
+                    );
+        else
+            filter_append_normalized(
+                    priv,
+                    (1 - cosw) / 2, 1 - cosw, (1 - cosw) / 2,
+                    1 + alpha, -2 * cosw, 1 - alpha
+                    );
+    }
+}
+
+/**
+ * edf_filter_add_section:
+ * @filter: the filter
+ * @b0: the coefficient of x[n]
+ * @b1: the coefficient of x[n-1]
+ * @b2: the coefficient of x[n-2]
+ * @a1: the coefficient of y[n-1]
+ * @a2: the coefficient of y[n-2]
+ *
+ * Appends the section y[n] = b0 x[n] + b1 x[n-1] + b2 x[n-2] - a1 y[n-1] -
+ * a2 y[n-2] to the cascade. Adding a section resets the state of the
+ * filter.
+ */
+void
+edf_filter_add_section(
+        EdfFilter  *filter,
+        gdouble     b0,
+        gdouble     b1,
+        gdouble     b2,
+        gdouble     a1,
+        gdouble     a2
+        )
+{
+    g_return_if_fail(EDF_IS_FILTER(filter));
+    EdfFilterPrivate* priv = edf_filter_get_instance_private(filter);
+
+    EdfBiquad section = {.b0 = b0, .b1 = b1, .b2 = b2, .a1 = a1, .a2 = a2};
+    filter_append(priv, &section);
+}
+
+/**
+ * edf_filter_add_lowpass:
+ * @filter: the filter
+ * @cutoff: the -3 dB frequency in Hz
+ * @order: the order of the filter, the response falls off with
+ *         6 dB per octave per order
+ * @error:(out): An error is returned here when @cutoff isn't below the
+ *               Nyquist frequency or @order is invalid
+ *
+ * Appends a Butterworth low pass filter to the cascade. Adding a filter
+ * resets the state.
+ *
+ * Returns: TRUE when the filter is added
+ */
+gboolean
+edf_filter_add_lowpass(EdfFilter* filter, gdouble cutoff, guint order, GError** error)
+{
+    g_return_val_if_fail(EDF_IS_FILTER(filter), FALSE);
+    g_return_val_if_fail(error != NULL && *error == NULL, FALSE);
+    EdfFilterPrivate* priv = edf_filter_get_instance_private(filter);
+
+    if (!filter_check_frequency(priv, cutoff, error) || !filter_check_order(order, error))
+        return FALSE;
+
+    filter_add_butterworth(priv, cutoff, order, FALSE);
+    return TRUE;
+}
+
+/**
+ * edf_filter_add_highpass:
+ * @filter: the filter
+ * @cutoff: the -3 dB frequency in Hz
+ * @order: the order of the filter, the response falls off with
+ *         6 dB per octave per order
+ * @error:(out): An error is returned here when @cutoff isn't below the
+ *               Nyquist frequency or @order is invalid
+ *
+ * Appends a Butterworth high pass filter to the cascade. Adding a filter
+ * resets the state.
+ *
+ * Returns: TRUE when the filter is added
+ */
+gboolean
+edf_filter_add_highpass(EdfFilter* filter, gdouble cutoff, guint order, GError** error)
+{
+    g_return_val_if_fail(EDF_IS_FILTER(filter), FALSE);
+    g_return_val_if_fail(error != NULL && *error == NULL, FALSE);
+    EdfFilterPrivate* priv = edf_filter_get_instance_private(filter);
+
+    if (!filter_check_frequency(priv, cutoff, error) || !filter_check_order(order, error))
+        return FALSE;
+
+    filter_add_butterworth(priv, cutoff, order, TRUE);
+    return TRUE;
+}
+
+/**
+ * edf_filter_add_notch:
+ * @filter: the filter
+ * @frequency: the frequency that is removed in Hz, e.g. 50 or 60 for
+ *             line noise
+ * @q: the quality factor, the frequency divided by the -3 dB bandwidth
+ * @error:(out): An error is returned here when @frequency isn't below the
+ *               Nyquist frequency or @q isn't positive
+ *
+ * Appends a notch filter to the cascade. Adding a filter resets the state.
+ *
+ * Returns: TRUE when the filter is added
+ */
+gboolean
+edf_filter_add_notch(EdfFilter* filter, gdouble frequency, gdouble q, GError** error)
+{
+    g_return_val_if_fail(EDF_IS_FILTER(filter), FALSE);
+    g_return_val_if_fail(error != NULL && *error == NULL, FALSE);
+    EdfFilterPrivate* priv = edf_filter_get_instance_private(filter);
+
+    if (!filter_check_frequency(priv, frequency, error))
+        return FALSE;
+    if (!(q > 0)) {
+        g_set_error(
+                error,
+                EDF_FILTER_ERROR,
+                EDF_FILTER_ERROR_DESIGN,
+                "The quality factor %g isn't positive",
+                q
+                );
+        return FALSE;
+    }
+
+    gdouble w0 = 2 * G_PI * frequency / priv->sample_rate;
+    gdouble alpha = sin(w0) / (2 * q);
+    filter_append_normalized(
+            priv,
+            1, -2 * cos(w0), 1,
+            1 + alpha, -2 * cos(w0), 1 - alpha
+            );
+    return TRUE;
+}
+
+/**
+ * edf_filter_get_magnitude:
+ * @filter: the filter
+ * @frequency: a frequency in Hz
+ *
+ * Returns: the gain of the cascade for a sinusoid of @frequency
+ */
+gdouble
+edf_filter_get_magnitude(EdfFilter* filter, gdouble frequency)
+{
+    g_return_val_if_fail(EDF_IS_FILTER(filter), 0);
+    EdfFilterPrivate* priv = edf_filter_get_instance_private(filter);
+
+    gdouble w = 2 * G_PI * frequency / priv->sample_rate;
+    gdouble magnitude = 1;
+
+    for (guint s = 0; s < priv->sections->len; s++) {
+        const EdfBiquad* b = &g_array_index(priv->sections, EdfBiquad, s);
+        gdouble num_re = b->b0 + b->b1 * cos(w) + b->b2 * cos(2 * w);
+        gdouble num_im = -(b->b1 * sin(w) + b->b2 * sin(2 * w));
+        gdouble den_re = 1 + b->a1 * cos(w) + b->a2 * cos(2 * w);
+        gdouble den_im = -(b->a1 * sin(w) + b->a2 * sin(2 * w));
+
+        magnitude *= hypot(num_re, num_im) / hypot(den_re, den_im);
+    }
+    return magnitude;
+}
+
+/* ************ filtering ************ */
+
+/**
+ * edf_filter_reset:
+ * @filter: the filter
+ *
+ * Clears the state of all channels, the next samples are filtered as the
+ * start of a new signal.
+ */
+void
+edf_filter_reset(EdfFilter* filter)
+{
+    g_return_if_fail(EDF_IS_FILTER(filter));
+    EdfFilterPrivate* priv = edf_filter_get_instance_private(filter);
+
+    gsize n = priv->sections->len * priv->num_channels;
+    if (n == 0)
+        return;
+    memset(priv->z1, 0, n * sizeof(gdouble));
+    memset(priv->z2, 0, n * sizeof(gdouble));
+}
+
+/*
+ * Filters frames of num_channels interleaved samples. The innermost loop
+ * runs over the channels, whose state is contiguous per section.
+ */
+static void
+filter_run_frames(EdfFilterPrivate* priv, gdouble* restrict frames, gsize num_frames)
+{
+    const EdfBiquad* sections = (const EdfBiquad*) priv->sections->data;
+    const guint nsec = priv->sections->len;
+    const guint nc = priv->num_channels;
+
+    for (gsize f = 0; f < num_frames; f++) {
+        gdouble* restrict x = &frames[f * nc];
+
+        for (guint s = 0; s < nsec; s++) {
+            const EdfBiquad sec = sections[s];
+            gdouble* restrict z1 = &priv->z1[s * nc];
+            gdouble* restrict z2 = &priv->z2[s * nc];
+
+            for (guint c = 0; c < nc; c++) {
+                gdouble in = x[c];
+                gdouble y = sec.b0 * in + z1[c];
+                z1[c] = sec.b1 * in - sec.a1 * y + z2[c];
+                z2[c] = sec.b2 * in - sec.a2 * y;
+                x[c] = y;
+            }
+        }
+    }
+}
+
+/* Filters the samples of one channel through one section */
+static void
+filter_run_section(
+        const EdfBiquad    *sec,
+        gdouble            *z1,
+        gdouble            *z2,
+        gdouble            *samples,
+        gsize               num_samples,
+        gssize              step
+        )
+{
+    gdouble s1 = *z1, s2 = *z2;
+    gdouble* x = step > 0 ? samples : samples + num_samples - 1;
+
+    for (gsize i = 0; i < num_samples; i++, x += step) {
+        gdouble in = *x;
+        gdouble y = sec->b0 * in + s1;
+        s1 = sec->b1 * in - sec->a1 * y + s2;
+        s2 = sec->b2 * in - sec->a2 * y;
+        *x = y;
+    }
+    *z1 = s1;
+    *z2 = s2;
+}
+
+/**
+ * edf_filter_process:(skip)
+ * @filter: the filter
+ * @channels: an array of edf_filter_get_num_channels() arrays, the samples
+ *            of each channel
+ * @num_samples: the number of samples of every channel
+ *
+ * Filters the next @num_samples samples of every channel in place. The
+ * samples continue the samples of the previous call.
+ */
+void
+edf_filter_process(EdfFilter* filter, gdouble* const* channels, gsize num_samples)
+{
+    g_return_if_fail(EDF_IS_FILTER(filter));
+    g_return_if_fail(channels != NULL);
+    EdfFilterPrivate* priv = edf_filter_get_instance_private(filter);
+    const guint nc = priv->num_channels;
+
+    if (priv->sections->len == 0)
+        return;
+    if (!priv->block)
+        priv->block = g_new(gdouble, (gsize) BLOCK_FRAMES * nc);
+
+    for (gsize start = 0; start < num_samples; start += BLOCK_FRAMES) {
+        gsize n = MIN(BLOCK_FRAMES, num_samples - start);
+
+        for (guint c = 0; c < nc; c++)
+            for (gsize i = 0; i < n; i++)
+                priv->block[i * nc + c] = channels[c][start + i];
+
+        filter_run_frames(priv, priv->block, n);
+
+        for (guint c = 0; c < nc; c++)
+            for (gsize i = 0; i < n; i++)
+                channels[c][start + i] = priv->block[i * nc + c];
+    }
+}
+
+/**
+ * edf_filter_process_interleaved:(skip)
+ * @filter: the filter
+ * @samples: frames of edf_filter_get_num_channels() samples, one of each
+ *           channel
+ * @num_frames: the number of frames
+ *
+ * Filters the next @num_frames frames in place. The frames continue the
+ * samples of the previous call.
+ */
+void
+edf_filter_process_interleaved(EdfFilter* filter, gdouble* samples, gsize num_frames)
+{
+    g_return_if_fail(EDF_IS_FILTER(filter));
+    g_return_if_fail(samples != NULL || num_frames == 0);
+    EdfFilterPrivate* priv = edf_filter_get_instance_private(filter);
+
+    filter_run_frames(priv, samples, num_frames);
+}
+
+/**
+ * edf_filter_process_channel:
+ * @filter: the filter
+ * @channel: the index of the channel
+ * @samples:(array length=num_samples)(inout): the samples of @channel
+ * @num_samples: the number of samples
+ *
+ * Filters the next @num_samples samples of one channel in place. The state
+ * of the other channels isn't changed.
+ */
+void
+edf_filter_process_channel(
+        EdfFilter  *filter,
+        guint       channel,
+        gdouble    *samples,
+        gsize       num_samples
+        )
+{
+    g_return_if_fail(EDF_IS_FILTER(filter));
+    g_return_if_fail(samples != NULL || num_samples == 0);
+    EdfFilterPrivate* priv = edf_filter_get_instance_private(filter);
+    g_return_if_fail(channel < priv->num_channels);
+
+    for (guint s = 0; s < priv->sections->len; s++) {
+        gsize index = s * priv->num_channels + channel;
+        filter_run_section(
+                &g_array_index(priv->sections, EdfBiquad, s),
+                &priv->z1[index],
+                &priv->z2[index],
+                samples,
+                num_samples,
+                1
+                );
+    }
+}
+
+/*
+ * Filters a complete signal in the given direction starting from the
+ * steady state of the cascade for a constant input of x0.
+ */
+static void
+filter_run_steady(
+        EdfFilterPrivate   *priv,
+        gdouble            *samples,
+        gsize               num_samples,
+        gssize              step
+        )
+{
+    gdouble u = step > 0 ? samples[0] : samples[num_samples - 1];
+
+    for (guint s = 0; s < priv->sections->len; s++) {
+        const EdfBiquad* sec = &g_array_index(priv->sections, EdfBiquad, s);
+        gdouble den = 1 + sec->a1 + sec->a2;
+        gdouble gain = fabs(den) > 1e-12 ? (sec->b0 + sec->b1 + sec->b2) / den : 0;
+        gdouble y = gain * u;
+        gdouble z1 = y - sec->b0 * u;
+        gdouble z2 = sec->b2 * u - sec->a2 * y;
+
+        filter_run_section(sec, &z1, &z2, samples, num_samples, step);
+        u = y;
+    }
+}
+
+/**
+ * edf_filter_process_zero_phase:
+ * @filter: the filter
+ * @samples:(array length=num_samples)(inout): a complete signal
+ * @num_samples: the number of samples
+ *
+ * Filters a complete signal forward and backward, so the phase shift of
+ * the cascade cancels and its magnitude response is squared. The ends of
+ * the signal are extended by point reflection and the filter starts from
+ * its steady state, which reduces the transients at the edges. This
+ * doesn't use or change the state of the channels.
+ */
+void
+edf_filter_process_zero_phase(EdfFilter* filter, gdouble* samples, gsize num_samples)
+{
+    g_return_if_fail(EDF_IS_FILTER(filter));
+    g_return_if_fail(samples != NULL || num_samples == 0);
+    EdfFilterPrivate* priv = edf_filter_get_instance_private(filter);
+
+    if (num_samples == 0 || priv->sections->len == 0)
+        return;
+
+    gsize pad = MIN(3 * (2 * (gsize) priv->sections->len + 1), num_samples - 1);
+    gsize n = num_samples + 2 * pad;
+    gdouble* ext = g_new(gdouble, n);
+
+    memcpy(&ext[pad], samples, num_samples * sizeof(gdouble));
+    for (gsize k = 0; k < pad; k++) {
+        ext[pad - 1 - k] = 2 * samples[0] - samples[k + 1];
+        ext[pad + num_samples + k] =
+            2 * samples[num_samples - 1] - samples[num_samples - 2 - k];
+    }
+
+    filter_run_steady(priv, ext, n, 1);
+    filter_run_steady(priv, ext, n, -1);
+
+    memcpy(samples, &ext[pad], num_samples * sizeof(gdouble));
+    g_free(ext);
+}
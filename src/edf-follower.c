@@ -0,0 +1,677 @@
+
+#include "edf-follower.h"
+#include "edf-file-priv.h"
+#include "edf-header-priv.h"
+#include "edf-parse-priv.h"
+#include "edf-signal.h"
+#include "edf-signal-priv.h"
+
+#include <string.h>
+
+/**
+ * SECTION:edf-follower
+ * @short_description: follows a file while it is being recorded
+ * @see_also: #EdfFile, #EdfHeader
+ * @include: gedf.h
+ *
+ * Acquisition software writes a bdf/edf file continuously, first the
+ * header and then a record at a time. edf_file_read() reads a file once,
+ * an #EdfFollower keeps reading a file while it grows. Every record that
+ * is complete on disk is appended to the signals of the header of the
+ * follower and the #EdfFollower::records-added signal is emitted for each
+ * batch of new records.
+ *
+ * The follower watches the file with a #GFileMonitor and checks its size
+ * every #EdfFollower:poll-interval milliseconds as well, because a monitor
+ * doesn't see the changes on every file system, e.g. on network shares.
+ * The file doesn't have to exist when the follower is started, its header
+ * is read as soon as it is complete.
+ *
+ * |[<!-- language="C" -->
+ * static void
+ * on_records(EdfFollower* follower, guint64 first, guint n, gpointer data)
+ * {
+ *     EdfHeader* header = edf_follower_get_header(follower);
+ *     GPtrArray* signals = edf_header_get_signals(header);
+ *     // the records first up to first + n of the signals are new
+ * }
+ *
+ * EdfFollower* follower = edf_follower_new("recording.bdf");
+ * g_signal_connect(follower, "records-added", G_CALLBACK(on_records), NULL);
+ * edf_follower_start(follower, &error);
+ * g_main_loop_run(loop);
+ * ]|
+ *
+ * While a file is recorded the number of records in its header is often -1
+ * or it is only updated now and then, so the follower ignores it and
+ * derives the number of complete records from the size of the file. The
+ * signals of the follower grow with the recording, unless
+ * #EdfFollower:ring-capacity is set, then they keep the latest records in
+ * a ring buffer and the memory stays constant. The follower works in
+ * the thread default main context of the thread that started it. Files
+ * that are compressed while they are recorded can't be followed.
+ */
+
+G_DEFINE_QUARK(edf_follower_error_quark, edf_follower_error)
+
+// Check the size of the file this often when no interval is set
+#define DEFAULT_POLL_INTERVAL   1000
+
+typedef struct _EdfFollowerPrivate {
+    GFile              *file;
+    GFileInputStream   *istream;    // NULL until the file exists
+    EdfHeader          *header;     // NULL until the header is complete
+    gsize               header_size;
+    gsize               record_size;
+    guint64             num_records;
+    guint               poll_interval;
+    guint               ring_capacity;
+    GFileMonitor       *monitor;
+    GSource            *timeout;    // attached to the thread default context
+    gboolean            started;
+} EdfFollowerPrivate;
+
+G_DEFINE_TYPE_WITH_PRIVATE(EdfFollower, edf_follower, G_TYPE_OBJECT)
+
+typedef enum {
+    PROP_PATH = 1,
+    PROP_POLL_INTERVAL,
+    PROP_RING_CAPACITY,
+    PROP_HEADER,
+    PROP_NUM_RECORDS,
+    N_PROPERTIES
+} EdfFollowerProperty;
+
+typedef enum {
+    SIGNAL_RECORDS_ADDED,
+    SIGNAL_FAILED,
+    N_SIGNALS
+} EdfFollowerSignal;
+
+static GParamSpec* follower_properties[N_PROPERTIES] = {NULL, };
+static guint follower_signals[N_SIGNALS] = {0, };
+
+static void
+edf_follower_init(EdfFollower* self)
+{
+    EdfFollowerPrivate* priv = edf_follower_get_instance_private(self);
+
+    priv->file = g_file_new_for_path("");
+    priv->poll_interval = DEFAULT_POLL_INTERVAL;
+}
+
+static void
+edf_follower_dispose(GObject* gobject)
+{
+    EdfFollower* self = EDF_FOLLOWER(gobject);
+    EdfFollowerPrivate* priv = edf_follower_get_instance_private(self);
+
+    edf_follower_stop(self);
+    g_clear_object(&priv->istream);
+    g_clear_object(&priv->header);
+    g_clear_object(&priv->file);
+
+    G_OBJECT_CLASS(edf_follower_parent_class)->dispose(gobject);
+}
+
+static void
+edf_follower_set_property(
+        GObject        *object,
+        guint32         propid,
+        const GValue   *value,
+        GParamSpec     *spec
+        )
+{
+    EdfFollowerPrivate* priv = edf_follower_get_instance_private(EDF_FOLLOWER(object));
+
+    switch ((EdfFollowerProperty) propid) {
+        case PROP_PATH:
+            g_clear_object(&priv->file);
+            priv->file = g_file_new_for_path(
+                    g_value_get_string(value) ? g_value_get_string(value) : ""
+                    );
+            break;
+        case PROP_POLL_INTERVAL:
+            priv->poll_interval = g_value_get_uint(value);
+            break;
+        case PROP_RING_CAPACITY:
+            priv->ring_capacity = g_value_get_uint(value);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID(object, propid, spec);
+    }
+}
+
+static void
+edf_follower_get_property(
+        GObject    *object,
+        guint32     propid,
+        GValue     *value,
+        GParamSpec *spec
+        )
+{
+    EdfFollowerPrivate* priv = edf_follower_get_instance_private(EDF_FOLLOWER(object));
+
+    switch ((EdfFollowerProperty) propid) {
+        case PROP_PATH:
+            g_value_take_string(value, g_file_get_path(priv->file));
+            break;
+        case PROP_POLL_INTERVAL:
+            g_value_set_uint(value, priv->poll_interval);
+            break;
+        case PROP_RING_CAPACITY:
+            g_value_set_uint(value, priv->ring_capacity);
+            break;
+        case PROP_HEADER:
+            g_value_set_object(value, priv->header);
+            break;
+        case PROP_NUM_RECORDS:
+            g_value_set_uint64(value, priv->num_records);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID(object, propid, spec);
+    }
+}
+
+static void
+edf_follower_class_init(EdfFollowerClass* klass)
+{
+    GObjectClass* object_class = G_OBJECT_CLASS(klass);
+
+    object_class->set_property = edf_follower_set_property;
+    object_class->get_property = edf_follower_get_property;
+    object_class->dispose = edf_follower_dispose;
+
+    /**
+     * EdfFollower:path:
+     *
+     * The path of the file that is followed.
+     */
+    follower_properties[PROP_PATH] = g_param_spec_string(
+            "path",
+            "Path",
+            "The path of the file that is followed",
+            NULL,
+            G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY
+            );
+
+    /**
+     * EdfFollower:poll-interval:
+     *
+     * The interval in milliseconds at which the size of the file is checked
+     * in addition to the #GFileMonitor. With 0 only the monitor is used,
+     * unless it isn't available. A change takes effect when the follower
+     * is started.
+     */
+    follower_properties[PROP_POLL_INTERVAL] = g_param_spec_uint(
+            "poll-interval",
+            "Poll interval",
+            "The interval in milliseconds at which the file is checked",
+            0,
+            G_MAXUINT,
+            DEFAULT_POLL_INTERVAL,
+            G_PARAM_READWRITE
+            );
+
+    /**
+     * EdfFollower:ring-capacity:
+     *
+     * When not 0 the signals keep only this number of the latest records,
+     * see edf_signal_set_ring_capacity(). It must be set before the header
+     * is read.
+     */
+    follower_properties[PROP_RING_CAPACITY] = g_param_spec_uint(
+            "ring-capacity",
+            "Ring capacity",
+            "The number of records that the signals keep, 0 for all",
+            0,
+            G_MAXUINT,
+            0,
+            G_PARAM_READWRITE
+            );
+
+    /**
+     * EdfFollower:header:
+     *
+     * The header of the file, NULL until it is complete on disk. The
+     * records that are read are appended to its signals.
+     */
+    follower_properties[PROP_HEADER] = g_param_spec_object(
+            "header",
+            "Header",
+            "The header of the file",
+            EDF_TYPE_HEADER,
+            G_PARAM_READABLE
+            );
+
+    /**
+     * EdfFollower:num-records:
+     *
+     * The number of records that have been read.
+     */
+    follower_properties[PROP_NUM_RECORDS] = g_param_spec_uint64(
+            "num-records",
+            "Number of records",
+            "The number of records that have been read",
+            0,
+            G_MAXUINT64,
+            0,
+            G_PARAM_READABLE
+            );
+
+    g_object_class_install_properties(
+            object_class, N_PROPERTIES, follower_properties
+            );
+
+    /**
+     * EdfFollower::records-added:
+     * @follower: the follower
+     * @first_record: the index of the first new record
+     * @num_records: the number of new records
+     *
+     * Emitted when complete records have been appended to the signals of
+     * the header of @follower.
+     */
+    follower_signals[SIGNAL_RECORDS_ADDED] = g_signal_new(
+            "records-added",
+            G_TYPE_FROM_CLASS(klass),
+            G_SIGNAL_RUN_LAST,
+            G_STRUCT_OFFSET(EdfFollowerClass, records_added),
+            NULL,
+            NULL,
+            NULL,
+            G_TYPE_NONE,
+            2,
+            G_TYPE_UINT64,
+            G_TYPE_UINT
+            );
+
+    /**
+     * EdfFollower::failed:
+     * @follower: the follower
+     * @error: what went wrong
+     *
+     * Emitted when the file can't be followed anymore after the follower
+     * was started, the follower is stopped then.
+     */
+    follower_signals[SIGNAL_FAILED] = g_signal_new(
+            "failed",
+            G_TYPE_FROM_CLASS(klass),
+            G_SIGNAL_RUN_LAST,
+            0,
+            NULL,
+            NULL,
+            NULL,
+            G_TYPE_NONE,
+            1,
+            G_TYPE_ERROR
+            );
+}
+
+/**
+ * edf_follower_new:(constructor)
+ * @path: the path of the file to follow, it doesn't have to exist yet
+ *
+ * Returns: a new #EdfFollower, it doesn't read anything until
+ *          edf_follower_start() or edf_follower_poll() is called.
+ */
+EdfFollower*
+edf_follower_new(const gchar* path)
+{
+    g_return_val_if_fail(path != NULL, NULL);
+
+    return g_object_new(EDF_TYPE_FOLLOWER, "path", path, NULL);
+}
+
+/**
+ * edf_follower_get_header:
+ * @follower: the follower
+ *
+ * Returns:(transfer none)(nullable): the header of the file or NULL when
+ *         it hasn't been written completely yet.
+ */
+EdfHeader*
+edf_follower_get_header(EdfFollower* follower)
+{
+    g_return_val_if_fail(EDF_IS_FOLLOWER(follower), NULL);
+    EdfFollowerPrivate* priv = edf_follower_get_instance_private(follower);
+    return priv->header;
+}
+
+/**
+ * edf_follower_get_num_records:
+ * @follower: the follower
+ *
+ * Returns: the number of records that have been read
+ */
+guint64
+edf_follower_get_num_records(EdfFollower* follower)
+{
+    g_return_val_if_fail(EDF_IS_FOLLOWER(follower), 0);
+    EdfFollowerPrivate* priv = edf_follower_get_instance_private(follower);
+    return priv->num_records;
+}
+
+/* ************ reading ************ */
+
+static gboolean
+follower_read_at(
+        EdfFollowerPrivate *priv,
+        goffset             offset,
+        guint8             *bytes,
+        gsize               size,
+        GError            **error
+        )
+{
+    gsize nread = 0;
+
+    if (!g_seekable_seek(G_SEEKABLE(priv->istream), offset, G_SEEK_SET, NULL, error))
+        return FALSE;
+    if (!g_input_stream_read_all(
+                G_INPUT_STREAM(priv->istream), bytes, size, &nread, NULL, error
+                ))
+        return FALSE;
+    if (nread != size) {
+        g_set_error(
+                error, EDF_FOLLOWER_ERROR, EDF_FOLLOWER_ERROR_SHRUNK,
+                "The file became shorter while it was read"
+                );
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/*
+ * Reads the header once it is complete in a file of size bytes.
+ *
+ * Returns: FALSE when the header isn't complete yet or an error occurred
+ */
+static gboolean
+follower_read_header(EdfFollower* self, guint64 size, GError** error)
+{
+    EdfFollowerPrivate* priv = edf_follower_get_instance_private(self);
+    EdfParsedHeader parsed = {0};
+    guint8 base[EDF_BASE_HEADER_SIZE];
+
+    if (size < EDF_BASE_HEADER_SIZE)
+        return FALSE;
+
+    if (!follower_read_at(priv, 0, base, sizeof(base), error))
+        return FALSE;
+
+    if (edf_file_is_compressed(base, sizeof(base))) {
+        g_set_error(
+                error, EDF_FOLLOWER_ERROR, EDF_FOLLOWER_ERROR_UNSUPPORTED,
+                "A compressed file can't be followed"
+                );
+        return FALSE;
+    }
+
+    if (!edf_parsed_header_parse_base(&parsed, base, error))
+        return FALSE;
+    if (size < parsed.header_size)
+        return FALSE;
+
+    if (!g_seekable_seek(G_SEEKABLE(priv->istream), 0, G_SEEK_SET, NULL, error))
+        return FALSE;
+    EdfHeader* header = edf_header_new_from_input_stream(
+            G_INPUT_STREAM(priv->istream), error
+            );
+    if (!header)
+        return FALSE;
+
+    if (edf_header_get_record_size(header) == 0) {
+        g_set_error(
+                error, EDF_FOLLOWER_ERROR, EDF_FOLLOWER_ERROR_FAILED,
+                "The records of the file don't contain samples"
+                );
+        g_object_unref(header);
+        return FALSE;
+    }
+
+    GPtrArray* signals = edf_header_get_signals(header);
+    for (guint i = 0; i < signals->len && priv->ring_capacity; i++)
+        edf_signal_set_ring_capacity(g_ptr_array_index(signals, i), priv->ring_capacity);
+
+    priv->header = header;
+    priv->header_size = parsed.header_size;
+    priv->record_size = edf_header_get_record_size(header);
+    g_object_notify_by_pspec(G_OBJECT(self), follower_properties[PROP_HEADER]);
+    return TRUE;
+}
+
+/* Opens the file if it exists, FALSE when it doesn't exist yet or on error */
+static gboolean
+follower_open(EdfFollowerPrivate* priv, GError** error)
+{
+    GError* local = NULL;
+
+    if (priv->istream)
+        return TRUE;
+
+    priv->istream = g_file_read(priv->file, NULL, &local);
+    if (!priv->istream) {
+        if (g_error_matches(local, G_IO_ERROR, G_IO_ERROR_NOT_FOUND))
+            g_error_free(local);
+        else
+            g_propagate_error(error, local);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/**
+ * edf_follower_poll:
+ * @follower: the follower
+ * @error:(out): An error is returned here when the file can't be read
+ *
+ * Reads the records that have been completed since the last call and
+ * emits #EdfFollower::records-added when there are any. The header is
+ * read first, as soon as it is complete. edf_follower_start() calls this
+ * function whenever the file changes, it may be called directly when the
+ * program has its own way of knowing that the file has grown.
+ *
+ * Returns: the number of new records
+ */
+guint
+edf_follower_poll(EdfFollower* follower, GError** error)
+{
+    g_return_val_if_fail(EDF_IS_FOLLOWER(follower), 0);
+    g_return_val_if_fail(error != NULL && *error == NULL, 0);
+
+    EdfFollowerPrivate* priv = edf_follower_get_instance_private(follower);
+
+    if (!follower_open(priv, error))
+        return 0;
+
+    GFileInfo* info = g_file_input_stream_query_info(
+            priv->istream, G_FILE_ATTRIBUTE_STANDARD_SIZE, NULL, error
+            );
+    if (!info)
+        return 0;
+    guint64 size = g_file_info_get_size(info);
+    g_object_unref(info);
+
+    if (!priv->header && !follower_read_header(follower, size, error))
+        return 0;
+
+    guint64 complete = size < priv->header_size ? 0 :
+                       (size - priv->header_size) / priv->record_size;
+    if (complete < priv->num_records || size < priv->header_size) {
+        g_set_error(
+                error, EDF_FOLLOWER_ERROR, EDF_FOLLOWER_ERROR_SHRUNK,
+                "The file contains %" G_GUINT64_FORMAT " records, %"
+                G_GUINT64_FORMAT " have been read already",
+                complete,
+                priv->num_records
+                );
+        return 0;
+    }
+
+    guint num_new = (guint) MIN(complete - priv->num_records, G_MAXUINT);
+    if (num_new == 0)
+        return 0;
+
+    GPtrArray* signals = edf_header_get_signals(priv->header);
+    goffset offset = priv->header_size + priv->num_records * priv->record_size;
+    guint rec;
+
+    if (!g_seekable_seek(G_SEEKABLE(priv->istream), offset, G_SEEK_SET, NULL, error))
+        return 0;
+
+    for (rec = 0; rec < num_new && !*error; rec++) {
+        for (guint i = 0; i < signals->len && !*error; i++) {
+            EdfSignal* signal = g_ptr_array_index(signals, i);
+            gsize expected = (gsize) edf_signal_get_num_samples_per_record(signal) *
+                             edf_signal_get_sample_size(signal);
+            gsize nread = edf_signal_read_record_from_istream(
+                    signal, G_INPUT_STREAM(priv->istream), error
+                    );
+            if (!*error && nread != expected)
+                g_set_error(
+                        error, EDF_FOLLOWER_ERROR, EDF_FOLLOWER_ERROR_SHRUNK,
+                        "The file became shorter while it was read"
+                        );
+        }
+    }
+
+    if (*error) {
+        // Only complete records are kept, a ring buffer numbers them from
+        // its oldest record
+        for (guint i = 0; i < signals->len; i++) {
+            EdfSignal* signal = g_ptr_array_index(signals, i);
+            guint64 dropped = edf_signal_get_num_dropped_records(signal);
+            edf_signal_truncate_records(
+                    signal, priv->num_records > dropped ? priv->num_records - dropped : 0
+                    );
+        }
+        return 0;
+    }
+
+    guint64 first = priv->num_records;
+    priv->num_records += num_new;
+    g_object_notify_by_pspec(G_OBJECT(follower), follower_properties[PROP_NUM_RECORDS]);
+    g_signal_emit(follower, follower_signals[SIGNAL_RECORDS_ADDED], 0, first, num_new);
+
+    return num_new;
+}
+
+/* ************ following ************ */
+
+static void
+follower_poll_or_fail(EdfFollower* self)
+{
+    GError* error = NULL;
+
+    g_object_ref(self);
+    edf_follower_poll(self, &error);
+    if (error) {
+        edf_follower_stop(self);
+        g_signal_emit(self, follower_signals[SIGNAL_FAILED], 0, error);
+        g_error_free(error);
+    }
+    g_object_unref(self);
+}
+
+static void
+follower_on_changed(
+        GFileMonitor       *monitor,
+        GFile              *file,
+        GFile              *other,
+        GFileMonitorEvent   event,
+        gpointer            data
+        )
+{
+    (void) monitor;
+    (void) file;
+    (void) other;
+
+    if (event == G_FILE_MONITOR_EVENT_CHANGED ||
+        event == G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT ||
+        event == G_FILE_MONITOR_EVENT_CREATED)
+        follower_poll_or_fail(EDF_FOLLOWER(data));
+}
+
+static gboolean
+follower_on_timeout(gpointer data)
+{
+    follower_poll_or_fail(EDF_FOLLOWER(data));
+    return G_SOURCE_CONTINUE;
+}
+
+/**
+ * edf_follower_start:
+ * @follower: the follower
+ * @error:(out): An error is returned here when the file can't be read
+ *
+ * Reads what is in the file already and keeps following it in the
+ * thread default main context until edf_follower_stop() is called or an
+ * error occurs, which is reported with #EdfFollower::failed.
+ *
+ * Returns: TRUE when the follower was started
+ */
+gboolean
+edf_follower_start(EdfFollower* follower, GError** error)
+{
+    g_return_val_if_fail(EDF_IS_FOLLOWER(follower), FALSE);
+    g_return_val_if_fail(error != NULL && *error == NULL, FALSE);
+
+    EdfFollowerPrivate* priv = edf_follower_get_instance_private(follower);
+    GError* local = NULL;
+    guint interval = priv->poll_interval;
+
+    if (priv->started)
+        return TRUE;
+
+    edf_follower_poll(follower, error);
+    if (*error)
+        return FALSE;
+
+    // Without a monitor polling is the only way to notice changes
+    priv->monitor = g_file_monitor_file(priv->file, G_FILE_MONITOR_NONE, NULL, &local);
+    if (priv->monitor) {
+        g_signal_connect(
+                priv->monitor, "changed", G_CALLBACK(follower_on_changed), follower
+                );
+    }
+    else {
+        g_clear_error(&local);
+        if (interval == 0)
+            interval = DEFAULT_POLL_INTERVAL;
+    }
+
+    if (interval > 0) {
+        GMainContext* context = g_main_context_ref_thread_default();
+        priv->timeout = g_timeout_source_new(interval);
+        g_source_set_callback(priv->timeout, follower_on_timeout, follower, NULL);
+        g_source_attach(priv->timeout, context);
+        g_main_context_unref(context);
+    }
+
+    priv->started = TRUE;
+    return TRUE;
+}
+
+/**
+ * edf_follower_stop:
+ * @follower: the follower
+ *
+ * Stops following the file, the records that were read remain available.
+ */
+void
+edf_follower_stop(EdfFollower* follower)
+{
+    g_return_if_fail(EDF_IS_FOLLOWER(follower));
+    EdfFollowerPrivate* priv = edf_follower_get_instance_private(follower);
+
+    if (priv->monitor) {
+        g_signal_handlers_disconnect_by_data(priv->monitor, follower);
+        g_file_monitor_cancel(priv->monitor);
+        g_clear_object(&priv->monitor);
+    }
+    if (priv->timeout) {
+        g_source_destroy(priv->timeout);
+        g_clear_pointer(&priv->timeout, g_source_unref);
+    }
+    priv->started = FALSE;
+}
@@ -0,0 +1,436 @@
+
+#include "edf-header-cache-priv.h"
+#include "edf-header.h"
+
+#include <errno.h>
+#include <glib/gstdio.h>
+#include <string.h>
+
+/**
+ * SECTION:edf-header-cache
+ * @short_description: an on disk cache of parsed headers
+ * @see_also: #EdfFile, #EdfHeader
+ * @include: gedf.h
+ *
+ * Tools that open the same files over and over, such as a file browser,
+ * spend most of their time parsing the ascii headers and creating the
+ * #EdfSignal s that describe them. When #EdfFile:use-header-cache is set,
+ * edf_file_read() stores the parsed header of a file in a small binary
+ * file in the cache directory. The next time the file is opened its header
+ * is taken from the cache with one small read, as long as the path, size
+ * and modification time of the file are unchanged.
+ *
+ * The cache lives in "gedf/headers" below g_get_user_cache_dir(), which
+ * is $XDG_CACHE_HOME on most systems. Entries are never expired, use
+ * edf_header_cache_clear() to remove them.
+ */
+
+#define CACHE_SUFFIX    ".hdr"
+
+/* layout of a cache entry, all numbers are little endian */
+static const gchar cache_magic[8] = "GEDFHDR1";
+
+static GMutex   cache_lock;
+static gchar   *cache_dir;      /* NULL for the default */
+
+/* ************* writing entries ************** */
+
+static void
+put_u32(GByteArray* array, guint32 value)
+{
+    value = GUINT32_TO_LE(value);
+    g_byte_array_append(array, (const guint8*) &value, sizeof(value));
+}
+
+static void
+put_u64(GByteArray* array, guint64 value)
+{
+    value = GUINT64_TO_LE(value);
+    g_byte_array_append(array, (const guint8*) &value, sizeof(value));
+}
+
+static void
+put_double(GByteArray* array, gdouble value)
+{
+    guint64 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    put_u64(array, bits);
+}
+
+static void
+put_string(GByteArray* array, const gchar* str)
+{
+    guint32 length = strlen(str);
+    put_u32(array, length);
+    g_byte_array_append(array, (const guint8*) str, length);
+}
+
+/* ************* reading entries ************** */
+
+typedef struct {
+    const guint8   *bytes;
+    gsize           length;
+    gsize           pos;
+} CacheReader;
+
+static gboolean
+get_u32(CacheReader* reader, guint32* value)
+{
+    if (reader->length - reader->pos < sizeof(*value))
+        return FALSE;
+    memcpy(value, &reader->bytes[reader->pos], sizeof(*value));
+    *value = GUINT32_FROM_LE(*value);
+    reader->pos += sizeof(*value);
+    return TRUE;
+}
+
+static gboolean
+get_u64(CacheReader* reader, guint64* value)
+{
+    if (reader->length - reader->pos < sizeof(*value))
+        return FALSE;
+    memcpy(value, &reader->bytes[reader->pos], sizeof(*value));
+    *value = GUINT64_FROM_LE(*value);
+    reader->pos += sizeof(*value);
+    return TRUE;
+}
+
+static gboolean
+get_int(CacheReader* reader, gint* value)
+{
+    guint32 v;
+    if (!get_u32(reader, &v))
+        return FALSE;
+    *value = (gint32) v;
+    return TRUE;
+}
+
+static gboolean
+get_double(CacheReader* reader, gdouble* value)
+{
+    guint64 bits;
+    if (!get_u64(reader, &bits))
+        return FALSE;
+    memcpy(value, &bits, sizeof(*value));
+    return TRUE;
+}
+
+/* Reads a string into dest, that holds size bytes including the '\0' */
+static gboolean
+get_string(CacheReader* reader, gchar* dest, gsize size)
+{
+    guint32 length;
+    if (!get_u32(reader, &length) ||
+        length >= size ||
+        reader->length - reader->pos < length)
+        return FALSE;
+    memcpy(dest, &reader->bytes[reader->pos], length);
+    dest[length] = '\0';
+    reader->pos += length;
+    return TRUE;
+}
+
+/* ************* utility functions ************** */
+
+/* The entry of path, the name is a hash as paths may be long */
+static gchar*
+cache_entry_path(const gchar* path)
+{
+    gchar* dir = edf_header_cache_get_dir();
+    gchar* hash = g_compute_checksum_for_string(G_CHECKSUM_SHA1, path, -1);
+    gchar* name = g_strconcat(hash, CACHE_SUFFIX, NULL);
+    gchar* entry = g_build_filename(dir, name, NULL);
+
+    g_free(name);
+    g_free(hash);
+    g_free(dir);
+    return entry;
+}
+
+static gboolean
+cache_entry_parse(
+        CacheReader                *reader,
+        const EdfHeaderCacheKey    *key,
+        EdfParsedHeader            *header
+        )
+{
+    gchar magic[sizeof(cache_magic)];
+    guint64 size, mtime, header_size, num_records;
+    guint32 mtime_usec, path_length, stored_length, num_signals;
+
+    if (reader->length < sizeof(magic))
+        return FALSE;
+    memcpy(magic, reader->bytes, sizeof(magic));
+    reader->pos = sizeof(magic);
+    if (memcmp(magic, cache_magic, sizeof(magic)) != 0)
+        return FALSE;
+
+    if (!get_u64(reader, &size) || size != key->size ||
+        !get_u64(reader, &mtime) || mtime != key->mtime ||
+        !get_u32(reader, &mtime_usec) || mtime_usec != key->mtime_usec)
+        return FALSE;
+
+    // Entries are named after a hash of the path, so check the path itself
+    path_length = strlen(key->path);
+    if (!get_u32(reader, &stored_length) || stored_length != path_length ||
+        reader->length - reader->pos < path_length ||
+        memcmp(&reader->bytes[reader->pos], key->path, path_length) != 0)
+        return FALSE;
+    reader->pos += path_length;
+
+    if (!get_int(reader, &header->version) ||
+        !get_string(reader, header->patient, sizeof(header->patient)) ||
+        !get_string(reader, header->recording, sizeof(header->recording)) ||
+        !get_int(reader, &header->year) ||
+        !get_int(reader, &header->month) ||
+        !get_int(reader, &header->day) ||
+        !get_int(reader, &header->hour) ||
+        !get_int(reader, &header->minute) ||
+        !get_int(reader, &header->second) ||
+        !get_u64(reader, &header_size) ||
+        !get_string(reader, header->reserved, sizeof(header->reserved)) ||
+        !get_u64(reader, &num_records) ||
+        !get_double(reader, &header->record_duration) ||
+        !get_u32(reader, &num_signals))
+        return FALSE;
+
+    header->header_size = header_size;
+    header->num_records = (gint64) num_records;
+
+    // Every signal takes more than 64 bytes, so a corrupt count is caught
+    if (num_signals > (reader->length - reader->pos) / 64 ||
+        header_size != edf_compute_header_size(num_signals))
+        return FALSE;
+
+    header->num_signals = num_signals;
+    header->signals = g_new0(EdfParsedSignal, num_signals);
+    for (guint i = 0; i < num_signals; i++) {
+        EdfParsedSignal* sig = &header->signals[i];
+        if (!get_string(reader, sig->label, sizeof(sig->label)) ||
+            !get_string(reader, sig->transducer, sizeof(sig->transducer)) ||
+            !get_string(reader, sig->physical_dimension, sizeof(sig->physical_dimension)) ||
+            !get_double(reader, &sig->physical_min) ||
+            !get_double(reader, &sig->physical_max) ||
+            !get_int(reader, &sig->digital_min) ||
+            !get_int(reader, &sig->digital_max) ||
+            !get_string(reader, sig->prefiltering, sizeof(sig->prefiltering)) ||
+            !get_u32(reader, &sig->ns) ||
+            !get_u32(reader, &sig->sample_size) ||
+            !get_string(reader, sig->reserved, sizeof(sig->reserved)))
+            return FALSE;
+    }
+    return reader->pos == reader->length;
+}
+
+/* ************* private functions ************** */
+
+gboolean
+edf_header_cache_key_init(EdfHeaderCacheKey* key, GFile* file)
+{
+    g_return_val_if_fail(key != NULL, FALSE);
+    g_return_val_if_fail(G_IS_FILE(file), FALSE);
+
+    memset(key, 0, sizeof(EdfHeaderCacheKey));
+
+    GFileInfo* info = g_file_query_info(
+            file,
+            G_FILE_ATTRIBUTE_STANDARD_SIZE ","
+            G_FILE_ATTRIBUTE_TIME_MODIFIED ","
+            G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC,
+            G_FILE_QUERY_INFO_NONE,
+            NULL,
+            NULL
+            );
+    if (!info)
+        return FALSE;
+
+    key->size = g_file_info_get_size(info);
+    key->mtime = g_file_info_get_attribute_uint64(info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+    key->mtime_usec = g_file_info_get_attribute_uint32(
+            info, G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC
+            );
+    g_object_unref(info);
+
+    key->path = g_file_get_path(file);
+    return key->path != NULL;
+}
+
+void
+edf_header_cache_key_clear(EdfHeaderCacheKey* key)
+{
+    g_clear_pointer(&key->path, g_free);
+}
+
+gboolean
+edf_header_cache_lookup(const EdfHeaderCacheKey* key, EdfParsedHeader* header)
+{
+    g_return_val_if_fail(key != NULL && key->path != NULL, FALSE);
+    g_return_val_if_fail(header != NULL, FALSE);
+
+    gchar* entry = cache_entry_path(key->path);
+    gchar* contents = NULL;
+    gsize length = 0;
+
+    memset(header, 0, sizeof(EdfParsedHeader));
+
+    gboolean result = g_file_get_contents(entry, &contents, &length, NULL);
+    if (result) {
+        CacheReader reader = {(const guint8*) contents, length, 0};
+        result = cache_entry_parse(&reader, key, header);
+        if (!result)
+            edf_parsed_header_clear(header);
+    }
+
+    g_free(contents);
+    g_free(entry);
+    return result;
+}
+
+void
+edf_header_cache_store(const EdfHeaderCacheKey* key, const EdfParsedHeader* header)
+{
+    g_return_if_fail(key != NULL && key->path != NULL);
+    g_return_if_fail(header != NULL);
+
+    GError* error = NULL;
+    gchar* dir = edf_header_cache_get_dir();
+    gchar* entry = cache_entry_path(key->path);
+    GByteArray* data = g_byte_array_sized_new(256 + header->num_signals * 128);
+
+    g_byte_array_append(data, (const guint8*) cache_magic, sizeof(cache_magic));
+    put_u64(data, key->size);
+    put_u64(data, key->mtime);
+    put_u32(data, key->mtime_usec);
+    put_string(data, key->path);
+
+    put_u32(data, header->version);
+    put_string(data, header->patient);
+    put_string(data, header->recording);
+    put_u32(data, header->year);
+    put_u32(data, header->month);
+    put_u32(data, header->day);
+    put_u32(data, header->hour);
+    put_u32(data, header->minute);
+    put_u32(data, header->second);
+    put_u64(data, header->header_size);
+    put_string(data, header->reserved);
+    put_u64(data, (guint64) header->num_records);
+    put_double(data, header->record_duration);
+    put_u32(data, header->num_signals);
+
+    for (guint i = 0; i < header->num_signals; i++) {
+        const EdfParsedSignal* sig = &header->signals[i];
+        put_string(data, sig->label);
+        put_string(data, sig->transducer);
+        put_string(data, sig->physical_dimension);
+        put_double(data, sig->physical_min);
+        put_double(data, sig->physical_max);
+        put_u32(data, sig->digital_min);
+        put_u32(data, sig->digital_max);
+        put_string(data, sig->prefiltering);
+        put_u32(data, sig->ns);
+        put_u32(data, sig->sample_size);
+        put_string(data, sig->reserved);
+    }
+
+    if (g_mkdir_with_parents(dir, 0700) != 0)
+        g_debug("Unable to create header cache %s", dir);
+    // Written to a temporary file and renamed, so readers never see half an entry
+    else if (!g_file_set_contents(entry, (const gchar*) data->data, data->len, &error)) {
+        g_debug("Unable to store cached header: %s", error->message);
+        g_clear_error(&error);
+    }
+
+    g_byte_array_unref(data);
+    g_free(entry);
+    g_free(dir);
+}
+
+/* ************* public functions ************** */
+
+/**
+ * edf_header_cache_get_dir:
+ *
+ * The directory that holds the cached headers.
+ *
+ * Returns:(transfer full): the path of the cache directory
+ */
+gchar*
+edf_header_cache_get_dir(void)
+{
+    gchar* dir;
+
+    g_mutex_lock(&cache_lock);
+    if (cache_dir)
+        dir = g_strdup(cache_dir);
+    else
+        dir = g_build_filename(g_get_user_cache_dir(), "gedf", "headers", NULL);
+    g_mutex_unlock(&cache_lock);
+    return dir;
+}
+
+/**
+ * edf_header_cache_set_dir:
+ * @dir:(nullable): the directory for the cached headers or NULL for the
+ *                  default
+ *
+ * Moves the header cache of this process to @dir, e.g. for a sandbox that
+ * may not write to the user's cache directory. The directory is created
+ * when the first header is stored.
+ */
+void
+edf_header_cache_set_dir(const gchar* dir)
+{
+    g_mutex_lock(&cache_lock);
+    g_free(cache_dir);
+    cache_dir = g_strdup(dir);
+    g_mutex_unlock(&cache_lock);
+}
+
+/**
+ * edf_header_cache_clear:
+ * @error:(out): An error is returned here when the cache cannot be read
+ *
+ * Removes all cached headers.
+ *
+ * Returns: TRUE when the cache is empty afterwards
+ */
+gboolean
+edf_header_cache_clear(GError** error)
+{
+    g_return_val_if_fail(error != NULL && *error == NULL, FALSE);
+
+    gchar* dir_path = edf_header_cache_get_dir();
+    gboolean result = TRUE;
+
+    if (!g_file_test(dir_path, G_FILE_TEST_IS_DIR)) {
+        g_free(dir_path);
+        return TRUE;
+    }
+
+    GDir* dir = g_dir_open(dir_path, 0, error);
+    if (!dir) {
+        g_free(dir_path);
+        return FALSE;
+    }
+
+    const gchar* name;
+    while ((name = g_dir_read_name(dir))) {
+        if (!g_str_has_suffix(name, CACHE_SUFFIX))
+            continue;
+        gchar* entry = g_build_filename(dir_path, name, NULL);
+        if (g_remove(entry) != 0 && result) {
+            int saved_errno = errno;
+            g_set_error(
+                    error, G_FILE_ERROR, g_file_error_from_errno(saved_errno),
+                    "Unable to remove '%s': %s", entry, g_strerror(saved_errno)
+                    );
+            result = FALSE;
+        }
+        g_free(entry);
+    }
+
+    g_dir_close(dir);
+    g_free(dir_path);
+    return result;
+}
@@ -1,10 +1,13 @@
 
 #include "edf-header.h"
+#include "edf-header-priv.h"
 #include "edf-signal.h"
+#include "edf-signal-priv.h"
 #include "glibconfig.h"
 #include <glib.h>
 #include <string.h>
 #include "edf-size-priv.h"
+#include "edf-trace-priv.h"
 #include <stdio.h>
 
 /**
@@ -27,16 +30,27 @@ typedef struct _EdfHeaderPrivate {
     GString    *local_patient_identification;
     GString    *local_recording_identification;
     GDateTime  *date_and_time;
-    gint        num_records;
+    gint64      num_records;
+    gint64      expected_num_records;   /* see edf_header_set_expected_num_records() */
+    gboolean    expects_records;
     gdouble     duration_of_record;
 
     GString    *reserved;
 
     GPtrArray  *signals;
+
+    gboolean    frozen;     /* read only, see edf_file_freeze() */
 } EdfHeaderPrivate;
 
 G_DEFINE_TYPE_WITH_PRIVATE(EdfHeader, edf_header, G_TYPE_OBJECT)
 
+static gboolean
+header_is_mutable(EdfHeader* header)
+{
+    EdfHeaderPrivate* priv = edf_header_get_instance_private(header);
+    return !priv->frozen;
+}
+
 /* *********** helpers for the properties ************* */
 static void
 set_patient_identification(EdfHeader* hdr, const gchar* info)
@@ -131,13 +145,36 @@ set_num_signals(EdfHeader* hdr, gint num_signals)
     EdfHeaderPrivate* priv = edf_header_get_instance_private(hdr);
     g_return_if_fail(num_signals >= 0 && num_signals < 9999);
 
+    // BioSemi files store their samples in 24 bits
+    guint sample_size = priv->version == EDF_BIOSEMI_VERSION ?
+        BDF_SAMPLE_SIZE : EDF_SAMPLE_SIZE;
+
     g_ptr_array_set_size(priv->signals, num_signals);
     for (gsize i = 0; i < (gsize)num_signals; i++) {
-        EdfSignal* signal = edf_signal_new();
+        EdfSignal* signal = g_object_new(
+                EDF_TYPE_SIGNAL,
+                "sample-size", sample_size,
+                NULL
+                );
         g_ptr_array_index(priv->signals, i) = signal;
     }
 }
 
+/*
+ * A header describes a bdf file when its signals contain 24 bit samples.
+ */
+static gboolean
+header_is_bdf(EdfHeader* hdr)
+{
+    EdfHeaderPrivate* priv = edf_header_get_instance_private(hdr);
+    for (gsize i = 0; i < priv->signals->len; i++) {
+        EdfSignal* signal = g_ptr_array_index(priv->signals, i);
+        if (edf_signal_get_sample_size(signal) == BDF_SAMPLE_SIZE)
+            return TRUE;
+    }
+    return FALSE;
+}
+
 /* ********* functions to read an header ********** */
 
 static gsize
@@ -157,6 +194,18 @@ read_version (EdfHeader* hdr, GInputStream* stream, GError** error)
     }
     temp[EDF_VERSION_SZ] = '\0';
 
+    if ((guint8) temp[0] == 0xFF) {
+        // BioSemi marks its 24 bit files with "\xFFBIOSEMI"
+        if (memcmp(&temp[1], EDF_BIOSEMI_ID, strlen(EDF_BIOSEMI_ID)) != 0) {
+            g_set_error(error, edf_header_error_quark(), EDF_HEADER_ERROR_PARSE,
+                        "Invalid or unknown file version"
+            );
+            return nread;
+        }
+        priv->version = EDF_BIOSEMI_VERSION;
+        return nread;
+    }
+
     val = g_ascii_strtoll(temp, NULL, 10);
 
     priv->version = val;
@@ -313,7 +362,7 @@ read_num_bytes (EdfHeader* hdr, GInputStream* stream, GError** error)
             error, edf_header_error_quark(), EDF_HEADER_ERROR_PARSE,
             "the num bytes of the header is not a multiple of 256 %s", temp
             );
-        return num_bytes;
+        return nread;
     }
     return nread;
 }
@@ -348,7 +397,7 @@ read_num_records (EdfHeader* hdr, GInputStream* stream, GError** error)
 {
     char temp[256];
     gsize nread = 0;
-    gint num_recs;
+    gint64 num_recs;
     EdfHeaderPrivate *priv = edf_header_get_instance_private(hdr);
 
     // read start date and time
@@ -715,10 +764,18 @@ header_update(EdfHeader* self)
     g_assert(EDF_IS_HEADER (self));
     EdfHeaderPrivate* priv = edf_header_get_instance_private(self);
 
+    // A frozen header is shared by readers, it was updated when frozen.
+    if (priv->frozen)
+        return;
+
     if (priv->signals->len > 0) {
-        priv->num_records = edf_signal_get_num_records (
+        guint64 num_records = edf_signal_get_num_records (
             g_ptr_array_index(priv->signals, 0)
         );
+        if (num_records == 0 && priv->expects_records)
+            priv->num_records = priv->expected_num_records;
+        else
+            priv->num_records = (gint64) num_records;
     }
     else {
         priv->num_records = -1;
@@ -795,6 +852,8 @@ edf_header_set_property (
     EdfHeader* self = EDF_HEADER(object);
     EdfHeaderPrivate* priv = edf_header_get_instance_private(self);
 
+    g_return_if_fail(header_is_mutable(self));
+
     switch ((EdfHeaderProperty) propid) {
         case PROP_PATIENT_INFO:
             set_patient_identification(self, g_value_get_string(value));
@@ -812,7 +871,7 @@ edf_header_set_property (
             set_reserved(self, g_value_get_string(value));
             break;
         case PROP_NUM_DATA_RECORDS:
-            priv->num_records = g_value_get_int(value);
+            priv->num_records = g_value_get_int64(value);
             break;
         case PROP_VERSION:          // read only
         case PROP_NUM_BYTES_HEADER: // read only
@@ -856,7 +915,7 @@ edf_header_get_property (
             g_value_set_string(value, priv->reserved->str);
             break;
         case PROP_NUM_DATA_RECORDS:
-            g_value_set_int(value, priv->num_records);
+            g_value_set_int64(value, priv->num_records);
             break;
         case PROP_NUM_SIGNALS:
             g_value_set_uint(value, priv->signals->len);
@@ -908,6 +967,7 @@ edf_header_class_init(EdfHeaderClass* klass)
      * The header specifies a version (0 for EDF and EDF+) this
      * property can obtain that version. It is stored as string in
      * the header, but turned into an integer for programming.
+     * BioSemi bdf files are reported as version 255.
      */
     edf_header_properties[PROP_VERSION] = g_param_spec_int(
             "version",
@@ -994,14 +1054,15 @@ edf_header_class_init(EdfHeaderClass* klass)
      * EdfHeader:num-data_records
      *
      * The number of data records per signal. This can be -1 when recording
-     * otherwise it should be >= 0.
+     * otherwise it should be >= 0. The property is a 64 bit integer, so pass
+     * a #gint64 to g_object_get().
      */
-    edf_header_properties[PROP_NUM_DATA_RECORDS] = g_param_spec_int(
+    edf_header_properties[PROP_NUM_DATA_RECORDS] = g_param_spec_int64(
             "num-data-records",
             "number-of-data-records",
             "The number of data records stored in this file per signal.",
             -1,
-            G_MAXINT,
+            EDF_MAX_NUM_RECORDS,
             -1,
             G_PARAM_READABLE
             );
@@ -1084,6 +1145,7 @@ gboolean
 edf_header_set_signals(EdfHeader* header, GPtrArray* signals)
 {
     g_return_val_if_fail(EDF_IS_HEADER(header), FALSE);
+    g_return_val_if_fail(header_is_mutable(header), FALSE);
     header_set_signals(header, signals);
     return TRUE;
 }
@@ -1094,9 +1156,10 @@ edf_header_set_signals(EdfHeader* header, GPtrArray* signals)
  * @ostream:(inout):The output stream to which the header should be written.
  * @error:(out):If an error occurs it will be returned here.
  *
- * Writes an header to an output stream.
+ * Writes an header to an output stream. The records of the signals may
+ * be written to the stream afterwards, see
+ * edf_header_set_expected_num_records().
  *
- * private: for internal use only
  * Returns::the number of written bytes.
  */
 gsize
@@ -1122,11 +1185,17 @@ edf_header_write_to_ostream(
 
     // Write version
     memset (buffer, ' ', EDF_VERSION_SZ);
-    g_string_printf(temp, "%d", priv->version);
-    memcpy(buffer,
-            temp->str,
-            MIN(temp->len, EDF_VERSION_SZ)
-          );
+    if (header_is_bdf(header)) {
+        buffer[0] = (gchar) 0xFF;
+        memcpy(&buffer[1], EDF_BIOSEMI_ID, strlen(EDF_BIOSEMI_ID));
+    }
+    else {
+        g_string_printf(temp, "%d", priv->version);
+        memcpy(buffer,
+                temp->str,
+                MIN(temp->len, EDF_VERSION_SZ)
+              );
+    }
 
     result = g_output_stream_write_all(
             ostream, buffer, EDF_VERSION_SZ, &sz, NULL, error
@@ -1228,7 +1297,7 @@ edf_header_write_to_ostream(
     
     // Write number of data records
     memset (buffer, ' ', EDF_NUM_DATA_REC_SZ);
-    g_string_printf(temp, "%d", priv->num_records);
+    g_string_printf(temp, "%" G_GINT64_FORMAT, priv->num_records);
     memcpy(buffer,
             temp->str,
             MIN(temp->len, EDF_NUM_DATA_REC_SZ)
@@ -1495,6 +1564,7 @@ edf_header_read_from_input_stream(
     g_return_val_if_fail(error != NULL && *error == NULL, 0);
 
     klass = EDF_HEADER_GET_CLASS(header);
+    EDF_TRACE(header__parse__start);
 
     nread += klass->read_version(header, istream, error);
     if (*error)
@@ -1536,14 +1606,30 @@ edf_header_read_from_input_stream(
     if (*error)
         return nread;
 
-    g_assert(nread == EDF_BASE_HEADER_SIZE);
+    // A stream that ends early isn't an error for g_input_stream_read_all
+    if (nread != EDF_BASE_HEADER_SIZE) {
+        g_set_error(
+                error, edf_header_error_quark(), EDF_HEADER_ERROR_PARSE,
+                "The header is truncated after %" G_GSIZE_FORMAT " bytes",
+                nread
+                );
+        return nread;
+    }
 
     nread += klass->read_signals(header, istream, error);
     if (*error)
         return nread;
 
-    g_assert(nread == (gsize)edf_header_get_num_bytes(header));
+    if (nread != (gsize)edf_header_get_num_bytes(header)) {
+        g_set_error(
+                error, edf_header_error_quark(), EDF_HEADER_ERROR_PARSE,
+                "The header is truncated after %" G_GSIZE_FORMAT " of %d bytes",
+                nread,
+                edf_header_get_num_bytes(header)
+                );
+    }
 
+    EDF_TRACE2(header__parse__done, nread, edf_header_get_num_signals(header));
     return nread;
 }
 
@@ -1593,6 +1679,7 @@ gboolean
 edf_header_set_patient(EdfHeader* header, const gchar* patient)
 {
     g_return_val_if_fail(EDF_IS_HEADER(header), FALSE);
+    g_return_val_if_fail(header_is_mutable(header), FALSE);
     g_return_val_if_fail(patient != NULL && g_str_is_ascii(patient), FALSE);
 
     char temp[256];
@@ -1634,6 +1721,7 @@ gboolean
 edf_header_set_recording(EdfHeader* header, const gchar* recording)
 {
     g_return_val_if_fail(EDF_IS_HEADER(header), FALSE);
+    g_return_val_if_fail(header_is_mutable(header), FALSE);
     g_return_val_if_fail(recording != NULL && g_str_is_ascii(recording), FALSE);
 
     char temp[256];
@@ -1676,6 +1764,7 @@ gboolean
 edf_header_set_time(EdfHeader* header, GDateTime* time)
 {
     g_return_val_if_fail (EDF_IS_HEADER (header), FALSE);
+    g_return_val_if_fail(header_is_mutable(header), FALSE);
     g_return_val_if_fail (time != NULL, FALSE);
 
     EdfHeaderPrivate *priv = edf_header_get_instance_private (header);
@@ -1732,6 +1821,7 @@ gboolean
 edf_header_set_reserved(EdfHeader* header, const gchar* reserved)
 {
     g_return_val_if_fail(EDF_IS_HEADER(header), FALSE);
+    g_return_val_if_fail(header_is_mutable(header), FALSE);
     g_return_val_if_fail(reserved != NULL && g_str_is_ascii(reserved), FALSE);
 
     char temp[256];
@@ -1749,13 +1839,13 @@ edf_header_set_reserved(EdfHeader* header, const gchar* reserved)
  *          like to know.
  *
  * Returns: -1 if no signals are added, otherwise the numbers of records
- *          of the first signal
+ *          of the first signal, see also edf_header_set_expected_num_records()
  */
-gint
+gint64
 edf_header_get_num_records(EdfHeader* header)
 {
     EdfHeaderPrivate *priv;
-    g_return_val_if_fail(EDF_IS_HEADER (header), G_MININT);
+    g_return_val_if_fail(EDF_IS_HEADER (header), G_MININT64);
     priv = edf_header_get_instance_private(header);
 
     header_update(header);
@@ -1763,6 +1853,29 @@ edf_header_get_num_records(EdfHeader* header)
     return priv->num_records;
 }
 
+/**
+ * edf_header_set_expected_num_records:
+ * @header: the #EdfHeader that is written before its records
+ * @num_records: the number of records that will follow the header, -1
+ *               when unknown, e.g. while recording
+ *
+ * A header is written with the number of records of its first signal.
+ * When the records are streamed after the header instead, its signals
+ * hold no records, set the number that the header should state then.
+ */
+void
+edf_header_set_expected_num_records(EdfHeader* header, gint64 num_records)
+{
+    EdfHeaderPrivate *priv;
+    g_return_if_fail(EDF_IS_HEADER(header));
+    g_return_if_fail(header_is_mutable(header));
+    g_return_if_fail(num_records >= -1 && num_records <= EDF_MAX_NUM_RECORDS);
+
+    priv = edf_header_get_instance_private(header);
+    priv->expected_num_records = num_records;
+    priv->expects_records = TRUE;
+}
+
 /**
  * edf_header_get_record_duration:
  * @header the #EdfHeader whose record duration you woud like to know.
@@ -1790,6 +1903,7 @@ edf_header_set_record_duration(EdfHeader* header, gdouble duration)
 {
     EdfHeaderPrivate *priv;
     g_return_val_if_fail(EDF_IS_HEADER (header), FALSE);
+    g_return_val_if_fail(header_is_mutable(header), FALSE);
     g_return_val_if_fail(duration > 0.0, FALSE);
 
     priv = edf_header_get_instance_private (header);
@@ -1854,3 +1968,155 @@ edf_compute_header_size(guint num_signals)
     return EDF_BASE_HEADER_SIZE + num_signals * EDF_SIGNAL_HEADER_SIZE;
 }
 
+
+/* ************ private functions ************ */
+
+EdfHeader*
+edf_header_new_from_input_stream(GInputStream* istream, GError** error)
+{
+    g_return_val_if_fail(G_IS_INPUT_STREAM(istream), NULL);
+    g_return_val_if_fail(error != NULL && *error == NULL, NULL);
+
+    EdfHeader* header = edf_header_new();
+    GPtrArray* signals = g_ptr_array_new_full(0, g_object_unref);
+
+    edf_header_set_signals(header, signals);
+    g_ptr_array_unref(signals);
+
+    edf_header_read_from_input_stream(header, istream, error);
+    if (*error) {
+        g_object_unref(header);
+        return NULL;
+    }
+    return header;
+}
+
+gint64
+edf_header_get_declared_num_records(EdfHeader* header)
+{
+    g_return_val_if_fail(EDF_IS_HEADER(header), -1);
+    EdfHeaderPrivate* priv = edf_header_get_instance_private(header);
+    return priv->num_records;
+}
+
+void
+edf_header_update_num_records(EdfHeader* header)
+{
+    g_return_if_fail(EDF_IS_HEADER(header));
+    header_update(header);
+}
+
+gsize
+edf_header_get_record_size(EdfHeader* header)
+{
+    g_return_val_if_fail(EDF_IS_HEADER(header), 0);
+    EdfHeaderPrivate* priv = edf_header_get_instance_private(header);
+    gsize size = 0;
+
+    for (guint i = 0; i < priv->signals->len; i++) {
+        EdfSignal* signal = g_ptr_array_index(priv->signals, i);
+        size += (gsize) edf_signal_get_num_samples_per_record(signal) *
+                edf_signal_get_sample_size(signal);
+    }
+    return size;
+}
+
+void
+edf_header_freeze(EdfHeader* header)
+{
+    g_return_if_fail(EDF_IS_HEADER(header));
+    EdfHeaderPrivate* priv = edf_header_get_instance_private(header);
+
+    header_update(header);
+    for (guint i = 0; i < priv->signals->len; i++)
+        edf_signal_freeze(g_ptr_array_index(priv->signals, i));
+    priv->frozen = TRUE;
+}
+
+void
+edf_header_set_parsed(EdfHeader* header, const EdfParsedHeader* parsed)
+{
+    g_return_if_fail(EDF_IS_HEADER(header));
+    g_return_if_fail(header_is_mutable(header));
+    EdfHeaderPrivate* priv = edf_header_get_instance_private(header);
+
+    priv->version = parsed->version;
+    g_string_assign(priv->local_patient_identification, parsed->patient);
+    g_string_assign(priv->local_recording_identification, parsed->recording);
+    g_string_assign(priv->reserved, parsed->reserved);
+    priv->num_records = parsed->num_records;
+    priv->duration_of_record = parsed->record_duration;
+
+    // Like read_date() and read_time(), the header has no time zone
+    GDateTime* date = g_date_time_new_local(
+            parsed->year, parsed->month, parsed->day,
+            parsed->hour, parsed->minute, parsed->second
+            );
+    if (date) {
+        g_date_time_unref(priv->date_and_time);
+        priv->date_and_time = date;
+    }
+
+    set_num_signals(header, parsed->num_signals);
+    for (guint i = 0; i < parsed->num_signals; i++) {
+        const EdfParsedSignal* sig = &parsed->signals[i];
+        g_object_set(
+                g_ptr_array_index(priv->signals, i),
+                "sample-size", sig->sample_size,
+                "label", sig->label,
+                "transducer", sig->transducer,
+                "physical-dimension", sig->physical_dimension,
+                "physical-min", sig->physical_min,
+                "physical-max", sig->physical_max,
+                "digital-min", sig->digital_min,
+                "digital-max", sig->digital_max,
+                "prefilter", sig->prefiltering,
+                "ns", sig->ns,
+                "reserved", sig->reserved,
+                NULL
+                );
+    }
+}
+
+void
+edf_header_get_parsed(EdfHeader* header, EdfParsedHeader* parsed)
+{
+    g_return_if_fail(EDF_IS_HEADER(header));
+    EdfHeaderPrivate* priv = edf_header_get_instance_private(header);
+
+    memset(parsed, 0, sizeof(EdfParsedHeader));
+    parsed->version = priv->version;
+    g_strlcpy(parsed->patient, priv->local_patient_identification->str, sizeof(parsed->patient));
+    g_strlcpy(parsed->recording, priv->local_recording_identification->str, sizeof(parsed->recording));
+    g_strlcpy(parsed->reserved, priv->reserved->str, sizeof(parsed->reserved));
+    g_date_time_get_ymd(priv->date_and_time, &parsed->year, &parsed->month, &parsed->day);
+    parsed->hour = g_date_time_get_hour(priv->date_and_time);
+    parsed->minute = g_date_time_get_minute(priv->date_and_time);
+    parsed->second = g_date_time_get_second(priv->date_and_time);
+    parsed->header_size = edf_compute_header_size(priv->signals->len);
+    parsed->num_records = priv->num_records;
+    parsed->record_duration = priv->duration_of_record;
+
+    parsed->num_signals = priv->signals->len;
+    parsed->signals = g_new0(EdfParsedSignal, priv->signals->len);
+    for (guint i = 0; i < priv->signals->len; i++) {
+        EdfSignal* signal = g_ptr_array_index(priv->signals, i);
+        EdfParsedSignal* sig = &parsed->signals[i];
+
+        g_strlcpy(sig->label, edf_signal_get_label(signal), sizeof(sig->label));
+        g_strlcpy(sig->transducer, edf_signal_get_transducer(signal), sizeof(sig->transducer));
+        g_strlcpy(
+                sig->physical_dimension,
+                edf_signal_get_physical_dimension(signal),
+                sizeof(sig->physical_dimension)
+                );
+        g_strlcpy(sig->prefiltering, edf_signal_get_prefiltering(signal), sizeof(sig->prefiltering));
+        g_strlcpy(sig->reserved, edf_signal_get_reserved(signal), sizeof(sig->reserved));
+        sig->physical_min = edf_signal_get_physical_min(signal);
+        sig->physical_max = edf_signal_get_physical_max(signal);
+        sig->digital_min = edf_signal_get_digital_min(signal);
+        sig->digital_max = edf_signal_get_digital_max(signal);
+        sig->ns = edf_signal_get_num_samples_per_record(signal);
+        sig->sample_size = edf_signal_get_sample_size(signal);
+    }
+}
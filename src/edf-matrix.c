@@ -0,0 +1,476 @@
+
+#include "edf-matrix.h"
+#include "edf-resampler.h"
+#include "edf-signal-priv.h"
+#include "edf-sample-priv.h"
+#include "edf-trace-priv.h"
+
+#include <string.h>
+
+/**
+ * SECTION:edf-matrix
+ * @short_description: exports a whole file as one channels × samples matrix
+ * @see_also: #EdfFile, #EdfSignal, #EdfResampler
+ * @include: gedf.h
+ *
+ * Machine learning code usually wants a recording as one contiguous
+ * matrix. edf_file_to_matrix() converts the selected channels of an
+ * #EdfFile that has been read into a buffer of the caller in one pass,
+ * without an intermediate array per channel:
+ *
+ * |[<!-- language="C" -->
+ * guint channels[] = {0, 2, 3};
+ * guint64 num_samples;
+ *
+ * if (!edf_file_get_matrix_shape(file, channels, 3, flags, &num_samples, &error))
+ *     return;
+ * gfloat* matrix = g_new(gfloat, 3 * num_samples);
+ * edf_file_to_matrix(file, channels, 3, flags, matrix, 3 * num_samples, &error);
+ * ]|
+ *
+ * In a row major matrix the samples of channel c start at
+ * c * num_samples, in a column major matrix the samples of time s start at
+ * s * num_channels. The matrix holds physical values as floats, or doubles
+ * with %EDF_MATRIX_FLOAT64.
+ *
+ * All channels of a matrix have the same number of samples. Channels with
+ * a lower sample rate than the highest of the selection are an error
+ * unless %EDF_MATRIX_RESAMPLE is passed, they are upsampled with an
+ * #EdfResampler then. When the signals differ in their number of records
+ * the shortest one determines the length.
+ *
+ * The records are converted in parallel on a pool of threads, one thread
+ * per processor. Channels that are resampled are converted by one thread
+ * each, as a resampler depends on the preceding samples. A column major
+ * matrix is filled in blocks of consecutive samples of all channels, so
+ * that the threads don't share cache lines, resampled channels are
+ * buffered for that before. The file must
+ * not be modified meanwhile, a frozen file (see edf_file_freeze()) may
+ * be converted from several threads at once.
+ */
+
+G_DEFINE_QUARK(edf_matrix_error_quark, edf_matrix_error)
+
+// The number of samples of a channel that a job converts at least
+#define MATRIX_JOB_SAMPLES  65536
+// The number of samples that are decoded at once
+#define MATRIX_BLOCK_SIZE   1024
+
+typedef struct {
+    EdfSignal      *signal;
+    guint           ns;             // of the signal
+    guint           sample_size;
+    gdouble         gain;
+    gdouble         offset;
+    EdfResampler   *resampler;      // NULL when the signal has the matrix rate
+    gsize           base;           // the index of the first sample in the matrix
+    gsize           stride;         // the distance between consecutive samples
+    gdouble        *resampled;      // column major: the resampled channel
+} MatrixChannel;
+
+typedef struct {
+    MatrixChannel  *channels;
+    guint           num_channels;
+    guint           ns;             // the samples per record in the matrix
+    guint64         num_records;
+    guint64         num_samples;    // per channel
+    gboolean        float64;
+    gpointer        matrix;
+} Matrix;
+
+typedef struct {
+    MatrixChannel  *channel;        // NULL for all channels of a column major matrix
+    guint64         first_record;
+    guint64         num_records;    // 0 for a channel that is resampled
+} MatrixJob;
+
+static void
+matrix_clear(Matrix* m)
+{
+    for (guint i = 0; i < m->num_channels; i++) {
+        g_clear_object(&m->channels[i].resampler);
+        g_clear_pointer(&m->channels[i].resampled, g_free);
+    }
+    g_clear_pointer(&m->channels, g_free);
+}
+
+static guint
+gcd(guint a, guint b)
+{
+    while (b) {
+        guint t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+/*
+ * Checks the selection and determines the shape of the matrix, the
+ * resamplers are created here so the jobs can't fail.
+ */
+static gboolean
+matrix_prepare(
+        Matrix         *m,
+        EdfFile        *file,
+        const guint    *channels,
+        guint           num_channels,
+        EdfMatrixFlags  flags,
+        GError        **error
+        )
+{
+    GPtrArray* signals = edf_file_get_signals(file);
+
+    if (!channels)
+        num_channels = signals->len;
+    if (num_channels == 0) {
+        g_set_error(
+                error, EDF_MATRIX_ERROR, EDF_MATRIX_ERROR_CHANNEL,
+                "No channels are selected"
+                );
+        return FALSE;
+    }
+
+    m->channels = g_new0(MatrixChannel, num_channels);
+    m->num_channels = num_channels;
+    m->ns = 0;
+    m->num_records = G_MAXUINT64;
+    m->float64 = (flags & EDF_MATRIX_FLOAT64) != 0;
+
+    for (guint i = 0; i < num_channels; i++) {
+        guint index = channels ? channels[i] : i;
+        if (index >= signals->len) {
+            g_set_error(
+                    error, EDF_MATRIX_ERROR, EDF_MATRIX_ERROR_CHANNEL,
+                    "Channel %u doesn't exist, the file has %u channels",
+                    index, signals->len
+                    );
+            return FALSE;
+        }
+        MatrixChannel* c = &m->channels[i];
+        c->signal = g_ptr_array_index(signals, index);
+        c->ns = edf_signal_get_num_samples_per_record(c->signal);
+        c->sample_size = edf_signal_get_sample_size(c->signal);
+        c->gain = edf_signal_get_gain(c->signal);
+        c->offset = edf_signal_get_offset(c->signal);
+
+        m->ns = MAX(m->ns, c->ns);
+        m->num_records = MIN(m->num_records, edf_signal_get_num_records(c->signal));
+    }
+
+    for (guint i = 0; i < num_channels; i++) {
+        MatrixChannel* c = &m->channels[i];
+        if (c->ns == m->ns)
+            continue;
+
+        if (!(flags & EDF_MATRIX_RESAMPLE) || c->ns == 0) {
+            g_set_error(
+                    error, EDF_MATRIX_ERROR, EDF_MATRIX_ERROR_SAMPLE_RATE,
+                    "Channel '%s' has %u instead of %u samples per record",
+                    edf_signal_get_label(c->signal), c->ns, m->ns
+                    );
+            return FALSE;
+        }
+        guint g = gcd(m->ns, c->ns);
+        c->resampler = edf_resampler_new(m->ns / g, c->ns / g, error);
+        if (!c->resampler)
+            return FALSE;
+    }
+
+    m->num_samples = m->num_records * m->ns;
+    for (guint i = 0; i < num_channels; i++) {
+        MatrixChannel* c = &m->channels[i];
+        if (flags & EDF_MATRIX_COLUMN_MAJOR) {
+            c->base = i;
+            c->stride = num_channels;
+        }
+        else {
+            c->base = i * m->num_samples;
+            c->stride = 1;
+        }
+    }
+    return TRUE;
+}
+
+/* Stores n physical values of channel c from sample first on */
+static void
+matrix_store(
+        const Matrix           *m,
+        const MatrixChannel    *c,
+        guint64                 first,
+        const gdouble          *values,
+        gsize                   n
+        )
+{
+    gsize index = c->base + first * c->stride;
+    if (m->float64) {
+        gdouble* out = m->matrix;
+        for (gsize i = 0; i < n; i++, index += c->stride)
+            out[index] = values[i];
+    }
+    else {
+        gfloat* out = m->matrix;
+        for (gsize i = 0; i < n; i++, index += c->stride)
+            out[index] = (gfloat) values[i];
+    }
+}
+
+/* Converts a record of a channel that has the matrix rate */
+static void
+matrix_convert_record(const Matrix* m, const MatrixChannel* c, guint64 rec)
+{
+    const guint8* bytes = edf_signal_get_record_bytes(c->signal, rec);
+    gint32 block[MATRIX_BLOCK_SIZE];
+    gdouble values[MATRIX_BLOCK_SIZE];
+
+    for (guint i = 0; i < c->ns; i += MATRIX_BLOCK_SIZE) {
+        gsize n = MIN(MATRIX_BLOCK_SIZE, c->ns - i);
+        edf_samples_decode(&bytes[i * c->sample_size], c->sample_size, n, block);
+        for (gsize j = 0; j < n; j++)
+            values[j] = c->gain * block[j] + c->offset;
+        matrix_store(m, c, rec * c->ns + i, values, n);
+    }
+}
+
+/* Converts a range of records of one channel or of all channels */
+static void
+matrix_convert_records(const Matrix* m, const MatrixJob* job)
+{
+    guint64 end = job->first_record + job->num_records;
+
+    if (job->channel) {
+        for (guint64 rec = job->first_record; rec < end; rec++)
+            matrix_convert_record(m, job->channel, rec);
+        return;
+    }
+
+    // Record by record, so a job writes one contiguous block of the matrix
+    for (guint64 rec = job->first_record; rec < end; rec++) {
+        for (guint i = 0; i < m->num_channels; i++) {
+            const MatrixChannel* c = &m->channels[i];
+            if (c->resampled)
+                matrix_store(m, c, rec * m->ns, &c->resampled[rec * m->ns], m->ns);
+            else
+                matrix_convert_record(m, c, rec);
+        }
+    }
+}
+
+/* Stores resampled values in the matrix or in the buffer of the channel */
+static void
+matrix_store_resampled(
+        const Matrix           *m,
+        const MatrixChannel    *c,
+        guint64                 first,
+        const gdouble          *values,
+        gsize                   n
+        )
+{
+    if (c->resampled)
+        memcpy(&c->resampled[first], values, n * sizeof(gdouble));
+    else
+        matrix_store(m, c, first, values, n);
+}
+
+/* Resamples a complete channel to the rate of the matrix */
+static void
+matrix_resample_channel(const Matrix* m, const MatrixJob* job)
+{
+    const MatrixChannel* c = job->channel;
+    gint32* block = g_new(gint32, c->ns);
+    gdouble* in = g_new(gdouble, c->ns);
+    gsize out_size = MAX(edf_resampler_get_max_output(c->resampler, c->ns), 1);
+    gdouble* out = g_new(gdouble, out_size);
+    guint64 pos = 0;
+    gsize n;
+
+    for (guint64 rec = 0; rec < m->num_records; rec++) {
+        const guint8* bytes = edf_signal_get_record_bytes(c->signal, rec);
+        edf_samples_decode(bytes, c->sample_size, c->ns, block);
+        for (guint i = 0; i < c->ns; i++)
+            in[i] = c->gain * block[i] + c->offset;
+
+        n = edf_resampler_process(c->resampler, in, c->ns, out);
+        n = (gsize) MIN((guint64) n, m->num_samples - pos);
+        matrix_store_resampled(m, c, pos, out, n);
+        pos += n;
+    }
+
+    gsize flush_size = edf_resampler_get_max_output(c->resampler, 0);
+    if (flush_size > out_size)
+        out = g_renew(gdouble, out, flush_size);
+    n = edf_resampler_flush(c->resampler, out);
+    n = (gsize) MIN((guint64) n, m->num_samples - pos);
+    matrix_store_resampled(m, c, pos, out, n);
+
+    g_free(out);
+    g_free(in);
+    g_free(block);
+}
+
+/* Runs on a worker thread, the jobs write to disjoint parts of the matrix */
+static void
+matrix_job_run(gpointer data, gpointer user_data)
+{
+    const MatrixJob* job = data;
+    const Matrix* m = user_data;
+
+    if (job->channel && job->channel->resampler)
+        matrix_resample_channel(m, job);
+    else
+        matrix_convert_records(m, job);
+}
+
+/* Runs the jobs on a pool of threads and waits for them */
+static gboolean
+matrix_run_jobs(Matrix* m, GArray* jobs, GError** error)
+{
+    if (jobs->len <= 1) {
+        for (guint i = 0; i < jobs->len; i++)
+            matrix_job_run(&g_array_index(jobs, MatrixJob, i), m);
+        return TRUE;
+    }
+
+    GThreadPool* pool = g_thread_pool_new(
+            matrix_job_run, m, MIN(g_get_num_processors(), jobs->len), FALSE, error
+            );
+    if (!pool)
+        return FALSE;
+    for (guint i = 0; i < jobs->len; i++)
+        g_thread_pool_push(pool, &g_array_index(jobs, MatrixJob, i), NULL);
+    // Waits for all jobs
+    g_thread_pool_free(pool, FALSE, TRUE);
+    return TRUE;
+}
+
+/**
+ * edf_file_get_matrix_shape:
+ * @file: an #EdfFile whose records have been read
+ * @channels:(array length=num_channels)(nullable): the indices of the
+ *           channels in the order of the rows, or NULL for all channels
+ * @num_channels: the number of elements of @channels
+ * @flags: the flags that will be passed to edf_file_to_matrix()
+ * @num_samples:(out): the number of samples per channel
+ * @error:(out): An error is returned here when the selection is invalid.
+ *
+ * Determines the size of the matrix that edf_file_to_matrix() produces,
+ * it holds the number of channels times @num_samples values.
+ *
+ * Returns: TRUE when the channels can be exported with @flags
+ */
+gboolean
+edf_file_get_matrix_shape(
+        EdfFile        *file,
+        const guint    *channels,
+        guint           num_channels,
+        EdfMatrixFlags  flags,
+        guint64        *num_samples,
+        GError        **error
+        )
+{
+    g_return_val_if_fail(EDF_IS_FILE(file), FALSE);
+    g_return_val_if_fail(num_samples != NULL, FALSE);
+    g_return_val_if_fail(error != NULL && *error == NULL, FALSE);
+
+    Matrix m = {0,};
+    gboolean result = matrix_prepare(&m, file, channels, num_channels, flags, error);
+
+    *num_samples = result ? m.num_samples : 0;
+    matrix_clear(&m);
+    return result;
+}
+
+/**
+ * edf_file_to_matrix:(skip)
+ * @file: an #EdfFile whose records have been read
+ * @channels:(array length=num_channels)(nullable): the indices of the
+ *           channels in the order of the rows, or NULL for all channels
+ * @num_channels: the number of elements of @channels
+ * @flags: the layout and type of @matrix and whether to resample
+ * @matrix: the output, floats or doubles depending on @flags
+ * @matrix_size: the number of values that fit in @matrix
+ * @error:(out): An error is returned here when the matrix cannot be made.
+ *
+ * Writes the physical values of the selected channels to @matrix, see
+ * edf_file_get_matrix_shape() for its size.
+ *
+ * Returns: TRUE when @matrix has been filled
+ */
+gboolean
+edf_file_to_matrix(
+        EdfFile        *file,
+        const guint    *channels,
+        guint           num_channels,
+        EdfMatrixFlags  flags,
+        gpointer        matrix,
+        gsize           matrix_size,
+        GError        **error
+        )
+{
+    g_return_val_if_fail(EDF_IS_FILE(file), FALSE);
+    g_return_val_if_fail(matrix != NULL || matrix_size == 0, FALSE);
+    g_return_val_if_fail(error != NULL && *error == NULL, FALSE);
+
+    Matrix m = {0,};
+    GArray* jobs = NULL;
+    gboolean result = FALSE;
+
+    if (!matrix_prepare(&m, file, channels, num_channels, flags, error))
+        goto done;
+
+    if (m.num_samples > G_MAXSIZE / m.num_channels ||
+        m.num_samples * m.num_channels > matrix_size) {
+        g_set_error(
+                error, EDF_MATRIX_ERROR, EDF_MATRIX_ERROR_SIZE,
+                "The matrix holds %" G_GSIZE_FORMAT " values, %u × %"
+                G_GUINT64_FORMAT " are needed",
+                matrix_size, m.num_channels, m.num_samples
+                );
+        goto done;
+    }
+    m.matrix = matrix;
+    EDF_TRACE1(convert__start, m.num_samples * m.num_channels);
+
+    gboolean column_major = (flags & EDF_MATRIX_COLUMN_MAJOR) != 0;
+    guint64 records_per_job = MAX(MATRIX_JOB_SAMPLES / MAX(m.ns, 1), 1);
+    jobs = g_array_new(FALSE, FALSE, sizeof(MatrixJob));
+
+    // A resampled channel is one job, the others are split in ranges of records
+    for (guint i = 0; i < m.num_channels; i++) {
+        MatrixChannel* c = &m.channels[i];
+        if (c->resampler) {
+            MatrixJob job = {c, 0, 0};
+            g_array_append_val(jobs, job);
+            if (column_major)
+                c->resampled = g_new0(gdouble, m.num_samples);
+            continue;
+        }
+        if (column_major)
+            continue;
+        for (guint64 rec = 0; rec < m.num_records; rec += records_per_job) {
+            MatrixJob job = {c, rec, MIN(records_per_job, m.num_records - rec)};
+            g_array_append_val(jobs, job);
+        }
+    }
+    if (column_major) {
+        // The resamplers fill their buffers first, then the blocks of
+        // records of all channels are written
+        if (!matrix_run_jobs(&m, jobs, error))
+            goto done;
+        g_array_set_size(jobs, 0);
+        records_per_job = MAX(records_per_job / m.num_channels, 1);
+        for (guint64 rec = 0; rec < m.num_records; rec += records_per_job) {
+            MatrixJob job = {NULL, rec, MIN(records_per_job, m.num_records - rec)};
+            g_array_append_val(jobs, job);
+        }
+    }
+    result = matrix_run_jobs(&m, jobs, error);
+
+done:
+    if (result)
+        EDF_TRACE1(convert__done, m.num_samples * m.num_channels);
+    if (jobs)
+        g_array_unref(jobs);
+    matrix_clear(&m);
+    return result;
+}
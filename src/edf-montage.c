@@ -0,0 +1,893 @@
+
+#include "edf-montage.h"
+#include "edf-signal-priv.h"
+#include "edf-sample-priv.h"
+
+#include <math.h>
+#include <string.h>
+
+/**
+ * SECTION:edf-montage
+ * @short_description: derives re-referenced channels from a recording
+ * @see_also: #EdfReader, #EdfFile
+ * @include: gedf.h
+ *
+ * Most analyses re-reference a recording first, e.g. to the average of all
+ * electrodes, to linked mastoids or as a chain of bipolar derivations. Each
+ * derived channel is a weighted sum of input channels, so a montage is a
+ * sparse matrix of derived × input channels. An #EdfMontage is built from
+ * channel labels with edf_montage_add_derivation() and its helpers, which
+ * add one row of the matrix at a time.
+ *
+ * Before it is applied, a montage is bound to the channels of a file.
+ * Only the input channels that the montage needs are decoded. The matrix is
+ * applied per record, one derived channel at a time.
+ *
+ * From C the derived samples of the current record of an #EdfReader are
+ * obtained with edf_montage_apply_record(). edf_montage_apply_to_file()
+ * creates a new #EdfFile with the derived signals and
+ * edf_montage_convert() writes the re-referenced version of a file on
+ * disk.
+ *
+ * |[<!-- language="C" -->
+ * const gchar* chans[] = {"Fp1", "Fp2", "C3", "C4"};
+ * const gchar* mastoids[] = {"M1", "M2"};
+ * EdfMontage* montage = edf_montage_new();
+ *
+ * edf_montage_add_reference(montage, chans, 4, mastoids, 2, "M1M2");
+ * edf_montage_convert(montage, "raw.bdf", "linked-mastoids.bdf", &error);
+ * ]|
+ */
+
+G_DEFINE_QUARK(edf_montage_error_quark, edf_montage_error)
+
+#define DERIVED_TRANSDUCER "derived channel"
+
+/* One input channel of the montage */
+typedef struct {
+    gchar              *label;
+    /* known after binding */
+    guint               channel;        // index in the file
+    gsize               row_offset;     // start of the samples in rows
+    EdfReaderChannel    info;
+} MontageInput;
+
+/* One non zero weight of the matrix */
+typedef struct {
+    guint       input;
+    gdouble     weight;
+} MontageTerm;
+
+/* One derived channel, its terms are stored consecutively */
+typedef struct {
+    gchar       label[EDF_LABEL_SZ + 1];
+    guint       first_term;
+    guint       num_terms;
+    /* known after binding */
+    guint       ns;
+    gsize       offset;     // start of the samples of a record in the output
+} MontageOutput;
+
+typedef struct _EdfMontagePrivate {
+    GArray     *inputs;         // MontageInput
+    GArray     *terms;          // MontageTerm
+    GArray     *outputs;        // MontageOutput
+    GHashTable *input_index;    // label -> index + 1 in inputs
+
+    gboolean    bound;
+    gdouble    *rows;           // the physical samples of the inputs of a record
+    gsize       num_row_samples;
+    gsize       num_out_samples;
+    gint32     *digital;        // the digital samples of one channel of a record
+    guint8     *record;         // and those encoded
+} EdfMontagePrivate;
+
+G_DEFINE_TYPE_WITH_PRIVATE(EdfMontage, edf_montage, G_TYPE_OBJECT)
+
+typedef enum {
+    PROP_NUM_OUTPUTS = 1,
+    PROP_NUM_INPUTS,
+    N_PROPERTIES
+} EdfMontageProperty;
+
+static void
+montage_input_clear(MontageInput* input)
+{
+    g_free(input->label);
+}
+
+static void
+edf_montage_init(EdfMontage* self)
+{
+    EdfMontagePrivate* priv = edf_montage_get_instance_private(self);
+
+    priv->inputs = g_array_new(FALSE, TRUE, sizeof(MontageInput));
+    g_array_set_clear_func(priv->inputs, (GDestroyNotify) montage_input_clear);
+    priv->terms = g_array_new(FALSE, FALSE, sizeof(MontageTerm));
+    priv->outputs = g_array_new(FALSE, TRUE, sizeof(MontageOutput));
+    priv->input_index = g_hash_table_new(g_str_hash, g_str_equal);
+    priv->bound = FALSE;
+    priv->rows = NULL;
+    priv->digital = NULL;
+    priv->record = NULL;
+}
+
+static void
+edf_montage_finalize(GObject* gobject)
+{
+    EdfMontagePrivate* priv = edf_montage_get_instance_private(EDF_MONTAGE(gobject));
+
+    // The keys of the index are owned by the inputs
+    g_hash_table_unref(priv->input_index);
+    g_array_unref(priv->inputs);
+    g_array_unref(priv->terms);
+    g_array_unref(priv->outputs);
+    g_free(priv->rows);
+    g_free(priv->digital);
+    g_free(priv->record);
+
+    G_OBJECT_CLASS(edf_montage_parent_class)->finalize(gobject);
+}
+
+static void
+edf_montage_get_property(
+        GObject    *object,
+        guint32     propid,
+        GValue     *value,
+        GParamSpec *spec
+        )
+{
+    EdfMontagePrivate* priv = edf_montage_get_instance_private(EDF_MONTAGE(object));
+
+    switch ((EdfMontageProperty) propid) {
+        case PROP_NUM_OUTPUTS:
+            g_value_set_uint(value, priv->outputs->len);
+            break;
+        case PROP_NUM_INPUTS:
+            g_value_set_uint(value, priv->inputs->len);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID(object, propid, spec);
+    }
+}
+
+static GParamSpec* montage_properties[N_PROPERTIES] = {NULL, };
+
+static void
+edf_montage_class_init(EdfMontageClass* klass)
+{
+    GObjectClass* object_class = G_OBJECT_CLASS(klass);
+
+    object_class->get_property = edf_montage_get_property;
+    object_class->finalize = edf_montage_finalize;
+
+    /**
+     * EdfMontage:num-outputs:
+     *
+     * The number of derived channels, the rows of the matrix.
+     */
+    montage_properties[PROP_NUM_OUTPUTS] = g_param_spec_uint(
+            "num-outputs",
+            "Number of outputs",
+            "The number of derived channels",
+            0,
+            G_MAXUINT,
+            0,
+            G_PARAM_READABLE
+            );
+
+    /**
+     * EdfMontage:num-inputs:
+     *
+     * The number of distinct input channels that the derivations use.
+     */
+    montage_properties[PROP_NUM_INPUTS] = g_param_spec_uint(
+            "num-inputs",
+            "Number of inputs",
+            "The number of input channels used by the montage",
+            0,
+            G_MAXUINT,
+            0,
+            G_PARAM_READABLE
+            );
+
+    g_object_class_install_properties(
+            object_class, N_PROPERTIES, montage_properties
+            );
+}
+
+/* ************ building ************ */
+
+static guint
+montage_input(EdfMontagePrivate* priv, const gchar* label)
+{
+    gpointer index = g_hash_table_lookup(priv->input_index, label);
+    if (index)
+        return GPOINTER_TO_UINT(index) - 1;
+
+    MontageInput input = {.label = g_strdup(label)};
+    g_array_append_val(priv->inputs, input);
+    g_hash_table_insert(
+            priv->input_index,
+            input.label,
+            GUINT_TO_POINTER(priv->inputs->len)
+            );
+    return priv->inputs->len - 1;
+}
+
+/**
+ * edf_montage_new:(constructor)
+ *
+ * Returns: a new #EdfMontage without derivations
+ */
+EdfMontage*
+edf_montage_new(void)
+{
+    return g_object_new(EDF_TYPE_MONTAGE, NULL);
+}
+
+/**
+ * edf_montage_add_derivation:
+ * @montage: the montage
+ * @label: the label of the derived channel
+ * @inputs:(array length=num_inputs): the labels of the input channels
+ * @weights:(array length=num_inputs): the weight of each input
+ * @num_inputs: the number of inputs, at least 1
+ *
+ * Adds a derived channel that is the sum of the @inputs multiplied by
+ * their @weights. The weights of an input that is mentioned twice are
+ * added. All inputs of a derivation must have the same sample rate.
+ */
+void
+edf_montage_add_derivation(
+        EdfMontage         *montage,
+        const gchar        *label,
+        const gchar* const *inputs,
+        const gdouble      *weights,
+        guint               num_inputs
+        )
+{
+    g_return_if_fail(EDF_IS_MONTAGE(montage));
+    g_return_if_fail(label != NULL && g_str_is_ascii(label));
+    g_return_if_fail(inputs != NULL && weights != NULL && num_inputs > 0);
+
+    EdfMontagePrivate* priv = edf_montage_get_instance_private(montage);
+    MontageOutput output = {
+        .first_term = priv->terms->len,
+        .num_terms = 0
+    };
+    g_snprintf(output.label, sizeof(output.label), "%s", label);
+
+    for (guint i = 0; i < num_inputs; i++) {
+        guint input = montage_input(priv, inputs[i]);
+        MontageTerm* terms = &g_array_index(priv->terms, MontageTerm, output.first_term);
+        guint t;
+
+        for (t = 0; t < output.num_terms; t++)
+            if (terms[t].input == input)
+                break;
+
+        if (t < output.num_terms) {
+            terms[t].weight += weights[i];
+        }
+        else {
+            MontageTerm term = {.input = input, .weight = weights[i]};
+            g_array_append_val(priv->terms, term);
+            output.num_terms++;
+        }
+    }
+
+    g_array_append_val(priv->outputs, output);
+    priv->bound = FALSE;
+}
+
+/**
+ * edf_montage_add_bipolar:
+ * @montage: the montage
+ * @active: the label of the active electrode
+ * @reference: the label of the reference electrode
+ *
+ * Adds the derivation @active - @reference, labeled "active-reference".
+ */
+void
+edf_montage_add_bipolar(EdfMontage* montage, const gchar* active, const gchar* reference)
+{
+    g_return_if_fail(active != NULL && reference != NULL);
+
+    const gchar* inputs[] = {active, reference};
+    const gdouble weights[] = {1.0, -1.0};
+    gchar* label = g_strdup_printf("%s-%s", active, reference);
+
+    edf_montage_add_derivation(montage, label, inputs, weights, 2);
+    g_free(label);
+}
+
+/**
+ * edf_montage_add_reference:
+ * @montage: the montage
+ * @channels:(array length=num_channels): the labels of the channels to re-reference
+ * @num_channels: the number of channels
+ * @references:(array length=num_references): the labels of the reference channels
+ * @num_references: the number of reference channels
+ * @reference_name: the name of the reference in the derived labels
+ *
+ * Adds a derivation for every channel of @channels that is the channel
+ * minus the mean of the @references, labeled "channel-reference_name".
+ * E.g. linked mastoids are the references "M1" and "M2".
+ */
+void
+edf_montage_add_reference(
+        EdfMontage         *montage,
+        const gchar* const *channels,
+        guint               num_channels,
+        const gchar* const *references,
+        guint               num_references,
+        const gchar        *reference_name
+        )
+{
+    g_return_if_fail(channels != NULL || num_channels == 0);
+    g_return_if_fail(references != NULL && num_references > 0);
+    g_return_if_fail(reference_name != NULL);
+
+    const gchar** inputs = g_new(const gchar*, num_references + 1);
+    gdouble* weights = g_new(gdouble, num_references + 1);
+
+    for (guint r = 0; r < num_references; r++) {
+        inputs[r + 1] = references[r];
+        weights[r + 1] = -1.0 / num_references;
+    }
+    weights[0] = 1.0;
+
+    for (guint c = 0; c < num_channels; c++) {
+        gchar* label = g_strdup_printf("%s-%s", channels[c], reference_name);
+        inputs[0] = channels[c];
+        edf_montage_add_derivation(montage, label, inputs, weights, num_references + 1);
+        g_free(label);
+    }
+
+    g_free(inputs);
+    g_free(weights);
+}
+
+/**
+ * edf_montage_add_average_reference:
+ * @montage: the montage
+ * @channels:(array length=num_channels): the labels of the channels
+ * @num_channels: the number of channels
+ *
+ * Re-references each of the @channels to the average of all @channels,
+ * the derived channels are labeled "channel-AVG".
+ */
+void
+edf_montage_add_average_reference(
+        EdfMontage         *montage,
+        const gchar* const *channels,
+        guint               num_channels
+        )
+{
+    g_return_if_fail(num_channels > 0);
+    edf_montage_add_reference(
+            montage, channels, num_channels, channels, num_channels, "AVG"
+            );
+}
+
+/**
+ * edf_montage_get_num_outputs:
+ * @montage: the montage
+ *
+ * Returns: the number of derived channels
+ */
+guint
+edf_montage_get_num_outputs(EdfMontage* montage)
+{
+    g_return_val_if_fail(EDF_IS_MONTAGE(montage), 0);
+    EdfMontagePrivate* priv = edf_montage_get_instance_private(montage);
+    return priv->outputs->len;
+}
+
+/**
+ * edf_montage_get_output_label:
+ * @montage: the montage
+ * @output: the index of a derived channel
+ *
+ * Returns:(transfer none): the label of derived channel @output
+ */
+const gchar*
+edf_montage_get_output_label(EdfMontage* montage, guint output)
+{
+    g_return_val_if_fail(EDF_IS_MONTAGE(montage), NULL);
+    EdfMontagePrivate* priv = edf_montage_get_instance_private(montage);
+    g_return_val_if_fail(output < priv->outputs->len, NULL);
+
+    return g_array_index(priv->outputs, MontageOutput, output).label;
+}
+
+/* ************ binding ************ */
+
+static gboolean
+montage_bind(
+        EdfMontage             *montage,
+        const EdfReaderChannel *channels,
+        guint                   num_channels,
+        GError                **error
+        )
+{
+    EdfMontagePrivate* priv = edf_montage_get_instance_private(montage);
+    gsize offset = 0;
+    guint max_ns = 0;
+
+    priv->bound = FALSE;
+
+    if (priv->outputs->len == 0) {
+        g_set_error_literal(
+                error,
+                EDF_MONTAGE_ERROR,
+                EDF_MONTAGE_ERROR_EMPTY,
+                "The montage has no derivations"
+                );
+        return FALSE;
+    }
+
+    for (guint i = 0; i < priv->inputs->len; i++) {
+        MontageInput* input = &g_array_index(priv->inputs, MontageInput, i);
+        guint c;
+
+        for (c = 0; c < num_channels; c++)
+            if (g_strcmp0(channels[c].label, input->label) == 0)
+                break;
+
+        if (c == num_channels) {
+            g_set_error(
+                    error,
+                    EDF_MONTAGE_ERROR,
+                    EDF_MONTAGE_ERROR_CHANNEL,
+                    "The file has no channel '%s'",
+                    input->label
+                    );
+            return FALSE;
+        }
+
+        input->channel = c;
+        input->info = channels[c];
+        input->row_offset = offset;
+        offset += channels[c].ns;
+        max_ns = MAX(max_ns, channels[c].ns);
+    }
+    priv->num_row_samples = offset;
+
+    offset = 0;
+    for (guint o = 0; o < priv->outputs->len; o++) {
+        MontageOutput* output = &g_array_index(priv->outputs, MontageOutput, o);
+        const MontageTerm* terms = &g_array_index(
+                priv->terms, MontageTerm, output->first_term
+                );
+
+        output->ns = g_array_index(priv->inputs, MontageInput, terms[0].input).info.ns;
+        for (guint t = 1; t < output->num_terms; t++) {
+            const MontageInput* input = &g_array_index(
+                    priv->inputs, MontageInput, terms[t].input
+                    );
+            if (input->info.ns != output->ns) {
+                g_set_error(
+                        error,
+                        EDF_MONTAGE_ERROR,
+                        EDF_MONTAGE_ERROR_SAMPLE_RATE,
+                        "The inputs of '%s' differ in sample rate",
+                        output->label
+                        );
+                return FALSE;
+            }
+        }
+        output->offset = offset;
+        offset += output->ns;
+    }
+    priv->num_out_samples = offset;
+
+    g_free(priv->rows);
+    priv->rows = g_new(gdouble, MAX(priv->num_row_samples, 1));
+    // The derived channels have the ns of their inputs
+    g_free(priv->digital);
+    priv->digital = g_new(gint32, MAX(max_ns, 1));
+    g_free(priv->record);
+    priv->record = g_malloc((gsize) MAX(max_ns, 1) * BDF_SAMPLE_SIZE);
+    priv->bound = TRUE;
+    return TRUE;
+}
+
+/**
+ * edf_montage_bind_reader:(skip)
+ * @montage: the montage
+ * @reader: the reader from which the montage is applied
+ * @error:(out): An error is returned here when a label of the montage
+ *               isn't a channel of @reader or the inputs of a derivation
+ *               differ in sample rate
+ *
+ * Looks up the input channels of the montage in @reader, this is
+ * necessary before edf_montage_apply_record().
+ *
+ * Returns: TRUE when the montage is bound
+ */
+gboolean
+edf_montage_bind_reader(EdfMontage* montage, EdfReader* reader, GError** error)
+{
+    g_return_val_if_fail(EDF_IS_MONTAGE(montage), FALSE);
+    g_return_val_if_fail(reader != NULL, FALSE);
+    g_return_val_if_fail(error != NULL && *error == NULL, FALSE);
+
+    guint n = edf_reader_get_num_channels(reader);
+    EdfReaderChannel* channels = g_new(EdfReaderChannel, MAX(n, 1));
+    for (guint c = 0; c < n; c++)
+        channels[c] = *edf_reader_get_channel(reader, c);
+
+    gboolean result = montage_bind(montage, channels, n, error);
+    g_free(channels);
+    return result;
+}
+
+/**
+ * edf_montage_get_output_ns:
+ * @montage: a bound montage
+ * @output: the index of a derived channel
+ *
+ * Returns: the number of samples per record of derived channel @output
+ */
+guint
+edf_montage_get_output_ns(EdfMontage* montage, guint output)
+{
+    g_return_val_if_fail(EDF_IS_MONTAGE(montage), 0);
+    EdfMontagePrivate* priv = edf_montage_get_instance_private(montage);
+    g_return_val_if_fail(priv->bound, 0);
+    g_return_val_if_fail(output < priv->outputs->len, 0);
+
+    return g_array_index(priv->outputs, MontageOutput, output).ns;
+}
+
+/**
+ * edf_montage_get_record_samples:
+ * @montage: a bound montage
+ *
+ * Returns: the number of derived samples of one record, the sum of the ns
+ *          of all derived channels.
+ */
+gsize
+edf_montage_get_record_samples(EdfMontage* montage)
+{
+    g_return_val_if_fail(EDF_IS_MONTAGE(montage), 0);
+    EdfMontagePrivate* priv = edf_montage_get_instance_private(montage);
+    g_return_val_if_fail(priv->bound, 0);
+
+    return priv->num_out_samples;
+}
+
+/* ************ applying ************ */
+
+/*
+ * Computes the derived channels from the input rows, one input of one
+ * derived channel at a time.
+ */
+static void
+montage_apply_rows(EdfMontagePrivate* priv, gdouble* restrict out)
+{
+    const MontageTerm* terms = (const MontageTerm*) priv->terms->data;
+    const MontageInput* inputs = (const MontageInput*) priv->inputs->data;
+
+    for (guint o = 0; o < priv->outputs->len; o++) {
+        const MontageOutput* output = &g_array_index(priv->outputs, MontageOutput, o);
+        gdouble* restrict dest = &out[output->offset];
+        const guint ns = output->ns;
+
+        for (guint t = 0; t < output->num_terms; t++) {
+            const MontageTerm* term = &terms[output->first_term + t];
+            const gdouble* restrict row = &priv->rows[inputs[term->input].row_offset];
+            const gdouble w = term->weight;
+
+            if (t == 0) {
+                for (guint i = 0; i < ns; i++)
+                    dest[i] = w * row[i];
+            }
+            else {
+                for (guint i = 0; i < ns; i++)
+                    dest[i] += w * row[i];
+            }
+        }
+    }
+}
+
+/**
+ * edf_montage_apply_record:(skip)
+ * @montage: a montage bound to @reader
+ * @reader: a reader with a current record
+ * @samples:(out): room for edf_montage_get_record_samples() values
+ *
+ * Computes the derived channels of the current record of @reader in
+ * physical units. The samples of derived channel k start after the samples
+ * of the channels before it.
+ */
+void
+edf_montage_apply_record(EdfMontage* montage, EdfReader* reader, gdouble* samples)
+{
+    g_return_if_fail(EDF_IS_MONTAGE(montage));
+    g_return_if_fail(reader != NULL && samples != NULL);
+    EdfMontagePrivate* priv = edf_montage_get_instance_private(montage);
+    g_return_if_fail(priv->bound);
+
+    // Only the channels used by the montage are decoded
+    for (guint i = 0; i < priv->inputs->len; i++) {
+        const MontageInput* input = &g_array_index(priv->inputs, MontageInput, i);
+        edf_reader_get_physical(reader, input->channel, &priv->rows[input->row_offset]);
+    }
+
+    montage_apply_rows(priv, samples);
+}
+
+/* ************ writing ************ */
+
+/*
+ * The derived signals, their physical range is the range that the weighted
+ * sum of the inputs can take.
+ */
+static GPtrArray*
+montage_create_signals(EdfMontagePrivate* priv)
+{
+    GPtrArray* signals = g_ptr_array_new_full(priv->outputs->len, g_object_unref);
+
+    for (guint o = 0; o < priv->outputs->len; o++) {
+        const MontageOutput* output = &g_array_index(priv->outputs, MontageOutput, o);
+        const MontageTerm* terms = &g_array_index(
+                priv->terms, MontageTerm, output->first_term
+                );
+        const EdfReaderChannel* first = &g_array_index(
+                priv->inputs, MontageInput, terms[0].input
+                ).info;
+        gdouble lo = 0, hi = 0;
+        guint sample_size = EDF_SAMPLE_SIZE;
+
+        for (guint t = 0; t < output->num_terms; t++) {
+            const EdfReaderChannel* info = &g_array_index(
+                    priv->inputs, MontageInput, terms[t].input
+                    ).info;
+            gdouble w = terms[t].weight;
+            lo += w >= 0 ? w * info->physical_min : w * info->physical_max;
+            hi += w >= 0 ? w * info->physical_max : w * info->physical_min;
+            sample_size = MAX(sample_size, info->sample_size);
+        }
+        if (hi <= lo)
+            hi = lo + 1;
+
+        EdfSignal* signal = g_object_new(
+                EDF_TYPE_SIGNAL,
+                "sample-size", sample_size,
+                "label", output->label,
+                "transducer", DERIVED_TRANSDUCER,
+                "physical-dimension", first->physical_dimension,
+                "physical-min", lo,
+                "physical-max", hi,
+                "digital-min", sample_size == BDF_SAMPLE_SIZE ?
+                               BDF_DIGITAL_MIN : EDF_DIGITAL_MIN,
+                "digital-max", sample_size == BDF_SAMPLE_SIZE ?
+                               BDF_DIGITAL_MAX : EDF_DIGITAL_MAX,
+                "prefilter", first->prefiltering,
+                "ns", output->ns,
+                NULL
+                );
+        g_ptr_array_add(signals, signal);
+    }
+    return signals;
+}
+
+/*
+ * Quantizes one derived record and appends it to the signals, a whole
+ * record of each derived channel at once.
+ */
+static void
+montage_append_record(
+        EdfMontagePrivate  *priv,
+        GPtrArray          *signals,
+        const gdouble      *samples
+        )
+{
+    for (guint o = 0; o < signals->len; o++) {
+        EdfSignal* signal = g_ptr_array_index(signals, o);
+        const MontageOutput* output = &g_array_index(priv->outputs, MontageOutput, o);
+        const gdouble* values = &samples[output->offset];
+        gdouble gain = edf_signal_get_gain(signal);
+        gdouble offset = edf_signal_get_offset(signal);
+        gint dmin = edf_signal_get_digital_min(signal);
+        gint dmax = edf_signal_get_digital_max(signal);
+
+        for (guint i = 0; i < output->ns; i++) {
+            gdouble d = round((values[i] - offset) / gain);
+            priv->digital[i] = (gint32) CLAMP(d, dmin, dmax);
+        }
+        edf_samples_encode(
+                priv->record, edf_signal_get_sample_size(signal), output->ns, priv->digital
+                );
+        edf_signal_append_record(signal, priv->record);
+    }
+}
+
+static EdfFile*
+montage_create_file(
+        EdfMontagePrivate  *priv,
+        const gchar        *patient,
+        const gchar        *recording,
+        const gchar        *reserved,
+        GDateTime          *start,
+        gdouble             record_duration,
+        GPtrArray         **signals
+        )
+{
+    EdfFile* file = edf_file_new();
+    EdfHeader* header = edf_file_header(file);
+
+    edf_header_set_patient(header, patient);
+    edf_header_set_recording(header, recording);
+    edf_header_set_reserved(header, reserved);
+    edf_header_set_time(header, start);
+    edf_header_set_record_duration(header, record_duration);
+
+    *signals = montage_create_signals(priv);
+    for (guint o = 0; o < (*signals)->len; o++)
+        edf_file_add_signal(file, g_ptr_array_index(*signals, o));
+
+    return file;
+}
+
+/**
+ * edf_montage_apply_to_file:
+ * @montage: the montage
+ * @file: a file with the input channels
+ * @error:(out): An error is returned here when the montage doesn't fit
+ *               the channels of @file
+ *
+ * Creates a file with the derived channels of @file, the header is copied
+ * from @file. The file has no path yet, set one with edf_file_set_path()
+ * in order to write it.
+ *
+ * Returns:(transfer full): a new #EdfFile or NULL
+ */
+EdfFile*
+edf_montage_apply_to_file(EdfMontage* montage, EdfFile* file, GError** error)
+{
+    g_return_val_if_fail(EDF_IS_MONTAGE(montage), NULL);
+    g_return_val_if_fail(EDF_IS_FILE(file), NULL);
+    g_return_val_if_fail(error != NULL && *error == NULL, NULL);
+
+    EdfMontagePrivate* priv = edf_montage_get_instance_private(montage);
+    GPtrArray* in_signals = edf_file_get_signals(file);
+    EdfReaderChannel* channels = g_new0(EdfReaderChannel, MAX(in_signals->len, 1));
+
+    for (guint c = 0; c < in_signals->len; c++) {
+        EdfSignal* signal = g_ptr_array_index(in_signals, c);
+        channels[c] = (EdfReaderChannel) {
+            .label = edf_signal_get_label(signal),
+            .transducer = edf_signal_get_transducer(signal),
+            .physical_dimension = edf_signal_get_physical_dimension(signal),
+            .prefiltering = edf_signal_get_prefiltering(signal),
+            .physical_min = edf_signal_get_physical_min(signal),
+            .physical_max = edf_signal_get_physical_max(signal),
+            .digital_min = edf_signal_get_digital_min(signal),
+            .digital_max = edf_signal_get_digital_max(signal),
+            .ns = edf_signal_get_num_samples_per_record(signal),
+            .sample_size = edf_signal_get_sample_size(signal),
+            .gain = edf_signal_get_gain(signal),
+            .phys_offset = edf_signal_get_offset(signal)
+        };
+    }
+
+    gboolean bound = montage_bind(montage, channels, in_signals->len, error);
+    g_free(channels);
+    if (!bound)
+        return NULL;
+
+    // The signals may differ in their number of records
+    guint64 num_records = G_MAXUINT64;
+    for (guint i = 0; i < priv->inputs->len; i++) {
+        const MontageInput* input = &g_array_index(priv->inputs, MontageInput, i);
+        EdfSignal* signal = g_ptr_array_index(in_signals, input->channel);
+        num_records = MIN(num_records, edf_signal_get_num_records(signal));
+    }
+
+    EdfHeader* in_header = edf_file_header(file);
+    GDateTime* start = edf_header_get_time(in_header);
+    GPtrArray* signals = NULL;
+    EdfFile* out = montage_create_file(
+            priv,
+            edf_header_get_patient(in_header),
+            edf_header_get_recording(in_header),
+            edf_header_get_reserved(in_header),
+            start,
+            edf_header_get_record_duration(in_header),
+            &signals
+            );
+    g_date_time_unref(start);
+
+    gdouble* samples = g_new(gdouble, MAX(priv->num_out_samples, 1));
+    for (guint64 rec = 0; rec < num_records; rec++) {
+        for (guint i = 0; i < priv->inputs->len; i++) {
+            const MontageInput* input = &g_array_index(priv->inputs, MontageInput, i);
+            EdfSignal* signal = g_ptr_array_index(in_signals, input->channel);
+            const guint8* bytes = edf_signal_get_record_bytes(signal, rec);
+            gdouble* row = &priv->rows[input->row_offset];
+
+            edf_samples_decode(bytes, input->info.sample_size, input->info.ns, priv->digital);
+            for (guint s = 0; s < input->info.ns; s++)
+                row[s] = input->info.gain * priv->digital[s] + input->info.phys_offset;
+        }
+        montage_apply_rows(priv, samples);
+        montage_append_record(priv, signals, samples);
+    }
+
+    g_free(samples);
+    g_ptr_array_unref(signals);
+    return out;
+}
+
+/**
+ * edf_montage_convert:
+ * @montage: the montage
+ * @input_path: the path of the recording
+ * @output_path: the path of the re-referenced recording
+ * @error:(out): An error is returned here when reading or writing fails or
+ *               the montage doesn't fit the channels of the input
+ *
+ * Writes a file with the derived channels of @input_path to @output_path.
+ * The input is streamed record by record, only the derived channels are
+ * kept in memory until they are written.
+ *
+ * Returns: TRUE when @output_path was written
+ */
+gboolean
+edf_montage_convert(
+        EdfMontage     *montage,
+        const gchar    *input_path,
+        const gchar    *output_path,
+        GError        **error
+        )
+{
+    g_return_val_if_fail(EDF_IS_MONTAGE(montage), FALSE);
+    g_return_val_if_fail(input_path != NULL && output_path != NULL, FALSE);
+    g_return_val_if_fail(error != NULL && *error == NULL, FALSE);
+
+    EdfMontagePrivate* priv = edf_montage_get_instance_private(montage);
+    EdfReader* reader = edf_reader_open(input_path, error);
+    if (!reader)
+        return FALSE;
+
+    if (!edf_montage_bind_reader(montage, reader, error)) {
+        edf_reader_free(reader);
+        return FALSE;
+    }
+
+    GDateTime* start = g_date_time_new_from_unix_utc(
+            edf_reader_get_start_time(reader)
+            );
+    GPtrArray* signals = NULL;
+    EdfFile* out = montage_create_file(
+            priv,
+            edf_reader_get_patient(reader),
+            edf_reader_get_recording(reader),
+            "",
+            start,
+            edf_reader_get_record_duration(reader),
+            &signals
+            );
+    g_date_time_unref(start);
+
+    gdouble* samples = g_new(gdouble, MAX(priv->num_out_samples, 1));
+    while (edf_reader_next_record(reader, error)) {
+        edf_montage_apply_record(montage, reader, samples);
+        montage_append_record(priv, signals, samples);
+    }
+
+    if (!*error) {
+        edf_file_set_path(out, output_path);
+        edf_file_replace(out, error);
+    }
+
+    g_free(samples);
+    g_ptr_array_unref(signals);
+    g_object_unref(out);
+    edf_reader_free(reader);
+    return *error == NULL;
+}
@@ -0,0 +1,316 @@
+
+#include "edf-parse-priv.h"
+#include "edf-header.h"
+#include "edf-trace-priv.h"
+
+#include <string.h>
+
+/* The offsets of the fields of the signal part of a header per signal */
+#define SIG_LABEL_OFFSET        0
+#define SIG_TRANSDUCER_OFFSET   (SIG_LABEL_OFFSET + EDF_LABEL_SZ)
+#define SIG_PHYS_DIM_OFFSET     (SIG_TRANSDUCER_OFFSET + EDF_TRANDUCER_TYPE_SZ)
+#define SIG_PHYS_MIN_OFFSET     (SIG_PHYS_DIM_OFFSET + EDF_PHYSICAL_DIMENSION_SZ)
+#define SIG_PHYS_MAX_OFFSET     (SIG_PHYS_MIN_OFFSET + EDF_PHYSICAL_MINIMUM_SZ)
+#define SIG_DIG_MIN_OFFSET      (SIG_PHYS_MAX_OFFSET + EDF_PHYSICAL_MAXIMUM_SZ)
+#define SIG_DIG_MAX_OFFSET      (SIG_DIG_MIN_OFFSET + EDF_DIGITAL_MINIMUM_SZ)
+#define SIG_PREFILTER_OFFSET    (SIG_DIG_MAX_OFFSET + EDF_DIGITAL_MAXIMUM_SZ)
+#define SIG_NS_OFFSET           (SIG_PREFILTER_OFFSET + EDF_PREFILTERING_SZ)
+#define SIG_RESERVED_OFFSET     (SIG_NS_OFFSET + EDF_NUM_SAMPLES_PER_RECORD_SZ)
+
+/* ************ fields ************ */
+
+void
+edf_parse_string(gchar* dest, const guint8* field, gsize size)
+{
+    memcpy(dest, field, size);
+    dest[size] = '\0';
+    g_strstrip(dest);
+}
+
+gboolean
+edf_parse_int(const guint8* field, gsize size, gint* value)
+{
+    gchar temp[EDF_PREFILTERING_SZ + 1];
+    gchar* end = NULL;
+
+    g_assert(size < sizeof(temp));
+    edf_parse_string(temp, field, size);
+
+    gint64 v = g_ascii_strtoll(temp, &end, 10);
+    if (end == temp || *end != '\0' || v < G_MININT || v > G_MAXINT)
+        return FALSE;
+
+    *value = (gint) v;
+    return TRUE;
+}
+
+gboolean
+edf_parse_double(const guint8* field, gsize size, gdouble* value)
+{
+    gchar temp[EDF_PREFILTERING_SZ + 1];
+    gchar* end = NULL;
+
+    g_assert(size < sizeof(temp));
+    edf_parse_string(temp, field, size);
+
+    gdouble v = g_ascii_strtod(temp, &end);
+    if (end == temp || *end != '\0')
+        return FALSE;
+
+    *value = v;
+    return TRUE;
+}
+
+/* Parses "xx.yy.zz" */
+static gboolean
+parse_triple(const guint8* field, gint* a, gint* b, gint* c)
+{
+    for (guint i = 0; i < 8; i++) {
+        gboolean dot = i == 2 || i == 5;
+        if (dot ? field[i] != '.' : !g_ascii_isdigit(field[i]))
+            return FALSE;
+    }
+    *a = (field[0] - '0') * 10 + field[1] - '0';
+    *b = (field[3] - '0') * 10 + field[4] - '0';
+    *c = (field[6] - '0') * 10 + field[7] - '0';
+    return TRUE;
+}
+
+static gboolean
+parse_error(GError** error, const gchar* field)
+{
+    g_set_error(
+            error,
+            EDF_HEADER_ERROR,
+            EDF_HEADER_ERROR_PARSE,
+            "The header contains an invalid %s",
+            field
+            );
+    return FALSE;
+}
+
+/* ************ headers ************ */
+
+gboolean
+edf_parsed_header_parse_base(
+        EdfParsedHeader    *header,
+        const guint8       *bytes,
+        GError            **error
+        )
+{
+    gint num_bytes, num_signals, num_records;
+    const guint8* field = bytes;
+
+    g_return_val_if_fail(header != NULL && bytes != NULL, FALSE);
+
+    memset(header, 0, sizeof(EdfParsedHeader));
+
+    if (field[0] == 0xFF) {
+        // BioSemi marks its 24 bit files with "\xFFBIOSEMI"
+        if (memcmp(&field[1], EDF_BIOSEMI_ID, strlen(EDF_BIOSEMI_ID)) != 0)
+            return parse_error(error, "version");
+        header->version = EDF_BIOSEMI_VERSION;
+    }
+    else if (!edf_parse_int(field, EDF_VERSION_SZ, &header->version))
+        return parse_error(error, "version");
+    field += EDF_VERSION_SZ;
+
+    edf_parse_string(header->patient, field, EDF_LOCAL_PATIENT_SZ);
+    field += EDF_LOCAL_PATIENT_SZ;
+
+    edf_parse_string(header->recording, field, EDF_LOCAL_RECORDING_SZ);
+    field += EDF_LOCAL_RECORDING_SZ;
+
+    if (!parse_triple(field, &header->day, &header->month, &header->year))
+        return parse_error(error, "start date");
+    // The clipping date of the edf specification
+    header->year += header->year < 85 ? 2000 : 1900;
+    field += EDF_START_DATE_SZ;
+
+    if (!parse_triple(field, &header->hour, &header->minute, &header->second))
+        return parse_error(error, "start time");
+    field += EDF_START_TIME_SZ;
+
+    if (!edf_parse_int(field, EDF_NUM_BYTES_IN_HEADER_SZ, &num_bytes) ||
+        num_bytes < EDF_BASE_HEADER_SIZE)
+        return parse_error(error, "header size");
+    field += EDF_NUM_BYTES_IN_HEADER_SZ;
+
+    edf_parse_string(header->reserved, field, EDF_RESERVED_SZ);
+    field += EDF_RESERVED_SZ;
+
+    if (!edf_parse_int(field, EDF_NUM_DATA_REC_SZ, &num_records) ||
+        num_records < -1)
+        return parse_error(error, "number of records");
+    header->num_records = num_records;
+    field += EDF_NUM_DATA_REC_SZ;
+
+    if (!edf_parse_double(field, EDF_DURATION_OF_DATA_RECORD_SZ, &header->record_duration) ||
+        header->record_duration < 0)
+        return parse_error(error, "record duration");
+    field += EDF_DURATION_OF_DATA_RECORD_SZ;
+
+    if (!edf_parse_int(field, EDF_NUM_SIGNALS_SZ, &num_signals) ||
+        num_signals < 0 ||
+        (gsize) num_bytes != edf_compute_header_size(num_signals))
+        return parse_error(error, "number of signals");
+
+    header->num_signals = num_signals;
+    header->header_size = num_bytes;
+    return TRUE;
+}
+
+gboolean
+edf_parsed_header_parse_signals(
+        EdfParsedHeader    *header,
+        const guint8       *bytes,
+        GError            **error
+        )
+{
+    const guint n = header->num_signals;
+    const guint sample_size = header->version == EDF_BIOSEMI_VERSION ?
+                              BDF_SAMPLE_SIZE : EDF_SAMPLE_SIZE;
+
+    g_return_val_if_fail(header->signals == NULL, FALSE);
+
+    header->signals = g_new0(EdfParsedSignal, n);
+
+    // The header stores a field of all signals before the next field
+    for (guint i = 0; i < n; i++) {
+        EdfParsedSignal* sig = &header->signals[i];
+        gint ns;
+
+        edf_parse_string(
+                sig->label,
+                &bytes[SIG_LABEL_OFFSET * n + i * EDF_LABEL_SZ],
+                EDF_LABEL_SZ
+                );
+        edf_parse_string(
+                sig->transducer,
+                &bytes[SIG_TRANSDUCER_OFFSET * n + i * EDF_TRANDUCER_TYPE_SZ],
+                EDF_TRANDUCER_TYPE_SZ
+                );
+        edf_parse_string(
+                sig->physical_dimension,
+                &bytes[SIG_PHYS_DIM_OFFSET * n + i * EDF_PHYSICAL_DIMENSION_SZ],
+                EDF_PHYSICAL_DIMENSION_SZ
+                );
+        edf_parse_string(
+                sig->prefiltering,
+                &bytes[SIG_PREFILTER_OFFSET * n + i * EDF_PREFILTERING_SZ],
+                EDF_PREFILTERING_SZ
+                );
+        edf_parse_string(
+                sig->reserved,
+                &bytes[SIG_RESERVED_OFFSET * n + i * EDF_NS_RESERVED_SZ],
+                EDF_NS_RESERVED_SZ
+                );
+
+        if (!edf_parse_double(
+                    &bytes[SIG_PHYS_MIN_OFFSET * n + i * EDF_PHYSICAL_MINIMUM_SZ],
+                    EDF_PHYSICAL_MINIMUM_SZ,
+                    &sig->physical_min) ||
+            !edf_parse_double(
+                    &bytes[SIG_PHYS_MAX_OFFSET * n + i * EDF_PHYSICAL_MAXIMUM_SZ],
+                    EDF_PHYSICAL_MAXIMUM_SZ,
+                    &sig->physical_max))
+            goto fail;
+
+        if (!edf_parse_int(
+                    &bytes[SIG_DIG_MIN_OFFSET * n + i * EDF_DIGITAL_MINIMUM_SZ],
+                    EDF_DIGITAL_MINIMUM_SZ,
+                    &sig->digital_min) ||
+            !edf_parse_int(
+                    &bytes[SIG_DIG_MAX_OFFSET * n + i * EDF_DIGITAL_MAXIMUM_SZ],
+                    EDF_DIGITAL_MAXIMUM_SZ,
+                    &sig->digital_max))
+            goto fail;
+
+        if (!edf_parse_int(
+                    &bytes[SIG_NS_OFFSET * n + i * EDF_NUM_SAMPLES_PER_RECORD_SZ],
+                    EDF_NUM_SAMPLES_PER_RECORD_SZ,
+                    &ns) ||
+            ns < 0)
+            goto fail;
+
+        sig->ns = ns;
+        sig->sample_size = sample_size;
+    }
+    return TRUE;
+
+fail:
+    g_clear_pointer(&header->signals, g_free);
+    return parse_error(error, "signal description");
+}
+
+gboolean
+edf_parsed_header_read(
+        EdfParsedHeader    *header,
+        GInputStream       *istream,
+        GError            **error
+        )
+{
+    guint8 base[EDF_BASE_HEADER_SIZE];
+    gsize nread = 0;
+
+    g_return_val_if_fail(G_IS_INPUT_STREAM(istream), FALSE);
+
+    EDF_TRACE(header__parse__start);
+    if (!g_input_stream_read_all(istream, base, sizeof(base), &nread, NULL, error))
+        return FALSE;
+    if (nread != sizeof(base))
+        return parse_error(error, "size, the file is too short");
+
+    if (!edf_parsed_header_parse_base(header, base, error))
+        return FALSE;
+
+    gsize size = header->header_size - EDF_BASE_HEADER_SIZE;
+    guint8* bytes = g_malloc(size);
+    gboolean result = g_input_stream_read_all(istream, bytes, size, &nread, NULL, error);
+
+    if (result && nread != size)
+        result = parse_error(error, "size, the file is too short");
+
+    if (result)
+        result = edf_parsed_header_parse_signals(header, bytes, error);
+
+    g_free(bytes);
+    if (result)
+        EDF_TRACE2(header__parse__done, header->header_size, header->num_signals);
+    return result;
+}
+
+void
+edf_parsed_header_clear(EdfParsedHeader* header)
+{
+    g_clear_pointer(&header->signals, g_free);
+    header->num_signals = 0;
+}
+
+gsize
+edf_parsed_header_get_record_size(const EdfParsedHeader* header)
+{
+    gsize size = 0;
+    for (guint i = 0; i < header->num_signals; i++)
+        size += (gsize) header->signals[i].ns * header->signals[i].sample_size;
+    return size;
+}
+
+gint64
+edf_parsed_header_get_start_time(const EdfParsedHeader* header)
+{
+    GDateTime* time = g_date_time_new_utc(
+            header->year,
+            header->month,
+            header->day,
+            header->hour,
+            header->minute,
+            header->second
+            );
+    if (!time)
+        return 0;
+
+    gint64 result = g_date_time_to_unix(time);
+    g_date_time_unref(time);
+    return result;
+}
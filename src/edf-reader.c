@@ -0,0 +1,502 @@
+
+#include "edf-reader.h"
+#include "edf-file.h"
+#include "edf-parse-priv.h"
+#include "edf-sample-priv.h"
+#include "edf-trace-priv.h"
+
+#include <string.h>
+
+/**
+ * SECTION:edf-reader
+ * @short_description: a plain C reader that streams the records of a file
+ * @see_also: #EdfFile
+ * @include: gedf.h
+ *
+ * #EdfFile loads a complete file into #EdfSignal objects. Programs that
+ * only need to stream samples, possibly at high rates, don't need that.
+ * An #EdfReader parses the header into plain #EdfReaderChannel
+ * descriptors, with the same parser as #EdfCatalog, and then reads one
+ * record at a time into a buffer that is reused. The samples of a channel
+ * of the current record are obtained with edf_reader_get_digital() or
+ * edf_reader_get_physical(), which don't check types of objects and
+ * decode a whole record of a channel at once.
+ *
+ * |[<!-- language="C" -->
+ * EdfReader* reader = edf_reader_open("recording.bdf", &error);
+ * const EdfReaderChannel* chan = edf_reader_get_channel(reader, 0);
+ * gdouble* samples = g_new(gdouble, chan->ns);
+ *
+ * while (edf_reader_next_record(reader, &error))
+ *     edf_reader_get_physical(reader, 0, samples);
+ * ]|
+ *
+ * Gzip and codec compressed files are read too, but only uncompressed
+ * files can be seeked with edf_reader_seek_record(). An #EdfReader isn't
+ * a GObject and it is not available from language bindings, use #EdfFile
+ * there. A reader should not be used from multiple threads at the same
+ * time.
+ */
+
+G_DEFINE_QUARK(edf_reader_error_quark, edf_reader_error)
+
+struct _EdfReader {
+    GInputStream       *istream;
+    EdfParsedHeader     header;
+    EdfReaderChannel   *channels;
+    gsize               record_size;
+    guint8             *record;         /* the bytes of the current record */
+    gint64              record_index;   /* -1 before the first record */
+};
+
+/**
+ * edf_reader_new_for_stream:(skip)
+ * @istream: a stream positioned at the start of an edf/bdf file
+ * @error:(out): An error is returned here when the header is invalid
+ *
+ * Reads the header from @istream, the records are read from it afterwards.
+ * A reference to @istream is taken.
+ *
+ * Returns: a new #EdfReader, free it with edf_reader_free(), or NULL
+ */
+EdfReader*
+edf_reader_new_for_stream(GInputStream* istream, GError** error)
+{
+    g_return_val_if_fail(G_IS_INPUT_STREAM(istream), NULL);
+    g_return_val_if_fail(error != NULL && *error == NULL, NULL);
+
+    EdfReader* reader = g_new0(EdfReader, 1);
+
+    if (!edf_parsed_header_read(&reader->header, istream, error)) {
+        g_free(reader);
+        return NULL;
+    }
+
+    reader->istream = g_object_ref(istream);
+    reader->channels = g_new0(EdfReaderChannel, reader->header.num_signals);
+
+    gsize offset = 0;
+    for (guint i = 0; i < reader->header.num_signals; i++) {
+        const EdfParsedSignal* sig = &reader->header.signals[i];
+        EdfReaderChannel* chan = &reader->channels[i];
+        gint dig_span = sig->digital_max - sig->digital_min;
+
+        chan->label = sig->label;
+        chan->transducer = sig->transducer;
+        chan->physical_dimension = sig->physical_dimension;
+        chan->prefiltering = sig->prefiltering;
+        chan->physical_min = sig->physical_min;
+        chan->physical_max = sig->physical_max;
+        chan->digital_min = sig->digital_min;
+        chan->digital_max = sig->digital_max;
+        chan->ns = sig->ns;
+        chan->sample_size = sig->sample_size;
+        chan->offset = offset;
+        chan->gain = dig_span == 0 ? 0 :
+                     (sig->physical_max - sig->physical_min) / dig_span;
+        chan->phys_offset = sig->physical_min - chan->gain * sig->digital_min;
+
+        offset += (gsize) sig->ns * sig->sample_size;
+    }
+
+    reader->record_size = offset;
+    reader->record = g_malloc0(MAX(offset, 1));
+    reader->record_index = -1;
+    return reader;
+}
+
+/**
+ * edf_reader_open:(skip)
+ * @path: the path of an (optionally compressed) edf/bdf file
+ * @error:(out): An error is returned here when the file cannot be opened or
+ *               its header is invalid
+ *
+ * Opens @path and reads its header.
+ *
+ * Returns: a new #EdfReader, free it with edf_reader_free(), or NULL
+ */
+EdfReader*
+edf_reader_open(const gchar* path, GError** error)
+{
+    g_return_val_if_fail(path != NULL, NULL);
+    g_return_val_if_fail(error != NULL && *error == NULL, NULL);
+
+    GFile* file = g_file_new_for_path(path);
+    GInputStream* istream = edf_file_open_input_stream(file, error);
+    g_object_unref(file);
+    if (!istream)
+        return NULL;
+
+    EdfReader* reader = edf_reader_new_for_stream(istream, error);
+    g_object_unref(istream);
+    return reader;
+}
+
+/**
+ * edf_reader_free:(skip)
+ * @reader: the reader to free
+ *
+ * Closes the file of @reader and frees it.
+ */
+void
+edf_reader_free(EdfReader* reader)
+{
+    if (!reader)
+        return;
+
+    g_object_unref(reader->istream);
+    edf_parsed_header_clear(&reader->header);
+    g_free(reader->channels);
+    g_free(reader->record);
+    g_free(reader);
+}
+
+/**
+ * edf_reader_get_num_channels:(skip)
+ * @reader: the reader
+ *
+ * Returns: the number of channels/signals in the file
+ */
+guint
+edf_reader_get_num_channels(const EdfReader* reader)
+{
+    g_return_val_if_fail(reader != NULL, 0);
+    return reader->header.num_signals;
+}
+
+/**
+ * edf_reader_get_channel:(skip)
+ * @reader: the reader
+ * @channel: the index of the channel
+ *
+ * Returns: the description of @channel, it is owned by @reader.
+ */
+const EdfReaderChannel*
+edf_reader_get_channel(const EdfReader* reader, guint channel)
+{
+    g_return_val_if_fail(reader != NULL, NULL);
+    g_return_val_if_fail(channel < reader->header.num_signals, NULL);
+    return &reader->channels[channel];
+}
+
+/**
+ * edf_reader_find_channel:(skip)
+ * @reader: the reader
+ * @label: the label of a channel
+ *
+ * Returns: the index of the first channel with @label or -1
+ */
+gint
+edf_reader_find_channel(const EdfReader* reader, const gchar* label)
+{
+    g_return_val_if_fail(reader != NULL && label != NULL, -1);
+
+    for (guint i = 0; i < reader->header.num_signals; i++)
+        if (g_strcmp0(reader->channels[i].label, label) == 0)
+            return i;
+    return -1;
+}
+
+/**
+ * edf_reader_get_patient:(skip)
+ * @reader: the reader
+ *
+ * Returns: the local patient identification of the header
+ */
+const gchar*
+edf_reader_get_patient(const EdfReader* reader)
+{
+    g_return_val_if_fail(reader != NULL, NULL);
+    return reader->header.patient;
+}
+
+/**
+ * edf_reader_get_recording:(skip)
+ * @reader: the reader
+ *
+ * Returns: the local recording identification of the header
+ */
+const gchar*
+edf_reader_get_recording(const EdfReader* reader)
+{
+    g_return_val_if_fail(reader != NULL, NULL);
+    return reader->header.recording;
+}
+
+/**
+ * edf_reader_get_start_time:(skip)
+ * @reader: the reader
+ *
+ * The header stores the start without a time zone, it is returned as if
+ * it was UTC.
+ *
+ * Returns: the start of the recording in seconds since the epoch
+ */
+gint64
+edf_reader_get_start_time(const EdfReader* reader)
+{
+    g_return_val_if_fail(reader != NULL, 0);
+    return edf_parsed_header_get_start_time(&reader->header);
+}
+
+/**
+ * edf_reader_get_num_records:(skip)
+ * @reader: the reader
+ *
+ * Returns: the number of records stated in the header, -1 when it is
+ *          unknown because the file was still being recorded.
+ */
+gint64
+edf_reader_get_num_records(const EdfReader* reader)
+{
+    g_return_val_if_fail(reader != NULL, -1);
+    return reader->header.num_records;
+}
+
+/**
+ * edf_reader_get_record_duration:(skip)
+ * @reader: the reader
+ *
+ * Returns: the duration of one record in seconds
+ */
+gdouble
+edf_reader_get_record_duration(const EdfReader* reader)
+{
+    g_return_val_if_fail(reader != NULL, 0);
+    return reader->header.record_duration;
+}
+
+/**
+ * edf_reader_get_record_size:(skip)
+ * @reader: the reader
+ *
+ * Returns: the number of bytes of one record
+ */
+gsize
+edf_reader_get_record_size(const EdfReader* reader)
+{
+    g_return_val_if_fail(reader != NULL, 0);
+    return reader->record_size;
+}
+
+/**
+ * edf_reader_get_record_index:(skip)
+ * @reader: the reader
+ *
+ * Returns: the index of the current record or -1 when no record has been
+ *          read yet.
+ */
+gint64
+edf_reader_get_record_index(const EdfReader* reader)
+{
+    g_return_val_if_fail(reader != NULL, -1);
+    return reader->record_index;
+}
+
+/**
+ * edf_reader_next_record:(skip)
+ * @reader: the reader
+ * @error:(out): An error is returned here when reading fails or the file
+ *               ends in the middle of a record
+ *
+ * Reads the next record, its samples are available until the next call
+ * to edf_reader_next_record() or edf_reader_seek_record().
+ *
+ * Returns: TRUE when a record was read, FALSE at the end of the file or
+ *          when an error occurred.
+ */
+gboolean
+edf_reader_next_record(EdfReader* reader, GError** error)
+{
+    gsize nread = 0;
+
+    g_return_val_if_fail(reader != NULL, FALSE);
+    g_return_val_if_fail(error != NULL && *error == NULL, FALSE);
+
+    // A header with a known number of records ignores trailing bytes
+    if (reader->header.num_records >= 0 &&
+        reader->record_index + 1 >= reader->header.num_records)
+        return FALSE;
+
+    if (reader->record_size == 0)
+        return FALSE;
+
+    if (!g_input_stream_read_all(
+                reader->istream,
+                reader->record,
+                reader->record_size,
+                &nread,
+                NULL,
+                error
+                ))
+        return FALSE;
+
+    if (nread == 0)
+        return FALSE;
+
+    if (nread != reader->record_size) {
+        g_set_error(
+                error,
+                EDF_READER_ERROR,
+                EDF_READER_ERROR_TRUNCATED,
+                "Record %" G_GINT64_FORMAT " is truncated after %" G_GSIZE_FORMAT
+                " of %" G_GSIZE_FORMAT " bytes",
+                reader->record_index + 1,
+                nread,
+                reader->record_size
+                );
+        return FALSE;
+    }
+
+    reader->record_index++;
+    EDF_TRACE2(records__read, 1, nread);
+    return TRUE;
+}
+
+/**
+ * edf_reader_seek_record:(skip)
+ * @reader: the reader
+ * @record: the index of the record to read
+ * @error:(out): An error is returned here when the stream cannot seek or
+ *               @record doesn't exist
+ *
+ * Reads record @record, this is only possible for uncompressed files.
+ * When it fails, the reader stays at its current record.
+ *
+ * Returns: TRUE when the record was read
+ */
+gboolean
+edf_reader_seek_record(EdfReader* reader, guint64 record, GError** error)
+{
+    g_return_val_if_fail(reader != NULL, FALSE);
+    g_return_val_if_fail(error != NULL && *error == NULL, FALSE);
+
+    if ((reader->header.num_records >= 0 &&
+         record >= (guint64) reader->header.num_records) ||
+        record > G_MAXINT64 / MAX(reader->record_size, 1)) {
+        g_set_error(
+                error,
+                EDF_READER_ERROR,
+                EDF_READER_ERROR_OUT_OF_RANGE,
+                "Record %" G_GUINT64_FORMAT " is beyond the end of the file",
+                record
+                );
+        return FALSE;
+    }
+
+    if (!G_IS_SEEKABLE(reader->istream) ||
+        !g_seekable_can_seek(G_SEEKABLE(reader->istream))) {
+        g_set_error_literal(
+                error,
+                EDF_READER_ERROR,
+                EDF_READER_ERROR_NOT_SEEKABLE,
+                "The file cannot be seeked, it is probably compressed"
+                );
+        return FALSE;
+    }
+
+    GSeekable* seekable = G_SEEKABLE(reader->istream);
+    goffset previous = g_seekable_tell(seekable);
+    gint64 current = reader->record_index;
+
+    goffset offset = reader->header.header_size + record * reader->record_size;
+    if (!g_seekable_seek(seekable, offset, G_SEEK_SET, NULL, error))
+        return FALSE;
+
+    GError* local_error = NULL;
+    reader->record_index = (gint64) record - 1;
+    if (edf_reader_next_record(reader, &local_error))
+        return TRUE;
+
+    /*
+     * Stay at the current record, a partial read may have overwritten its
+     * bytes so it is read again.
+     */
+    reader->record_index = current;
+    if (current >= 0 &&
+        g_seekable_seek(seekable, previous - reader->record_size, G_SEEK_SET, NULL, NULL))
+        g_input_stream_read_all(
+                reader->istream, reader->record, reader->record_size, NULL, NULL, NULL
+                );
+    else
+        g_seekable_seek(seekable, previous, G_SEEK_SET, NULL, NULL);
+
+    if (!local_error)
+        g_set_error(
+                &local_error,
+                EDF_READER_ERROR,
+                EDF_READER_ERROR_OUT_OF_RANGE,
+                "Record %" G_GUINT64_FORMAT " is beyond the end of the file",
+                record
+                );
+    g_propagate_error(error, local_error);
+    return FALSE;
+}
+
+/**
+ * edf_reader_get_record_bytes:(skip)
+ * @reader: the reader
+ *
+ * Returns: the raw bytes of the current record, the samples of a channel
+ *          start at the offset of its #EdfReaderChannel.
+ */
+const guint8*
+edf_reader_get_record_bytes(const EdfReader* reader)
+{
+    g_return_val_if_fail(reader != NULL, NULL);
+    return reader->record;
+}
+
+/**
+ * edf_reader_get_digital:(skip)
+ * @reader: the reader
+ * @channel: the index of the channel
+ * @samples:(out): room for the ns samples of @channel
+ *
+ * Decodes the digital samples of @channel in the current record.
+ */
+void
+edf_reader_get_digital(const EdfReader* reader, guint channel, gint32* samples)
+{
+    g_return_if_fail(reader != NULL && samples != NULL);
+    g_return_if_fail(channel < reader->header.num_signals);
+
+    const EdfReaderChannel* chan = &reader->channels[channel];
+    edf_samples_decode(
+            &reader->record[chan->offset], chan->sample_size, chan->ns, samples
+            );
+}
+
+/**
+ * edf_reader_get_physical:(skip)
+ * @reader: the reader
+ * @channel: the index of the channel
+ * @samples:(out): room for the ns samples of @channel
+ *
+ * Decodes the samples of @channel in the current record and converts them
+ * to physical units.
+ */
+void
+edf_reader_get_physical(const EdfReader* reader, guint channel, gdouble* samples)
+{
+    g_return_if_fail(reader != NULL && samples != NULL);
+    g_return_if_fail(channel < reader->header.num_signals);
+
+    const EdfReaderChannel* chan = &reader->channels[channel];
+    const guint8* bytes = &reader->record[chan->offset];
+    const gdouble gain = chan->gain, offset = chan->phys_offset;
+
+    if (chan->sample_size == BDF_SAMPLE_SIZE) {
+        for (gsize i = 0; i < chan->ns; i++) {
+            const guint8* b = &bytes[i * BDF_SAMPLE_SIZE];
+            guint32 v = b[0] | (b[1] << 8) | ((guint32) b[2] << 16);
+            samples[i] = gain * ((gint32) (v ^ 0x800000u) - 0x800000) + offset;
+        }
+    }
+    else {
+        for (gsize i = 0; i < chan->ns; i++) {
+            const guint8* b = &bytes[i * EDF_SAMPLE_SIZE];
+            samples[i] = gain * (gint16) (guint16) (b[0] | (b[1] << 8)) + offset;
+        }
+    }
+}
@@ -0,0 +1,438 @@
+
+#include "edf-record-queue.h"
+#include "edf-header-priv.h"
+#include "edf-trace-priv.h"
+
+#include <string.h>
+
+/**
+ * SECTION:edf-record-queue
+ * @short_description: passes records from an acquisition thread to a writer thread
+ * @see_also: #EdfFile, #EdfFollower
+ * @include: gedf.h
+ *
+ * The callback of an amplifier must never wait for the disk. An
+ * #EdfRecordQueue is a ring of preallocated record buffers between one
+ * producer thread, that fills records, and one consumer thread, that
+ * writes them. Neither side takes a lock or allocates memory. When the
+ * consumer falls behind and the queue is full, the producer drops the
+ * record instead of waiting and the drop is counted, the high-water mark
+ * tells how close the queue came to being full.
+ *
+ * An #EdfRecordWriter is a consumer thread that writes the records of a
+ * queue to an output stream in batches:
+ *
+ * |[<!-- language="C" -->
+ * // The header is written first, with -1 records
+ * GOutputStream* ostream = edf_file_open_output_stream(file, TRUE, &error);
+ * edf_header_set_expected_num_records(header, -1);
+ * edf_header_write_to_ostream(header, ostream, &error);
+ *
+ * EdfRecordQueue* queue = edf_record_queue_new_for_header(header, 256);
+ * EdfRecordWriter* writer = edf_record_writer_new(queue, ostream);
+ *
+ * // in the acquisition thread, for every record
+ * guint8* record = edf_record_queue_acquire(queue);
+ * if (record) {
+ *     fill_record(record);
+ *     edf_record_queue_publish(queue);
+ * }
+ *
+ * // when the acquisition has stopped
+ * edf_record_writer_finish(writer, &num_written, &error);
+ * edf_record_queue_free(queue);
+ * ]|
+ *
+ * The number of records in the header can be set afterwards with
+ * edf_file_repair(). The queue and the writer are plain C structures,
+ * they are not available from language bindings.
+ */
+
+// Keeps the indices of the producer and the consumer in different cache lines
+#define QUEUE_CACHE_LINE    64
+// The largest capacity of a queue
+#define QUEUE_MAX_CAPACITY  (1u << 30)
+// How long an idle writer sleeps before it checks the queue again
+#define WRITER_IDLE_USEC    1000
+
+/*
+ * The indices grow without bound and wrap around at G_MAXUINT, a record
+ * lives in slot index & mask. head - tail is the number of queued records.
+ */
+struct _EdfRecordQueue {
+    gsize       record_size;
+    guint       capacity;
+    guint       mask;
+    guint8     *slots;
+
+    /* written by the producer */
+    guint       head;
+    guint       dropped;
+    guint       high_water;
+    gboolean    acquired;
+    guint8      pad0[QUEUE_CACHE_LINE];
+
+    /* written by the consumer */
+    guint       tail;
+    guint8      pad1[QUEUE_CACHE_LINE];
+};
+
+struct _EdfRecordWriter {
+    EdfRecordQueue     *queue;
+    GOutputStream      *ostream;
+    GThread            *thread;
+    gint                stop;
+    guint64             num_written;
+    GError             *error;
+};
+
+/**
+ * edf_record_queue_new:(skip)
+ * @record_size: the size of one record in bytes
+ * @capacity: the number of records in the queue, it is rounded up to a
+ *            power of 2
+ *
+ * Returns: a new #EdfRecordQueue, free it with edf_record_queue_free()
+ */
+EdfRecordQueue*
+edf_record_queue_new(gsize record_size, guint capacity)
+{
+    g_return_val_if_fail(record_size > 0, NULL);
+    g_return_val_if_fail(capacity > 0 && capacity <= QUEUE_MAX_CAPACITY, NULL);
+
+    EdfRecordQueue* queue = g_new0(EdfRecordQueue, 1);
+    guint size = 1;
+
+    while (size < capacity)
+        size <<= 1;
+
+    queue->record_size = record_size;
+    queue->capacity = size;
+    queue->mask = size - 1;
+    queue->slots = g_malloc0(record_size * size);
+    return queue;
+}
+
+/**
+ * edf_record_queue_new_for_header:(skip)
+ * @header: the header of the file whose records are queued
+ * @capacity: the number of records in the queue, it is rounded up to a
+ *            power of 2
+ *
+ * Returns: a new #EdfRecordQueue for the records of the signals of
+ *          @header, free it with edf_record_queue_free()
+ */
+EdfRecordQueue*
+edf_record_queue_new_for_header(EdfHeader* header, guint capacity)
+{
+    g_return_val_if_fail(EDF_IS_HEADER(header), NULL);
+
+    return edf_record_queue_new(edf_header_get_record_size(header), capacity);
+}
+
+/**
+ * edf_record_queue_free:(skip)
+ * @queue: the queue to free
+ *
+ * Frees @queue, the producer and the consumer must have stopped.
+ */
+void
+edf_record_queue_free(EdfRecordQueue* queue)
+{
+    if (!queue)
+        return;
+    g_free(queue->slots);
+    g_free(queue);
+}
+
+/**
+ * edf_record_queue_get_record_size:(skip)
+ * @queue: the queue
+ *
+ * Returns: the size of one record in bytes
+ */
+gsize
+edf_record_queue_get_record_size(const EdfRecordQueue* queue)
+{
+    g_return_val_if_fail(queue != NULL, 0);
+    return queue->record_size;
+}
+
+/**
+ * edf_record_queue_get_capacity:(skip)
+ * @queue: the queue
+ *
+ * Returns: the number of records that fit in @queue
+ */
+guint
+edf_record_queue_get_capacity(const EdfRecordQueue* queue)
+{
+    g_return_val_if_fail(queue != NULL, 0);
+    return queue->capacity;
+}
+
+/* ************ producer ************ */
+
+/**
+ * edf_record_queue_acquire:(skip)
+ * @queue: the queue
+ *
+ * Obtains the buffer of the next record, for the producer thread only. The
+ * buffer contains old bytes, the record is passed on to the consumer with
+ * edf_record_queue_publish(). When the queue is full the record is
+ * dropped: the counter of dropped records is incremented and NULL is
+ * returned. This doesn't block.
+ *
+ * Returns:(nullable): the buffer of edf_record_queue_get_record_size()
+ *          bytes of the next record or NULL when the queue is full.
+ */
+guint8*
+edf_record_queue_acquire(EdfRecordQueue* queue)
+{
+    g_return_val_if_fail(queue != NULL, NULL);
+
+    guint tail = g_atomic_int_get(&queue->tail);
+
+    if (queue->head - tail == queue->capacity) {
+        g_atomic_int_inc(&queue->dropped);
+        return NULL;
+    }
+
+    queue->acquired = TRUE;
+    return &queue->slots[(gsize) (queue->head & queue->mask) * queue->record_size];
+}
+
+/**
+ * edf_record_queue_publish:(skip)
+ * @queue: the queue
+ *
+ * Passes the record of the last edf_record_queue_acquire() on to the
+ * consumer, for the producer thread only.
+ */
+void
+edf_record_queue_publish(EdfRecordQueue* queue)
+{
+    g_return_if_fail(queue != NULL);
+    g_return_if_fail(queue->acquired);
+
+    // The store of head orders the bytes of the record before it
+    guint head = queue->head + 1;
+    g_atomic_int_set(&queue->head, head);
+    queue->acquired = FALSE;
+
+    guint queued = head - g_atomic_int_get(&queue->tail);
+    if (queued > queue->high_water)
+        g_atomic_int_set(&queue->high_water, queued);
+}
+
+/**
+ * edf_record_queue_push:(skip)
+ * @queue: the queue
+ * @record:(array): edf_record_queue_get_record_size() bytes of a record
+ *
+ * Copies @record into @queue and publishes it, for the producer thread
+ * only.
+ *
+ * Returns: FALSE when the queue is full and the record was dropped
+ */
+gboolean
+edf_record_queue_push(EdfRecordQueue* queue, const guint8* record)
+{
+    g_return_val_if_fail(queue != NULL, FALSE);
+    g_return_val_if_fail(record != NULL, FALSE);
+
+    guint8* buffer = edf_record_queue_acquire(queue);
+    if (!buffer)
+        return FALSE;
+
+    memcpy(buffer, record, queue->record_size);
+    edf_record_queue_publish(queue);
+    return TRUE;
+}
+
+/* ************ consumer ************ */
+
+/**
+ * edf_record_queue_peek:(skip)
+ * @queue: the queue
+ * @num_records:(out): the number of records at the returned address
+ *
+ * Obtains the oldest records of @queue, for the consumer thread only.
+ * The records that are contiguous in memory are returned at once, so they
+ * can be written with one call. They stay in the queue until they are
+ * released with edf_record_queue_release().
+ *
+ * Returns:(nullable): the bytes of @num_records records or NULL when the
+ *          queue is empty.
+ */
+const guint8*
+edf_record_queue_peek(EdfRecordQueue* queue, guint* num_records)
+{
+    g_return_val_if_fail(queue != NULL, NULL);
+    g_return_val_if_fail(num_records != NULL, NULL);
+
+    guint tail = queue->tail;
+    guint queued = g_atomic_int_get(&queue->head) - tail;
+    guint slot = tail & queue->mask;
+
+    *num_records = MIN(queued, queue->capacity - slot);
+    if (*num_records == 0)
+        return NULL;
+    return &queue->slots[(gsize) slot * queue->record_size];
+}
+
+/**
+ * edf_record_queue_release:(skip)
+ * @queue: the queue
+ * @num_records: the number of records that were consumed
+ *
+ * Returns the buffers of the oldest @num_records records to the producer,
+ * for the consumer thread only.
+ */
+void
+edf_record_queue_release(EdfRecordQueue* queue, guint num_records)
+{
+    g_return_if_fail(queue != NULL);
+    g_return_if_fail(num_records <= g_atomic_int_get(&queue->head) - queue->tail);
+
+    g_atomic_int_set(&queue->tail, queue->tail + num_records);
+}
+
+/* ************ counters ************ */
+
+/**
+ * edf_record_queue_get_num_queued:(skip)
+ * @queue: the queue
+ *
+ * Returns: the number of records in @queue, from any thread it is a
+ *          snapshot.
+ */
+guint
+edf_record_queue_get_num_queued(EdfRecordQueue* queue)
+{
+    g_return_val_if_fail(queue != NULL, 0);
+    guint tail = g_atomic_int_get(&queue->tail);
+    return g_atomic_int_get(&queue->head) - tail;
+}
+
+/**
+ * edf_record_queue_get_high_water:(skip)
+ * @queue: the queue
+ *
+ * Returns: the largest number of records that were in @queue at once
+ */
+guint
+edf_record_queue_get_high_water(EdfRecordQueue* queue)
+{
+    g_return_val_if_fail(queue != NULL, 0);
+    return g_atomic_int_get(&queue->high_water);
+}
+
+/**
+ * edf_record_queue_get_num_dropped:(skip)
+ * @queue: the queue
+ *
+ * Returns: the number of records that were dropped because @queue was full
+ */
+guint
+edf_record_queue_get_num_dropped(EdfRecordQueue* queue)
+{
+    g_return_val_if_fail(queue != NULL, 0);
+    return g_atomic_int_get(&queue->dropped);
+}
+
+/* ************ writer ************ */
+
+static gpointer
+writer_run(gpointer data)
+{
+    EdfRecordWriter* writer = data;
+    EdfRecordQueue* queue = writer->queue;
+
+    while (TRUE) {
+        // Records published before the stop are seen by the peek after it
+        gboolean stopping = g_atomic_int_get(&writer->stop);
+        guint n = 0;
+        const guint8* records = edf_record_queue_peek(queue, &n);
+
+        if (n > 0) {
+            if (!g_output_stream_write_all(
+                        writer->ostream,
+                        records,
+                        (gsize) n * queue->record_size,
+                        NULL,
+                        NULL,
+                        &writer->error
+                        ))
+                break;
+            edf_record_queue_release(queue, n);
+            writer->num_written += n;
+            EDF_TRACE2(records__write, n, (gsize) n * queue->record_size);
+        }
+        else if (stopping) {
+            break;
+        }
+        else {
+            g_usleep(WRITER_IDLE_USEC);
+        }
+    }
+    return NULL;
+}
+
+/**
+ * edf_record_writer_new:(skip)
+ * @queue: the queue to drain, it must outlive the writer
+ * @ostream: the stream to write the records to
+ *
+ * Starts a thread that is the consumer of @queue, it writes the queued
+ * records to @ostream in batches. When writing fails the thread stops
+ * consuming and the producer starts to drop records, the error is
+ * returned by edf_record_writer_finish().
+ *
+ * Returns: a new #EdfRecordWriter, stop it with edf_record_writer_finish()
+ */
+EdfRecordWriter*
+edf_record_writer_new(EdfRecordQueue* queue, GOutputStream* ostream)
+{
+    g_return_val_if_fail(queue != NULL, NULL);
+    g_return_val_if_fail(G_IS_OUTPUT_STREAM(ostream), NULL);
+
+    EdfRecordWriter* writer = g_new0(EdfRecordWriter, 1);
+    writer->queue = queue;
+    writer->ostream = g_object_ref(ostream);
+    writer->thread = g_thread_new("edf-record-writer", writer_run, writer);
+    return writer;
+}
+
+/**
+ * edf_record_writer_finish:(skip)
+ * @writer: the writer
+ * @num_written:(out)(optional): the number of records that were written
+ * @error:(out): The error that stopped the writer is returned here
+ *
+ * Writes the records that are still queued, stops the thread of @writer
+ * and frees it. The producer must have stopped publishing records. The
+ * output stream isn't closed.
+ *
+ * Returns: TRUE when all records were written
+ */
+gboolean
+edf_record_writer_finish(EdfRecordWriter* writer, guint64* num_written, GError** error)
+{
+    g_return_val_if_fail(writer != NULL, FALSE);
+    g_return_val_if_fail(error != NULL && *error == NULL, FALSE);
+
+    g_atomic_int_set(&writer->stop, TRUE);
+    g_thread_join(writer->thread);
+
+    if (num_written)
+        *num_written = writer->num_written;
+
+    gboolean result = writer->error == NULL;
+    if (writer->error)
+        g_propagate_error(error, writer->error);
+
+    g_object_unref(writer->ostream);
+    g_free(writer);
+    return result;
+}
@@ -0,0 +1,540 @@
+
+#include "edf-resampler.h"
+
+#include <math.h>
+#include <string.h>
+
+/**
+ * SECTION:edf-resampler
+ * @short_description: converts a signal to another sample rate while streaming
+ * @see_also: #EdfFilter, #EdfSignal
+ * @include: gedf.h
+ *
+ * An #EdfResampler changes the sample rate of one signal by a rational
+ * factor up / down, e.g. 1 / 8 to go from 2048 Hz to 256 Hz, or
+ * 3 / 2 to go from 256 Hz to 384 Hz. The signal is conceptually upsampled,
+ * low pass filtered and downsampled. The anti-aliasing filter is a
+ * windowed sinc, split into up polyphase branches, so only the products
+ * that contribute to an output sample are computed.
+ *
+ * The resampler keeps the last input samples, so a signal may be passed in
+ * pieces, e.g. one record at a time. The delay of the filter is
+ * compensated: output sample m corresponds to input time m * down / up.
+ * Hence the last output samples are only known after the end of the
+ * signal, they are obtained with edf_resampler_flush().
+ *
+ * |[<!-- language="C" -->
+ * EdfResampler* resampler = edf_resampler_new(256, 2048, &error);
+ * gdouble* out = g_new(gdouble, edf_resampler_get_max_output(resampler, ns));
+ *
+ * while (edf_reader_next_record(reader, &error)) {
+ *     edf_reader_get_physical(reader, channel, in);
+ *     gsize n = edf_resampler_process(resampler, in, ns, out);
+ *     ...
+ * }
+ * gsize n = edf_resampler_flush(resampler, out);
+ * ]|
+ *
+ * An #EdfSignal is resampled at once with edf_signal_resample().
+ */
+
+G_DEFINE_QUARK(edf_resampler_error_quark, edf_resampler_error)
+
+// The largest up or down factor after reduction
+#define MAX_FACTOR          4096
+// The number of zero crossings of the sinc on each side
+#define HALF_ZERO_CROSSINGS 10
+// The shape of the Kaiser window
+#define KAISER_BETA         5.0
+
+typedef struct _EdfResamplerPrivate {
+    guint       up;
+    guint       down;
+    guint       num_taps;       // length of the prototype filter
+    guint       delay;          // of the filter in upsampled samples
+    guint       phase_taps;     // taps per polyphase branch
+    gdouble    *phases;         // up × phase_taps, each branch reversed
+
+    /* the input history, x[0] is input sample base */
+    gdouble    *x;
+    gsize       x_len;
+    gsize       x_cap;
+    gint64      base;
+    guint64     num_input;
+    guint64     num_output;
+} EdfResamplerPrivate;
+
+G_DEFINE_TYPE_WITH_PRIVATE(EdfResampler, edf_resampler, G_TYPE_OBJECT)
+
+typedef enum {
+    PROP_UP = 1,
+    PROP_DOWN,
+    N_PROPERTIES
+} EdfResamplerProperty;
+
+static void
+edf_resampler_init(EdfResampler* self)
+{
+    EdfResamplerPrivate* priv = edf_resampler_get_instance_private(self);
+
+    priv->up = 1;
+    priv->down = 1;
+}
+
+static void
+edf_resampler_finalize(GObject* gobject)
+{
+    EdfResamplerPrivate* priv = edf_resampler_get_instance_private(
+            EDF_RESAMPLER(gobject)
+            );
+
+    g_free(priv->phases);
+    g_free(priv->x);
+
+    G_OBJECT_CLASS(edf_resampler_parent_class)->finalize(gobject);
+}
+
+/* The zeroth order modified Bessel function of the first kind */
+static gdouble
+bessel_i0(gdouble x)
+{
+    gdouble sum = 1, term = 1;
+    for (guint k = 1; k < 64; k++) {
+        term *= (x / (2 * k)) * (x / (2 * k));
+        sum += term;
+        if (term < sum * 1e-17)
+            break;
+    }
+    return sum;
+}
+
+/*
+ * Designs the low pass filter at the upsampled rate with a cutoff at the
+ * Nyquist frequency of the lower of both rates and splits it into the
+ * polyphase branches.
+ */
+static void
+resampler_design(EdfResamplerPrivate* priv)
+{
+    guint factor = MAX(priv->up, priv->down);
+    guint n = 2 * HALF_ZERO_CROSSINGS * factor + 1;
+    gdouble fc = 0.5 / factor;
+    gdouble* h = g_new(gdouble, n);
+    gdouble sum = 0;
+
+    priv->num_taps = n;
+    priv->delay = (n - 1) / 2;
+    for (guint i = 0; i < n; i++) {
+        gdouble t = (gdouble) i - priv->delay;
+        gdouble r = t / priv->delay;
+        gdouble sinc = t == 0 ? 1 : sin(2 * G_PI * fc * t) / (2 * G_PI * fc * t);
+        gdouble window = bessel_i0(KAISER_BETA * sqrt(MAX(0, 1 - r * r))) /
+                         bessel_i0(KAISER_BETA);
+        h[i] = 2 * fc * sinc * window;
+        sum += h[i];
+    }
+
+    priv->phase_taps = (n + priv->up - 1) / priv->up;
+    g_free(priv->phases);
+    priv->phases = g_new0(gdouble, (gsize) priv->up * priv->phase_taps);
+
+    // The gain of every branch is about 1
+    for (guint p = 0; p < priv->up; p++) {
+        gdouble* branch = &priv->phases[(gsize) p * priv->phase_taps];
+        for (guint k = 0; k < priv->phase_taps; k++) {
+            guint i = p + k * priv->up;
+            if (i < n)
+                branch[priv->phase_taps - 1 - k] = h[i] * priv->up / sum;
+        }
+    }
+    g_free(h);
+}
+
+static void
+edf_resampler_constructed(GObject* gobject)
+{
+    EdfResampler* self = EDF_RESAMPLER(gobject);
+    EdfResamplerPrivate* priv = edf_resampler_get_instance_private(self);
+
+    resampler_design(priv);
+    edf_resampler_reset(self);
+
+    G_OBJECT_CLASS(edf_resampler_parent_class)->constructed(gobject);
+}
+
+static void
+edf_resampler_set_property(
+        GObject        *object,
+        guint32         propid,
+        const GValue   *value,
+        GParamSpec     *spec
+        )
+{
+    EdfResamplerPrivate* priv = edf_resampler_get_instance_private(
+            EDF_RESAMPLER(object)
+            );
+
+    switch ((EdfResamplerProperty) propid) {
+        case PROP_UP:
+            priv->up = g_value_get_uint(value);
+            break;
+        case PROP_DOWN:
+            priv->down = g_value_get_uint(value);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID(object, propid, spec);
+    }
+}
+
+static void
+edf_resampler_get_property(
+        GObject    *object,
+        guint32     propid,
+        GValue     *value,
+        GParamSpec *spec
+        )
+{
+    EdfResamplerPrivate* priv = edf_resampler_get_instance_private(
+            EDF_RESAMPLER(object)
+            );
+
+    switch ((EdfResamplerProperty) propid) {
+        case PROP_UP:
+            g_value_set_uint(value, priv->up);
+            break;
+        case PROP_DOWN:
+            g_value_set_uint(value, priv->down);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID(object, propid, spec);
+    }
+}
+
+static GParamSpec* resampler_properties[N_PROPERTIES] = {NULL, };
+
+static void
+edf_resampler_class_init(EdfResamplerClass* klass)
+{
+    GObjectClass* object_class = G_OBJECT_CLASS(klass);
+
+    object_class->set_property = edf_resampler_set_property;
+    object_class->get_property = edf_resampler_get_property;
+    object_class->constructed = edf_resampler_constructed;
+    object_class->finalize = edf_resampler_finalize;
+
+    /**
+     * EdfResampler:up:
+     *
+     * The factor by which the signal is upsampled.
+     */
+    resampler_properties[PROP_UP] = g_param_spec_uint(
+            "up",
+            "Up",
+            "The factor by which the signal is upsampled",
+            1,
+            MAX_FACTOR,
+            1,
+            G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY
+            );
+
+    /**
+     * EdfResampler:down:
+     *
+     * The factor by which the signal is downsampled.
+     */
+    resampler_properties[PROP_DOWN] = g_param_spec_uint(
+            "down",
+            "Down",
+            "The factor by which the signal is downsampled",
+            1,
+            MAX_FACTOR,
+            1,
+            G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY
+            );
+
+    g_object_class_install_properties(
+            object_class, N_PROPERTIES, resampler_properties
+            );
+}
+
+static guint
+greatest_common_divisor(guint a, guint b)
+{
+    while (b) {
+        guint t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+/**
+ * edf_resampler_new:(constructor)
+ * @up: the numerator of the ratio, e.g. the new sample rate
+ * @down: the denominator of the ratio, e.g. the old sample rate
+ * @error:(out): An error is returned here when a factor is 0 or the
+ *               reduced factors are larger than 4096
+ *
+ * Creates a resampler that changes the sample rate by a factor @up / @down,
+ * the factors are reduced by their greatest common divisor first. Sample
+ * rates in Hz or the number of samples per record of two signals may be
+ * used directly.
+ *
+ * Returns:(transfer full): a new #EdfResampler or NULL
+ */
+EdfResampler*
+edf_resampler_new(guint up, guint down, GError** error)
+{
+    g_return_val_if_fail(error != NULL && *error == NULL, NULL);
+
+    guint gcd = up && down ? greatest_common_divisor(up, down) : 1;
+    if (up == 0 || down == 0 || up / gcd > MAX_FACTOR || down / gcd > MAX_FACTOR) {
+        g_set_error(
+                error,
+                EDF_RESAMPLER_ERROR,
+                EDF_RESAMPLER_ERROR_RATIO,
+                "The ratio %u/%u isn't supported, the reduced factors must be "
+                "between 1 and %d",
+                up,
+                down,
+                MAX_FACTOR
+                );
+        return NULL;
+    }
+
+    return g_object_new(
+            EDF_TYPE_RESAMPLER,
+            "up", up / gcd,
+            "down", down / gcd,
+            NULL
+            );
+}
+
+/**
+ * edf_resampler_get_up:
+ * @resampler: the resampler
+ *
+ * Returns: the reduced upsampling factor
+ */
+guint
+edf_resampler_get_up(EdfResampler* resampler)
+{
+    g_return_val_if_fail(EDF_IS_RESAMPLER(resampler), 0);
+    EdfResamplerPrivate* priv = edf_resampler_get_instance_private(resampler);
+    return priv->up;
+}
+
+/**
+ * edf_resampler_get_down:
+ * @resampler: the resampler
+ *
+ * Returns: the reduced downsampling factor
+ */
+guint
+edf_resampler_get_down(EdfResampler* resampler)
+{
+    g_return_val_if_fail(EDF_IS_RESAMPLER(resampler), 0);
+    EdfResamplerPrivate* priv = edf_resampler_get_instance_private(resampler);
+    return priv->down;
+}
+
+/**
+ * edf_resampler_get_num_taps:
+ * @resampler: the resampler
+ *
+ * Returns: the length of the anti-aliasing filter at the upsampled rate
+ */
+guint
+edf_resampler_get_num_taps(EdfResampler* resampler)
+{
+    g_return_val_if_fail(EDF_IS_RESAMPLER(resampler), 0);
+    EdfResamplerPrivate* priv = edf_resampler_get_instance_private(resampler);
+    return priv->num_taps;
+}
+
+/* The number of output samples of the first num_input samples */
+static guint64
+resampler_total_output(EdfResamplerPrivate* priv, guint64 num_input)
+{
+    return (num_input * priv->up + priv->down - 1) / priv->down;
+}
+
+/**
+ * edf_resampler_get_max_output:
+ * @resampler: the resampler
+ * @num_input: the number of samples that are going to be processed
+ *
+ * Returns: the largest number of samples that edf_resampler_process()
+ *          followed by edf_resampler_flush() return for @num_input more
+ *          samples.
+ */
+gsize
+edf_resampler_get_max_output(EdfResampler* resampler, gsize num_input)
+{
+    g_return_val_if_fail(EDF_IS_RESAMPLER(resampler), 0);
+    EdfResamplerPrivate* priv = edf_resampler_get_instance_private(resampler);
+
+    return resampler_total_output(priv, priv->num_input + num_input) -
+           priv->num_output;
+}
+
+static void
+resampler_append(EdfResamplerPrivate* priv, const gdouble* input, gsize n)
+{
+    if (n == 0)
+        return;
+    if (priv->x_len + n > priv->x_cap) {
+        priv->x_cap = MAX(priv->x_len + n, 2 * priv->x_cap);
+        priv->x = g_renew(gdouble, priv->x, priv->x_cap);
+    }
+    if (input)
+        memcpy(&priv->x[priv->x_len], input, n * sizeof(gdouble));
+    else
+        memset(&priv->x[priv->x_len], 0, n * sizeof(gdouble));
+    priv->x_len += n;
+}
+
+/*
+ * The inner product of a branch and the history. The four partial sums
+ * don't wait for each other's additions, the compiler may not reorder the
+ * additions to a single sum by itself.
+ */
+static inline gdouble
+resampler_dot(const gdouble* restrict h, const gdouble* restrict x, guint n)
+{
+    gdouble s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    guint i = 0;
+
+    for (; i + 4 <= n; i += 4) {
+        s0 += h[i] * x[i];
+        s1 += h[i + 1] * x[i + 1];
+        s2 += h[i + 2] * x[i + 2];
+        s3 += h[i + 3] * x[i + 3];
+    }
+    for (; i < n; i++)
+        s0 += h[i] * x[i];
+
+    return (s0 + s1) + (s2 + s3);
+}
+
+/*
+ * Computes the output samples up to limit for which the history is
+ * complete and drops the history that isn't needed anymore.
+ */
+static gsize
+resampler_produce(EdfResamplerPrivate* priv, gdouble* output, guint64 limit)
+{
+    const guint k = priv->phase_taps;
+    const gint64 end = priv->base + (gint64) priv->x_len;
+    gsize count = 0;
+
+    while (priv->num_output < limit) {
+        guint64 t = priv->num_output * priv->down + priv->delay;
+        gint64 n = (gint64) (t / priv->up);
+        guint phase = t % priv->up;
+
+        if (n >= end)
+            break;
+
+        output[count++] = resampler_dot(
+                &priv->phases[(gsize) phase * k],
+                &priv->x[n - k + 1 - priv->base],
+                k
+                );
+        priv->num_output++;
+    }
+
+    gint64 next = (gint64) ((priv->num_output * priv->down + priv->delay) / priv->up);
+    gint64 drop = MIN(next - k + 1 - priv->base, (gint64) priv->x_len);
+    if (drop > 0) {
+        memmove(priv->x, &priv->x[drop], (priv->x_len - drop) * sizeof(gdouble));
+        priv->x_len -= drop;
+        priv->base += drop;
+    }
+    return count;
+}
+
+/**
+ * edf_resampler_process:(skip)
+ * @resampler: the resampler
+ * @input: the next samples of the signal
+ * @num_input: the number of samples in @input
+ * @output: room for edf_resampler_get_max_output() samples
+ *
+ * Resamples the next part of a signal, the output samples whose inputs
+ * are complete are written to @output.
+ *
+ * Returns: the number of samples written to @output
+ */
+gsize
+edf_resampler_process(
+        EdfResampler   *resampler,
+        const gdouble  *input,
+        gsize           num_input,
+        gdouble        *output
+        )
+{
+    g_return_val_if_fail(EDF_IS_RESAMPLER(resampler), 0);
+    g_return_val_if_fail(input != NULL || num_input == 0, 0);
+    g_return_val_if_fail(output != NULL, 0);
+    EdfResamplerPrivate* priv = edf_resampler_get_instance_private(resampler);
+
+    resampler_append(priv, input, num_input);
+    priv->num_input += num_input;
+
+    return resampler_produce(priv, output, G_MAXUINT64);
+}
+
+/**
+ * edf_resampler_flush:(skip)
+ * @resampler: the resampler
+ * @output: room for edf_resampler_get_max_output(resampler, 0) samples
+ *
+ * Ends the signal, the remaining output samples are computed as if the
+ * signal continues with zeros. Afterwards the resampler is reset.
+ *
+ * Returns: the number of samples written to @output
+ */
+gsize
+edf_resampler_flush(EdfResampler* resampler, gdouble* output)
+{
+    g_return_val_if_fail(EDF_IS_RESAMPLER(resampler), 0);
+    g_return_val_if_fail(output != NULL, 0);
+    EdfResamplerPrivate* priv = edf_resampler_get_instance_private(resampler);
+
+    guint64 total = resampler_total_output(priv, priv->num_input);
+    gsize count = 0;
+
+    if (priv->num_output < total) {
+        guint64 t = (total - 1) * priv->down + priv->delay;
+        gint64 needed = (gint64) (t / priv->up) + 1;
+        gint64 end = priv->base + (gint64) priv->x_len;
+        if (needed > end)
+            resampler_append(priv, NULL, needed - end);
+        count = resampler_produce(priv, output, total);
+    }
+
+    edf_resampler_reset(resampler);
+    return count;
+}
+
+/**
+ * edf_resampler_reset:
+ * @resampler: the resampler
+ *
+ * Drops the history, the next samples are resampled as the start of a
+ * new signal.
+ */
+void
+edf_resampler_reset(EdfResampler* resampler)
+{
+    g_return_if_fail(EDF_IS_RESAMPLER(resampler));
+    EdfResamplerPrivate* priv = edf_resampler_get_instance_private(resampler);
+
+    // The signal is preceded by zeros
+    priv->x_len = 0;
+    priv->base = -(gint64) (priv->phase_taps - 1);
+    resampler_append(priv, NULL, priv->phase_taps - 1);
+    priv->num_input = 0;
+    priv->num_output = 0;
+}
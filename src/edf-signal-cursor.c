@@ -0,0 +1,195 @@
+
+#include "edf-signal-cursor.h"
+#include "edf-signal-priv.h"
+#include "edf-sample-priv.h"
+
+/**
+ * SECTION:edf-signal-cursor
+ * @short_description: per thread read positions in a shared signal
+ * @see_also: #EdfSignal, #EdfFile
+ * @include: gedf.h
+ *
+ * Once an #EdfFile is frozen with edf_file_freeze() its signals don't
+ * change anymore and they may be read by several threads at the same time.
+ * An #EdfSignalCursor holds the state of one reader, so each thread uses
+ * a cursor of its own and no locks are involved:
+ *
+ * |[<!-- language="C" -->
+ * EdfSignalCursor cursor;
+ * gdouble block[1024];
+ * gsize n;
+ *
+ * edf_signal_cursor_init(&cursor, signal);
+ * edf_signal_cursor_seek(&cursor, first_sample);
+ * while ((n = edf_signal_cursor_read(&cursor, block, G_N_ELEMENTS(block))))
+ *     process(block, n);
+ * edf_signal_cursor_clear(&cursor);
+ * ]|
+ *
+ * A cursor must not be shared between threads itself.
+ */
+
+/* The number of samples decoded at once */
+#define CURSOR_BLOCK_SIZE 256
+
+/**
+ * edf_signal_cursor_init:(skip)
+ * @cursor: the cursor to initialize, typically on the stack
+ * @signal: a frozen #EdfSignal, see edf_file_freeze()
+ *
+ * Points @cursor at the first sample of @signal, a reference to @signal
+ * is held until edf_signal_cursor_clear().
+ */
+void
+edf_signal_cursor_init(EdfSignalCursor* cursor, EdfSignal* signal)
+{
+    g_return_if_fail(cursor != NULL);
+    g_return_if_fail(EDF_IS_SIGNAL(signal));
+    g_return_if_fail(edf_signal_is_frozen(signal));
+
+    guint64 num_records = edf_signal_get_num_records(signal);
+
+    cursor->signal = g_object_ref(signal);
+    cursor->position = 0;
+    cursor->ns = edf_signal_get_num_samples_per_record(signal);
+    cursor->sample_size = edf_signal_get_sample_size(signal);
+    cursor->gain = edf_signal_get_gain(signal);
+    cursor->offset = edf_signal_get_offset(signal);
+
+    // Only the last record may be incomplete
+    cursor->num_samples = 0;
+    if (num_records > 0)
+        cursor->num_samples = (num_records - 1) * cursor->ns +
+            edf_signal_get_record_num_stored(signal, num_records - 1);
+}
+
+/**
+ * edf_signal_cursor_clear:(skip)
+ * @cursor: an initialized cursor
+ *
+ * Releases the signal of @cursor, the cursor may be initialized again.
+ */
+void
+edf_signal_cursor_clear(EdfSignalCursor* cursor)
+{
+    g_return_if_fail(cursor != NULL);
+    g_clear_object(&cursor->signal);
+    cursor->position = cursor->num_samples = 0;
+}
+
+/**
+ * edf_signal_cursor_get_position:(skip)
+ * @cursor: the input cursor
+ *
+ * Returns: the index of the sample that is read next
+ */
+guint64
+edf_signal_cursor_get_position(const EdfSignalCursor* cursor)
+{
+    g_return_val_if_fail(cursor != NULL, 0);
+    return cursor->position;
+}
+
+/**
+ * edf_signal_cursor_get_num_samples:(skip)
+ * @cursor: the input cursor
+ *
+ * Returns: the number of samples of the signal of @cursor
+ */
+guint64
+edf_signal_cursor_get_num_samples(const EdfSignalCursor* cursor)
+{
+    g_return_val_if_fail(cursor != NULL, 0);
+    return cursor->num_samples;
+}
+
+/**
+ * edf_signal_cursor_seek:(skip)
+ * @cursor: the input cursor
+ * @position: the index of the sample to read next
+ *
+ * Returns: TRUE when @position is within the signal or at its end
+ */
+gboolean
+edf_signal_cursor_seek(EdfSignalCursor* cursor, guint64 position)
+{
+    g_return_val_if_fail(cursor != NULL && cursor->signal != NULL, FALSE);
+    if (position > cursor->num_samples)
+        return FALSE;
+
+    cursor->position = position;
+    return TRUE;
+}
+
+/*
+ * Decodes up to n samples from the current position on, without crossing
+ * the end of a record.
+ */
+static gsize
+cursor_decode(EdfSignalCursor* cursor, gint32* values, gsize n)
+{
+    guint64 nrec = cursor->position / cursor->ns;
+    guint i = (guint) (cursor->position % cursor->ns);
+    guint stored = edf_signal_get_record_num_stored(cursor->signal, nrec);
+    const guint8* bytes = edf_signal_get_record_bytes(cursor->signal, nrec);
+
+    n = MIN(n, stored - i);
+    edf_samples_decode(&bytes[i * cursor->sample_size], cursor->sample_size, n, values);
+    cursor->position += n;
+    return n;
+}
+
+/**
+ * edf_signal_cursor_read_digital:(skip)
+ * @cursor: the input cursor
+ * @values: the buffer for at least @n samples
+ * @n: the number of samples to read
+ *
+ * Reads the digital values of the next @n samples and advances @cursor.
+ *
+ * Returns: the number of samples read, less than @n at the end of the signal
+ */
+gsize
+edf_signal_cursor_read_digital(EdfSignalCursor* cursor, gint32* values, gsize n)
+{
+    g_return_val_if_fail(cursor != NULL && cursor->signal != NULL, 0);
+    g_return_val_if_fail(values != NULL || n == 0, 0);
+
+    gsize total = 0;
+    n = (gsize) MIN((guint64) n, cursor->num_samples - cursor->position);
+    while (total < n)
+        total += cursor_decode(cursor, &values[total], n - total);
+    return total;
+}
+
+/**
+ * edf_signal_cursor_read:(skip)
+ * @cursor: the input cursor
+ * @values: the buffer for at least @n samples
+ * @n: the number of samples to read
+ *
+ * Reads the physical values of the next @n samples and advances @cursor.
+ *
+ * Returns: the number of samples read, less than @n at the end of the signal
+ */
+gsize
+edf_signal_cursor_read(EdfSignalCursor* cursor, gdouble* values, gsize n)
+{
+    g_return_val_if_fail(cursor != NULL && cursor->signal != NULL, 0);
+    g_return_val_if_fail(values != NULL || n == 0, 0);
+
+    gint32 digital[CURSOR_BLOCK_SIZE];
+    gsize total = 0, num;
+
+    while (total < n) {
+        num = edf_signal_cursor_read_digital(
+                cursor, digital, MIN(n - total, CURSOR_BLOCK_SIZE)
+                );
+        if (num == 0)
+            break;
+        for (gsize i = 0; i < num; i++)
+            values[total + i] = cursor->gain * digital[i] + cursor->offset;
+        total += num;
+    }
+    return total;
+}
@@ -1,12 +1,16 @@
 
 
 #include "edf-signal.h"
+#include "edf-signal-priv.h"
 #include "edf-size-priv.h"
+#include "edf-sample-priv.h"
+#include "edf-trace-priv.h"
+#include "edf-resampler.h"
 
 #include "glibconfig.h"
 #include <glib.h>
 #include <gmodule.h>
-#include <errno.h>
+#include <math.h>
 #include <string.h>
 
 G_DEFINE_QUARK(edf_signal_error_quark, edf_signal_error)
@@ -19,164 +23,72 @@ G_DEFINE_QUARK(edf_signal_error_quark, edf_signal_error)
  * member.
  * This means that for each record ns bytes per sample
  * are recorded.
+ * The bytes of the records are allocated from an EdfArena, that is shared
+ * with the other signals of an EdfFile, so a signal doesn't free its
+ * records one by one.
+ *
+ * A signal with a ring capacity stores its records in a fixed number of
+ * slots of one buffer instead. The records array then holds one EdfRecord
+ * per slot and record nrec lives in slot (ring_head + nrec) % ring_capacity,
+ * use signal_record() and signal_num_records() to access the records in
+ * either mode.
  */
 
-typedef union {
-    gint16  i16;
-    guint16 u16;
-    gint32  i32;
-    guint32 u32;
-    guint8  array[4];
-} sample_repr;
-
 typedef struct _record {
     guint8* bytes;          /* the bytes representing the signal */
     guint   ns;             /* the number of samples in a complete record */
-    guint   sizeof_sample;  /* the number of bytes of one sample */
     guint   ns_stored;      /* the number of samples currently stored */
 } EdfRecord;
 
-static EdfRecord*
-edf_record_new(guint ns, guint sizeof_sample, GError** error) {
-    g_return_val_if_fail(error != NULL || *error, NULL);
-    EdfRecord* new = malloc(sizeof(EdfRecord));
-    if (!new) {
-        int saved_errno = errno;
-        if (saved_errno == ENOMEM)
-            g_set_error(
-                    error,
-                    EDF_SIGNAL_ERROR,
-                    EDF_SIGNAL_ERROR_ENOMEM,
-                    "Unable to create record: %s",
-                    g_strerror(saved_errno)
-                    );
-        else 
-            g_set_error_literal(
-                    error,
-                    EDF_SIGNAL_ERROR,
-                    EDF_SIGNAL_ERROR_FAILED,
-                    "Unable to allocate EdfRecord"
-                    );
-
-        return new;
-    }
-
-    new->ns_stored = 0;
-    new->sizeof_sample = sizeof_sample;
-    new->ns = ns;
-    new->bytes = calloc(ns , sizeof_sample);
-    if (!new->bytes) {
-        int saved_errno = errno;
-        if (saved_errno == ENOMEM)
-            g_set_error(
-                    error,
-                    EDF_SIGNAL_ERROR,
-                    EDF_SIGNAL_ERROR_ENOMEM,
-                    "Unable to create record: %s",
-                    g_strerror(saved_errno)
-                    );
-        else 
-            g_set_error_literal(
-                    error,
-                    EDF_SIGNAL_ERROR,
-                    EDF_SIGNAL_ERROR_FAILED,
-                    "Unable to allocate EdfRecord"
-                    );
-
-        g_free(new);
-        new = NULL;
-    }
-    
-    return new;
-}
-
-static void
-edf_record_destroy(EdfRecord* record)
-{
-    g_free(record->bytes);
-    g_free(record);
-}
-
-static gsize
-edf_record_size(const EdfRecord* record)
-{
-    return record->ns_stored;
-}
-
-static void
-edf_record_append(EdfRecord* record, gint value)
-{
-    sample_repr repr;
-    repr.i16 = GINT16_TO_LE(value);
-    memcpy(&record->bytes[record->sizeof_sample * record->ns_stored],
-            repr.array,
-            sizeof(repr.i16)
-          );
-    record->ns_stored++;
-}
-
-int
-edf_record_get(EdfRecord* record, guint index)
-{
-    sample_repr repr;
-    memcpy(repr.array, &record->bytes[index * record->sizeof_sample], record->sizeof_sample);
-    repr.u16 = GUINT16_FROM_LE(repr.u16);
-    return repr.i16;
-}
-
 typedef struct _EdfSignalPrivate {
     /* recording info.*/
-    GString*    label;
-    GString*    transducer_type;
-    GString*    physical_dimension;
+    gchar       label[EDF_LABEL_SZ + 1];
+    gchar       transducer_type[EDF_TRANDUCER_TYPE_SZ + 1];
+    gchar       physical_dimension[EDF_PHYSICAL_DIMENSION_SZ + 1];
     gdouble     physical_min;
     gdouble     physical_max;
     gint        digital_min;
     gint        digital_max;
-    GString*    prefiltering;
-    gint        num_samples_per_record;
-    GString*    reserved;
+    gchar       prefiltering[EDF_PREFILTERING_SZ + 1];
+    guint       num_samples_per_record;
+    gchar       reserved[EDF_NS_RESERVED_SZ + 1];
     guint       sample_size;
-    GPtrArray*  records;
+    GArray*     records;    /* EdfRecord */
+    EdfArena*   arena;      /* owns the bytes of the records */
+    guint       ring_capacity;  /* the number of slots, 0 when unbounded */
+    guint       ring_head;      /* the slot of the oldest record */
+    guint       ring_len;       /* the number of records in the slots */
+    guint64     ring_dropped;   /* the number of overwritten records */
+    guint8*     ring_bytes;     /* the samples of all slots */
+    guint8*     ring_scratch;   /* one record after the slots, see read */
+    gboolean    frozen;         /* read only, see edf_file_freeze() */
 } EdfSignalPrivate;
 
-
 G_DEFINE_TYPE_WITH_PRIVATE(EdfSignal, edf_signal, G_TYPE_OBJECT)
 
+static gboolean
+signal_is_mutable(EdfSignal* signal)
+{
+    EdfSignalPrivate* priv = edf_signal_get_instance_private(signal);
+    return !priv->frozen;
+}
+
 
 static void
 edf_signal_init(EdfSignal* self)
 {
     EdfSignalPrivate* priv = edf_signal_get_instance_private(self);
 
-    priv->label = g_string_new("");
-    priv->transducer_type = g_string_new("");
-    priv->physical_dimension = g_string_new("");
-
+    // The strings are empty as the private data is zeroed.
     priv->physical_min = 0;
     priv->physical_max = 0;
     priv->digital_min = 0;
     priv->digital_max = 0;
 
-    priv->prefiltering = g_string_new("");
     priv->num_samples_per_record = 0;
 
-    priv->reserved = g_string_new("");
-
-    priv->records = g_ptr_array_new_with_free_func((GDestroyNotify) edf_record_destroy);
-}
-
-static void
-edf_signal_dispose(GObject* gobject)
-{
-    EdfSignalPrivate* priv = edf_signal_get_instance_private(EDF_SIGNAL(gobject));
-
-    // Drop references on objects
-    g_ptr_array_unref(priv->records);
-    priv->records = NULL;
-
-    // Chain up to parent
-    G_OBJECT_CLASS(edf_signal_parent_class)->dispose(gobject);
+    priv->records = g_array_new(FALSE, FALSE, sizeof(EdfRecord));
+    priv->arena = NULL; // created on demand or shared by an EdfFile
 }
 
 static void
@@ -184,15 +96,13 @@ edf_signal_finalize(GObject* gobject)
 {
     EdfSignalPrivate* priv = edf_signal_get_instance_private(EDF_SIGNAL(gobject));
 
-    // free remaining resources.
-    g_string_free(priv->label, TRUE);
-    g_string_free(priv->transducer_type, TRUE);
-    g_string_free(priv->physical_dimension, TRUE);
-    g_string_free(priv->prefiltering, TRUE);
-    g_string_free(priv->reserved, TRUE);
-    
+    // free remaining resources, the bytes of all records go with the arena.
+    g_array_unref(priv->records);
+    g_clear_pointer(&priv->arena, edf_arena_unref);
+    g_free(priv->ring_bytes);
+
     // Chain up to parent
-    G_OBJECT_CLASS(edf_signal_parent_class)->dispose(gobject);
+    G_OBJECT_CLASS(edf_signal_parent_class)->finalize(gobject);
 }
 
 typedef enum {
@@ -223,6 +133,8 @@ edf_signal_set_property (
     EdfSignal* self = EDF_SIGNAL(object);
     EdfSignalPrivate* priv = edf_signal_get_instance_private(self);
 
+    g_return_if_fail(signal_is_mutable(self));
+
     switch ((EdfSignalProperty) propid) {
         case PROP_LABEL:
             edf_signal_set_label(self, g_value_get_string(value));
@@ -277,13 +189,13 @@ edf_signal_get_property (
 
     switch ((EdfSignalProperty) propid) {
         case PROP_LABEL:
-            g_value_set_string(value, priv->label->str);
+            g_value_set_string(value, priv->label);
             break;
         case PROP_TRANDUCER:
-            g_value_set_string(value, priv->transducer_type->str);
+            g_value_set_string(value, priv->transducer_type);
             break;
         case PROP_PHYSICAL_DIMENSION:
-            g_value_set_string(value, priv->physical_dimension->str);
+            g_value_set_string(value, priv->physical_dimension);
             break;
         case PROP_PHYSICAL_MIN:
             g_value_set_double(value, priv->physical_min);
@@ -298,19 +210,19 @@ edf_signal_get_property (
             g_value_set_int(value, priv->digital_max);
             break;
         case PROP_PREFILTERING:
-            g_value_set_string(value, priv->prefiltering->str);
+            g_value_set_string(value, priv->prefiltering);
             break;
         case PROP_NUM_SAMPLES_PER_RECORD:
             g_value_set_uint(value, priv->num_samples_per_record);
             break;
         case PROP_RESERVED:
-            g_value_set_string(value, priv->reserved->str);
+            g_value_set_string(value, priv->reserved);
             break;
         case PROP_SAMPLE_SIZE:
             g_value_set_uint(value, priv->sample_size);
             break;
         case PROP_NUM_RECORDS:
-            g_value_set_int(value, edf_signal_get_num_records(self));
+            g_value_set_uint64(value, edf_signal_get_num_records(self));
             break;
         case PROP_SIGNAL:
             g_value_set_boxed(value, edf_signal_get_values(self));
@@ -329,7 +241,6 @@ edf_signal_class_init(EdfSignalClass* klass)
 
     object_class->set_property = edf_signal_set_property;
     object_class->get_property = edf_signal_get_property;
-    object_class->dispose = edf_signal_dispose;
     object_class->finalize = edf_signal_finalize;
 
     edf_signal_properties[PROP_LABEL] = g_param_spec_string(
@@ -380,8 +291,8 @@ edf_signal_class_init(EdfSignalClass* klass)
             "digital-min",
             "digital-minimum",
             "The digital minimum of an signal",
-            G_MININT16,
-            G_MAXINT16,
+            BDF_DIGITAL_MIN,
+            BDF_DIGITAL_MAX,
             0,
             G_PARAM_READWRITE
             );
@@ -390,8 +301,8 @@ edf_signal_class_init(EdfSignalClass* klass)
             "digital-max",
             "digital-maximum",
             "The digital maximum of an signal",
-            G_MININT16,
-            G_MAXINT16,
+            BDF_DIGITAL_MIN,
+            BDF_DIGITAL_MAX,
             0,
             G_PARAM_READWRITE
             );
@@ -422,22 +333,28 @@ edf_signal_class_init(EdfSignalClass* klass)
             G_PARAM_READWRITE | G_PARAM_CONSTRUCT
             );
 
+    /**
+     * EdfSignal:sample-size:
+     *
+     * The number of bytes of one sample, this is 2 for edf files and
+     * 3 for the 24 bit samples of BioSemi bdf files.
+     */
     edf_signal_properties[PROP_SAMPLE_SIZE] = g_param_spec_uint(
         "sample-size",
         "Sample-Size",
         "The number of bytes of a sample",
-        1,
-        8,
-        2,
+        EDF_SAMPLE_SIZE,
+        BDF_SAMPLE_SIZE,
+        EDF_SAMPLE_SIZE,
         G_PARAM_READWRITE| G_PARAM_CONSTRUCT_ONLY | G_PARAM_PRIVATE
     );
 
-    edf_signal_properties[PROP_NUM_RECORDS] = g_param_spec_uint(
+    edf_signal_properties[PROP_NUM_RECORDS] = g_param_spec_uint64(
         "num-records",
         "Number of Records",
         "The number of records contained in this signal.",
         0,
-        G_MAXUINT,
+        G_MAXUINT64,
         0,
         G_PARAM_READABLE
         );
@@ -455,25 +372,87 @@ edf_signal_class_init(EdfSignalClass* klass)
             );
 }
 
-static gsize
+static EdfArena*
+signal_arena(EdfSignalPrivate* priv)
+{
+    if (!priv->arena)
+        priv->arena = edf_arena_new();
+    return priv->arena;
+}
+
+/*
+ * Record indices are 64 bit like sample indices and byte offsets. The EDF
+ * header limits a file to 99999999 records, so the records array itself
+ * never grows past the range of its guint length.
+ */
+static guint64
+signal_num_records(EdfSignalPrivate* priv)
+{
+    return priv->ring_capacity ? priv->ring_len : priv->records->len;
+}
+
+static EdfRecord*
+signal_record(EdfSignalPrivate* priv, guint64 nrec)
+{
+    if (priv->ring_capacity)
+        nrec = (priv->ring_head + nrec) % priv->ring_capacity;
+    return &g_array_index(priv->records, EdfRecord, (guint) nrec);
+}
+
+/*
+ * Adds a record whose bytes are not initialized, the caller must fill it.
+ * In a full ring buffer the oldest record is reused.
+ */
+static EdfRecord*
+signal_add_record(EdfSignalPrivate* priv)
+{
+    if (priv->ring_capacity) {
+        EdfRecord* rec;
+        if (priv->ring_len < priv->ring_capacity) {
+            priv->ring_len++;
+            rec = signal_record(priv, priv->ring_len - 1);
+        }
+        else {
+            rec = signal_record(priv, 0);
+            priv->ring_head = (priv->ring_head + 1) % priv->ring_capacity;
+            priv->ring_dropped++;
+        }
+        rec->ns_stored = 0;
+        return rec;
+    }
+
+    EdfRecord record = {
+        .bytes = edf_arena_alloc(
+                signal_arena(priv),
+                (gsize) priv->num_samples_per_record * priv->sample_size
+                ),
+        .ns = priv->num_samples_per_record,
+        .ns_stored = 0
+    };
+    g_array_append_val(priv->records, record);
+    return &g_array_index(priv->records, EdfRecord, priv->records->len - 1);
+}
+
+static guint64
 signal_capacity(EdfSignal* signal)
 {
     EdfSignalPrivate* priv = edf_signal_get_instance_private(signal);
-    return priv->records->len * priv->num_samples_per_record;
+    return signal_num_records(priv) * priv->num_samples_per_record;
 }
 
-static gsize
+static guint64
 signal_size (EdfSignal* signal)
 {
     EdfSignalPrivate* priv = edf_signal_get_instance_private(signal);
-    gsize size = 0;
-    if (priv->records->len == 0)
+    guint64 num_records = signal_num_records(priv);
+    guint64 size = 0;
+    if (num_records == 0)
         return size;
 
-    EdfRecord* record = g_ptr_array_index(priv->records, priv->records->len -1);
+    EdfRecord* record = signal_record(priv, num_records - 1);
 
-    size = (priv->records->len - 1) * priv->num_samples_per_record;
-    size += edf_record_size(record);
+    size = (num_records - 1) * priv->num_samples_per_record;
+    size += record->ns_stored;
     return size;
 }
 
@@ -482,22 +461,25 @@ static void
 signal_append_private(EdfSignal* signal, gint value, GError** error)
 {
     EdfSignalPrivate* priv = edf_signal_get_instance_private(signal);
-    gsize capacity, size;
+    guint64 capacity, size;
     EdfRecord* rec = NULL;
     capacity = signal_capacity(signal);
     size = signal_size(signal);
+    (void) error;
 
     g_assert(size <= capacity);
     if (size == capacity) {
-        rec = edf_record_new(priv->num_samples_per_record, sizeof(gint16), error);
-        if (*error) {
-            g_assert(rec == NULL);
-            return;
-        }
-        g_ptr_array_add(priv->records, rec);
+        // A record that isn't complete is written with zeros for the rest
+        rec = signal_add_record(priv);
+        memset(rec->bytes, 0, (gsize) rec->ns * priv->sample_size);
     }
-    rec = g_ptr_array_index(priv->records, priv->records->len - 1);
-    edf_record_append(rec, value);
+    rec = signal_record(priv, signal_num_records(priv) - 1);
+    edf_sample_encode(
+            &rec->bytes[priv->sample_size * rec->ns_stored],
+            priv->sample_size,
+            value
+            );
+    rec->ns_stored++;
 }
 
 /**
@@ -582,7 +564,7 @@ edf_signal_get_label(EdfSignal* signal)
     g_return_val_if_fail(EDF_IS_SIGNAL(signal), NULL);
 
     EdfSignalPrivate* priv = edf_signal_get_instance_private(signal);
-    return priv->label->str;
+    return priv->label;
 }
 
 /**
@@ -599,6 +581,7 @@ edf_signal_set_label(EdfSignal* signal, const gchar* label)
 {
     EdfSignalPrivate *priv;
     g_return_if_fail(EDF_IS_SIGNAL(signal));
+    g_return_if_fail(signal_is_mutable(signal));
     g_return_if_fail(g_str_is_ascii(label));
     char temp[256];
 
@@ -606,7 +589,7 @@ edf_signal_set_label(EdfSignal* signal, const gchar* label)
     g_snprintf(temp, sizeof(temp), "%s", label);
     g_strstrip(temp);
     temp[EDF_LABEL_SZ] = '\0';
-    g_string_assign(priv->label, temp);
+    g_strlcpy(priv->label, temp, sizeof(priv->label));
 }
 
 /**
@@ -620,7 +603,7 @@ edf_signal_get_transducer(EdfSignal* signal)
     g_return_val_if_fail(EDF_IS_SIGNAL(signal), NULL);
 
     EdfSignalPrivate* priv = edf_signal_get_instance_private(signal);
-    return priv->transducer_type->str;
+    return priv->transducer_type;
 }
 
 /**
@@ -637,6 +620,7 @@ edf_signal_set_transducer(EdfSignal* signal, const gchar* transducer)
 {
     EdfSignalPrivate *priv;
     g_return_if_fail(EDF_IS_SIGNAL(signal));
+    g_return_if_fail(signal_is_mutable(signal));
     g_return_if_fail(g_str_is_ascii(transducer));
     char temp[256];
 
@@ -644,7 +628,7 @@ edf_signal_set_transducer(EdfSignal* signal, const gchar* transducer)
     g_snprintf(temp, sizeof(temp), "%s", transducer);
     g_strstrip(temp);
     temp[EDF_TRANDUCER_TYPE_SZ] = '\0';
-    g_string_assign (priv->transducer_type, temp);
+    g_strlcpy(priv->transducer_type, temp, sizeof(priv->transducer_type));
 }
 
 /**
@@ -658,7 +642,7 @@ edf_signal_get_physical_dimension(EdfSignal* signal)
     g_return_val_if_fail(EDF_IS_SIGNAL(signal), NULL);
 
     EdfSignalPrivate* priv = edf_signal_get_instance_private(signal);
-    return priv->physical_dimension->str;
+    return priv->physical_dimension;
 }
 
 /**
@@ -675,13 +659,14 @@ edf_signal_set_physical_dimension(EdfSignal* signal, const gchar* dimension)
 {
     EdfSignalPrivate *priv;
     g_return_if_fail(EDF_IS_SIGNAL(signal));
+    g_return_if_fail(signal_is_mutable(signal));
     g_return_if_fail(g_str_is_ascii(dimension));
     char temp[256];
 
     priv = edf_signal_get_instance_private(signal);
     g_snprintf(temp, sizeof(temp), "%s", dimension);
     g_strstrip(temp);
-    g_string_printf (priv->physical_dimension, "%s", temp);
+    g_strlcpy(priv->physical_dimension, temp, sizeof(priv->physical_dimension));
 }
 
 /**
@@ -713,6 +698,7 @@ void
 edf_signal_set_physical_min(EdfSignal* signal, gdouble min)
 {
     g_return_if_fail(EDF_IS_SIGNAL(signal));
+    g_return_if_fail(signal_is_mutable(signal));
 
     EdfSignalPrivate* priv = edf_signal_get_instance_private(signal);
     priv->physical_min = min;
@@ -747,6 +733,7 @@ void
 edf_signal_set_physical_max(EdfSignal* signal, gdouble max)
 {
     g_return_if_fail(EDF_IS_SIGNAL(signal));
+    g_return_if_fail(signal_is_mutable(signal));
 
     EdfSignalPrivate* priv = edf_signal_get_instance_private(signal);
     priv->physical_max = max;
@@ -782,6 +769,7 @@ void
 edf_signal_set_digital_min(EdfSignal* signal, gint min)
 {
     g_return_if_fail(EDF_IS_SIGNAL(signal));
+    g_return_if_fail(signal_is_mutable(signal));
 
     EdfSignalPrivate* priv = edf_signal_get_instance_private(signal);
     priv->digital_min = min;
@@ -817,6 +805,7 @@ void
 edf_signal_set_digital_max(EdfSignal* signal, gint max)
 {
     g_return_if_fail(EDF_IS_SIGNAL(signal));
+    g_return_if_fail(signal_is_mutable(signal));
 
     EdfSignalPrivate* priv = edf_signal_get_instance_private(signal);
     priv->digital_max = max;
@@ -833,7 +822,7 @@ edf_signal_get_prefiltering(EdfSignal* signal)
     g_return_val_if_fail(EDF_IS_SIGNAL(signal), NULL);
 
     EdfSignalPrivate* priv = edf_signal_get_instance_private(signal);
-    return priv->prefiltering->str;
+    return priv->prefiltering;
 }
 
 /**
@@ -850,6 +839,7 @@ edf_signal_set_prefiltering(EdfSignal* signal, const gchar* prefiltering)
 {
     EdfSignalPrivate *priv;
     g_return_if_fail(EDF_IS_SIGNAL(signal));
+    g_return_if_fail(signal_is_mutable(signal));
     g_return_if_fail(g_str_is_ascii(prefiltering));
     char temp[256];
 
@@ -857,7 +847,7 @@ edf_signal_set_prefiltering(EdfSignal* signal, const gchar* prefiltering)
     g_snprintf(temp, sizeof(temp), "%s", prefiltering);
     g_strstrip(temp);
     temp[EDF_PREFILTERING_SZ] = '\0';
-    g_string_assign (priv->prefiltering, temp);
+    g_strlcpy(priv->prefiltering, temp, sizeof(priv->prefiltering));
 }
 
 /**
@@ -872,6 +862,7 @@ void
 edf_signal_append_digital(EdfSignal* signal, gint value, GError** error)
 {
     g_return_if_fail(EDF_IS_SIGNAL(signal));
+    g_return_if_fail(signal_is_mutable(signal));
     g_return_if_fail(error != NULL && *error == NULL);
 
     EdfSignalPrivate* priv = edf_signal_get_instance_private(signal);
@@ -899,13 +890,30 @@ edf_signal_append_digital(EdfSignal* signal, gint value, GError** error)
  *
  * Returns: the number of records contained in this #EdfSignal
  */
-guint
+guint64
 edf_signal_get_num_records(EdfSignal* signal)
 {
-    g_return_val_if_fail(EDF_IS_SIGNAL(signal), -1);
+    g_return_val_if_fail(EDF_IS_SIGNAL(signal), 0);
 
     EdfSignalPrivate* priv = edf_signal_get_instance_private(signal);
-    return priv->records->len;
+    return signal_num_records(priv);
+}
+
+/**
+ * edf_signal_get_num_samples:
+ * @signal: the input signal
+ *
+ * The number of samples that @signal holds, a record that is being
+ * appended to counts with the samples it holds so far. A recording of
+ * several days easily exceeds the range of 32 bits.
+ *
+ * Returns: the number of samples stored in @signal
+ */
+guint64
+edf_signal_get_num_samples(EdfSignal* signal)
+{
+    g_return_val_if_fail(EDF_IS_SIGNAL(signal), 0);
+    return signal_size(signal);
 }
 
 /**
@@ -921,7 +929,7 @@ edf_signal_get_reserved(EdfSignal* signal)
 {
     g_return_val_if_fail(EDF_IS_SIGNAL(signal), NULL);
     EdfSignalPrivate* priv = edf_signal_get_instance_private(signal);
-    return priv->reserved->str;
+    return priv->reserved;
 }
 
 /**
@@ -938,6 +946,7 @@ edf_signal_set_reserved(EdfSignal* signal, const gchar* reserved)
 {
     EdfSignalPrivate *priv;
     g_return_if_fail(EDF_IS_SIGNAL(signal));
+    g_return_if_fail(signal_is_mutable(signal));
     g_return_if_fail(g_str_is_ascii(reserved));
     char temp[256];
 
@@ -945,7 +954,7 @@ edf_signal_set_reserved(EdfSignal* signal, const gchar* reserved)
     g_snprintf(temp, sizeof(temp), "%s", reserved);
     g_strstrip(temp);
     temp[EDF_NS_RESERVED_SZ] = '\0';
-    g_string_assign(priv->reserved, temp);
+    g_strlcpy(priv->reserved, temp, sizeof(priv->reserved));
 }
 
 /**
@@ -953,10 +962,10 @@ edf_signal_set_reserved(EdfSignal* signal, const gchar* reserved)
  *
  * Returns: the number of samples in each record
  */
-gint
+guint
 edf_signal_get_num_samples_per_record(EdfSignal* signal)
 {
-    g_return_val_if_fail(EDF_IS_SIGNAL(signal), -1);
+    g_return_val_if_fail(EDF_IS_SIGNAL(signal), 0);
     EdfSignalPrivate* priv = edf_signal_get_instance_private(signal);
     return priv->num_samples_per_record;
 }
@@ -972,14 +981,167 @@ void
 edf_signal_set_num_samples_per_record(EdfSignal* signal, guint num_samples)
 {
     g_return_if_fail(EDF_IS_SIGNAL(signal));
+    g_return_if_fail(signal_is_mutable(signal));
     EdfSignalPrivate* priv = edf_signal_get_instance_private(signal);
     priv->num_samples_per_record = num_samples;
 }
 
+/**
+ * edf_signal_get_sample_size:
+ * @signal: the input signal
+ *
+ * Returns: the number of bytes of one sample, 2 for edf and 3 for bdf.
+ */
+guint
+edf_signal_get_sample_size(EdfSignal* signal)
+{
+    g_return_val_if_fail(EDF_IS_SIGNAL(signal), 0);
+    EdfSignalPrivate* priv = edf_signal_get_instance_private(signal);
+    return priv->sample_size;
+}
+
+/**
+ * edf_signal_get_gain:
+ * @signal: the input signal
+ *
+ * A digital sample d is converted to physical units by
+ * gain * d + offset, see also edf_signal_get_offset().
+ *
+ * Returns: the physical size of one digital step.
+ */
+gdouble
+edf_signal_get_gain(EdfSignal* signal)
+{
+    g_return_val_if_fail(EDF_IS_SIGNAL(signal), 0);
+    EdfSignalPrivate* priv = edf_signal_get_instance_private(signal);
+
+    gint dig_span = priv->digital_max - priv->digital_min;
+    if (dig_span == 0)
+        return 0;
+    return (priv->physical_max - priv->physical_min) / dig_span;
+}
+
+/**
+ * edf_signal_get_offset:
+ * @signal: the input signal
+ *
+ * Returns: the physical value of a digital sample of 0,
+ *          see edf_signal_get_gain().
+ */
+gdouble
+edf_signal_get_offset(EdfSignal* signal)
+{
+    g_return_val_if_fail(EDF_IS_SIGNAL(signal), 0);
+    EdfSignalPrivate* priv = edf_signal_get_instance_private(signal);
+
+    return priv->physical_min - edf_signal_get_gain(signal) * priv->digital_min;
+}
+
+/**
+ * edf_signal_set_arena:(skip)
+ * @signal: the input signal
+ * @arena: the arena from which the records of @signal are allocated
+ */
+void
+edf_signal_set_arena(EdfSignal* signal, EdfArena* arena)
+{
+    g_return_if_fail(EDF_IS_SIGNAL(signal));
+    g_return_if_fail(arena != NULL);
+    EdfSignalPrivate* priv = edf_signal_get_instance_private(signal);
+
+    if (priv->arena == arena || priv->records->len > 0 || priv->ring_capacity)
+        return;
+
+    g_clear_pointer(&priv->arena, edf_arena_unref);
+    priv->arena = edf_arena_ref(arena);
+}
+
+/**
+ * edf_signal_get_record_bytes:(skip)
+ * @signal: the input signal
+ * @nrec: the index of the record
+ *
+ * Returns: the raw little endian samples of record @nrec
+ */
+const guint8*
+edf_signal_get_record_bytes(EdfSignal* signal, guint64 nrec)
+{
+    g_return_val_if_fail(EDF_IS_SIGNAL(signal), NULL);
+    EdfSignalPrivate* priv = edf_signal_get_instance_private(signal);
+    g_return_val_if_fail(nrec < signal_num_records(priv), NULL);
+
+    return signal_record(priv, nrec)->bytes;
+}
+
+/**
+ * edf_signal_append_record:(skip)
+ * @signal: the input signal
+ * @bytes: the little endian samples of one record
+ *
+ * Appends a complete record to @signal at once, instead of appending its
+ * samples one by one with edf_signal_append_digital(). The samples aren't
+ * checked against the digital range of @signal.
+ */
+void
+edf_signal_append_record(EdfSignal* signal, const guint8* bytes)
+{
+    g_return_if_fail(EDF_IS_SIGNAL(signal));
+    g_return_if_fail(signal_is_mutable(signal));
+    g_return_if_fail(bytes != NULL);
+    EdfSignalPrivate* priv = edf_signal_get_instance_private(signal);
+    g_return_if_fail(signal_size(signal) == signal_capacity(signal));
+
+    EdfRecord* rec = signal_add_record(priv);
+    memcpy(rec->bytes, bytes, (gsize) rec->ns * priv->sample_size);
+    rec->ns_stored = rec->ns;
+}
+
+/**
+ * edf_signal_get_record_num_stored:(skip)
+ * @signal: the input signal
+ * @nrec: the index of the record
+ *
+ * Returns: the number of samples that were stored in record @nrec, only
+ *          the last record of a signal may be incomplete.
+ */
+guint
+edf_signal_get_record_num_stored(EdfSignal* signal, guint64 nrec)
+{
+    g_return_val_if_fail(EDF_IS_SIGNAL(signal), 0);
+    EdfSignalPrivate* priv = edf_signal_get_instance_private(signal);
+    g_return_val_if_fail(nrec < signal_num_records(priv), 0);
+
+    return signal_record(priv, nrec)->ns_stored;
+}
+
+/**
+ * edf_signal_truncate_records:(skip)
+ * @signal: the input signal
+ * @num_records: the number of records to keep
+ *
+ * Drops the records of @signal from @num_records on. Their bytes stay in
+ * the arena until it is freed.
+ */
+void
+edf_signal_truncate_records(EdfSignal* signal, guint64 num_records)
+{
+    g_return_if_fail(EDF_IS_SIGNAL(signal));
+    g_return_if_fail(signal_is_mutable(signal));
+    EdfSignalPrivate* priv = edf_signal_get_instance_private(signal);
+
+    if (priv->ring_capacity)
+        priv->ring_len = (guint) MIN(priv->ring_len, num_records);
+    else if (num_records < priv->records->len)
+        g_array_set_size(priv->records, (guint) num_records);
+}
+
 /**
  * edf_signal_get_values
  * @signal: the signal whose value you would like to read.
  *
+ * A #GArray holds at most G_MAXUINT values, read longer signals in parts
+ * with an #EdfSignalCursor.
+ *
  * Returns:(transfer full) (element-type gdouble): A list of doubles that is represents
  * the signal that is recorded.
  */
@@ -990,31 +1152,459 @@ edf_signal_get_values(EdfSignal* signal)
 
     EdfSignalPrivate* priv = edf_signal_get_instance_private(signal);
 
-    size_t size = edf_signal_get_num_records(signal) *
-                  edf_signal_get_num_samples_per_record(signal);
+    guint64 size = signal_capacity(signal);
+    g_return_val_if_fail(size <= G_MAXUINT, NULL);
 
-    GArray* ret = g_array_sized_new(FALSE, FALSE, sizeof(gdouble), size);
+    GArray* ret = g_array_sized_new(FALSE, FALSE, sizeof(gdouble), (guint) size);
     g_return_val_if_fail(ret, NULL);
 
-    int dig_min = edf_signal_get_digital_min(signal);
-    int dig_max = edf_signal_get_digital_min(signal);
-    double phys_min = edf_signal_get_physical_min(signal);
-    double phys_max = edf_signal_get_physical_max(signal);
-    double phys_span = phys_max - phys_min;
-    int dig_span = dig_max - dig_min;
-    double step = phys_span / dig_span;
-
-    for (gsize nrec = 0; nrec < priv->records->len; nrec++) {
-        EdfRecord* record = g_ptr_array_index(priv->records, nrec);
-        for (gsize i = 0; i < (unsigned) priv->num_samples_per_record; i++) {
-            int digital_val = edf_record_get(record, i);
-            gdouble val = phys_min + step * (digital_val - dig_min);
+    // The same conversion as the rest of the library, it handles a signal
+    // whose digital minimum equals its digital maximum.
+    gdouble gain = edf_signal_get_gain(signal);
+    gdouble offset = edf_signal_get_offset(signal);
+
+    EDF_TRACE1(convert__start, size);
+    for (guint64 nrec = 0; nrec < signal_num_records(priv); nrec++) {
+        const guint8* bytes = signal_record(priv, nrec)->bytes;
+        for (gsize i = 0; i < priv->num_samples_per_record; i++) {
+            int digital_val = edf_sample_decode(
+                    &bytes[i * priv->sample_size], priv->sample_size
+                    );
+            gdouble val = gain * digital_val + offset;
             g_array_append_val(ret, val);
         }
     }
+    EDF_TRACE1(convert__done, ret->len);
     return ret;
 }
 
+/* Quantizes physical values and appends them to signal */
+static gboolean
+signal_append_physical(
+        EdfSignal      *signal,
+        const gdouble  *values,
+        gsize           num_values,
+        GError        **error
+        )
+{
+    EdfSignalPrivate* priv = edf_signal_get_instance_private(signal);
+    gdouble gain = edf_signal_get_gain(signal);
+    gdouble offset = edf_signal_get_offset(signal);
+
+    for (gsize i = 0; i < num_values; i++) {
+        gdouble d = round((values[i] - offset) / gain);
+        edf_signal_append_digital(
+                signal, (gint) CLAMP(d, priv->digital_min, priv->digital_max), error
+                );
+        if (*error)
+            return FALSE;
+    }
+    return TRUE;
+}
+
+/**
+ * edf_signal_resample:
+ * @signal: the input signal
+ * @ns: the number of samples per record of the new signal
+ * @error:(out): An error is returned here when the ratio of @ns and the
+ *               ns of @signal isn't supported
+ *
+ * Creates a copy of @signal at another sample rate, the records of the copy
+ * contain @ns samples. The samples are resampled record by record with an
+ * #EdfResampler, so the copy may be added to a file with the same record
+ * duration, e.g. to align channels with a different sample rate. The
+ * physical and digital range are those of @signal.
+ *
+ * Returns:(transfer full): a new #EdfSignal or NULL
+ */
+EdfSignal*
+edf_signal_resample(EdfSignal* signal, guint ns, GError** error)
+{
+    g_return_val_if_fail(EDF_IS_SIGNAL(signal), NULL);
+    g_return_val_if_fail(error != NULL && *error == NULL, NULL);
+
+    EdfSignalPrivate* priv = edf_signal_get_instance_private(signal);
+    g_return_val_if_fail(priv->num_samples_per_record > 0, NULL);
+
+    EdfResampler* resampler = edf_resampler_new(
+            ns, priv->num_samples_per_record, error
+            );
+    if (!resampler)
+        return NULL;
+
+    EdfSignal* new = g_object_new(
+            EDF_TYPE_SIGNAL,
+            "sample-size", priv->sample_size,
+            "label", priv->label,
+            "transducer", priv->transducer_type,
+            "physical-dimension", priv->physical_dimension,
+            "physical-min", priv->physical_min,
+            "physical-max", priv->physical_max,
+            "digital-min", priv->digital_min,
+            "digital-max", priv->digital_max,
+            "prefilter", priv->prefiltering,
+            "ns", ns,
+            NULL
+            );
+
+    gdouble gain = edf_signal_get_gain(signal);
+    gdouble offset = edf_signal_get_offset(signal);
+    guint ns_in = priv->num_samples_per_record;
+    gdouble* in = g_new(gdouble, ns_in);
+    // A record yields at most ns + 1 samples, the flush the delay of the filter
+    gsize out_size = MAX(
+            ns + 1,
+            edf_resampler_get_num_taps(resampler) /
+            (2 * edf_resampler_get_down(resampler)) + 1
+            );
+    gdouble* out = g_new(gdouble, MAX(out_size, 1));
+
+    for (guint64 nrec = 0; nrec < signal_num_records(priv) && !*error; nrec++) {
+        const guint8* bytes = signal_record(priv, nrec)->bytes;
+        for (guint i = 0; i < ns_in; i++)
+            in[i] = gain * edf_sample_decode(
+                    &bytes[i * priv->sample_size], priv->sample_size
+                    ) + offset;
+
+        gsize n = edf_resampler_process(resampler, in, ns_in, out);
+        signal_append_physical(new, out, n, error);
+    }
+    if (!*error) {
+        gsize n = edf_resampler_flush(resampler, out);
+        signal_append_physical(new, out, n, error);
+    }
+
+    g_free(in);
+    g_free(out);
+    g_object_unref(resampler);
+    if (*error)
+        g_clear_object(&new);
+    return new;
+}
+
+/**
+ * edf_signal_freeze:(skip)
+ * @signal: the input signal
+ *
+ * Makes @signal read only, see edf_file_freeze().
+ */
+void
+edf_signal_freeze(EdfSignal* signal)
+{
+    g_return_if_fail(EDF_IS_SIGNAL(signal));
+    EdfSignalPrivate* priv = edf_signal_get_instance_private(signal);
+    priv->frozen = TRUE;
+}
+
+/**
+ * edf_signal_is_frozen:
+ * @signal: the input signal
+ *
+ * Returns: TRUE when @signal is read only, it belongs to a frozen #EdfFile
+ */
+gboolean
+edf_signal_is_frozen(EdfSignal* signal)
+{
+    g_return_val_if_fail(EDF_IS_SIGNAL(signal), FALSE);
+    return !signal_is_mutable(signal);
+}
+
+/**
+ * edf_signal_set_ring_capacity:
+ * @signal: the input signal
+ * @num_records: the number of records to keep, at least 1
+ *
+ * Turns @signal into a ring buffer of @num_records records, e.g. to keep
+ * the last seconds of a recording for a live display. All records are
+ * stored in one buffer that is allocated here, when a record is added to
+ * a full buffer the oldest record is overwritten without allocating
+ * memory. The latest @num_records records that @signal already contains
+ * are kept.
+ *
+ * The number of samples per record and the sample size must not change
+ * afterwards and the capacity can be set only once. The records of a
+ * ring buffer are numbered from the oldest record that is still stored,
+ * see edf_signal_get_num_dropped_records().
+ */
+void
+edf_signal_set_ring_capacity(EdfSignal* signal, guint num_records)
+{
+    g_return_if_fail(EDF_IS_SIGNAL(signal));
+    g_return_if_fail(signal_is_mutable(signal));
+    g_return_if_fail(num_records > 0);
+    EdfSignalPrivate* priv = edf_signal_get_instance_private(signal);
+    g_return_if_fail(priv->ring_capacity == 0);
+    g_return_if_fail(priv->num_samples_per_record > 0);
+
+    gsize record_size = (gsize) priv->num_samples_per_record * priv->sample_size;
+    guint num_kept = MIN(priv->records->len, num_records);
+    guint first = priv->records->len - num_kept;
+    GArray* slots = g_array_sized_new(FALSE, FALSE, sizeof(EdfRecord), num_records);
+
+    // One more record to read into while the slots are full
+    priv->ring_bytes = g_malloc0(record_size * (num_records + 1));
+    priv->ring_scratch = &priv->ring_bytes[record_size * num_records];
+    EDF_TRACE1(storage__alloc, record_size * (num_records + 1));
+    for (guint slot = 0; slot < num_records; slot++) {
+        EdfRecord record = {
+            .bytes = &priv->ring_bytes[slot * record_size],
+            .ns = priv->num_samples_per_record,
+            .ns_stored = 0
+        };
+        if (slot < num_kept) {
+            EdfRecord* old = &g_array_index(priv->records, EdfRecord, first + slot);
+            memcpy(record.bytes, old->bytes, record_size);
+            record.ns_stored = old->ns_stored;
+        }
+        g_array_append_val(slots, record);
+    }
+
+    // The bytes of the old records go with the arena
+    g_array_unref(priv->records);
+    priv->records = slots;
+    priv->ring_capacity = num_records;
+    priv->ring_head = 0;
+    priv->ring_len = num_kept;
+    priv->ring_dropped = first;
+}
+
+/**
+ * edf_signal_get_ring_capacity:
+ * @signal: the input signal
+ *
+ * Returns: the number of records of the ring buffer of @signal or 0 when
+ *          its records are not limited.
+ */
+guint
+edf_signal_get_ring_capacity(EdfSignal* signal)
+{
+    g_return_val_if_fail(EDF_IS_SIGNAL(signal), 0);
+    EdfSignalPrivate* priv = edf_signal_get_instance_private(signal);
+    return priv->ring_capacity;
+}
+
+/**
+ * edf_signal_get_num_dropped_records:
+ * @signal: the input signal
+ *
+ * Record 0 of a ring buffer is the record that was added as record
+ * edf_signal_get_num_dropped_records() in total.
+ *
+ * Returns: the number of records that were overwritten in the ring buffer
+ */
+guint64
+edf_signal_get_num_dropped_records(EdfSignal* signal)
+{
+    g_return_val_if_fail(EDF_IS_SIGNAL(signal), 0);
+    EdfSignalPrivate* priv = edf_signal_get_instance_private(signal);
+    return priv->ring_dropped;
+}
+
+/**
+ * edf_signal_get_latest_spans:(skip)
+ * @signal: a signal with a ring capacity
+ * @num_samples: the number of samples of the window
+ * @spans:(out caller-allocates)(array fixed-size=2): the spans of the window
+ *
+ * Finds the latest @num_samples samples of the ring buffer of @signal
+ * without copying them. The window consists of at most two spans of raw
+ * little endian samples, the second one follows the first in time. Unused
+ * spans are set to NULL and 0. The window is shorter than @num_samples
+ * when @signal contains fewer samples. The spans are valid until the next
+ * sample or record is added to @signal.
+ *
+ * Returns: the number of spans, 0, 1 or 2
+ */
+guint
+edf_signal_get_latest_spans(
+        EdfSignal      *signal,
+        gsize           num_samples,
+        EdfSignalSpan   spans[2]
+        )
+{
+    g_return_val_if_fail(EDF_IS_SIGNAL(signal), 0);
+    g_return_val_if_fail(spans != NULL, 0);
+    EdfSignalPrivate* priv = edf_signal_get_instance_private(signal);
+    g_return_val_if_fail(priv->ring_capacity > 0, 0);
+
+    memset(spans, 0, 2 * sizeof(EdfSignalSpan));
+
+    gsize n = MIN(num_samples, signal_size(signal));
+    if (n == 0)
+        return 0;
+
+    // The position after the last stored sample in the buffer
+    gsize ns = priv->num_samples_per_record;
+    guint last_slot = (priv->ring_head + priv->ring_len - 1) % priv->ring_capacity;
+    gsize end = last_slot * ns + signal_record(priv, priv->ring_len - 1)->ns_stored;
+
+    if (n <= end) {
+        spans[0].bytes = &priv->ring_bytes[(end - n) * priv->sample_size];
+        spans[0].num_samples = n;
+        return 1;
+    }
+
+    gsize wrapped = n - end;
+    spans[0].bytes = &priv->ring_bytes[
+            (priv->ring_capacity * ns - wrapped) * priv->sample_size
+            ];
+    spans[0].num_samples = wrapped;
+    spans[1].bytes = priv->ring_bytes;
+    spans[1].num_samples = end;
+    return end > 0 ? 2 : 1;
+}
+
+/**
+ * edf_signal_copy_latest:
+ * @signal: a signal with a ring capacity
+ * @num_samples: the number of samples of the window
+ * @values:(out caller-allocates)(array length=num_samples): the physical
+ *         values of the window, oldest first
+ *
+ * Copies the latest @num_samples samples of the ring buffer of @signal in
+ * physical units, see edf_signal_get_latest_spans().
+ *
+ * Returns: the number of values that were copied, fewer than @num_samples
+ *          when @signal contains fewer samples.
+ */
+gsize
+edf_signal_copy_latest(EdfSignal* signal, gsize num_samples, gdouble* values)
+{
+    g_return_val_if_fail(EDF_IS_SIGNAL(signal), 0);
+    g_return_val_if_fail(values != NULL || num_samples == 0, 0);
+
+    EdfSignalPrivate* priv = edf_signal_get_instance_private(signal);
+    EdfSignalSpan spans[2];
+    gint32 block[1024];
+    gdouble gain = edf_signal_get_gain(signal);
+    gdouble offset = edf_signal_get_offset(signal);
+    gsize num_copied = 0;
+
+    guint num_spans = edf_signal_get_latest_spans(signal, num_samples, spans);
+    for (guint s = 0; s < num_spans; s++) {
+        for (gsize start = 0; start < spans[s].num_samples; start += G_N_ELEMENTS(block)) {
+            gsize n = MIN(G_N_ELEMENTS(block), spans[s].num_samples - start);
+            edf_samples_decode(
+                    &spans[s].bytes[start * priv->sample_size], priv->sample_size, n, block
+                    );
+            for (gsize i = 0; i < n; i++)
+                values[num_copied + i] = gain * block[i] + offset;
+            num_copied += n;
+        }
+    }
+    return num_copied;
+}
+
+/*
+ * Converts the samples [first, first + num_samples) to physical values in
+ * either f32 or f64, record by record without intermediate allocations.
+ */
+static gsize
+signal_copy_values(
+        EdfSignal  *signal,
+        guint64     first,
+        gsize       num_samples,
+        gfloat     *f32,
+        gdouble    *f64
+        )
+{
+    EdfSignalPrivate* priv = edf_signal_get_instance_private(signal);
+    guint64 size = signal_size(signal);
+    guint ns = priv->num_samples_per_record;
+    gdouble gain = edf_signal_get_gain(signal);
+    gdouble offset = edf_signal_get_offset(signal);
+    gint32 block[1024];
+    gsize num_copied = 0;
+
+    if (first >= size)
+        return 0;
+    num_samples = (gsize) MIN((guint64) num_samples, size - first);
+
+    EDF_TRACE1(convert__start, num_samples);
+    while (num_copied < num_samples) {
+        guint64 pos = first + num_copied;
+        const guint8* bytes = signal_record(priv, pos / ns)->bytes;
+        guint i = (guint) (pos % ns);
+        gsize n = MIN(MIN(num_samples - num_copied, ns - i), G_N_ELEMENTS(block));
+
+        edf_samples_decode(&bytes[i * priv->sample_size], priv->sample_size, n, block);
+        // Computed in double and rounded once, as edf_file_to_matrix() does
+        if (f32) {
+            gfloat* out = &f32[num_copied];
+            for (gsize j = 0; j < n; j++)
+                out[j] = (gfloat) (gain * block[j] + offset);
+        }
+        else {
+            gdouble* out = &f64[num_copied];
+            for (gsize j = 0; j < n; j++)
+                out[j] = gain * block[j] + offset;
+        }
+        num_copied += n;
+    }
+    EDF_TRACE1(convert__done, num_copied);
+    return num_copied;
+}
+
+/**
+ * edf_signal_copy_values_f32:
+ * @signal: the input signal
+ * @first: the index of the first sample to copy
+ * @num_samples: the number of samples to copy
+ * @values:(out caller-allocates)(array length=num_samples): a buffer for
+ *         at least @num_samples values
+ *
+ * Copies the physical values of the samples from @first on into @values.
+ * In contrast to edf_signal_get_values() nothing is allocated, so one
+ * buffer can be reused for many calls. The samples of edf and bdf files
+ * have at most 24 bits, so single precision holds them without loss of
+ * resolution at half the size. Pass G_MAXSIZE as @num_samples to copy up
+ * to the end of the signal into a buffer of edf_signal_get_num_samples()
+ * values.
+ *
+ * Returns: the number of values copied, fewer than @num_samples when the
+ *          signal ends before
+ */
+gsize
+edf_signal_copy_values_f32(
+        EdfSignal  *signal,
+        guint64     first,
+        gsize       num_samples,
+        gfloat     *values
+        )
+{
+    g_return_val_if_fail(EDF_IS_SIGNAL(signal), 0);
+    g_return_val_if_fail(values != NULL || num_samples == 0, 0);
+
+    return signal_copy_values(signal, first, num_samples, values, NULL);
+}
+
+/**
+ * edf_signal_copy_values_f64:
+ * @signal: the input signal
+ * @first: the index of the first sample to copy
+ * @num_samples: the number of samples to copy
+ * @values:(out caller-allocates)(array length=num_samples): a buffer for
+ *         at least @num_samples values
+ *
+ * The double precision variant of edf_signal_copy_values_f32().
+ *
+ * Returns: the number of values copied, fewer than @num_samples when the
+ *          signal ends before
+ */
+gsize
+edf_signal_copy_values_f64(
+        EdfSignal  *signal,
+        guint64     first,
+        gsize       num_samples,
+        gdouble    *values
+        )
+{
+    g_return_val_if_fail(EDF_IS_SIGNAL(signal), 0);
+    g_return_val_if_fail(values != NULL || num_samples == 0, 0);
+
+    return signal_copy_values(signal, first, num_samples, NULL, values);
+}
+
 /**
  * edf_signal_write_record_to_ostream:(skip)
  */
@@ -1022,7 +1612,7 @@ void
 edf_signal_write_record_to_ostream(
         EdfSignal        *signal,
         GOutputStream    *ostream,
-        guint             nrec,
+        guint64           nrec,
         GError          **error
         )
 {
@@ -1032,25 +1622,29 @@ edf_signal_write_record_to_ostream(
 
     EdfSignalPrivate *priv = edf_signal_get_instance_private(signal);
 
-    g_return_if_fail(nrec < priv->records->len);
+    g_return_if_fail(nrec < signal_num_records(priv));
 
-    EdfRecord* record = g_ptr_array_index(priv->records, nrec);
+    EdfRecord* record = signal_record(priv, nrec);
+    gsize size = (gsize) record->ns * priv->sample_size;
     g_output_stream_write_all(
             ostream,
             record->bytes,
-            record->ns * record->sizeof_sample,
+            size,
             &bytes_written,
             NULL,
             error
             );
-    if (bytes_written != record->ns * record->sizeof_sample) {
-        g_critical("Bytes written is %lu where %u was expected",
-                  bytes_written, record->ns * record->sizeof_sample);
+    if (bytes_written != size) {
+        g_critical("Bytes written is %" G_GSIZE_FORMAT " where %" G_GSIZE_FORMAT " was expected",
+                  bytes_written, size);
     }
 }
 
 /**
  * edf_signal_read_record_from_istream:(skip)
+ *
+ * A record that isn't read completely is not added to a ring buffer, so
+ * it doesn't push out the oldest record.
  */
 gsize
 edf_signal_read_record_from_istream(
@@ -1060,36 +1654,49 @@ edf_signal_read_record_from_istream(
     )
 {
     g_return_val_if_fail(EDF_IS_SIGNAL(signal) && G_IS_INPUT_STREAM(istream), 0);
+    g_return_val_if_fail(signal_is_mutable(signal), 0);
     g_return_val_if_fail(error && *error == NULL, 0);
 
     gsize numread = 0;
     EdfSignalPrivate *priv = edf_signal_get_instance_private(signal);
-    gsize memchunksize = priv->num_samples_per_record * priv->sample_size;
-
-    EdfRecord* record = edf_record_new (
-        priv->num_samples_per_record,
-        priv->sample_size,
-        error
-    );
-
-    if (*error) {
-        if (record)
-            edf_record_destroy(record);
+    gsize memchunksize = (gsize) priv->num_samples_per_record * priv->sample_size;
+
+    // Only a complete record enters the ring buffer, a full buffer keeps
+    // its oldest record until the new one has been read
+    if (priv->ring_capacity) {
+        gboolean full = priv->ring_len == priv->ring_capacity;
+        guint8* bytes = full ? priv->ring_scratch :
+                               signal_record(priv, priv->ring_len)->bytes;
+        if (!g_input_stream_read_all(
+                    istream, bytes, memchunksize, &numread, NULL, error
+                    ) || numread < memchunksize)
+            return numread;
+
+        EdfRecord* rec = signal_add_record(priv);
+        if (full)
+            memcpy(rec->bytes, bytes, memchunksize);
+        rec->ns_stored = rec->ns;
         return numread;
     }
 
+    // The bytes are only handed to a record when they are read
+    guint8* bytes = edf_arena_alloc(signal_arena(priv), memchunksize);
+
     if (
         g_input_stream_read_all(
-            istream, record->bytes, memchunksize, &numread, NULL, error
+            istream, bytes, memchunksize, &numread, NULL, error
         ) != TRUE
     ) {
-        goto fail;
+        return numread;
     }
-    g_ptr_array_add (priv->records, record);
-    return numread;
-    
-fail:
+    if (numread < memchunksize)
+        memset(&bytes[numread], 0, memchunksize - numread);
+
+    EdfRecord record = {
+        .bytes = bytes,
+        .ns = priv->num_samples_per_record,
+        .ns_stored = priv->num_samples_per_record
+    };
+    g_array_append_val(priv->records, record);
     return numread;
 }
-
-
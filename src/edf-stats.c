@@ -0,0 +1,273 @@
+
+#include "edf-stats.h"
+#include "edf-signal-priv.h"
+#include "edf-sample-priv.h"
+
+#include <math.h>
+#include <string.h>
+
+/**
+ * SECTION:edf-stats
+ * @short_description: per channel statistics to check the quality of a recording
+ * @see_also: #EdfSignal, #EdfReader
+ * @include: gedf.h
+ *
+ * Before a recording is analyzed its channels are checked for flat lines,
+ * saturation against the digital minimum or maximum, DC offset and noise.
+ * An #EdfSignalStats collects these statistics in one pass over the digital
+ * samples: the extremes, mean, variance and root mean square, the number
+ * of samples at the digital rails of the header, the longest run of equal
+ * samples and a coarse histogram of the digital codes.
+ *
+ * edf_file_compute_stats() computes the statistics of all signals of a file
+ * in memory. While a file is streamed with an #EdfReader, or over a mapped
+ * file, the raw samples of every record are added instead:
+ *
+ * |[<!-- language="C" -->
+ * const EdfReaderChannel* chan = edf_reader_get_channel(reader, c);
+ * EdfSignalStats stats;
+ *
+ * edf_signal_stats_init(
+ *         &stats, chan->digital_min, chan->digital_max, chan->gain, chan->phys_offset
+ *         );
+ * while (edf_reader_next_record(reader, &error))
+ *     edf_signal_stats_add_bytes(
+ *             &stats,
+ *             edf_reader_get_record_bytes(reader) + chan->offset,
+ *             chan->ns,
+ *             chan->sample_size
+ *             );
+ * ]|
+ *
+ * The samples are processed in blocks. Per block the sums are exact
+ * integers relative to the first sample of the block. The blocks are
+ * combined with the pairwise update of the mean and variance, which stays
+ * accurate for long recordings with a large DC offset.
+ */
+
+// The sum of squares of a block of 24 bit samples fits in a gint64
+#define STATS_BLOCK     1024
+
+/**
+ * edf_signal_stats_init:
+ * @stats: the statistics to initialize
+ * @digital_min: the digital minimum of the signal in the header
+ * @digital_max: the digital maximum of the signal in the header
+ * @gain: the gain of the signal, see edf_signal_get_gain()
+ * @offset: the offset of the signal, see edf_signal_get_offset()
+ *
+ * Initializes @stats for a signal without samples.
+ */
+void
+edf_signal_stats_init(
+        EdfSignalStats *stats,
+        gint            digital_min,
+        gint            digital_max,
+        gdouble         gain,
+        gdouble         offset
+        )
+{
+    g_return_if_fail(stats != NULL);
+    g_return_if_fail(digital_min <= digital_max);
+
+    memset(stats, 0, sizeof(EdfSignalStats));
+    stats->range_min = digital_min;
+    stats->range_max = digital_max;
+    stats->gain = gain;
+    stats->offset = offset;
+}
+
+/* Updates the physical values from the digital ones */
+static void
+stats_update(EdfSignalStats* stats)
+{
+    gdouble lo = stats->gain * stats->digital_min + stats->offset;
+    gdouble hi = stats->gain * stats->digital_max + stats->offset;
+
+    stats->min = MIN(lo, hi);
+    stats->max = MAX(lo, hi);
+    stats->mean = stats->gain * stats->digital_mean + stats->offset;
+    stats->variance = stats->gain * stats->gain *
+                      stats->digital_m2 / stats->num_samples;
+    stats->rms = sqrt(stats->mean * stats->mean + stats->variance);
+}
+
+static void
+stats_add_block(EdfSignalStats* stats, const gint32* restrict x, gsize n)
+{
+    const gint32 pivot = x[0];
+    const gint32 range_min = stats->range_min;
+    const gint32 range_max = stats->range_max;
+    const gint64 range = (gint64) range_max - range_min + 1;
+    gint32 lo = pivot, hi = pivot;
+    gint64 s1 = 0, s2 = 0;
+    guint64 at_min = 0, at_max = 0;
+
+    for (gsize i = 0; i < n; i++) {
+        gint32 v = x[i];
+        gint64 d = (gint64) v - pivot;
+        lo = v < lo ? v : lo;
+        hi = v > hi ? v : hi;
+        s1 += d;
+        s2 += d * d;
+        at_min += v <= range_min;
+        at_max += v >= range_max;
+    }
+
+    for (gsize i = 0; i < n; i++) {
+        gint64 v = CLAMP(x[i], range_min, range_max);
+        stats->histogram[(v - range_min) * EDF_STATS_HISTOGRAM_BINS / range]++;
+    }
+
+    for (gsize i = 0; i < n; i++) {
+        if (stats->run > 0 && x[i] == stats->last) {
+            stats->run++;
+        }
+        else {
+            stats->last = x[i];
+            stats->run = 1;
+        }
+        stats->longest_flat_run = MAX(stats->longest_flat_run, stats->run);
+    }
+
+    // Combine the mean and the sum of squared deviations of the block
+    gdouble block_mean = pivot + (gdouble) s1 / n;
+    gdouble block_m2 = (gdouble) s2 - (gdouble) s1 * s1 / n;
+    guint64 total = stats->num_samples + n;
+    gdouble delta = block_mean - stats->digital_mean;
+
+    if (stats->num_samples == 0) {
+        stats->digital_min = lo;
+        stats->digital_max = hi;
+    }
+    else {
+        stats->digital_min = MIN(stats->digital_min, lo);
+        stats->digital_max = MAX(stats->digital_max, hi);
+    }
+    stats->digital_mean += delta * n / total;
+    stats->digital_m2 += MAX(block_m2, 0) +
+                         delta * delta * ((gdouble) stats->num_samples * n / total);
+    stats->num_samples = total;
+    stats->num_at_digital_min += at_min;
+    stats->num_at_digital_max += at_max;
+}
+
+/**
+ * edf_signal_stats_add_digital:
+ * @stats: initialized statistics
+ * @samples:(array length=num_samples): the next digital samples
+ * @num_samples: the number of samples
+ *
+ * Adds digital samples to @stats.
+ */
+void
+edf_signal_stats_add_digital(
+        EdfSignalStats *stats,
+        const gint32   *samples,
+        gsize           num_samples
+        )
+{
+    g_return_if_fail(stats != NULL);
+    g_return_if_fail(samples != NULL || num_samples == 0);
+
+    if (num_samples == 0)
+        return;
+
+    for (gsize start = 0; start < num_samples; start += STATS_BLOCK)
+        stats_add_block(stats, &samples[start], MIN(STATS_BLOCK, num_samples - start));
+    stats_update(stats);
+}
+
+/**
+ * edf_signal_stats_add_bytes:
+ * @stats: initialized statistics
+ * @bytes:(array): the raw samples as they are stored in a record
+ * @num_samples: the number of samples in @bytes
+ * @sample_size: the size of a sample, 2 for edf and 3 for bdf
+ *
+ * Adds the little endian samples of a record to @stats, e.g. the samples of
+ * a channel in edf_reader_get_record_bytes().
+ */
+void
+edf_signal_stats_add_bytes(
+        EdfSignalStats *stats,
+        const guint8   *bytes,
+        gsize           num_samples,
+        guint           sample_size
+        )
+{
+    g_return_if_fail(stats != NULL);
+    g_return_if_fail(bytes != NULL || num_samples == 0);
+    g_return_if_fail(sample_size == EDF_SAMPLE_SIZE || sample_size == BDF_SAMPLE_SIZE);
+
+    gint32 block[STATS_BLOCK];
+
+    if (num_samples == 0)
+        return;
+
+    for (gsize start = 0; start < num_samples; start += STATS_BLOCK) {
+        gsize n = MIN(STATS_BLOCK, num_samples - start);
+        edf_samples_decode(&bytes[start * sample_size], sample_size, n, block);
+        stats_add_block(stats, block, n);
+    }
+    stats_update(stats);
+}
+
+/**
+ * edf_signal_compute_stats:
+ * @signal: the signal
+ * @stats:(out caller-allocates): the statistics of @signal
+ *
+ * Computes the statistics of the samples that are stored in @signal.
+ */
+void
+edf_signal_compute_stats(EdfSignal* signal, EdfSignalStats* stats)
+{
+    g_return_if_fail(EDF_IS_SIGNAL(signal));
+    g_return_if_fail(stats != NULL);
+
+    guint sample_size = edf_signal_get_sample_size(signal);
+
+    edf_signal_stats_init(
+            stats,
+            edf_signal_get_digital_min(signal),
+            edf_signal_get_digital_max(signal),
+            edf_signal_get_gain(signal),
+            edf_signal_get_offset(signal)
+            );
+
+    guint64 num_records = edf_signal_get_num_records(signal);
+    for (guint64 nrec = 0; nrec < num_records; nrec++)
+        edf_signal_stats_add_bytes(
+                stats,
+                edf_signal_get_record_bytes(signal, nrec),
+                edf_signal_get_record_num_stored(signal, nrec),
+                sample_size
+                );
+}
+
+/**
+ * edf_file_compute_stats:(skip)
+ * @file: the file
+ * @num_signals:(out): the number of signals of @file
+ *
+ * Computes the statistics of all signals of @file.
+ *
+ * Returns:(transfer full): an array with the statistics of every signal,
+ *          free it with g_free().
+ */
+EdfSignalStats*
+edf_file_compute_stats(EdfFile* file, guint* num_signals)
+{
+    g_return_val_if_fail(EDF_IS_FILE(file), NULL);
+    g_return_val_if_fail(num_signals != NULL, NULL);
+
+    GPtrArray* signals = edf_file_get_signals(file);
+    EdfSignalStats* stats = g_new(EdfSignalStats, MAX(signals->len, 1));
+
+    for (guint i = 0; i < signals->len; i++)
+        edf_signal_compute_stats(g_ptr_array_index(signals, i), &stats[i]);
+
+    *num_signals = signals->len;
+    return stats;
+}
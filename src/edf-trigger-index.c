@@ -0,0 +1,835 @@
+
+#include "edf-trigger-index.h"
+#include "edf-file.h"
+#include "edf-header-priv.h"
+#include "edf-signal-priv.h"
+#include "edf-sample-priv.h"
+
+#include <gio/gio.h>
+#include <string.h>
+
+/**
+ * SECTION:edf-trigger-index
+ * @short_description: an index of the changes in a trigger signal
+ * @see_also: #EdfFile, #EdfSignal
+ * @include: gedf.h
+ *
+ * Stimulus locked analysis needs the sample positions at which the trigger
+ * code of a recording changes. #EdfTriggerIndex finds those positions in one
+ * pass over the trigger signal and stores only the edges as #EdfTriggerEvent s.
+ * In BioSemi bdf files this is the "Status" signal whose lower 16 bits hold
+ * the trigger code.
+ *
+ * The index can be stored in a small sidecar file next to the recording,
+ * so a subsequent analysis of the same recording doesn't need to scan the
+ * file again.
+ */
+
+G_DEFINE_QUARK(edf_trigger_index_error_quark, edf_trigger_index_error)
+
+#define TRIGGER_LABEL       "Status"
+#define TRIGGER_TRANSDUCER  "Triggers and Status"
+#define TRIGGER_CODE_MASK   0xFFFF
+#define SIDECAR_SUFFIX      ".trg"
+
+/*
+ * The number of samples that is compared at once when looking for an edge.
+ * Trigger signals are constant most of the time, hence whole blocks are
+ * skipped.
+ */
+#define SCAN_BLOCK          64
+
+/* layout of a sidecar file, all numbers are little endian */
+static const gchar sidecar_magic[8] = "GEDFTRG1";
+#define SIDECAR_HEADER_SIZE 48
+#define SIDECAR_EVENT_SIZE  12
+
+typedef struct _EdfTriggerIndexPrivate {
+    GArray     *events;
+    gdouble     sample_rate;
+    guint32     code_mask;
+
+    /* state while scanning */
+    guint64     num_scanned;
+    guint32     last_code;
+} EdfTriggerIndexPrivate;
+
+G_DEFINE_TYPE_WITH_PRIVATE(EdfTriggerIndex, edf_trigger_index, G_TYPE_OBJECT)
+
+typedef enum {
+    PROP_NUM_EVENTS = 1,
+    PROP_SAMPLE_RATE,
+    PROP_CODE_MASK,
+    N_PROPERTIES
+} EdfTriggerIndexProperty;
+
+static void
+edf_trigger_index_init(EdfTriggerIndex* self)
+{
+    EdfTriggerIndexPrivate* priv = edf_trigger_index_get_instance_private(self);
+
+    priv->events = g_array_new(FALSE, FALSE, sizeof(EdfTriggerEvent));
+    priv->sample_rate = 0;
+    priv->code_mask = TRIGGER_CODE_MASK;
+    priv->num_scanned = 0;
+    priv->last_code = 0;
+}
+
+static void
+edf_trigger_index_finalize(GObject* gobject)
+{
+    EdfTriggerIndexPrivate* priv = edf_trigger_index_get_instance_private(
+            EDF_TRIGGER_INDEX(gobject)
+            );
+
+    g_array_unref(priv->events);
+
+    G_OBJECT_CLASS(edf_trigger_index_parent_class)->finalize(gobject);
+}
+
+static void
+edf_trigger_index_set_property(
+        GObject        *object,
+        guint32         propid,
+        const GValue   *value,
+        GParamSpec     *spec
+        )
+{
+    EdfTriggerIndex* self = EDF_TRIGGER_INDEX(object);
+    EdfTriggerIndexPrivate* priv = edf_trigger_index_get_instance_private(self);
+
+    switch ((EdfTriggerIndexProperty) propid) {
+        case PROP_SAMPLE_RATE:
+            priv->sample_rate = g_value_get_double(value);
+            break;
+        case PROP_CODE_MASK:
+            priv->code_mask = g_value_get_uint(value);
+            break;
+        case PROP_NUM_EVENTS: // read only
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID(object, propid, spec);
+    }
+}
+
+static void
+edf_trigger_index_get_property(
+        GObject        *object,
+        guint32         propid,
+        GValue         *value,
+        GParamSpec     *spec
+        )
+{
+    EdfTriggerIndex* self = EDF_TRIGGER_INDEX(object);
+    EdfTriggerIndexPrivate* priv = edf_trigger_index_get_instance_private(self);
+
+    switch ((EdfTriggerIndexProperty) propid) {
+        case PROP_NUM_EVENTS:
+            g_value_set_uint(value, priv->events->len);
+            break;
+        case PROP_SAMPLE_RATE:
+            g_value_set_double(value, priv->sample_rate);
+            break;
+        case PROP_CODE_MASK:
+            g_value_set_uint(value, priv->code_mask);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID(object, propid, spec);
+    }
+}
+
+static GParamSpec* edf_trigger_index_properties[N_PROPERTIES] = {NULL,};
+
+static void
+edf_trigger_index_class_init(EdfTriggerIndexClass* klass)
+{
+    GObjectClass* object_class = G_OBJECT_CLASS(klass);
+
+    object_class->set_property = edf_trigger_index_set_property;
+    object_class->get_property = edf_trigger_index_get_property;
+    object_class->finalize = edf_trigger_index_finalize;
+
+    /**
+     * EdfTriggerIndex:num-events:
+     *
+     * The number of edges found in the trigger signal.
+     */
+    edf_trigger_index_properties[PROP_NUM_EVENTS] = g_param_spec_uint(
+            "num-events",
+            "Number of events",
+            "The number of changes of the trigger code",
+            0,
+            G_MAXUINT,
+            0,
+            G_PARAM_READABLE
+            );
+
+    /**
+     * EdfTriggerIndex:sample-rate:
+     *
+     * The sample rate of the trigger signal in Hz, it is used to convert
+     * times into sample indices.
+     */
+    edf_trigger_index_properties[PROP_SAMPLE_RATE] = g_param_spec_double(
+            "sample-rate",
+            "Sample rate",
+            "The sample rate of the trigger signal",
+            0.0,
+            G_MAXDOUBLE,
+            0.0,
+            G_PARAM_READWRITE
+            );
+
+    /**
+     * EdfTriggerIndex:code-mask:
+     *
+     * The bits of a sample of the trigger signal that form the trigger
+     * code. For BioSemi files these are the lower 16 bits, the upper 8
+     * bits are status bits.
+     */
+    edf_trigger_index_properties[PROP_CODE_MASK] = g_param_spec_uint(
+            "code-mask",
+            "Code mask",
+            "The bits of a trigger sample that form the trigger code",
+            0,
+            G_MAXUINT32,
+            TRIGGER_CODE_MASK,
+            G_PARAM_READWRITE | G_PARAM_CONSTRUCT
+            );
+
+    g_object_class_install_properties(
+            object_class, N_PROPERTIES, edf_trigger_index_properties
+            );
+}
+
+/* ************* scanning ************** */
+
+/*
+ * Scans n samples in bytes for changes of the trigger code. The scan
+ * continues where the previous call stopped, so the records of a signal
+ * should be fed in order.
+ *
+ * Instead of decoding every sample, a block of samples is compared with
+ * the same block shifted by one sample. When they are equal, all samples in
+ * the block are equal to the previous one and the block can be skipped.
+ * memcmp is vectorized by the C library, so this amounts to a SIMD compare of
+ * adjacent (24 bit) words.
+ */
+static void
+trigger_index_scan_bytes(
+        EdfTriggerIndex    *index,
+        const guint8       *bytes,
+        gsize               n,
+        guint               sample_size
+        )
+{
+    EdfTriggerIndexPrivate* priv = edf_trigger_index_get_instance_private(index);
+    gsize i = 0;
+
+    while (i < n) {
+        if (i > 0 && n - i >= SCAN_BLOCK &&
+            memcmp(&bytes[(i - 1) * sample_size],
+                   &bytes[i * sample_size],
+                   SCAN_BLOCK * sample_size) == 0
+           ) {
+            i += SCAN_BLOCK;
+            continue;
+        }
+
+        guint32 code = (guint32) edf_sample_decode(&bytes[i * sample_size], sample_size);
+        code &= priv->code_mask;
+        if (code != priv->last_code) {
+            EdfTriggerEvent event = {
+                .sample = priv->num_scanned + i,
+                .code = code
+            };
+            g_array_append_val(priv->events, event);
+            priv->last_code = code;
+        }
+        i++;
+    }
+    priv->num_scanned += n;
+}
+
+static gint
+find_trigger_signal(GPtrArray* signals)
+{
+    for (guint i = 0; i < signals->len; i++) {
+        EdfSignal* signal = g_ptr_array_index(signals, i);
+        if (g_strcmp0(edf_signal_get_label(signal), TRIGGER_LABEL) == 0 ||
+            g_strcmp0(edf_signal_get_transducer(signal), TRIGGER_TRANSDUCER) == 0)
+            return i;
+    }
+    return -1;
+}
+
+static gboolean
+query_source_file(
+        const gchar    *path,
+        guint64        *size,
+        guint64        *mtime,
+        guint32        *mtime_usec,
+        GError        **error
+        )
+{
+    GFile* file = g_file_new_for_path(path);
+    GFileInfo* info = g_file_query_info(
+            file,
+            G_FILE_ATTRIBUTE_STANDARD_SIZE ","
+            G_FILE_ATTRIBUTE_TIME_MODIFIED ","
+            G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC,
+            G_FILE_QUERY_INFO_NONE,
+            NULL,
+            error
+            );
+    g_object_unref(file);
+    if (!info)
+        return FALSE;
+
+    *size = g_file_info_get_size(info);
+    *mtime = g_file_info_get_attribute_uint64(info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+    *mtime_usec = g_file_info_get_attribute_uint32(
+            info, G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC
+            );
+    g_object_unref(info);
+    return TRUE;
+}
+
+static guint64
+time_to_sample(gdouble time, gdouble sample_rate)
+{
+    gdouble pos = time * sample_rate;
+    if (pos <= 0)
+        return 0;
+    if (pos >= (gdouble) G_MAXUINT64)
+        return G_MAXUINT64;
+
+    guint64 sample = (guint64) pos;
+    if ((gdouble) sample < pos)
+        sample++;
+    return sample;
+}
+
+/* ************* sidecar files ************** */
+
+static void
+put_u32(GByteArray* array, guint32 value)
+{
+    value = GUINT32_TO_LE(value);
+    g_byte_array_append(array, (const guint8*) &value, sizeof(value));
+}
+
+static void
+put_u64(GByteArray* array, guint64 value)
+{
+    value = GUINT64_TO_LE(value);
+    g_byte_array_append(array, (const guint8*) &value, sizeof(value));
+}
+
+static guint32
+get_u32(const guint8* bytes)
+{
+    guint32 value;
+    memcpy(&value, bytes, sizeof(value));
+    return GUINT32_FROM_LE(value);
+}
+
+static guint64
+get_u64(const guint8* bytes)
+{
+    guint64 value;
+    memcpy(&value, bytes, sizeof(value));
+    return GUINT64_FROM_LE(value);
+}
+
+/* ************* public functions ***************** */
+
+/**
+ * edf_trigger_index_new:(constructor)
+ *
+ * Create a new empty trigger index.
+ *
+ * Returns:(transfer full): a new #EdfTriggerIndex
+ */
+EdfTriggerIndex*
+edf_trigger_index_new(void)
+{
+    return g_object_new(EDF_TYPE_TRIGGER_INDEX, NULL);
+}
+
+/**
+ * edf_trigger_index_new_for_signal:(constructor)
+ * @signal: a trigger signal whose records are loaded in memory
+ * @record_duration: the duration of one record in seconds
+ *
+ * Creates an index of the changes of the trigger code in @signal.
+ *
+ * Returns:(transfer full): a new #EdfTriggerIndex
+ */
+EdfTriggerIndex*
+edf_trigger_index_new_for_signal(EdfSignal* signal, gdouble record_duration)
+{
+    g_return_val_if_fail(EDF_IS_SIGNAL(signal), NULL);
+    g_return_val_if_fail(record_duration > 0, NULL);
+
+    guint ns = edf_signal_get_num_samples_per_record(signal);
+    guint sample_size = edf_signal_get_sample_size(signal);
+    guint64 num_records = edf_signal_get_num_records(signal);
+
+    EdfTriggerIndex* index = g_object_new(
+            EDF_TYPE_TRIGGER_INDEX,
+            "sample-rate", ns / record_duration,
+            NULL
+            );
+
+    for (guint64 nrec = 0; nrec < num_records; nrec++) {
+        const guint8* bytes = edf_signal_get_record_bytes(signal, nrec);
+        trigger_index_scan_bytes(index, bytes, ns, sample_size);
+    }
+
+    return index;
+}
+
+/**
+ * edf_trigger_index_scan:(constructor)
+ * @path: the path of an edf or bdf file
+ * @error:(out): An error is returned here when the file cannot be read or
+ *               doesn't contain a trigger signal.
+ *
+ * Streams once through the file at @path and builds an index of the
+ * changes in its trigger signal. Only the header of the file is parsed
+ * the samples of the other signals are not decoded.
+ *
+ * Returns:(transfer full): a new #EdfTriggerIndex or NULL
+ */
+EdfTriggerIndex*
+edf_trigger_index_scan(const gchar* path, GError** error)
+{
+    g_return_val_if_fail(path != NULL, NULL);
+    g_return_val_if_fail(error != NULL && *error == NULL, NULL);
+
+    EdfTriggerIndex    *index = NULL;
+    EdfHeader          *header = NULL;
+    GPtrArray          *signals;
+    GFile              *file = g_file_new_for_path(path);
+    GInputStream       *istream = NULL;
+    guint8             *record = NULL;
+    gint64              num_records;
+    gdouble             duration;
+    gint                trigger;
+    gsize               trigger_offset = 0, record_size = 0;
+
+    istream = edf_file_open_input_stream(file, error);
+    if (!istream)
+        goto fail;
+
+    header = edf_header_new_from_input_stream(istream, error);
+    if (!header)
+        goto fail;
+
+    signals = edf_header_get_signals(header);
+    num_records = edf_header_get_declared_num_records(header);
+    duration = edf_header_get_record_duration(header);
+
+    trigger = find_trigger_signal(signals);
+    if (trigger < 0) {
+        g_set_error(
+                error,
+                EDF_TRIGGER_INDEX_ERROR,
+                EDF_TRIGGER_INDEX_ERROR_NO_TRIGGER_SIGNAL,
+                "'%s' doesn't contain a trigger signal",
+                path
+                );
+        goto fail;
+    }
+
+    for (guint i = 0; i < signals->len; i++) {
+        EdfSignal* signal = g_ptr_array_index(signals, i);
+        gsize size = (gsize) edf_signal_get_num_samples_per_record(signal) *
+                     edf_signal_get_sample_size(signal);
+        if (i == (guint) trigger)
+            trigger_offset = record_size;
+        record_size += size;
+    }
+
+    EdfSignal* trigsig = g_ptr_array_index(signals, trigger);
+    guint ns = edf_signal_get_num_samples_per_record(trigsig);
+    guint sample_size = edf_signal_get_sample_size(trigsig);
+
+    index = g_object_new(
+            EDF_TYPE_TRIGGER_INDEX,
+            "sample-rate", duration > 0 ? ns / duration : 0.0,
+            NULL
+            );
+
+    record = g_malloc(record_size);
+    // The number of records is -1 while a file is being recorded
+    for (gint64 nrec = 0; num_records < 0 || nrec < num_records; nrec++) {
+        gsize nread = 0;
+        if (!g_input_stream_read_all(
+                    istream,
+                    record,
+                    record_size,
+                    &nread,
+                    NULL,
+                    error
+                    )
+           )
+            goto fail;
+
+        if (nread < record_size) {
+            if (num_records < 0)
+                break;
+            g_set_error(
+                    error,
+                    EDF_TRIGGER_INDEX_ERROR,
+                    EDF_TRIGGER_INDEX_ERROR_FAILED,
+                    "'%s' is truncated after %" G_GINT64_FORMAT " records",
+                    path,
+                    nrec
+                    );
+            goto fail;
+        }
+        trigger_index_scan_bytes(index, &record[trigger_offset], ns, sample_size);
+    }
+
+    g_free(record);
+    g_object_unref(istream);
+    g_object_unref(file);
+    g_object_unref(header);
+    return index;
+
+fail:
+    g_free(record);
+    g_clear_object(&index);
+    g_clear_object(&istream);
+    g_object_unref(file);
+    g_clear_object(&header);
+    return NULL;
+}
+
+/**
+ * edf_trigger_index_new_for_path:(constructor)
+ * @path: the path of an edf or bdf file
+ * @error:(out): An error is returned here when no index can be made.
+ *
+ * Obtains the trigger index of the file at @path. When the sidecar file
+ * (see edf_trigger_index_sidecar_path()) exists and is up to date with
+ * the file at @path, the index is loaded from the sidecar. Otherwise the file
+ * is scanned with edf_trigger_index_scan() and the result is stored in the
+ * sidecar for the next time. Failing to write the sidecar isn't an error.
+ *
+ * Returns:(transfer full): a new #EdfTriggerIndex or NULL
+ */
+EdfTriggerIndex*
+edf_trigger_index_new_for_path(const gchar* path, GError** error)
+{
+    g_return_val_if_fail(path != NULL, NULL);
+    g_return_val_if_fail(error != NULL && *error == NULL, NULL);
+
+    GError* sidecar_error = NULL;
+    gchar* sidecar = edf_trigger_index_sidecar_path(path);
+
+    EdfTriggerIndex* index = edf_trigger_index_load(sidecar, path, &sidecar_error);
+    if (index) {
+        g_free(sidecar);
+        return index;
+    }
+    g_clear_error(&sidecar_error);
+
+    index = edf_trigger_index_scan(path, error);
+    if (index) {
+        edf_trigger_index_save(index, sidecar, path, &sidecar_error);
+        if (sidecar_error) {
+            g_debug("Unable to store trigger index: %s", sidecar_error->message);
+            g_clear_error(&sidecar_error);
+        }
+    }
+
+    g_free(sidecar);
+    return index;
+}
+
+/**
+ * edf_trigger_index_save:
+ * @index: the index to store
+ * @sidecar_path: the path of the sidecar file
+ * @source_path:(nullable): the path of the indexed file, its size and
+ *                          modification time are stored in the sidecar.
+ * @error:(out): An error is returned here when the sidecar cannot be written
+ *
+ * Stores @index in a compact binary sidecar file.
+ *
+ * Returns: TRUE when the sidecar was written.
+ */
+gboolean
+edf_trigger_index_save(
+        EdfTriggerIndex    *index,
+        const gchar        *sidecar_path,
+        const gchar        *source_path,
+        GError            **error
+        )
+{
+    g_return_val_if_fail(EDF_IS_TRIGGER_INDEX(index), FALSE);
+    g_return_val_if_fail(sidecar_path != NULL, FALSE);
+    g_return_val_if_fail(error != NULL && *error == NULL, FALSE);
+
+    EdfTriggerIndexPrivate* priv = edf_trigger_index_get_instance_private(index);
+    guint64 size = 0, mtime = 0, sample_rate;
+    guint32 mtime_usec = 0;
+    gboolean result;
+
+    if (source_path &&
+        !query_source_file(source_path, &size, &mtime, &mtime_usec, error))
+        return FALSE;
+
+    memcpy(&sample_rate, &priv->sample_rate, sizeof(sample_rate));
+
+    GByteArray* data = g_byte_array_sized_new(
+            SIDECAR_HEADER_SIZE + priv->events->len * SIDECAR_EVENT_SIZE
+            );
+    g_byte_array_append(data, (const guint8*) sidecar_magic, sizeof(sidecar_magic));
+    put_u64(data, size);
+    put_u64(data, mtime);
+    put_u32(data, mtime_usec);
+    put_u32(data, priv->code_mask);
+    put_u64(data, sample_rate);
+    put_u64(data, priv->events->len);
+    for (guint i = 0; i < priv->events->len; i++) {
+        EdfTriggerEvent* event = &g_array_index(priv->events, EdfTriggerEvent, i);
+        put_u64(data, event->sample);
+        put_u32(data, event->code);
+    }
+
+    result = g_file_set_contents(
+            sidecar_path, (const gchar*) data->data, data->len, error
+            );
+    g_byte_array_unref(data);
+    return result;
+}
+
+/**
+ * edf_trigger_index_load:(constructor)
+ * @sidecar_path: the path of a sidecar file made by edf_trigger_index_save()
+ * @source_path:(nullable): the path of the indexed file
+ * @error:(out): An error is returned here when the sidecar cannot be read
+ *
+ * Loads a trigger index from a sidecar file. When @source_path is given
+ * the sidecar is only accepted when the size and modification time of
+ * @source_path are equal to when the sidecar was written.
+ *
+ * Returns:(transfer full): a new #EdfTriggerIndex or NULL
+ */
+EdfTriggerIndex*
+edf_trigger_index_load(
+        const gchar    *sidecar_path,
+        const gchar    *source_path,
+        GError        **error
+        )
+{
+    g_return_val_if_fail(sidecar_path != NULL, NULL);
+    g_return_val_if_fail(error != NULL && *error == NULL, NULL);
+
+    gchar *contents = NULL;
+    gsize length = 0;
+    guint64 num_events, sample_rate;
+    gdouble rate;
+
+    if (!g_file_get_contents(sidecar_path, &contents, &length, error))
+        return NULL;
+
+    const guint8* bytes = (const guint8*) contents;
+    if (length < SIDECAR_HEADER_SIZE ||
+        memcmp(bytes, sidecar_magic, sizeof(sidecar_magic)) != 0)
+        goto invalid;
+
+    num_events = get_u64(&bytes[40]);
+    if (num_events > (length - SIDECAR_HEADER_SIZE) / SIDECAR_EVENT_SIZE ||
+        length != SIDECAR_HEADER_SIZE + num_events * SIDECAR_EVENT_SIZE)
+        goto invalid;
+
+    if (source_path) {
+        guint64 size, mtime;
+        guint32 mtime_usec;
+        if (!query_source_file(source_path, &size, &mtime, &mtime_usec, error)) {
+            g_free(contents);
+            return NULL;
+        }
+        if (size != get_u64(&bytes[8]) ||
+            mtime != get_u64(&bytes[16]) ||
+            mtime_usec != get_u32(&bytes[24])) {
+            g_set_error(
+                    error,
+                    EDF_TRIGGER_INDEX_ERROR,
+                    EDF_TRIGGER_INDEX_ERROR_SIDECAR,
+                    "'%s' is out of date with '%s'",
+                    sidecar_path,
+                    source_path
+                    );
+            g_free(contents);
+            return NULL;
+        }
+    }
+
+    sample_rate = get_u64(&bytes[32]);
+    memcpy(&rate, &sample_rate, sizeof(rate));
+
+    EdfTriggerIndex* index = g_object_new(
+            EDF_TYPE_TRIGGER_INDEX,
+            "code-mask", get_u32(&bytes[28]),
+            "sample-rate", rate,
+            NULL
+            );
+    EdfTriggerIndexPrivate* priv = edf_trigger_index_get_instance_private(index);
+
+    g_array_set_size(priv->events, num_events);
+    for (guint64 i = 0; i < num_events; i++) {
+        const guint8* ev = &bytes[SIDECAR_HEADER_SIZE + i * SIDECAR_EVENT_SIZE];
+        EdfTriggerEvent* event = &g_array_index(priv->events, EdfTriggerEvent, i);
+        event->sample = get_u64(ev);
+        event->code = get_u32(&ev[8]);
+    }
+
+    g_free(contents);
+    return index;
+
+invalid:
+    g_set_error(
+            error,
+            EDF_TRIGGER_INDEX_ERROR,
+            EDF_TRIGGER_INDEX_ERROR_SIDECAR,
+            "'%s' isn't a valid trigger index",
+            sidecar_path
+            );
+    g_free(contents);
+    return NULL;
+}
+
+/**
+ * edf_trigger_index_sidecar_path:
+ * @path: the path of an edf or bdf file
+ *
+ * Returns:(transfer full): the path of the sidecar of @path.
+ */
+gchar*
+edf_trigger_index_sidecar_path(const gchar* path)
+{
+    g_return_val_if_fail(path != NULL, NULL);
+    return g_strdup_printf("%s%s", path, SIDECAR_SUFFIX);
+}
+
+/**
+ * edf_trigger_index_get_num_events:
+ * @index: the #EdfTriggerIndex
+ *
+ * Returns: the number of changes of the trigger code
+ */
+guint
+edf_trigger_index_get_num_events(EdfTriggerIndex* index)
+{
+    g_return_val_if_fail(EDF_IS_TRIGGER_INDEX(index), 0);
+    EdfTriggerIndexPrivate* priv = edf_trigger_index_get_instance_private(index);
+    return priv->events->len;
+}
+
+/**
+ * edf_trigger_index_get_events:
+ * @index: the #EdfTriggerIndex
+ *
+ * Returns:(transfer none)(element-type EdfTriggerEvent): all the events
+ *         ordered by sample.
+ */
+GArray*
+edf_trigger_index_get_events(EdfTriggerIndex* index)
+{
+    g_return_val_if_fail(EDF_IS_TRIGGER_INDEX(index), NULL);
+    EdfTriggerIndexPrivate* priv = edf_trigger_index_get_instance_private(index);
+    return priv->events;
+}
+
+/**
+ * edf_trigger_index_get_sample_rate:
+ * @index: the #EdfTriggerIndex
+ *
+ * Returns: the sample rate of the indexed trigger signal
+ */
+gdouble
+edf_trigger_index_get_sample_rate(EdfTriggerIndex* index)
+{
+    g_return_val_if_fail(EDF_IS_TRIGGER_INDEX(index), 0);
+    EdfTriggerIndexPrivate* priv = edf_trigger_index_get_instance_private(index);
+    return priv->sample_rate;
+}
+
+/**
+ * edf_trigger_index_lookup:
+ * @index: the #EdfTriggerIndex
+ * @code: the trigger code to look for or #EDF_TRIGGER_ANY_CODE
+ * @first_sample: the first sample of the range
+ * @last_sample: the end of the range, this sample is not included
+ *
+ * Obtain the events with @code in the range [@first_sample, @last_sample).
+ *
+ * Returns:(transfer full)(element-type EdfTriggerEvent): the matching events
+ */
+GArray*
+edf_trigger_index_lookup(
+        EdfTriggerIndex    *index,
+        guint32             code,
+        guint64             first_sample,
+        guint64             last_sample
+        )
+{
+    g_return_val_if_fail(EDF_IS_TRIGGER_INDEX(index), NULL);
+    EdfTriggerIndexPrivate* priv = edf_trigger_index_get_instance_private(index);
+    GArray* result = g_array_new(FALSE, FALSE, sizeof(EdfTriggerEvent));
+
+    // binary search for the first event in range
+    guint low = 0, high = priv->events->len;
+    while (low < high) {
+        guint mid = low + (high - low) / 2;
+        if (g_array_index(priv->events, EdfTriggerEvent, mid).sample < first_sample)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    for (guint i = low; i < priv->events->len; i++) {
+        EdfTriggerEvent* event = &g_array_index(priv->events, EdfTriggerEvent, i);
+        if (event->sample >= last_sample)
+            break;
+        if (code == EDF_TRIGGER_ANY_CODE || event->code == code)
+            g_array_append_val(result, *event);
+    }
+    return result;
+}
+
+/**
+ * edf_trigger_index_lookup_time:
+ * @index: the #EdfTriggerIndex
+ * @code: the trigger code to look for or #EDF_TRIGGER_ANY_CODE
+ * @start: the start of the range in seconds
+ * @end: the end of the range in seconds, not included
+ *
+ * Obtain the events with @code in the range [@start, @end). The times are
+ * converted to samples using the #EdfTriggerIndex:sample-rate.
+ *
+ * Returns:(transfer full)(element-type EdfTriggerEvent): the matching events
+ */
+GArray*
+edf_trigger_index_lookup_time(
+        EdfTriggerIndex    *index,
+        guint32             code,
+        gdouble             start,
+        gdouble             end
+        )
+{
+    g_return_val_if_fail(EDF_IS_TRIGGER_INDEX(index), NULL);
+    EdfTriggerIndexPrivate* priv = edf_trigger_index_get_instance_private(index);
+
+    return edf_trigger_index_lookup(
+            index,
+            code,
+            time_to_sample(start, priv->sample_rate),
+            time_to_sample(end, priv->sample_rate)
+            );
+}
@@ -0,0 +1,275 @@
+
+#include <gedf.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "test-util.h"
+
+/* ******** global constants ********* */
+
+#define NUM_RECORDS     4
+
+static gchar g_catalog_dir[1024] = "";
+static gchar g_archive_dir[1024] = "";
+
+/* ******* utility functions ************ */
+
+static void
+write_file(const gchar* path, guint ns, gdouble record_duration)
+{
+    EdfSignal *cz = test_create_signal("Cz", "active electrode", 2, ns, -1000.0, 1000.0);
+    EdfSignal *resp = test_create_signal("Resp", "belt", 2, ns / 8, -10.0, 10.0);
+    EdfFile   *file = test_create_file(record_duration, cz, resp, NULL);
+
+    g_object_set(resp, "physical-dimension", "mV", NULL);
+    for (guint i = 0; i < ns * NUM_RECORDS; i++) {
+        test_append_digital(cz, i % 100);
+        if (i % 8 == 0)
+            test_append_digital(resp, 0);
+    }
+    test_write_file(file, path);
+
+    g_object_unref(cz);
+    g_object_unref(resp);
+    g_object_unref(file);
+}
+
+static gchar*
+archive_path(const gchar* name)
+{
+    return g_build_filename(g_archive_dir, name, NULL);
+}
+
+static EdfCatalog*
+scan_archive(guint expected_parsed, guint expected_skipped, guint expected_failed)
+{
+    GError* error = NULL;
+    guint parsed, skipped, failed;
+    EdfCatalog* catalog = edf_catalog_new();
+
+    g_object_set(catalog, "num-threads", 2, NULL);
+    edf_catalog_scan(catalog, g_archive_dir, &error);
+    g_assert_no_error(error);
+
+    g_object_get(
+            catalog,
+            "num-parsed", &parsed,
+            "num-skipped", &skipped,
+            "num-failed", &failed,
+            NULL
+            );
+    g_assert_cmpuint(parsed, ==, expected_parsed);
+    g_assert_cmpuint(skipped, ==, expected_skipped);
+    g_assert_cmpuint(failed, ==, expected_failed);
+    return catalog;
+}
+
+static int
+catalog_test_init(void)
+{
+    gchar template[1024] = "gedf_catalog_test_XXXXXX";
+    GError *error = NULL;
+    char *temp_dir = g_dir_make_tmp(template, &error);
+
+    if (error) {
+        g_printerr("Unable to open temp dir: %s\n", error->message);
+        g_error_free(error);
+        return -1;
+    }
+    g_snprintf(g_catalog_dir, sizeof(g_catalog_dir), "%s", temp_dir);
+    g_snprintf(g_archive_dir, sizeof(g_archive_dir), "%s/%s", temp_dir, "archive");
+    g_free(temp_dir);
+
+    gchar* session = g_build_filename(g_archive_dir, "subject1", "session1", NULL);
+    g_assert_cmpint(g_mkdir_with_parents(session, 0700), ==, 0);
+    g_free(session);
+
+    gchar* path = archive_path("subject1/session1/fast.edf");
+    write_file(path, 2048, 1.0);
+    g_free(path);
+
+    path = archive_path("slow.EDF");
+    write_file(path, 256, 2.0);
+    g_free(path);
+
+    // Neither of these belongs in the catalogue
+    path = archive_path("notes.txt");
+    g_file_set_contents(path, "not a recording", -1, &error);
+    g_assert_no_error(error);
+    g_free(path);
+
+    path = archive_path("broken.bdf");
+    g_file_set_contents(path, "0       truncated", -1, &error);
+    g_assert_no_error(error);
+    g_free(path);
+
+    return 0;
+}
+
+/* ******* tests ******** */
+
+static void
+catalog_scan(void)
+{
+    EdfCatalog* catalog = scan_archive(2, 0, 1);
+    gchar* path = archive_path("subject1/session1/fast.edf");
+
+    g_assert_cmpuint(edf_catalog_get_num_entries(catalog), ==, 2);
+
+    const EdfCatalogEntry* entry = edf_catalog_lookup(catalog, path);
+    g_assert_nonnull(entry);
+    g_assert_cmpfloat(entry->duration, ==, NUM_RECORDS);
+    g_assert_cmpuint(entry->num_channels, ==, 2);
+    g_assert_cmpstr(entry->channels[0].label, ==, "Cz");
+    g_assert_cmpstr(entry->channels[0].unit, ==, "uV");
+    g_assert_cmpfloat(entry->channels[0].sample_rate, ==, 2048);
+    g_assert_cmpstr(entry->channels[1].label, ==, "Resp");
+    g_assert_cmpfloat(entry->channels[1].sample_rate, ==, 256);
+
+    GPtrArray* found = edf_catalog_find(catalog, "Cz", 2048);
+    g_assert_cmpuint(found->len, ==, 1);
+    g_assert_true(g_ptr_array_index(found, 0) == entry);
+    g_ptr_array_unref(found);
+
+    found = edf_catalog_find(catalog, "Cz", 0);
+    g_assert_cmpuint(found->len, ==, 2);
+    g_ptr_array_unref(found);
+
+    g_free(path);
+    g_object_unref(catalog);
+}
+
+static void
+catalog_save_load(void)
+{
+    GError* error = NULL;
+    EdfCatalog* catalog = scan_archive(2, 0, 1);
+    gchar* catalog_path = g_build_filename(g_catalog_dir, "archive.cat", NULL);
+
+    edf_catalog_save(catalog, catalog_path, &error);
+    g_assert_no_error(error);
+
+    EdfCatalog* loaded = edf_catalog_load(catalog_path, &error);
+    g_assert_no_error(error);
+    g_assert_cmpuint(edf_catalog_get_num_entries(loaded), ==, 2);
+
+    for (guint i = 0; i < 2; i++) {
+        const EdfCatalogEntry* a = edf_catalog_get_entry(catalog, i);
+        const EdfCatalogEntry* b = edf_catalog_get_entry(loaded, i);
+        g_assert_cmpstr(a->path, ==, b->path);
+        g_assert_cmpint(a->mtime, ==, b->mtime);
+        g_assert_cmpuint(a->size, ==, b->size);
+        g_assert_cmpint(a->start_time, ==, b->start_time);
+        g_assert_cmpfloat(a->duration, ==, b->duration);
+        g_assert_cmpuint(a->num_channels, ==, b->num_channels);
+        for (guint c = 0; c < a->num_channels; c++) {
+            g_assert_cmpstr(a->channels[c].label, ==, b->channels[c].label);
+            g_assert_cmpstr(a->channels[c].unit, ==, b->channels[c].unit);
+            g_assert_cmpfloat(a->channels[c].sample_rate, ==, b->channels[c].sample_rate);
+        }
+    }
+
+    // Truncating the catalogue makes it invalid
+    gchar* contents = NULL;
+    gsize length = 0;
+    g_file_get_contents(catalog_path, &contents, &length, &error);
+    g_assert_no_error(error);
+    g_file_set_contents(catalog_path, contents, length - 3, &error);
+    g_assert_no_error(error);
+
+    g_assert_null(edf_catalog_load(catalog_path, &error));
+    g_assert_error(error, EDF_CATALOG_ERROR, EDF_CATALOG_ERROR_FORMAT);
+    g_clear_error(&error);
+
+    g_free(contents);
+    g_free(catalog_path);
+    g_object_unref(loaded);
+    g_object_unref(catalog);
+}
+
+static void
+catalog_rescan(void)
+{
+    GError* error = NULL;
+    EdfCatalog* catalog = scan_archive(2, 0, 1);
+    gchar* fast = archive_path("subject1/session1/fast.edf");
+    gchar* slow = archive_path("slow.EDF");
+
+    // Nothing changed, only the invalid file is parsed again
+    edf_catalog_scan(catalog, g_archive_dir, &error);
+    g_assert_no_error(error);
+
+    guint parsed, skipped;
+    g_object_get(catalog, "num-parsed", &parsed, "num-skipped", &skipped, NULL);
+    g_assert_cmpuint(parsed, ==, 0);
+    g_assert_cmpuint(skipped, ==, 2);
+
+    // Pretend fast.edf was modified and remove slow.EDF
+    GFile* file = g_file_new_for_path(fast);
+    g_file_set_attribute_uint64(
+            file,
+            G_FILE_ATTRIBUTE_TIME_MODIFIED,
+            edf_catalog_lookup(catalog, fast)->mtime / G_USEC_PER_SEC + 10,
+            G_FILE_QUERY_INFO_NONE,
+            NULL,
+            &error
+            );
+    g_assert_no_error(error);
+    g_object_unref(file);
+    g_assert_cmpint(g_remove(slow), ==, 0);
+
+    edf_catalog_scan(catalog, g_archive_dir, &error);
+    g_assert_no_error(error);
+    g_object_get(catalog, "num-parsed", &parsed, "num-skipped", &skipped, NULL);
+    g_assert_cmpuint(parsed, ==, 1);
+    g_assert_cmpuint(skipped, ==, 0);
+
+    g_assert_cmpuint(edf_catalog_get_num_entries(catalog), ==, 1);
+    g_assert_nonnull(edf_catalog_lookup(catalog, fast));
+    g_assert_null(edf_catalog_lookup(catalog, slow));
+
+    g_free(fast);
+    g_free(slow);
+    g_object_unref(catalog);
+}
+
+static void
+catalog_compressed_recording(void)
+{
+    GError *error = NULL;
+    gchar  *dir = g_build_filename(g_catalog_dir, "recording", NULL);
+    gchar  *path = g_build_filename(dir, "ongoing.edf.gz", NULL);
+
+    g_assert_cmpint(g_mkdir_with_parents(dir, 0700), ==, 0);
+
+    // A compressed file that doesn't state its number of records yet
+    EdfSignal* cz = test_create_signal("Cz", "active electrode", 2, 256, -1000.0, 1000.0);
+    EdfFile* file = test_create_file(1.0, cz, NULL);
+    edf_header_set_expected_num_records(edf_file_header(file), -1);
+    test_write_file(file, path);
+
+    EdfCatalog* catalog = edf_catalog_new();
+    edf_catalog_scan(catalog, dir, &error);
+    g_assert_no_error(error);
+
+    const EdfCatalogEntry* entry = edf_catalog_lookup(catalog, path);
+    g_assert_nonnull(entry);
+    g_assert_cmpfloat(entry->duration, ==, -1);
+    g_assert_cmpfloat(entry->channels[0].sample_rate, ==, 256);
+
+    g_object_unref(catalog);
+    g_object_unref(cz);
+    g_object_unref(file);
+    g_free(path);
+    g_free(dir);
+}
+
+void add_catalog_suite(void)
+{
+    g_assert_true(catalog_test_init() == 0);
+
+    g_test_add_func("/EdfCatalog/scan", catalog_scan);
+    g_test_add_func("/EdfCatalog/save_load", catalog_save_load);
+    g_test_add_func("/EdfCatalog/rescan", catalog_rescan);
+    g_test_add_func("/EdfCatalog/compressed_recording", catalog_compressed_recording);
+}
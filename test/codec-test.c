@@ -0,0 +1,363 @@
+
+#include <gedf.h>
+#include <glib.h>
+#include <math.h>
+#include <string.h>
+
+#include "test-util.h"
+
+/* ******** global constants ********* */
+
+#define NS              250
+#define NS_SLOW         3
+#define NUM_RECORDS     8
+#define AMPLITUDE       100000.0
+
+static gchar g_codec_dir[1024] = "";
+static gchar g_bdf_file[1024] = "";
+static gchar g_edf_file[1024] = "";
+
+/* ******* utility functions ************ */
+
+// A smooth signal, the codec should store it in much less than 24 bits
+static gint
+sine_value(guint64 sample, guint sample_size)
+{
+    gdouble amplitude = sample_size == 3 ? AMPLITUDE : AMPLITUDE / 8;
+    return (gint) round(amplitude * sin(sample * 0.01));
+}
+
+// An irregular signal that still spans the whole 16 bit range
+static gint
+noise_value(guint64 sample)
+{
+    return (gint) ((sample * 2654435761u) >> 16 & 0xffff) - 32768;
+}
+
+static void
+write_file(const gchar* path, guint sample_size)
+{
+    EdfSignal *sine = test_create_signal(
+            "sine", "active electrode", sample_size, NS, -262144.0, 262143.0
+            );
+    EdfSignal *noise = test_create_signal(
+            "noise", "active electrode", 2, NS, -262144.0, 262143.0
+            );
+    EdfSignal *slow = test_create_signal(
+            "slow", "active electrode", sample_size, NS_SLOW, -262144.0, 262143.0
+            );
+    EdfFile   *file = sample_size == 2 ?
+            test_create_file(1.0, sine, noise, slow, NULL) :
+            test_create_file(1.0, sine, slow, NULL);
+
+    for (guint64 i = 0; i < NS * NUM_RECORDS; i++) {
+        test_append_digital(sine, sine_value(i, sample_size));
+        if (sample_size == 2)
+            test_append_digital(noise, noise_value(i));
+        if (i < NS_SLOW * NUM_RECORDS)
+            test_append_digital(slow, (gint) i - 10);
+    }
+    test_write_file(file, path);
+
+    g_object_unref(sine);
+    g_object_unref(noise);
+    g_object_unref(slow);
+    g_object_unref(file);
+}
+
+static gchar*
+temp_path(const gchar* name)
+{
+    return g_build_filename(g_codec_dir, name, NULL);
+}
+
+static void
+assert_equal_files(const gchar* path1, const gchar* path2)
+{
+    GError *error = NULL;
+    gchar  *contents1 = NULL, *contents2 = NULL;
+    gsize   size1 = 0, size2 = 0;
+
+    g_file_get_contents(path1, &contents1, &size1, &error);
+    g_assert_no_error(error);
+    g_file_get_contents(path2, &contents2, &size2, &error);
+    g_assert_no_error(error);
+
+    g_assert_cmpmem(contents1, size1, contents2, size2);
+
+    g_free(contents1);
+    g_free(contents2);
+}
+
+static goffset
+file_size(const gchar* path)
+{
+    GFile* file = g_file_new_for_path(path);
+    GFileInfo* info = g_file_query_info(
+            file, G_FILE_ATTRIBUTE_STANDARD_SIZE, G_FILE_QUERY_INFO_NONE, NULL, NULL
+            );
+    g_assert_nonnull(info);
+    goffset size = g_file_info_get_size(info);
+    g_object_unref(info);
+    g_object_unref(file);
+    return size;
+}
+
+static void
+round_trip(const gchar* source, const gchar* container, const gchar* restored)
+{
+    GError* error = NULL;
+
+    edf_codec_compress(source, container, &error);
+    g_assert_no_error(error);
+
+    edf_codec_decompress(container, restored, &error);
+    g_assert_no_error(error);
+
+    assert_equal_files(source, restored);
+}
+
+static int
+codec_test_init(void)
+{
+    gchar template[1024] = "gedf_codec_test_XXXXXX";
+    GError *error = NULL;
+    char *temp_dir = g_dir_make_tmp(template, &error);
+
+    if (error) {
+        g_printerr("Unable to open temp dir: %s\n", error->message);
+        g_error_free(error);
+        return -1;
+    }
+    g_snprintf(g_codec_dir, sizeof(g_codec_dir), "%s", temp_dir);
+    g_snprintf(g_bdf_file, sizeof(g_bdf_file), "%s/%s", temp_dir, "codec.bdf");
+    g_snprintf(g_edf_file, sizeof(g_edf_file), "%s/%s", temp_dir, "codec.edf");
+    g_free(temp_dir);
+
+    write_file(g_bdf_file, 3);
+    write_file(g_edf_file, 2);
+    return 0;
+}
+
+/* ******* tests ******** */
+
+static void
+codec_round_trip(void)
+{
+    gchar* container = temp_path("round-trip.bdfz");
+    gchar* restored = temp_path("round-trip.bdf");
+
+    round_trip(g_bdf_file, container, restored);
+    // The smooth 24 bit signal dominates, so it should shrink considerably
+    g_assert_cmpint(file_size(container), <, file_size(g_bdf_file) / 2);
+
+    round_trip(g_edf_file, container, restored);
+    g_assert_cmpint(file_size(container), <, file_size(g_edf_file));
+
+    g_free(container);
+    g_free(restored);
+}
+
+static void
+codec_trailing_bytes(void)
+{
+    GError *error = NULL;
+    gchar  *contents = NULL;
+    gsize   size = 0;
+    gchar  *truncated = temp_path("truncated.edf");
+    gchar  *container = temp_path("truncated.edfz");
+    gchar  *restored = temp_path("truncated-restored.edf");
+
+    // A partial last record must survive as well
+    g_file_get_contents(g_edf_file, &contents, &size, &error);
+    g_assert_no_error(error);
+    g_file_set_contents(truncated, contents, size - 101, &error);
+    g_assert_no_error(error);
+
+    round_trip(truncated, container, restored);
+
+    g_free(contents);
+    g_free(truncated);
+    g_free(container);
+    g_free(restored);
+}
+
+static void
+codec_edf_file(void)
+{
+    GError *error = NULL;
+    gchar  *container = temp_path("file.bdfz");
+    gchar  *written = temp_path("written.bdfz");
+    gchar  *restored = temp_path("written.bdf");
+
+    edf_codec_compress(g_bdf_file, container, &error);
+    g_assert_no_error(error);
+
+    // EdfFile reads the container as if it were the original
+    EdfFile* file = edf_file_new_for_path(container);
+    edf_file_read(file, &error);
+    g_assert_no_error(error);
+
+    GPtrArray* signals = edf_file_get_signals(file);
+    g_assert_cmpuint(signals->len, ==, 2);
+    GArray* values = edf_signal_get_values(g_ptr_array_index(signals, 0));
+    g_assert_cmpuint(values->len, ==, NS * NUM_RECORDS);
+    g_array_unref(values);
+
+    // and writes a container because of the name
+    edf_file_set_path(file, written);
+    edf_file_replace(file, &error);
+    g_assert_no_error(error);
+
+    edf_codec_decompress(written, restored, &error);
+    g_assert_no_error(error);
+    assert_equal_files(g_bdf_file, restored);
+
+    g_object_unref(file);
+    g_free(container);
+    g_free(written);
+    g_free(restored);
+}
+
+static void
+codec_read_range(void)
+{
+    GError *error = NULL;
+    gchar  *container = temp_path("range.bdfz");
+    gint32  samples[NS * 3];
+
+    edf_codec_compress(g_bdf_file, container, &error);
+    g_assert_no_error(error);
+
+    EdfCodecReader* reader = edf_codec_reader_new_for_path(container, &error);
+    g_assert_no_error(error);
+    g_assert_cmpuint(edf_codec_reader_get_num_records(reader), ==, NUM_RECORDS);
+    g_assert_nonnull(edf_codec_reader_get_header(reader));
+
+    // A range that spans parts of three records
+    const guint64 first = NS * 2 + 17;
+    edf_codec_reader_read_range(reader, 0, first, samples, G_N_ELEMENTS(samples), &error);
+    g_assert_no_error(error);
+    for (gsize i = 0; i < G_N_ELEMENTS(samples); i++)
+        g_assert_cmpint(samples[i], ==, sine_value(first + i, 3));
+
+    edf_codec_reader_read_range(reader, 1, 0, samples, NS_SLOW * NUM_RECORDS, &error);
+    g_assert_no_error(error);
+    for (gint i = 0; i < NS_SLOW * NUM_RECORDS; i++)
+        g_assert_cmpint(samples[i], ==, i - 10);
+
+    edf_codec_reader_read_range(reader, 1, 1, samples, NS_SLOW * NUM_RECORDS, &error);
+    g_assert_error(error, EDF_CODEC_ERROR, EDF_CODEC_ERROR_RANGE);
+    g_clear_error(&error);
+
+    edf_codec_reader_read_range(reader, 2, 0, samples, 1, &error);
+    g_assert_error(error, EDF_CODEC_ERROR, EDF_CODEC_ERROR_RANGE);
+    g_clear_error(&error);
+
+    g_object_unref(reader);
+    g_free(container);
+}
+
+static void
+codec_errors(void)
+{
+    GError* error = NULL;
+
+    EdfCodecReader* reader = edf_codec_reader_new_for_path(g_edf_file, &error);
+    g_assert_null(reader);
+    g_assert_error(error, EDF_CODEC_ERROR, EDF_CODEC_ERROR_FORMAT);
+    g_clear_error(&error);
+
+    gchar* restored = temp_path("not-a-container.edf");
+    edf_codec_decompress(g_edf_file, restored, &error);
+    g_assert_error(error, EDF_CODEC_ERROR, EDF_CODEC_ERROR_FORMAT);
+    g_clear_error(&error);
+    g_free(restored);
+}
+
+/*
+ * Writes a copy of the container at source with value stored at offset,
+ * a negative offset counts from the end.
+ */
+static gchar*
+write_corrupt_copy(const gchar* source, const gchar* name, goffset offset, guint64 value)
+{
+    GError *error = NULL;
+    gchar  *contents = NULL;
+    gsize   size = 0;
+    gchar  *path = temp_path(name);
+
+    g_file_get_contents(source, &contents, &size, &error);
+    g_assert_no_error(error);
+    if (offset < 0)
+        offset += size;
+
+    value = GUINT64_TO_LE(value);
+    memcpy(&contents[offset], &value, sizeof(value));
+    g_file_set_contents(path, contents, size, &error);
+    g_assert_no_error(error);
+
+    g_free(contents);
+    return path;
+}
+
+static void
+codec_corrupt(void)
+{
+    GError *error = NULL;
+    gchar  *container = temp_path("corrupt.edfz");
+    gchar  *restored = temp_path("corrupt.edf");
+    gint32  sample;
+    guint32 header_size;
+
+    edf_codec_compress(g_edf_file, container, &error);
+    g_assert_no_error(error);
+
+    // The index offset of the footer points far beyond the end of the file
+    gchar* bad_index = write_corrupt_copy(
+            container, "bad-index.edfz", -32, G_GUINT64_CONSTANT(1) << 40
+            );
+    EdfCodecReader* reader = edf_codec_reader_new_for_path(bad_index, &error);
+    g_assert_null(reader);
+    g_assert_error(error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA);
+    g_clear_error(&error);
+
+    // The size of the first block is larger than the file
+    gchar* contents = NULL;
+    g_file_get_contents(container, &contents, NULL, &error);
+    g_assert_no_error(error);
+    memcpy(&header_size, &contents[8], sizeof(header_size));
+    header_size = GUINT32_FROM_LE(header_size);
+    g_free(contents);
+
+    gchar* bad_block = write_corrupt_copy(
+            container, "bad-block.edfz", 16 + header_size, 0xfffffff0
+            );
+    edf_codec_decompress(bad_block, restored, &error);
+    g_assert_error(error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA);
+    g_clear_error(&error);
+
+    reader = edf_codec_reader_new_for_path(bad_block, &error);
+    g_assert_no_error(error);
+    edf_codec_reader_read_range(reader, 0, 0, &sample, 1, &error);
+    g_assert_error(error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA);
+    g_clear_error(&error);
+
+    g_object_unref(reader);
+    g_free(bad_index);
+    g_free(bad_block);
+    g_free(container);
+    g_free(restored);
+}
+
+void add_codec_suite(void)
+{
+    g_assert_true(codec_test_init() == 0);
+
+    g_test_add_func("/EdfCodec/round_trip", codec_round_trip);
+    g_test_add_func("/EdfCodec/trailing_bytes", codec_trailing_bytes);
+    g_test_add_func("/EdfCodec/edf_file", codec_edf_file);
+    g_test_add_func("/EdfCodec/read_range", codec_read_range);
+    g_test_add_func("/EdfCodec/errors", codec_errors);
+    g_test_add_func("/EdfCodec/corrupt", codec_corrupt);
+}
@@ -0,0 +1,193 @@
+
+#include <gedf.h>
+#include <glib.h>
+
+#include "test-util.h"
+
+/* ******** global constants ********* */
+
+#define NS              64
+#define NUM_SAMPLES     1000    // the last record is incomplete
+#define NUM_THREADS     8
+#define NUM_ITERATIONS  50
+#define SAMPLE_RANGE    1000
+
+/* ******* utility functions ************ */
+
+static EdfFile*
+create_frozen_file(void)
+{
+    EdfFile* file = edf_file_new();
+
+    for (guint s = 0; s < 2; s++) {
+        EdfSignal* signal = edf_signal_new_full(
+                s ? "Cz" : "Fz", "electrode", "uV",
+                -100.0, 100.0, -SAMPLE_RANGE, SAMPLE_RANGE, "", NS
+                );
+        // The second signal is the first one a sample ahead
+        for (guint i = 0; i < NUM_SAMPLES; i++)
+            test_append_digital(signal, test_sample_value(0, i + s, SAMPLE_RANGE));
+        edf_file_add_signal(file, signal);
+        g_object_unref(signal);
+    }
+
+    edf_file_freeze(file);
+    return file;
+}
+
+/*
+ * Reads all signals of a shared frozen file in several ways, a thread
+ * compares everything with what it expects.
+ */
+static gpointer
+read_file(gpointer data)
+{
+    EdfFile* file = data;
+    GPtrArray* signals = edf_file_get_signals(file);
+    gdouble values[100];
+
+    for (guint it = 0; it < NUM_ITERATIONS; it++) {
+        EdfSignal* signal = g_ptr_array_index(signals, it % signals->len);
+        guint s = it % signals->len;
+        gdouble gain = edf_signal_get_gain(signal);
+        gdouble offset = edf_signal_get_offset(signal);
+        EdfSignalCursor cursor;
+        guint64 position = (it * 37) % NUM_SAMPLES;
+        gsize n;
+
+        edf_signal_cursor_init(&cursor, signal);
+        g_assert_true(edf_signal_cursor_seek(&cursor, position));
+        while ((n = edf_signal_cursor_read(&cursor, values, G_N_ELEMENTS(values)))) {
+            for (gsize i = 0; i < n; i++)
+                g_assert_cmpfloat_with_epsilon(
+                        values[i],
+                        gain * test_sample_value(0, position + i + s, SAMPLE_RANGE) + offset,
+                        1e-9
+                        );
+            position += n;
+        }
+        g_assert_cmpuint(position, ==, NUM_SAMPLES);
+        edf_signal_cursor_clear(&cursor);
+
+        GArray* all = edf_signal_get_values(signal);
+        g_assert_cmpuint(all->len, >=, NUM_SAMPLES);
+        g_array_unref(all);
+
+        EdfSignalStats stats;
+        edf_signal_compute_stats(signal, &stats);
+        g_assert_cmpuint(stats.num_samples, ==, NUM_SAMPLES);
+
+        EdfHeader* header = edf_file_header(file);
+        g_assert_cmpint(edf_header_get_num_records(header), ==,
+                        (NUM_SAMPLES + NS - 1) / NS);
+    }
+    return NULL;
+}
+
+/* ******* tests ******** */
+
+static void
+cursor_read(void)
+{
+    EdfFile* file = create_frozen_file();
+    EdfSignal* signal = g_ptr_array_index(edf_file_get_signals(file), 0);
+    EdfSignalCursor cursor;
+    gint32 digital[NUM_SAMPLES + 10];
+
+    edf_signal_cursor_init(&cursor, signal);
+    g_assert_cmpuint(edf_signal_cursor_get_num_samples(&cursor), ==, NUM_SAMPLES);
+
+    // Reads cross the boundaries of the records
+    gsize total = 0, n;
+    while ((n = edf_signal_cursor_read_digital(&cursor, &digital[total], NS + 3)))
+        total += n;
+    g_assert_cmpuint(total, ==, NUM_SAMPLES);
+    g_assert_cmpuint(edf_signal_cursor_get_position(&cursor), ==, NUM_SAMPLES);
+    for (guint i = 0; i < NUM_SAMPLES; i++)
+        g_assert_cmpint(digital[i], ==, test_sample_value(0, i, SAMPLE_RANGE));
+
+    edf_signal_cursor_clear(&cursor);
+    g_object_unref(file);
+}
+
+static void
+cursor_seek(void)
+{
+    EdfFile* file = create_frozen_file();
+    EdfSignal* signal = g_ptr_array_index(edf_file_get_signals(file), 1);
+    EdfSignalCursor cursor;
+    gdouble values[NS];
+
+    edf_signal_cursor_init(&cursor, signal);
+    g_assert_true(edf_signal_cursor_seek(&cursor, NUM_SAMPLES - 10));
+    g_assert_cmpuint(edf_signal_cursor_read(&cursor, values, NS), ==, 10);
+    g_assert_cmpfloat_with_epsilon(
+            values[9],
+            edf_signal_get_gain(signal) * test_sample_value(0, NUM_SAMPLES, SAMPLE_RANGE) +
+                edf_signal_get_offset(signal),
+            1e-9
+            );
+    g_assert_cmpuint(edf_signal_cursor_read(&cursor, values, NS), ==, 0);
+
+    g_assert_true(edf_signal_cursor_seek(&cursor, NUM_SAMPLES));
+    g_assert_false(edf_signal_cursor_seek(&cursor, NUM_SAMPLES + 1));
+    g_assert_cmpuint(edf_signal_cursor_get_position(&cursor), ==, NUM_SAMPLES);
+
+    edf_signal_cursor_clear(&cursor);
+    g_object_unref(file);
+}
+
+static void
+cursor_frozen(void)
+{
+    GError* error = NULL;
+    EdfFile* file = create_frozen_file();
+    EdfSignal* signal = g_ptr_array_index(edf_file_get_signals(file), 0);
+
+    g_assert_true(edf_file_is_frozen(file));
+    g_assert_true(edf_signal_is_frozen(signal));
+
+    g_test_expect_message(G_LOG_DOMAIN, G_LOG_LEVEL_CRITICAL, "*signal_is_mutable*");
+    edf_signal_append_digital(signal, 0, &error);
+    g_test_assert_expected_messages();
+    g_assert_no_error(error);
+
+    g_test_expect_message(G_LOG_DOMAIN, G_LOG_LEVEL_CRITICAL, "*header_is_mutable*");
+    edf_header_set_patient(edf_file_header(file), "X");
+    g_test_assert_expected_messages();
+
+    g_test_expect_message(G_LOG_DOMAIN, G_LOG_LEVEL_CRITICAL, "*file_is_mutable*");
+    edf_file_add_signal(file, signal);
+    g_test_assert_expected_messages();
+
+    g_assert_cmpuint(edf_signal_get_num_records(signal), ==, (NUM_SAMPLES + NS - 1) / NS);
+    g_assert_cmpuint(edf_file_get_num_signals(file), ==, 2);
+    g_object_unref(file);
+}
+
+/*
+ * Many threads read one frozen file at the same time. Configure with
+ * -Dbuild-tsan-test=true and run "meson test --suite tsan" to have data
+ * races reported.
+ */
+static void
+cursor_concurrent(void)
+{
+    EdfFile* file = create_frozen_file();
+    GThread* threads[NUM_THREADS];
+
+    for (guint i = 0; i < NUM_THREADS; i++)
+        threads[i] = g_thread_new("reader", read_file, file);
+    for (guint i = 0; i < NUM_THREADS; i++)
+        g_thread_join(threads[i]);
+
+    g_object_unref(file);
+}
+
+void add_cursor_suite(void)
+{
+    g_test_add_func("/EdfSignalCursor/read", cursor_read);
+    g_test_add_func("/EdfSignalCursor/seek", cursor_seek);
+    g_test_add_func("/EdfSignalCursor/frozen", cursor_frozen);
+    g_test_add_func("/EdfSignalCursor/concurrent", cursor_concurrent);
+}
@@ -0,0 +1,231 @@
+
+#include <gedf.h>
+#include <glib.h>
+#include <math.h>
+
+#include "test-util.h"
+
+/* ******** global constants ********* */
+
+#define NS              100
+#define NUM_RECORDS     10
+#define RAMP_PERIOD     1000
+#define CONST_VALUE     5
+
+static gchar g_epoch_file[1024] = "";
+
+/* ******* utility functions ************ */
+
+static void
+write_file(const gchar* path)
+{
+    // With equal physical and digital ranges physical values equal digital ones
+    EdfSignal *ramp = test_create_signal("ramp", "active electrode", 2, NS, -32768.0, 32767.0);
+    EdfSignal *slow = test_create_signal("slow", "active electrode", 2, NS / 2, -32768.0, 32767.0);
+    EdfSignal *constant = test_create_signal("const", "active electrode", 2, NS, -32768.0, 32767.0);
+    EdfFile   *file = test_create_file(1.0, ramp, slow, constant, NULL);
+
+    for (gint i = 0; i < NS * NUM_RECORDS; i++) {
+        test_append_digital(ramp, i % RAMP_PERIOD);
+        test_append_digital(constant, CONST_VALUE);
+        if (i % 2 == 0)
+            test_append_digital(slow, -1);
+    }
+    test_write_file(file, path);
+
+    g_object_unref(ramp);
+    g_object_unref(slow);
+    g_object_unref(constant);
+    g_object_unref(file);
+}
+
+static EdfEpocher*
+create_epocher(void)
+{
+    GError* error = NULL;
+    const gchar* labels[] = {"ramp", "const", NULL};
+
+    EdfEpocher* epocher = edf_epocher_new_for_path(g_epoch_file, &error);
+    g_assert_no_error(error);
+
+    edf_epocher_select_channels_by_label(epocher, labels, &error);
+    g_assert_no_error(error);
+    g_assert_cmpuint(edf_epocher_get_num_channels(epocher), ==, 2);
+
+    return epocher;
+}
+
+static int
+epocher_test_init(void)
+{
+    gchar template[1024] = "gedf_epocher_test_XXXXXX";
+    GError *error = NULL;
+    char *temp_dir = g_dir_make_tmp(template, &error);
+
+    if (error) {
+        g_printerr("Unable to open temp dir: %s\n", error->message);
+        g_error_free(error);
+        return -1;
+    }
+    g_snprintf(g_epoch_file, sizeof(g_epoch_file), "%s/%s", temp_dir, "epochs.edf");
+    g_free(temp_dir);
+
+    write_file(g_epoch_file);
+    return 0;
+}
+
+/* ******* tests ******** */
+
+static void
+epocher_extract(void)
+{
+    GError *error = NULL;
+    EdfEpocher* epocher = create_epocher();
+    // The first window spans three records.
+    const guint64 events[] = {150, 520, 990};
+    const guint pre = 60, post = 100;
+
+    edf_epocher_set_window(epocher, pre, post);
+    g_assert_cmpuint(edf_epocher_get_num_samples(epocher), ==, pre + post);
+
+    gsize size = edf_epocher_get_tensor_size(epocher, G_N_ELEMENTS(events));
+    g_assert_cmpuint(size, ==, G_N_ELEMENTS(events) * 2 * (pre + post));
+    gfloat* tensor = g_new(gfloat, size);
+
+    edf_epocher_extract(epocher, events, G_N_ELEMENTS(events), tensor, size, &error);
+    g_assert_no_error(error);
+
+    for (gsize e = 0; e < G_N_ELEMENTS(events); e++) {
+        gfloat* ramp = tensor + (e * 2 + 0) * (pre + post);
+        gfloat* constant = tensor + (e * 2 + 1) * (pre + post);
+        for (guint i = 0; i < pre + post; i++) {
+            gint64 sample = (gint64) events[e] - pre + i;
+            if (sample >= NS * NUM_RECORDS) {
+                g_assert_true(isnan(ramp[i]));
+                g_assert_true(isnan(constant[i]));
+                continue;
+            }
+            g_assert_cmpfloat(ramp[i], ==, sample % RAMP_PERIOD);
+            g_assert_cmpfloat(constant[i], ==, CONST_VALUE);
+        }
+    }
+
+    g_free(tensor);
+    g_object_unref(epocher);
+}
+
+static void
+epocher_outside(void)
+{
+    GError *error = NULL;
+    EdfEpocher* epocher = create_epocher();
+    const guint64 events[] = {10, 5000};
+    const guint pre = 20, post = 20;
+
+    edf_epocher_set_window(epocher, pre, post);
+    gsize size = edf_epocher_get_tensor_size(epocher, G_N_ELEMENTS(events));
+    gfloat* tensor = g_new(gfloat, size);
+
+    edf_epocher_extract(epocher, events, G_N_ELEMENTS(events), tensor, size, &error);
+    g_assert_no_error(error);
+
+    // The first 10 samples precede the recording
+    for (guint i = 0; i < pre + post; i++) {
+        if (i < 10)
+            g_assert_true(isnan(tensor[i]));
+        else
+            g_assert_cmpfloat(tensor[i], ==, i - 10);
+    }
+
+    // The second window is beyond the end of the recording
+    for (gsize i = 2 * (pre + post); i < size; i++)
+        g_assert_true(isnan(tensor[i]));
+
+    g_free(tensor);
+    g_object_unref(epocher);
+}
+
+static void
+epocher_baseline(void)
+{
+    GError *error = NULL;
+    EdfEpocher* epocher = create_epocher();
+    const guint64 events[] = {200};
+    const guint pre = 10, post = 10;
+
+    edf_epocher_set_window(epocher, pre, post);
+    edf_epocher_set_baseline(epocher, -10, 0);
+
+    gsize size = edf_epocher_get_tensor_size(epocher, G_N_ELEMENTS(events));
+    gfloat* tensor = g_new(gfloat, size);
+
+    edf_epocher_extract(epocher, events, G_N_ELEMENTS(events), tensor, size, &error);
+    g_assert_no_error(error);
+
+    // The mean of the ramp over [190, 200) is 194.5
+    for (guint i = 0; i < pre + post; i++) {
+        g_assert_cmpfloat_with_epsilon(tensor[i], 190 + i - 194.5, 1e-4);
+        g_assert_cmpfloat(tensor[pre + post + i], ==, 0);
+    }
+
+    // A baseline outside of the window is an error
+    edf_epocher_set_baseline(epocher, -20, 0);
+    edf_epocher_extract(epocher, events, G_N_ELEMENTS(events), tensor, size, &error);
+    g_assert_error(error, EDF_EPOCHER_ERROR, EDF_EPOCHER_ERROR_WINDOW);
+    g_clear_error(&error);
+
+    g_free(tensor);
+    g_object_unref(epocher);
+}
+
+static void
+epocher_errors(void)
+{
+    GError *error = NULL;
+    const guint64 events[] = {200};
+    gfloat tensor[8];
+
+    // The channels differ in sample rate, so none are selected by default.
+    EdfEpocher* epocher = edf_epocher_new_for_path(g_epoch_file, &error);
+    g_assert_no_error(error);
+    g_assert_cmpuint(edf_epocher_get_num_channels(epocher), ==, 0);
+
+    edf_epocher_set_window(epocher, 2, 2);
+    edf_epocher_extract(epocher, events, 1, tensor, G_N_ELEMENTS(tensor), &error);
+    g_assert_error(error, EDF_EPOCHER_ERROR, EDF_EPOCHER_ERROR_CHANNEL);
+    g_clear_error(&error);
+
+    const guint mixed[] = {0, 1};
+    edf_epocher_select_channels(epocher, mixed, G_N_ELEMENTS(mixed), &error);
+    g_assert_error(error, EDF_EPOCHER_ERROR, EDF_EPOCHER_ERROR_SAMPLE_RATE);
+    g_clear_error(&error);
+
+    const gchar* unknown[] = {"ramp", "Cz", NULL};
+    edf_epocher_select_channels_by_label(epocher, unknown, &error);
+    g_assert_error(error, EDF_EPOCHER_ERROR, EDF_EPOCHER_ERROR_CHANNEL);
+    g_clear_error(&error);
+
+    const guint channels[] = {0, 2};
+    edf_epocher_select_channels(epocher, channels, G_N_ELEMENTS(channels), &error);
+    g_assert_no_error(error);
+
+    // 1 event * 2 channels * 4 samples fits, 2 * 2 * 4 doesn't
+    edf_epocher_extract(epocher, events, 1, tensor, G_N_ELEMENTS(tensor), &error);
+    g_assert_no_error(error);
+    edf_epocher_set_window(epocher, 4, 4);
+    edf_epocher_extract(epocher, events, 1, tensor, G_N_ELEMENTS(tensor), &error);
+    g_assert_error(error, EDF_EPOCHER_ERROR, EDF_EPOCHER_ERROR_TENSOR_SIZE);
+    g_clear_error(&error);
+
+    g_object_unref(epocher);
+}
+
+void add_epocher_suite(void)
+{
+    g_assert_true(epocher_test_init() == 0);
+
+    g_test_add_func("/EdfEpocher/extract", epocher_extract);
+    g_test_add_func("/EdfEpocher/outside", epocher_outside);
+    g_test_add_func("/EdfEpocher/baseline", epocher_baseline);
+    g_test_add_func("/EdfEpocher/errors", epocher_errors);
+}
@@ -2,7 +2,9 @@
 #include <gedf.h>
 #include <locale.h>
 #include <glib.h>
+#include <glib/gstdio.h>
 #include <time.h>
+#include <string.h>
 #include <math.h>
 
 /* ************ declarations ********** */
@@ -430,7 +432,7 @@ file_open_reading(FileFixture* fixture, gconstpointer unused)
     GDateTime   *date = NULL;
     unsigned int expected_header_size;
     char        *reserved = NULL;
-    int          num_records;
+    gint64       num_records;
     double       dur_record;
     unsigned int num_signals;
 
@@ -472,6 +474,274 @@ file_open_reading(FileFixture* fixture, gconstpointer unused)
         g_date_time_unref(date);
 }
 
+static void
+file_gzip(FileFixture* fixture, gconstpointer unused)
+{
+    (void) unused;
+    GError  *error = NULL;
+    gchar   *gz_path = g_strdup_printf("%s.gz", g_temp_file);
+    gchar   *contents = NULL;
+    gsize    length = 0;
+    EdfFile *file;
+
+    edf_file_set_path(fixture->file, gz_path);
+    edf_file_replace(fixture->file, &error);
+    g_assert_no_error(error);
+
+    g_file_get_contents(gz_path, &contents, &length, &error);
+    g_assert_no_error(error);
+    g_assert_cmpuint(length, >, 2);
+    g_assert_cmpuint((guint8) contents[0], ==, 0x1f);
+    g_assert_cmpuint((guint8) contents[1], ==, 0x8b);
+
+    file = edf_file_new_for_path(gz_path);
+    edf_file_read(file, &error);
+    g_assert_no_error(error);
+
+    g_assert_true(check_signal_equality(file, fixture->file));
+
+    GPtrArray* sigs_in = edf_file_get_signals(file);
+    GPtrArray* sigs_out = edf_file_get_signals(fixture->file);
+    for (guint i = 0; i < sigs_in->len; i++) {
+        GArray* values_in = edf_signal_get_values(g_ptr_array_index(sigs_in, i));
+        GArray* values_out = edf_signal_get_values(g_ptr_array_index(sigs_out, i));
+        g_assert_cmpuint(values_in->len, ==, values_out->len);
+        g_assert_cmpmem(values_in->data, values_in->len * sizeof(gdouble),
+                        values_out->data, values_out->len * sizeof(gdouble));
+        g_array_unref(values_in);
+        g_array_unref(values_out);
+    }
+
+    g_object_unref(file);
+    g_free(contents);
+    g_free(gz_path);
+}
+
+static void
+file_signals_outlive_file(FileFixture* fixture, gconstpointer unused)
+{
+    (void) unused;
+    GError  *error = NULL;
+    EdfFile *file;
+
+    edf_file_replace(fixture->file, &error);
+    g_assert_no_error(error);
+
+    file = edf_file_new_for_path(g_temp_file);
+    edf_file_read(file, &error);
+    g_assert_no_error(error);
+
+    // The samples of the file are shared by its signals
+    GPtrArray* sigs_in = g_ptr_array_ref(edf_file_get_signals(file));
+    g_object_unref(file);
+
+    GPtrArray* sigs_out = edf_file_get_signals(fixture->file);
+    g_assert_cmpuint(sigs_in->len, ==, sigs_out->len);
+    for (guint i = 0; i < sigs_in->len; i++) {
+        GArray* values_in = edf_signal_get_values(g_ptr_array_index(sigs_in, i));
+        GArray* values_out = edf_signal_get_values(g_ptr_array_index(sigs_out, i));
+        g_assert_cmpuint(values_in->len, ==, values_out->len);
+        g_assert_cmpmem(values_in->data, values_in->len * sizeof(gdouble),
+                        values_out->data, values_out->len * sizeof(gdouble));
+        g_array_unref(values_in);
+        g_array_unref(values_out);
+    }
+
+    g_ptr_array_unref(sigs_in);
+}
+
+/*
+ * Writes the first length bytes of the file of the fixture to name in the
+ * temporary directory.
+ */
+static gchar*
+write_truncated_copy(FileFixture* fixture, const gchar* name, gsize length)
+{
+    GError  *error = NULL;
+    gchar   *contents = NULL;
+    gsize    size = 0;
+    gchar   *path = g_build_filename(g_temp_dir, name, NULL);
+
+    edf_file_replace(fixture->file, &error);
+    g_assert_no_error(error);
+
+    g_file_get_contents(g_temp_file, &contents, &size, &error);
+    g_assert_no_error(error);
+    g_assert_cmpuint(length, <=, size);
+
+    g_file_set_contents(path, contents, length, &error);
+    g_assert_no_error(error);
+
+    g_free(contents);
+    return path;
+}
+
+static void
+file_validate(FileFixture* fixture, gconstpointer unused)
+{
+    (void) unused;
+    GError       *error = NULL;
+    EdfFileReport report;
+    const gsize   record_size = 2 * 2048 * 2;
+
+    edf_file_replace(fixture->file, &error);
+    g_assert_no_error(error);
+
+    EdfFile* file = edf_file_new_for_path(g_temp_file);
+    g_assert_true(edf_file_validate(file, &report, &error));
+    g_assert_no_error(error);
+    g_assert_cmpuint(report.header_size, ==, hdr_info.expected_header_size);
+    g_assert_cmpuint(report.record_size, ==, record_size);
+    g_assert_cmpint(report.declared_num_records, ==, hdr_info.num_records);
+    g_assert_cmpuint(report.num_records, ==, hdr_info.num_records);
+    g_assert_cmpuint(report.trailing_bytes, ==, 0);
+    g_assert_cmpuint(report.num_lost_records, ==, 0);
+    g_object_unref(file);
+
+    // 10 records and half of the 11th
+    gchar* path = write_truncated_copy(
+            fixture,
+            "truncated.edf",
+            hdr_info.expected_header_size + 10 * record_size + record_size / 2
+            );
+    file = edf_file_new_for_path(path);
+    g_assert_false(edf_file_validate(file, &report, &error));
+    g_assert_error(error, EDF_FILE_ERROR, EDF_FILE_ERROR_TRUNCATED);
+    g_clear_error(&error);
+    g_assert_cmpuint(report.num_records, ==, 10);
+    g_assert_cmpuint(report.trailing_bytes, ==, record_size / 2);
+    g_assert_cmpuint(report.num_lost_records, ==, hdr_info.num_records - 10);
+
+    edf_file_read(file, &error);
+    g_assert_error(error, EDF_FILE_ERROR, EDF_FILE_ERROR_TRUNCATED);
+    g_clear_error(&error);
+    g_assert_cmpuint(edf_signal_get_num_records(
+            g_ptr_array_index(edf_file_get_signals(file), 0)
+            ), ==, 10);
+    g_object_unref(file);
+
+    g_remove(path);
+    g_free(path);
+}
+
+static void
+file_recover(FileFixture* fixture, gconstpointer unused)
+{
+    (void) unused;
+    GError       *error = NULL;
+    EdfFileReport report;
+    const gsize   record_size = 2 * 2048 * 2;
+    gint64        num_records = 0;
+
+    gchar* path = write_truncated_copy(
+            fixture,
+            "recover.edf",
+            hdr_info.expected_header_size + 10 * record_size + 100
+            );
+
+    EdfFile* file = edf_file_new_for_path(path);
+    edf_file_read_recover(file, &report, &error);
+    g_assert_no_error(error);
+    g_assert_cmpuint(report.num_records, ==, 10);
+    g_assert_cmpuint(report.trailing_bytes, ==, 100);
+    g_assert_cmpuint(report.num_lost_records, ==, hdr_info.num_records - 10);
+
+    g_object_get(edf_file_header(file), "num-data-records", &num_records, NULL);
+    g_assert_cmpint(num_records, ==, 10);
+
+    // The recovered samples equal the ones that were written
+    GPtrArray* sigs_in = edf_file_get_signals(file);
+    GPtrArray* sigs_out = edf_file_get_signals(fixture->file);
+    for (guint i = 0; i < sigs_in->len; i++) {
+        GArray* values_in = edf_signal_get_values(g_ptr_array_index(sigs_in, i));
+        GArray* values_out = edf_signal_get_values(g_ptr_array_index(sigs_out, i));
+        g_assert_cmpuint(values_in->len, ==, 10 * 2048);
+        g_assert_cmpmem(values_in->data, values_in->len * sizeof(gdouble),
+                        values_out->data, values_in->len * sizeof(gdouble));
+        g_array_unref(values_in);
+        g_array_unref(values_out);
+    }
+    g_object_unref(file);
+
+    // Repair the file in place, afterwards it is valid
+    file = edf_file_new_for_path(path);
+    g_assert_true(edf_file_repair(file, &report, &error));
+    g_assert_no_error(error);
+    g_assert_true(edf_file_validate(file, &report, &error));
+    g_assert_no_error(error);
+    g_assert_cmpint(report.declared_num_records, ==, 10);
+    g_assert_cmpuint(report.file_size, ==,
+                     hdr_info.expected_header_size + 10 * record_size);
+
+    edf_file_read(file, &error);
+    g_assert_no_error(error);
+    g_object_unref(file);
+
+    g_remove(path);
+    g_free(path);
+}
+
+static void
+file_stale_header(FileFixture* fixture, gconstpointer unused)
+{
+    (void) unused;
+    GError       *error = NULL;
+    EdfFileReport report;
+    const gsize   record_size = 2 * 2048 * 2;
+    gchar        *contents = NULL;
+    gsize         length = 0;
+
+    gchar* path = write_truncated_copy(
+            fixture, "stale.edf", hdr_info.expected_header_size + 2 * record_size
+            );
+
+    // The most records a header can declare, far more than fit in memory
+    g_file_get_contents(path, &contents, &length, &error);
+    g_assert_no_error(error);
+    memcpy(&contents[236], "99999999", 8);
+    g_file_set_contents(path, contents, length, &error);
+    g_assert_no_error(error);
+    g_free(contents);
+
+    EdfFile* file = edf_file_new_for_path(path);
+    edf_file_read(file, &error);
+    g_assert_error(error, EDF_FILE_ERROR, EDF_FILE_ERROR_TRUNCATED);
+    g_clear_error(&error);
+    g_object_unref(file);
+
+    file = edf_file_new_for_path(path);
+    edf_file_read_recover(file, &report, &error);
+    g_assert_no_error(error);
+    g_assert_cmpint(report.declared_num_records, ==, 99999999);
+    g_assert_cmpuint(report.num_records, ==, 2);
+    g_object_unref(file);
+
+    g_remove(path);
+    g_free(path);
+}
+
+static void
+file_truncated_header(FileFixture* fixture, gconstpointer unused)
+{
+    (void) unused;
+    GError* error = NULL;
+    gchar* path = write_truncated_copy(fixture, "header.edf", 300);
+
+    // An error instead of an assertion
+    EdfFile* file = edf_file_new_for_path(path);
+    edf_file_read(file, &error);
+    g_assert_error(error, EDF_HEADER_ERROR, EDF_HEADER_ERROR_PARSE);
+    g_clear_error(&error);
+
+    g_assert_false(edf_file_validate(file, NULL, &error));
+    g_assert_error(error, EDF_HEADER_ERROR, EDF_HEADER_ERROR_PARSE);
+    g_clear_error(&error);
+    g_object_unref(file);
+
+    g_remove(path);
+    g_free(path);
+}
+
 void file_set_signals(void)
 {
     EdfFile* file;
@@ -527,5 +797,53 @@ void add_file_suite(void)
         file_open_reading,
         file_fixture_tear_down
     );
+    g_test_add(
+        "/EdfFile/gzip",
+        FileFixture,
+        NULL,
+        file_fixture_set_up,
+        file_gzip,
+        file_fixture_tear_down
+    );
+    g_test_add(
+        "/EdfFile/signals_outlive_file",
+        FileFixture,
+        NULL,
+        file_fixture_set_up,
+        file_signals_outlive_file,
+        file_fixture_tear_down
+    );
     g_test_add_func("/EdfFile/set_signals", file_set_signals);
+    g_test_add(
+        "/EdfFile/validate",
+        FileFixture,
+        NULL,
+        file_fixture_set_up,
+        file_validate,
+        file_fixture_tear_down
+    );
+    g_test_add(
+        "/EdfFile/recover",
+        FileFixture,
+        NULL,
+        file_fixture_set_up,
+        file_recover,
+        file_fixture_tear_down
+    );
+    g_test_add(
+        "/EdfFile/stale_header",
+        FileFixture,
+        NULL,
+        file_fixture_set_up,
+        file_stale_header,
+        file_fixture_tear_down
+    );
+    g_test_add(
+        "/EdfFile/truncated_header",
+        FileFixture,
+        NULL,
+        file_fixture_set_up,
+        file_truncated_header,
+        file_fixture_tear_down
+    );
 }
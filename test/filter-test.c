@@ -0,0 +1,235 @@
+
+#include <gedf.h>
+#include <glib.h>
+#include <math.h>
+
+/* ******** global constants ********* */
+
+#define NUM_SAMPLES     2000
+#define NUM_CHANNELS    3
+
+/* ******* utility functions ************ */
+
+static gdouble
+noise_value(guint channel, guint sample)
+{
+    return ((sample * 7919 + channel * 104729) % 2001) / 100.0 - 10;
+}
+
+static gdouble
+sine(gdouble frequency, gdouble sample_rate, guint sample)
+{
+    return sin(2 * G_PI * frequency * sample / sample_rate);
+}
+
+static EdfFilter*
+create_bank(void)
+{
+    GError* error = NULL;
+    EdfFilter* filter = edf_filter_new(256, NUM_CHANNELS);
+
+    edf_filter_add_highpass(filter, 0.5, 2, &error);
+    g_assert_no_error(error);
+    edf_filter_add_notch(filter, 50, 30, &error);
+    g_assert_no_error(error);
+    edf_filter_add_lowpass(filter, 40, 4, &error);
+    g_assert_no_error(error);
+    return filter;
+}
+
+/* ******* tests ******** */
+
+static void
+filter_design(void)
+{
+    GError* error = NULL;
+    EdfFilter* filter = edf_filter_new(500, 1);
+
+    g_assert_cmpfloat(edf_filter_get_sample_rate(filter), ==, 500);
+    g_assert_cmpuint(edf_filter_get_num_channels(filter), ==, 1);
+    g_assert_cmpfloat(edf_filter_get_magnitude(filter, 30), ==, 1);
+
+    g_assert_true(edf_filter_add_lowpass(filter, 30, 4, &error));
+    g_assert_no_error(error);
+    g_assert_cmpuint(edf_filter_get_num_sections(filter), ==, 2);
+    g_assert_cmpfloat_with_epsilon(edf_filter_get_magnitude(filter, 30), G_SQRT2 / 2, 1e-9);
+    g_assert_cmpfloat_with_epsilon(edf_filter_get_magnitude(filter, 0), 1, 1e-9);
+    g_assert_cmpfloat(edf_filter_get_magnitude(filter, 200), <, 1e-4);
+    g_object_unref(filter);
+
+    // an odd order has a first order section
+    filter = edf_filter_new(500, 1);
+    g_assert_true(edf_filter_add_highpass(filter, 1, 3, &error));
+    g_assert_no_error(error);
+    g_assert_cmpuint(edf_filter_get_num_sections(filter), ==, 2);
+    g_assert_cmpfloat_with_epsilon(edf_filter_get_magnitude(filter, 1), G_SQRT2 / 2, 1e-9);
+    g_assert_cmpfloat_with_epsilon(edf_filter_get_magnitude(filter, 0), 0, 1e-9);
+    g_assert_cmpfloat_with_epsilon(edf_filter_get_magnitude(filter, 100), 1, 1e-6);
+    g_object_unref(filter);
+
+    filter = edf_filter_new(500, 1);
+    g_assert_true(edf_filter_add_notch(filter, 50, 30, &error));
+    g_assert_no_error(error);
+    g_assert_cmpuint(edf_filter_get_num_sections(filter), ==, 1);
+    g_assert_cmpfloat(edf_filter_get_magnitude(filter, 50), <, 1e-9);
+    g_assert_cmpfloat(edf_filter_get_magnitude(filter, 10), >, 0.999);
+    g_object_unref(filter);
+}
+
+static void
+filter_stream(void)
+{
+    EdfFilter* reference = create_bank();
+    EdfFilter* planar = create_bank();
+    EdfFilter* interleaved = create_bank();
+    gdouble* expected[NUM_CHANNELS];
+    gdouble* channels[NUM_CHANNELS];
+    gdouble* frames = g_new(gdouble, NUM_SAMPLES * NUM_CHANNELS);
+
+    for (guint c = 0; c < NUM_CHANNELS; c++) {
+        expected[c] = g_new(gdouble, NUM_SAMPLES);
+        channels[c] = g_new(gdouble, NUM_SAMPLES);
+        for (guint i = 0; i < NUM_SAMPLES; i++) {
+            expected[c][i] = channels[c][i] = noise_value(c, i);
+            frames[i * NUM_CHANNELS + c] = noise_value(c, i);
+        }
+        edf_filter_process_channel(reference, c, expected[c], NUM_SAMPLES);
+    }
+
+    // records of an odd size, the state is carried from record to record
+    for (guint start = 0; start < NUM_SAMPLES; start += 37) {
+        guint n = MIN(37, NUM_SAMPLES - start);
+        gdouble* record[NUM_CHANNELS];
+        for (guint c = 0; c < NUM_CHANNELS; c++)
+            record[c] = &channels[c][start];
+        edf_filter_process(planar, record, n);
+    }
+    for (guint start = 0; start < NUM_SAMPLES; start += 101) {
+        guint n = MIN(101, NUM_SAMPLES - start);
+        edf_filter_process_interleaved(
+                interleaved, &frames[start * NUM_CHANNELS], n
+                );
+    }
+
+    for (guint c = 0; c < NUM_CHANNELS; c++) {
+        for (guint i = 0; i < NUM_SAMPLES; i++) {
+            g_assert_cmpfloat_with_epsilon(channels[c][i], expected[c][i], 1e-9);
+            g_assert_cmpfloat_with_epsilon(
+                    frames[i * NUM_CHANNELS + c], expected[c][i], 1e-9
+                    );
+        }
+    }
+
+    // after a reset the filter starts over
+    for (guint i = 0; i < NUM_SAMPLES; i++)
+        channels[0][i] = noise_value(0, i);
+    edf_filter_reset(planar);
+    edf_filter_process_channel(planar, 0, channels[0], NUM_SAMPLES);
+    for (guint i = 0; i < NUM_SAMPLES; i++)
+        g_assert_cmpfloat_with_epsilon(channels[0][i], expected[0][i], 1e-9);
+
+    for (guint c = 0; c < NUM_CHANNELS; c++) {
+        g_free(expected[c]);
+        g_free(channels[c]);
+    }
+    g_free(frames);
+    g_object_unref(reference);
+    g_object_unref(planar);
+    g_object_unref(interleaved);
+}
+
+static void
+filter_notch(void)
+{
+    GError* error = NULL;
+    EdfFilter* filter = edf_filter_new(500, 1);
+    gdouble* samples = g_new(gdouble, NUM_SAMPLES);
+
+    edf_filter_add_notch(filter, 50, 10, &error);
+    g_assert_no_error(error);
+
+    for (guint i = 0; i < NUM_SAMPLES; i++)
+        samples[i] = sine(5, 500, i) + sine(50, 500, i);
+    edf_filter_process_channel(filter, 0, samples, NUM_SAMPLES);
+
+    // after the transient only the 5 Hz component remains
+    for (guint i = NUM_SAMPLES / 2; i < NUM_SAMPLES; i++)
+        g_assert_cmpfloat_with_epsilon(samples[i], sine(5, 500, i), 0.02);
+
+    g_free(samples);
+    g_object_unref(filter);
+}
+
+static void
+filter_zero_phase(void)
+{
+    GError* error = NULL;
+    EdfFilter* filter = edf_filter_new(500, 1);
+    gdouble* forward = g_new(gdouble, NUM_SAMPLES);
+    gdouble* zero_phase = g_new(gdouble, NUM_SAMPLES);
+    gdouble forward_error = 0;
+
+    edf_filter_add_lowpass(filter, 40, 4, &error);
+    g_assert_no_error(error);
+
+    for (guint i = 0; i < NUM_SAMPLES; i++)
+        forward[i] = zero_phase[i] = sine(2, 500, i);
+
+    edf_filter_process_zero_phase(filter, zero_phase, NUM_SAMPLES);
+    edf_filter_process_channel(filter, 0, forward, NUM_SAMPLES);
+
+    // The forward filter delays the signal, forward-backward doesn't
+    for (guint i = 0; i < NUM_SAMPLES; i++) {
+        forward_error = MAX(forward_error, fabs(forward[i] - sine(2, 500, i)));
+        g_assert_cmpfloat_with_epsilon(zero_phase[i], sine(2, 500, i), 0.01);
+        if (i > 100 && i < NUM_SAMPLES - 100)
+            g_assert_cmpfloat_with_epsilon(zero_phase[i], sine(2, 500, i), 1e-6);
+    }
+    g_assert_cmpfloat(forward_error, >, 0.05);
+
+    // A constant passes a low pass filter without transients
+    for (guint i = 0; i < NUM_SAMPLES; i++)
+        zero_phase[i] = 5.0;
+    edf_filter_process_zero_phase(filter, zero_phase, NUM_SAMPLES);
+    for (guint i = 0; i < NUM_SAMPLES; i++)
+        g_assert_cmpfloat_with_epsilon(zero_phase[i], 5.0, 1e-9);
+
+    g_free(forward);
+    g_free(zero_phase);
+    g_object_unref(filter);
+}
+
+static void
+filter_errors(void)
+{
+    GError* error = NULL;
+    EdfFilter* filter = edf_filter_new(500, 1);
+
+    g_assert_false(edf_filter_add_lowpass(filter, 250, 2, &error));
+    g_assert_error(error, EDF_FILTER_ERROR, EDF_FILTER_ERROR_FREQUENCY);
+    g_clear_error(&error);
+
+    g_assert_false(edf_filter_add_highpass(filter, 0, 2, &error));
+    g_assert_error(error, EDF_FILTER_ERROR, EDF_FILTER_ERROR_FREQUENCY);
+    g_clear_error(&error);
+
+    g_assert_false(edf_filter_add_highpass(filter, 1, 0, &error));
+    g_assert_error(error, EDF_FILTER_ERROR, EDF_FILTER_ERROR_DESIGN);
+    g_clear_error(&error);
+
+    g_assert_false(edf_filter_add_notch(filter, 50, 0, &error));
+    g_assert_error(error, EDF_FILTER_ERROR, EDF_FILTER_ERROR_DESIGN);
+    g_clear_error(&error);
+
+    g_assert_cmpuint(edf_filter_get_num_sections(filter), ==, 0);
+    g_object_unref(filter);
+}
+
+void add_filter_suite(void)
+{
+    g_test_add_func("/EdfFilter/design", filter_design);
+    g_test_add_func("/EdfFilter/stream", filter_stream);
+    g_test_add_func("/EdfFilter/notch", filter_notch);
+    g_test_add_func("/EdfFilter/zero_phase", filter_zero_phase);
+    g_test_add_func("/EdfFilter/errors", filter_errors);
+}
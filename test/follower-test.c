@@ -0,0 +1,303 @@
+
+#include <gedf.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "test-util.h"
+
+/* ******** global constants ********* */
+
+#define NS              16
+#define NUM_RECORDS     5
+#define HEADER_SIZE     (256 + 256)
+#define RECORD_SIZE     (NS * 2)
+#define SAMPLE_RANGE    1000
+
+// The offset of the number of records in the header
+#define NUM_RECORDS_OFFSET  236
+
+typedef struct {
+    gchar      *dir;
+    gchar      *path;
+    gchar      *contents;   // the complete file
+    gsize       length;
+    guint64     first;      // of the last records-added
+    guint       num_added;
+    GMainLoop  *loop;
+} FollowerFixture;
+
+/* ******* utility functions ************ */
+
+static void
+follower_fixture_set_up(FollowerFixture* fixture, gconstpointer data)
+{
+    (void) data;
+    GError* error = NULL;
+
+    fixture->dir = g_dir_make_tmp("gedf_follower_XXXXXX", &error);
+    g_assert_no_error(error);
+    fixture->path = g_build_filename(fixture->dir, "recording.edf", NULL);
+
+    // Write the complete file and keep its bytes
+    gchar* complete = g_build_filename(fixture->dir, "complete.edf", NULL);
+    EdfSignal* signal = test_create_signal("Fz", "electrode", 2, NS, -100.0, 100.0);
+    EdfFile* file = test_create_file(1.0, signal, NULL);
+    test_fill_signal(signal, 0, NS * NUM_RECORDS, SAMPLE_RANGE);
+    test_write_file(file, complete);
+
+    g_file_get_contents(complete, &fixture->contents, &fixture->length, &error);
+    g_assert_no_error(error);
+    g_assert_cmpuint(fixture->length, ==, HEADER_SIZE + NUM_RECORDS * RECORD_SIZE);
+
+    // The header of a file that is being recorded
+    memcpy(&fixture->contents[NUM_RECORDS_OFFSET], "-1      ", 8);
+
+    g_remove(complete);
+    g_free(complete);
+    g_object_unref(signal);
+    g_object_unref(file);
+}
+
+static void
+follower_fixture_tear_down(FollowerFixture* fixture, gconstpointer data)
+{
+    (void) data;
+    g_remove(fixture->path);
+    g_rmdir(fixture->dir);
+    g_free(fixture->path);
+    g_free(fixture->dir);
+    g_free(fixture->contents);
+}
+
+/* Appends the bytes [start, end) of the file, like a recorder does */
+static void
+append_bytes(FollowerFixture* fixture, gsize start, gsize end)
+{
+    FILE* f = fopen(fixture->path, "ab");
+    g_assert_nonnull(f);
+    g_assert_cmpuint(fwrite(&fixture->contents[start], 1, end - start, f), ==, end - start);
+    fclose(f);
+}
+
+static void
+on_records_added(EdfFollower* follower, guint64 first, guint num, gpointer data)
+{
+    FollowerFixture* fixture = data;
+    fixture->first = first;
+    fixture->num_added += num;
+
+    if (fixture->loop && edf_follower_get_num_records(follower) == NUM_RECORDS)
+        g_main_loop_quit(fixture->loop);
+}
+
+static void
+on_failed(EdfFollower* follower, GError* error, gpointer data)
+{
+    (void) follower;
+    (void) data;
+    g_error("Following failed: %s", error->message);
+}
+
+/* ******* tests ******** */
+
+static void
+follower_poll(FollowerFixture* fixture, gconstpointer unused)
+{
+    (void) unused;
+    GError* error = NULL;
+    EdfFollower* follower = edf_follower_new(fixture->path);
+    g_signal_connect(follower, "records-added", G_CALLBACK(on_records_added), fixture);
+
+    // The file doesn't exist yet
+    g_assert_cmpuint(edf_follower_poll(follower, &error), ==, 0);
+    g_assert_no_error(error);
+    g_assert_null(edf_follower_get_header(follower));
+
+    // A part of the header
+    append_bytes(fixture, 0, 300);
+    g_assert_cmpuint(edf_follower_poll(follower, &error), ==, 0);
+    g_assert_no_error(error);
+    g_assert_null(edf_follower_get_header(follower));
+
+    // The header and a part of the first record
+    append_bytes(fixture, 300, HEADER_SIZE + RECORD_SIZE / 2);
+    g_assert_cmpuint(edf_follower_poll(follower, &error), ==, 0);
+    g_assert_no_error(error);
+    g_assert_nonnull(edf_follower_get_header(follower));
+    g_assert_cmpuint(fixture->num_added, ==, 0);
+
+    append_bytes(fixture, HEADER_SIZE + RECORD_SIZE / 2, HEADER_SIZE + 5 * RECORD_SIZE / 2);
+    g_assert_cmpuint(edf_follower_poll(follower, &error), ==, 2);
+    g_assert_no_error(error);
+    g_assert_cmpuint(fixture->first, ==, 0);
+    g_assert_cmpuint(fixture->num_added, ==, 2);
+
+    append_bytes(fixture, HEADER_SIZE + 5 * RECORD_SIZE / 2, fixture->length);
+    g_assert_cmpuint(edf_follower_poll(follower, &error), ==, NUM_RECORDS - 2);
+    g_assert_no_error(error);
+    g_assert_cmpuint(fixture->first, ==, 2);
+    g_assert_cmpuint(edf_follower_get_num_records(follower), ==, NUM_RECORDS);
+
+    // Nothing new
+    g_assert_cmpuint(edf_follower_poll(follower, &error), ==, 0);
+    g_assert_no_error(error);
+
+    GPtrArray* signals = edf_header_get_signals(edf_follower_get_header(follower));
+    g_assert_cmpuint(signals->len, ==, 1);
+    EdfSignal* signal = g_ptr_array_index(signals, 0);
+    g_assert_cmpuint(edf_signal_get_num_records(signal), ==, NUM_RECORDS);
+    GArray* values = edf_signal_get_values(signal);
+    for (guint i = 0; i < values->len; i++)
+        g_assert_cmpfloat_with_epsilon(
+                g_array_index(values, gdouble, i),
+                edf_signal_get_gain(signal) * test_sample_value(0, i, SAMPLE_RANGE) +
+                    edf_signal_get_offset(signal),
+                1e-9
+                );
+    g_array_unref(values);
+
+    // The recording is overwritten
+    FILE* f = fopen(fixture->path, "wb");
+    fclose(f);
+    append_bytes(fixture, 0, HEADER_SIZE + RECORD_SIZE);
+    g_assert_cmpuint(edf_follower_poll(follower, &error), ==, 0);
+    g_assert_error(error, EDF_FOLLOWER_ERROR, EDF_FOLLOWER_ERROR_SHRUNK);
+    g_clear_error(&error);
+
+    g_object_unref(follower);
+}
+
+static gboolean
+append_remainder(gpointer data)
+{
+    FollowerFixture* fixture = data;
+    append_bytes(fixture, HEADER_SIZE + RECORD_SIZE, fixture->length);
+    return G_SOURCE_REMOVE;
+}
+
+static gboolean
+on_timeout(gpointer data)
+{
+    (void) data;
+    g_assert_not_reached();
+    return G_SOURCE_REMOVE;
+}
+
+static GSource*
+add_timeout(GMainContext* context, guint interval, GSourceFunc func, gpointer data)
+{
+    GSource* source = g_timeout_source_new(interval);
+    g_source_set_callback(source, func, data, NULL);
+    g_source_attach(source, context);
+    return source;
+}
+
+/*
+ * Follows the file in context, which is the thread default context while
+ * the follower is started.
+ */
+static void
+run_follower(FollowerFixture* fixture, GMainContext* context)
+{
+    GError* error = NULL;
+    EdfFollower* follower = edf_follower_new(fixture->path);
+    g_object_set(follower, "poll-interval", 20, NULL);
+    g_signal_connect(follower, "records-added", G_CALLBACK(on_records_added), fixture);
+    g_signal_connect(follower, "failed", G_CALLBACK(on_failed), fixture);
+
+    append_bytes(fixture, 0, HEADER_SIZE + RECORD_SIZE);
+    g_assert_true(edf_follower_start(follower, &error));
+    g_assert_no_error(error);
+    g_assert_cmpuint(edf_follower_get_num_records(follower), ==, 1);
+
+    fixture->loop = g_main_loop_new(context, FALSE);
+    GSource* append = add_timeout(context, 50, append_remainder, fixture);
+    GSource* guard = add_timeout(context, 10000, on_timeout, NULL);
+    g_main_loop_run(fixture->loop);
+    g_source_destroy(guard);
+    g_source_unref(guard);
+    g_source_unref(append);
+
+    g_assert_cmpuint(edf_follower_get_num_records(follower), ==, NUM_RECORDS);
+    g_assert_cmpuint(fixture->num_added, ==, NUM_RECORDS);
+
+    edf_follower_stop(follower);
+    g_main_loop_unref(fixture->loop);
+    fixture->loop = NULL;
+    g_object_unref(follower);
+}
+
+static void
+follower_start(FollowerFixture* fixture, gconstpointer unused)
+{
+    (void) unused;
+    run_follower(fixture, NULL);
+}
+
+static void
+follower_thread_context(FollowerFixture* fixture, gconstpointer unused)
+{
+    (void) unused;
+    GMainContext* context = g_main_context_new();
+
+    g_main_context_push_thread_default(context);
+    run_follower(fixture, context);
+    g_main_context_pop_thread_default(context);
+
+    g_main_context_unref(context);
+}
+
+static void
+follower_compressed(FollowerFixture* fixture, gconstpointer unused)
+{
+    (void) unused;
+    GError* error = NULL;
+    guint8 bytes[HEADER_SIZE] = {0x1f, 0x8b};
+
+    g_file_set_contents(fixture->path, (const gchar*) bytes, sizeof(bytes), &error);
+    g_assert_no_error(error);
+
+    EdfFollower* follower = edf_follower_new(fixture->path);
+    g_assert_false(edf_follower_start(follower, &error));
+    g_assert_error(error, EDF_FOLLOWER_ERROR, EDF_FOLLOWER_ERROR_UNSUPPORTED);
+    g_clear_error(&error);
+    g_object_unref(follower);
+}
+
+void add_follower_suite(void)
+{
+    g_test_add(
+        "/EdfFollower/poll",
+        FollowerFixture,
+        NULL,
+        follower_fixture_set_up,
+        follower_poll,
+        follower_fixture_tear_down
+    );
+    g_test_add(
+        "/EdfFollower/start",
+        FollowerFixture,
+        NULL,
+        follower_fixture_set_up,
+        follower_start,
+        follower_fixture_tear_down
+    );
+    g_test_add(
+        "/EdfFollower/thread_context",
+        FollowerFixture,
+        NULL,
+        follower_fixture_set_up,
+        follower_thread_context,
+        follower_fixture_tear_down
+    );
+    g_test_add(
+        "/EdfFollower/compressed",
+        FollowerFixture,
+        NULL,
+        follower_fixture_set_up,
+        follower_compressed,
+        follower_fixture_tear_down
+    );
+}
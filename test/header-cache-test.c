@@ -0,0 +1,299 @@
+
+#include <gedf.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <string.h>
+
+/* ******** global constants ********* */
+
+#define NS              32
+#define NUM_RECORDS     4
+#define NUM_SIGNALS     3
+
+// The offset of the local patient identification in the header
+#define PATIENT_OFFSET  8
+
+typedef struct {
+    gchar  *dir;
+    gchar  *cache_dir;
+    gchar  *path;
+} CacheFixture;
+
+/* ******* utility functions ************ */
+
+static void
+cache_fixture_set_up(CacheFixture* fixture, gconstpointer data)
+{
+    (void) data;
+    GError* error = NULL;
+
+    fixture->dir = g_dir_make_tmp("gedf_header_cache_XXXXXX", &error);
+    g_assert_no_error(error);
+    fixture->cache_dir = g_build_filename(fixture->dir, "cache", NULL);
+    fixture->path = g_build_filename(fixture->dir, "recording.edf", NULL);
+    edf_header_cache_set_dir(fixture->cache_dir);
+
+    EdfFile* file = edf_file_new_for_path(fixture->path);
+    edf_header_set_patient(edf_file_header(file), "X X X Patient");
+    edf_header_set_record_duration(edf_file_header(file), 0.25);
+    for (guint i = 0; i < NUM_SIGNALS; i++) {
+        gchar* label = g_strdup_printf("EEG %u", i);
+        EdfSignal* signal = edf_signal_new_full(
+                label, "AgAgCl electrode", "uV", -250.0 * (i + 1), 250.0 * (i + 1),
+                -32768, 32767, "HP:0.1Hz", NS * (i + 1)
+                );
+        for (guint j = 0; j < NS * (i + 1) * NUM_RECORDS; j++) {
+            edf_signal_append_digital(signal, (gint) (j * 31 % 4001) - 2000, &error);
+            g_assert_no_error(error);
+        }
+        edf_file_add_signal(file, signal);
+        g_object_unref(signal);
+        g_free(label);
+    }
+    edf_file_replace(file, &error);
+    g_assert_no_error(error);
+    g_object_unref(file);
+}
+
+static void
+cache_fixture_tear_down(CacheFixture* fixture, gconstpointer data)
+{
+    (void) data;
+    GError* error = NULL;
+
+    g_assert_true(edf_header_cache_clear(&error));
+    g_assert_no_error(error);
+    edf_header_cache_set_dir(NULL);
+
+    g_rmdir(fixture->cache_dir);
+    g_remove(fixture->path);
+    g_rmdir(fixture->dir);
+    g_free(fixture->path);
+    g_free(fixture->cache_dir);
+    g_free(fixture->dir);
+}
+
+static EdfFile*
+read_file(const gchar* path, gboolean use_cache)
+{
+    GError* error = NULL;
+    EdfFile* file = edf_file_new_for_path(path);
+    edf_file_set_use_header_cache(file, use_cache);
+    edf_file_read(file, &error);
+    g_assert_no_error(error);
+    return file;
+}
+
+static guint
+count_entries(const gchar* dir_path)
+{
+    GDir* dir = g_dir_open(dir_path, 0, NULL);
+    guint n = 0;
+    if (!dir)
+        return 0;
+    while (g_dir_read_name(dir))
+        n++;
+    g_dir_close(dir);
+    return n;
+}
+
+static void
+assert_files_equal(EdfFile* expected, EdfFile* file)
+{
+    EdfHeader* h1 = edf_file_header(expected);
+    EdfHeader* h2 = edf_file_header(file);
+
+    g_assert_cmpint(edf_header_get_version(h2), ==, edf_header_get_version(h1));
+    g_assert_cmpstr(edf_header_get_patient(h2), ==, edf_header_get_patient(h1));
+    g_assert_cmpstr(edf_header_get_recording(h2), ==, edf_header_get_recording(h1));
+    g_assert_cmpstr(edf_header_get_reserved(h2), ==, edf_header_get_reserved(h1));
+    g_assert_cmpint(edf_header_get_num_records(h2), ==, edf_header_get_num_records(h1));
+    g_assert_cmpfloat(
+            edf_header_get_record_duration(h2), ==, edf_header_get_record_duration(h1)
+            );
+    g_assert_cmpint(edf_header_get_num_bytes(h2), ==, edf_header_get_num_bytes(h1));
+
+    GDateTime* t1 = edf_header_get_time(h1);
+    GDateTime* t2 = edf_header_get_time(h2);
+    g_assert_true(g_date_time_equal(t1, t2));
+
+    GPtrArray* s1 = edf_file_get_signals(expected);
+    GPtrArray* s2 = edf_file_get_signals(file);
+    g_assert_cmpuint(s2->len, ==, s1->len);
+    for (guint i = 0; i < s1->len; i++) {
+        EdfSignal* a = g_ptr_array_index(s1, i);
+        EdfSignal* b = g_ptr_array_index(s2, i);
+        g_assert_cmpstr(edf_signal_get_label(b), ==, edf_signal_get_label(a));
+        g_assert_cmpstr(edf_signal_get_transducer(b), ==, edf_signal_get_transducer(a));
+        g_assert_cmpstr(
+                edf_signal_get_physical_dimension(b), ==, edf_signal_get_physical_dimension(a)
+                );
+        g_assert_cmpstr(edf_signal_get_prefiltering(b), ==, edf_signal_get_prefiltering(a));
+        g_assert_cmpstr(edf_signal_get_reserved(b), ==, edf_signal_get_reserved(a));
+        g_assert_cmpfloat(edf_signal_get_physical_min(b), ==, edf_signal_get_physical_min(a));
+        g_assert_cmpfloat(edf_signal_get_physical_max(b), ==, edf_signal_get_physical_max(a));
+        g_assert_cmpint(edf_signal_get_digital_min(b), ==, edf_signal_get_digital_min(a));
+        g_assert_cmpint(edf_signal_get_digital_max(b), ==, edf_signal_get_digital_max(a));
+        g_assert_cmpuint(
+                edf_signal_get_num_samples_per_record(b), ==,
+                edf_signal_get_num_samples_per_record(a)
+                );
+        g_assert_cmpuint(edf_signal_get_sample_size(b), ==, edf_signal_get_sample_size(a));
+
+        GArray* v1 = edf_signal_get_values(a);
+        GArray* v2 = edf_signal_get_values(b);
+        g_assert_cmpmem(
+                v2->data, v2->len * sizeof(gdouble), v1->data, v1->len * sizeof(gdouble)
+                );
+        g_array_unref(v2);
+        g_array_unref(v1);
+    }
+}
+
+/* Overwrites the patient in the header without changing the size of the file */
+static void
+replace_patient(const gchar* path, const gchar* patient)
+{
+    GError* error = NULL;
+    gchar* contents = NULL;
+    gsize length = 0;
+
+    g_file_get_contents(path, &contents, &length, &error);
+    g_assert_no_error(error);
+    memset(&contents[PATIENT_OFFSET], ' ', 80);
+    memcpy(&contents[PATIENT_OFFSET], patient, strlen(patient));
+    g_file_set_contents(path, contents, length, &error);
+    g_assert_no_error(error);
+    g_free(contents);
+}
+
+static void
+set_mtime(const gchar* path, guint64 mtime, guint32 mtime_usec)
+{
+    GError* error = NULL;
+    GFile* file = g_file_new_for_path(path);
+
+    g_file_set_attribute_uint64(
+            file, G_FILE_ATTRIBUTE_TIME_MODIFIED, mtime,
+            G_FILE_QUERY_INFO_NONE, NULL, &error
+            );
+    g_assert_no_error(error);
+    g_file_set_attribute_uint32(
+            file, G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC, mtime_usec,
+            G_FILE_QUERY_INFO_NONE, NULL, &error
+            );
+    g_assert_no_error(error);
+    g_object_unref(file);
+}
+
+/* ******* tests ******** */
+
+static void
+header_cache_hit(CacheFixture* fixture, gconstpointer unused)
+{
+    (void) unused;
+    EdfFile* expected = read_file(fixture->path, FALSE);
+    g_assert_cmpuint(count_entries(fixture->cache_dir), ==, 0);
+
+    // The first read stores the header
+    EdfFile* stored = read_file(fixture->path, TRUE);
+    g_assert_cmpuint(count_entries(fixture->cache_dir), ==, 1);
+    assert_files_equal(expected, stored);
+
+    // The second read takes it from the cache
+    EdfFile* cached = read_file(fixture->path, TRUE);
+    g_assert_cmpuint(count_entries(fixture->cache_dir), ==, 1);
+    assert_files_equal(expected, cached);
+
+    g_object_unref(cached);
+    g_object_unref(stored);
+    g_object_unref(expected);
+}
+
+static void
+header_cache_invalidate(CacheFixture* fixture, gconstpointer unused)
+{
+    (void) unused;
+    GFile* gfile = g_file_new_for_path(fixture->path);
+    GFileInfo* info = g_file_query_info(
+            gfile,
+            G_FILE_ATTRIBUTE_TIME_MODIFIED "," G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC,
+            G_FILE_QUERY_INFO_NONE, NULL, NULL
+            );
+    g_assert_nonnull(info);
+    guint64 mtime = g_file_info_get_attribute_uint64(info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+    guint32 usec = g_file_info_get_attribute_uint32(info, G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC);
+    g_object_unref(info);
+    g_object_unref(gfile);
+
+    EdfFile* file = read_file(fixture->path, TRUE);
+    g_object_unref(file);
+
+    // With the same size and time the cached header is used
+    replace_patient(fixture->path, "Y Y Y Changed");
+    set_mtime(fixture->path, mtime, usec);
+    file = read_file(fixture->path, TRUE);
+    g_assert_cmpstr(edf_header_get_patient(edf_file_header(file)), ==, "X X X Patient");
+    g_object_unref(file);
+
+    // A newer file is parsed again
+    set_mtime(fixture->path, mtime + 10, usec);
+    file = read_file(fixture->path, TRUE);
+    g_assert_cmpstr(edf_header_get_patient(edf_file_header(file)), ==, "Y Y Y Changed");
+    g_object_unref(file);
+
+    // And the cache is up to date afterwards
+    file = read_file(fixture->path, FALSE);
+    EdfFile* cached = read_file(fixture->path, TRUE);
+    assert_files_equal(file, cached);
+    g_object_unref(cached);
+    g_object_unref(file);
+}
+
+static void
+header_cache_clear(CacheFixture* fixture, gconstpointer unused)
+{
+    (void) unused;
+    GError* error = NULL;
+
+    EdfFile* file = read_file(fixture->path, TRUE);
+    g_assert_true(edf_file_get_use_header_cache(file));
+    g_assert_cmpuint(count_entries(fixture->cache_dir), ==, 1);
+    g_object_unref(file);
+
+    g_assert_true(edf_header_cache_clear(&error));
+    g_assert_no_error(error);
+    g_assert_cmpuint(count_entries(fixture->cache_dir), ==, 0);
+
+    gchar* dir = edf_header_cache_get_dir();
+    g_assert_cmpstr(dir, ==, fixture->cache_dir);
+    g_free(dir);
+}
+
+void add_header_cache_suite(void)
+{
+    g_test_add(
+        "/EdfHeaderCache/hit",
+        CacheFixture,
+        NULL,
+        cache_fixture_set_up,
+        header_cache_hit,
+        cache_fixture_tear_down
+    );
+    g_test_add(
+        "/EdfHeaderCache/invalidate",
+        CacheFixture,
+        NULL,
+        cache_fixture_set_up,
+        header_cache_invalidate,
+        cache_fixture_tear_down
+    );
+    g_test_add(
+        "/EdfHeaderCache/clear",
+        CacheFixture,
+        NULL,
+        cache_fixture_set_up,
+        header_cache_clear,
+        cache_fixture_tear_down
+    );
+}
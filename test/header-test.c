@@ -29,8 +29,52 @@ header_size(void)
     edf_header_destroy(hdr);
 }
 
+static void
+header_stream_num_records(void)
+{
+    GError* error = NULL;
+    EdfHeader* hdr = edf_header_new();
+    GPtrArray* signals = g_ptr_array_new_full(1, g_object_unref);
+    gint64 num_records = 0;
+
+    // The records are streamed after the header, so the signals are empty
+    g_ptr_array_add(signals, edf_signal_new());
+    edf_header_set_signals(hdr, signals);
+    g_ptr_array_unref(signals);
+    edf_header_set_expected_num_records(hdr, 42);
+
+    GOutputStream* ostream = g_memory_output_stream_new_resizable();
+    gsize written = edf_header_write_to_ostream(hdr, ostream, &error);
+    g_assert_no_error(error);
+    g_assert_cmpuint(written, ==, bdf_header_size_validator(1));
+    g_output_stream_close(ostream, NULL, &error);
+    g_assert_no_error(error);
+
+    GBytes* bytes = g_memory_output_stream_steal_as_bytes(
+            G_MEMORY_OUTPUT_STREAM(ostream)
+            );
+    GInputStream* istream = g_memory_input_stream_new_from_bytes(bytes);
+    EdfHeader* read = edf_header_new();
+    signals = g_ptr_array_new_full(1, g_object_unref);
+    edf_header_set_signals(read, signals);
+    g_ptr_array_unref(signals);
+
+    edf_header_read_from_input_stream(read, istream, &error);
+    g_assert_no_error(error);
+    g_object_get(read, "num-data-records", &num_records, NULL);
+    g_assert_cmpint(num_records, ==, 42);
+    g_assert_cmpuint(edf_header_get_num_signals(read), ==, 1);
+
+    g_object_unref(istream);
+    g_bytes_unref(bytes);
+    g_object_unref(ostream);
+    edf_header_destroy(read);
+    edf_header_destroy(hdr);
+}
+
 void add_header_suite(void)
 {
     g_test_add_func("/EdfHeader/create", header_create);
     g_test_add_func("/EdfHeader/size",header_size);
+    g_test_add_func("/EdfHeader/stream_num_records", header_stream_num_records);
 }
@@ -0,0 +1,209 @@
+
+#include <gedf.h>
+#include <glib.h>
+
+#include "test-util.h"
+
+/* ******** global constants ********* */
+
+#define NS              300
+#define NUM_RECORDS     500
+#define NUM_SIGNALS     3
+#define SAMPLE_RANGE    10000
+
+/* ******* utility functions ************ */
+
+static EdfSignal*
+create_signal(guint index, guint ns, guint num_records, gboolean constant)
+{
+    gchar* label = g_strdup_printf("S%u", index);
+    EdfSignal* signal = test_create_signal(label, "electrode", 2, ns, -100.0, 100.0);
+
+    if (constant) {
+        for (guint i = 0; i < ns * num_records; i++)
+            test_append_digital(signal, SAMPLE_RANGE);
+    }
+    else {
+        test_fill_signal(signal, index, ns * num_records, SAMPLE_RANGE);
+    }
+    g_free(label);
+    return signal;
+}
+
+static EdfFile*
+create_file(void)
+{
+    EdfFile* file = edf_file_new();
+    for (guint i = 0; i < NUM_SIGNALS; i++) {
+        EdfSignal* signal = create_signal(i, NS, NUM_RECORDS, FALSE);
+        edf_file_add_signal(file, signal);
+        g_object_unref(signal);
+    }
+    return file;
+}
+
+static gdouble
+physical_value(EdfFile* file, guint signal, guint i)
+{
+    EdfSignal* s = g_ptr_array_index(edf_file_get_signals(file), signal);
+    return edf_signal_get_gain(s) * test_sample_value(signal, i, SAMPLE_RANGE) +
+           edf_signal_get_offset(s);
+}
+
+/* ******* tests ******** */
+
+static void
+matrix_row_major(void)
+{
+    GError* error = NULL;
+    EdfFile* file = create_file();
+    guint channels[] = {2, 0};
+    guint64 num_samples = 0;
+
+    g_assert_true(edf_file_get_matrix_shape(
+            file, channels, 2, EDF_MATRIX_FLAGS_NONE, &num_samples, &error
+            ));
+    g_assert_no_error(error);
+    g_assert_cmpuint(num_samples, ==, NS * NUM_RECORDS);
+
+    gfloat* matrix = g_new(gfloat, 2 * num_samples);
+    g_assert_true(edf_file_to_matrix(
+            file, channels, 2, EDF_MATRIX_FLAGS_NONE, matrix, 2 * num_samples, &error
+            ));
+    g_assert_no_error(error);
+
+    for (guint c = 0; c < 2; c++)
+        for (guint i = 0; i < num_samples; i++)
+            g_assert_cmpfloat_with_epsilon(
+                    matrix[c * num_samples + i],
+                    physical_value(file, channels[c], i),
+                    1e-4
+                    );
+
+    g_free(matrix);
+    g_object_unref(file);
+}
+
+static void
+matrix_column_major(void)
+{
+    GError* error = NULL;
+    EdfFile* file = create_file();
+    guint64 num_samples = 0;
+    EdfMatrixFlags flags = EDF_MATRIX_COLUMN_MAJOR | EDF_MATRIX_FLOAT64;
+
+    g_assert_true(edf_file_get_matrix_shape(file, NULL, 0, flags, &num_samples, &error));
+    g_assert_no_error(error);
+    g_assert_cmpuint(num_samples, ==, NS * NUM_RECORDS);
+
+    gdouble* matrix = g_new(gdouble, NUM_SIGNALS * num_samples);
+    g_assert_true(edf_file_to_matrix(
+            file, NULL, 0, flags, matrix, NUM_SIGNALS * num_samples, &error
+            ));
+    g_assert_no_error(error);
+
+    for (guint i = 0; i < num_samples; i++)
+        for (guint c = 0; c < NUM_SIGNALS; c++)
+            g_assert_cmpfloat_with_epsilon(
+                    matrix[i * NUM_SIGNALS + c], physical_value(file, c, i), 1e-9
+                    );
+
+    g_free(matrix);
+    g_object_unref(file);
+}
+
+static void
+matrix_errors(void)
+{
+    GError* error = NULL;
+    EdfFile* file = create_file();
+    guint bad_channels[] = {0, NUM_SIGNALS};
+    guint64 num_samples = 0;
+    gfloat value;
+
+    g_assert_false(edf_file_get_matrix_shape(
+            file, bad_channels, 2, EDF_MATRIX_FLAGS_NONE, &num_samples, &error
+            ));
+    g_assert_error(error, EDF_MATRIX_ERROR, EDF_MATRIX_ERROR_CHANNEL);
+    g_clear_error(&error);
+
+    g_assert_false(edf_file_to_matrix(
+            file, NULL, 0, EDF_MATRIX_FLAGS_NONE, &value, 1, &error
+            ));
+    g_assert_error(error, EDF_MATRIX_ERROR, EDF_MATRIX_ERROR_SIZE);
+    g_clear_error(&error);
+
+    // A signal with a different rate needs EDF_MATRIX_RESAMPLE
+    EdfSignal* signal = create_signal(NUM_SIGNALS, NS / 2, NUM_RECORDS, FALSE);
+    edf_file_add_signal(file, signal);
+    g_object_unref(signal);
+
+    g_assert_false(edf_file_get_matrix_shape(
+            file, NULL, 0, EDF_MATRIX_FLAGS_NONE, &num_samples, &error
+            ));
+    g_assert_error(error, EDF_MATRIX_ERROR, EDF_MATRIX_ERROR_SAMPLE_RATE);
+    g_clear_error(&error);
+
+    g_object_unref(file);
+}
+
+static void
+matrix_resample(void)
+{
+    GError* error = NULL;
+    EdfFile* file = edf_file_new();
+    guint64 num_samples = 0;
+    EdfMatrixFlags flags = EDF_MATRIX_RESAMPLE | EDF_MATRIX_FLOAT64;
+
+    EdfSignal* fast = create_signal(0, 8, 100, FALSE);
+    EdfSignal* slow = create_signal(1, 4, 100, TRUE);
+    // The shortest signal determines the number of samples
+    EdfSignal* shorter = create_signal(2, 8, 90, FALSE);
+    edf_file_add_signal(file, fast);
+    edf_file_add_signal(file, slow);
+    edf_file_add_signal(file, shorter);
+
+    g_assert_true(edf_file_get_matrix_shape(file, NULL, 0, flags, &num_samples, &error));
+    g_assert_no_error(error);
+    g_assert_cmpuint(num_samples, ==, 8 * 90);
+
+    gdouble* matrix = g_new(gdouble, 3 * num_samples);
+    g_assert_true(edf_file_to_matrix(file, NULL, 0, flags, matrix, 3 * num_samples, &error));
+    g_assert_no_error(error);
+
+    for (guint i = 0; i < num_samples; i++) {
+        g_assert_cmpfloat_with_epsilon(matrix[i], physical_value(file, 0, i), 1e-9);
+        g_assert_cmpfloat_with_epsilon(
+                matrix[2 * num_samples + i], physical_value(file, 2, i), 1e-9
+                );
+    }
+
+    // Away from the edges the constant signal stays constant
+    gdouble expected = edf_signal_get_gain(slow) * SAMPLE_RANGE + edf_signal_get_offset(slow);
+    for (guint i = num_samples / 4; i < 3 * num_samples / 4; i++)
+        g_assert_cmpfloat_with_epsilon(matrix[num_samples + i], expected, 0.05);
+
+    // The resampled channel is buffered for a column major matrix
+    gdouble* columns = g_new(gdouble, 3 * num_samples);
+    flags |= EDF_MATRIX_COLUMN_MAJOR;
+    g_assert_true(edf_file_to_matrix(file, NULL, 0, flags, columns, 3 * num_samples, &error));
+    g_assert_no_error(error);
+    for (guint i = 0; i < num_samples; i++)
+        for (guint c = 0; c < 3; c++)
+            g_assert_cmpfloat(columns[i * 3 + c], ==, matrix[c * num_samples + i]);
+
+    g_free(columns);
+    g_free(matrix);
+    g_object_unref(shorter);
+    g_object_unref(slow);
+    g_object_unref(fast);
+    g_object_unref(file);
+}
+
+void add_matrix_suite(void)
+{
+    g_test_add_func("/EdfMatrix/row_major", matrix_row_major);
+    g_test_add_func("/EdfMatrix/column_major", matrix_column_major);
+    g_test_add_func("/EdfMatrix/errors", matrix_errors);
+    g_test_add_func("/EdfMatrix/resample", matrix_resample);
+}
@@ -0,0 +1,265 @@
+
+#include <gedf.h>
+#include <glib.h>
+
+#include "test-util.h"
+
+/* ******** global constants ********* */
+
+#define NS              100
+#define NS_SLOW         10
+#define NUM_RECORDS     4
+#define NUM_EEG         4
+#define SAMPLE_RANGE    30000
+
+static gchar g_montage_dir[1024] = "";
+static gchar g_input_file[1024] = "";
+
+static const gchar* g_eeg_labels[NUM_EEG] = {"Fz", "Cz", "M1", "M2"};
+
+/* ******* utility functions ************ */
+
+/* The four eeg channels and a slower temperature channel */
+static EdfFile*
+create_file(void)
+{
+    EdfFile    *file = test_create_file(1.0, NULL);
+    EdfHeader  *header = edf_file_header(file);
+
+    g_object_set(
+            header,
+            "patient-identification", "montage patient",
+            "recording-identification", "montage recording",
+            NULL
+            );
+
+    for (guint c = 0; c <= NUM_EEG; c++) {
+        guint ns = c < NUM_EEG ? NS : NS_SLOW;
+        EdfSignal* signal = test_create_signal(
+                c < NUM_EEG ? g_eeg_labels[c] : "Temp", "active electrode", 2, ns,
+                -3276.8, 3276.7
+                );
+        test_fill_signal(signal, c, ns * NUM_RECORDS, SAMPLE_RANGE);
+        edf_file_add_signal(file, signal);
+        g_object_unref(signal);
+    }
+    return file;
+}
+
+/* The physical value of sample i of input channel c */
+static gdouble
+physical(guint channel, guint sample)
+{
+    return 0.1 * test_sample_value(channel, sample, SAMPLE_RANGE);
+}
+
+static int
+montage_test_init(void)
+{
+    gchar template[1024] = "gedf_montage_test_XXXXXX";
+    GError *error = NULL;
+    char *temp_dir = g_dir_make_tmp(template, &error);
+
+    if (error) {
+        g_printerr("Unable to open temp dir: %s\n", error->message);
+        g_error_free(error);
+        return -1;
+    }
+    g_snprintf(g_montage_dir, sizeof(g_montage_dir), "%s", temp_dir);
+    g_free(temp_dir);
+
+    g_snprintf(g_input_file, sizeof(g_input_file), "%s/%s", g_montage_dir, "input.edf");
+
+    EdfFile* file = create_file();
+    test_write_file(file, g_input_file);
+    g_object_unref(file);
+    return 0;
+}
+
+/* ******* tests ******** */
+
+static void
+montage_build(void)
+{
+    EdfMontage* montage = edf_montage_new();
+    const gchar* mastoids[] = {"M1", "M2"};
+    guint num_inputs = 0;
+
+    g_assert_cmpuint(edf_montage_get_num_outputs(montage), ==, 0);
+
+    edf_montage_add_bipolar(montage, "Fz", "Cz");
+    edf_montage_add_reference(montage, g_eeg_labels, 2, mastoids, 2, "M1M2");
+    edf_montage_add_average_reference(montage, g_eeg_labels, NUM_EEG);
+
+    g_assert_cmpuint(edf_montage_get_num_outputs(montage), ==, 1 + 2 + NUM_EEG);
+    g_assert_cmpstr(edf_montage_get_output_label(montage, 0), ==, "Fz-Cz");
+    g_assert_cmpstr(edf_montage_get_output_label(montage, 2), ==, "Cz-M1M2");
+    g_assert_cmpstr(edf_montage_get_output_label(montage, 6), ==, "M2-AVG");
+
+    g_object_get(montage, "num-inputs", &num_inputs, NULL);
+    g_assert_cmpuint(num_inputs, ==, NUM_EEG);
+
+    g_object_unref(montage);
+}
+
+static void
+montage_apply_record(void)
+{
+    GError* error = NULL;
+    EdfMontage* montage = edf_montage_new();
+    const gchar* mastoids[] = {"M1", "M2"};
+
+    edf_montage_add_bipolar(montage, "Fz", "Cz");
+    edf_montage_add_reference(montage, g_eeg_labels, 1, mastoids, 2, "M1M2");
+    edf_montage_add_average_reference(montage, g_eeg_labels, NUM_EEG);
+
+    EdfReader* reader = edf_reader_open(g_input_file, &error);
+    g_assert_no_error(error);
+    g_assert_true(edf_montage_bind_reader(montage, reader, &error));
+    g_assert_no_error(error);
+
+    gsize n = edf_montage_get_record_samples(montage);
+    g_assert_cmpuint(n, ==, (2 + NUM_EEG) * NS);
+    g_assert_cmpuint(edf_montage_get_output_ns(montage, 0), ==, NS);
+
+    gdouble* samples = g_new(gdouble, n);
+    guint nrec = 0;
+    while (edf_reader_next_record(reader, &error)) {
+        edf_montage_apply_record(montage, reader, samples);
+
+        for (guint i = 0; i < NS; i++) {
+            guint s = nrec * NS + i;
+            gdouble avg = 0;
+            for (guint c = 0; c < NUM_EEG; c++)
+                avg += physical(c, s) / NUM_EEG;
+
+            g_assert_cmpfloat_with_epsilon(
+                    samples[i], physical(0, s) - physical(1, s), 1e-9
+                    );
+            g_assert_cmpfloat_with_epsilon(
+                    samples[NS + i],
+                    physical(0, s) - (physical(2, s) + physical(3, s)) / 2,
+                    1e-9
+                    );
+            for (guint c = 0; c < NUM_EEG; c++)
+                g_assert_cmpfloat_with_epsilon(
+                        samples[(2 + c) * NS + i], physical(c, s) - avg, 1e-9
+                        );
+        }
+        nrec++;
+    }
+    g_assert_no_error(error);
+    g_assert_cmpuint(nrec, ==, NUM_RECORDS);
+
+    g_free(samples);
+    edf_reader_free(reader);
+    g_object_unref(montage);
+}
+
+static void
+montage_apply_to_file(void)
+{
+    GError* error = NULL;
+    EdfFile* file = create_file();
+    EdfMontage* montage = edf_montage_new();
+
+    edf_montage_add_bipolar(montage, "Fz", "Cz");
+    EdfFile* derived = edf_montage_apply_to_file(montage, file, &error);
+    g_assert_no_error(error);
+    g_assert_nonnull(derived);
+
+    g_assert_cmpuint(edf_file_get_num_signals(derived), ==, 1);
+    g_assert_cmpstr(
+            edf_header_get_patient(edf_file_header(derived)), ==, "montage patient"
+            );
+
+    EdfSignal* signal = g_ptr_array_index(edf_file_get_signals(derived), 0);
+    g_assert_cmpstr(edf_signal_get_label(signal), ==, "Fz-Cz");
+    g_assert_cmpstr(edf_signal_get_physical_dimension(signal), ==, "uV");
+    g_assert_cmpuint(edf_signal_get_num_records(signal), ==, NUM_RECORDS);
+    g_assert_cmpfloat_with_epsilon(edf_signal_get_physical_min(signal), -6553.5, 1e-9);
+    g_assert_cmpfloat_with_epsilon(edf_signal_get_physical_max(signal), 6553.5, 1e-9);
+
+    g_object_unref(derived);
+    g_object_unref(montage);
+    g_object_unref(file);
+}
+
+static void
+montage_convert(void)
+{
+    GError* error = NULL;
+    EdfMontage* montage = edf_montage_new();
+    gchar* output = g_build_filename(g_montage_dir, "bipolar.edf", NULL);
+
+    edf_montage_add_bipolar(montage, "Fz", "Cz");
+    edf_montage_add_bipolar(montage, "M1", "M2");
+    g_assert_true(edf_montage_convert(montage, g_input_file, output, &error));
+    g_assert_no_error(error);
+
+    EdfReader* reader = edf_reader_open(output, &error);
+    g_assert_no_error(error);
+    g_assert_cmpuint(edf_reader_get_num_channels(reader), ==, 2);
+    g_assert_cmpint(edf_reader_get_num_records(reader), ==, NUM_RECORDS);
+    g_assert_cmpstr(edf_reader_get_patient(reader), ==, "montage patient");
+    g_assert_cmpstr(edf_reader_get_channel(reader, 1)->label, ==, "M1-M2");
+
+    gdouble values[NS];
+    guint nrec = 0;
+    while (edf_reader_next_record(reader, &error)) {
+        const EdfReaderChannel* chan = edf_reader_get_channel(reader, 0);
+        edf_reader_get_physical(reader, 0, values);
+        // The derived values are quantized again
+        for (guint i = 0; i < NS; i++) {
+            guint s = nrec * NS + i;
+            g_assert_cmpfloat_with_epsilon(
+                    values[i], physical(0, s) - physical(1, s), chan->gain
+                    );
+        }
+        nrec++;
+    }
+    g_assert_no_error(error);
+    g_assert_cmpuint(nrec, ==, NUM_RECORDS);
+
+    edf_reader_free(reader);
+    g_object_unref(montage);
+    g_free(output);
+}
+
+static void
+montage_errors(void)
+{
+    GError* error = NULL;
+    EdfFile* file = create_file();
+    EdfMontage* montage = edf_montage_new();
+
+    g_assert_null(edf_montage_apply_to_file(montage, file, &error));
+    g_assert_error(error, EDF_MONTAGE_ERROR, EDF_MONTAGE_ERROR_EMPTY);
+    g_clear_error(&error);
+
+    edf_montage_add_bipolar(montage, "Fz", "Oz");
+    g_assert_null(edf_montage_apply_to_file(montage, file, &error));
+    g_assert_error(error, EDF_MONTAGE_ERROR, EDF_MONTAGE_ERROR_CHANNEL);
+    g_clear_error(&error);
+    g_object_unref(montage);
+
+    montage = edf_montage_new();
+    edf_montage_add_bipolar(montage, "Fz", "Temp");
+    g_assert_false(edf_montage_convert(montage, g_input_file, "unused.edf", &error));
+    g_assert_error(error, EDF_MONTAGE_ERROR, EDF_MONTAGE_ERROR_SAMPLE_RATE);
+    g_clear_error(&error);
+
+    g_object_unref(montage);
+    g_object_unref(file);
+}
+
+void add_montage_suite(void)
+{
+    g_assert_true(montage_test_init() == 0);
+
+    g_test_add_func("/EdfMontage/build", montage_build);
+    g_test_add_func("/EdfMontage/apply_record", montage_apply_record);
+    g_test_add_func("/EdfMontage/apply_to_file", montage_apply_to_file);
+    g_test_add_func("/EdfMontage/convert", montage_convert);
+    g_test_add_func("/EdfMontage/errors", montage_errors);
+}
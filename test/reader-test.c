@@ -0,0 +1,358 @@
+
+#include <gedf.h>
+#include <glib.h>
+
+#include "test-util.h"
+
+/* ******** global constants ********* */
+
+#define NS              200
+#define NS_SLOW         5
+#define NUM_RECORDS     6
+#define SAMPLE_RANGE(sample_size)   ((sample_size) == 3 ? 4000000 : 30000)
+
+// A sparse file of more than 8 GiB with more than 2^32 samples
+#define LARGE_NS            8192
+#define LARGE_NUM_RECORDS   ((G_GUINT64_CONSTANT(1) << 19) + 2)
+
+static gchar g_reader_dir[1024] = "";
+static gchar g_edf_file[1024] = "";
+static gchar g_bdf_file[1024] = "";
+static gchar g_gz_file[1024] = "";
+
+/* ******* utility functions ************ */
+
+static void
+write_file(const gchar* path, guint sample_size)
+{
+    EdfSignal *fast = test_create_signal(
+            "Fz", "active electrode", sample_size, NS, -3200.0, 3200.0
+            );
+    EdfSignal *slow = test_create_signal(
+            "Temp", "active electrode", sample_size, NS_SLOW, -3200.0, 3200.0
+            );
+    EdfFile   *file = test_create_file(1.0, fast, slow, NULL);
+
+    g_object_set(
+            edf_file_header(file),
+            "patient-identification", "reader patient",
+            "recording-identification", "reader recording",
+            NULL
+            );
+    test_fill_signal(fast, 0, NS * NUM_RECORDS, SAMPLE_RANGE(sample_size));
+    test_fill_signal(slow, 1, NS_SLOW * NUM_RECORDS, SAMPLE_RANGE(sample_size));
+    test_write_file(file, path);
+
+    g_object_unref(fast);
+    g_object_unref(slow);
+    g_object_unref(file);
+}
+
+static void
+check_record(EdfReader* reader, guint64 nrec, guint sample_size)
+{
+    gint32 digital[NS];
+    gdouble physical[NS];
+
+    for (guint c = 0; c < edf_reader_get_num_channels(reader); c++) {
+        const EdfReaderChannel* chan = edf_reader_get_channel(reader, c);
+        edf_reader_get_digital(reader, c, digital);
+        edf_reader_get_physical(reader, c, physical);
+
+        for (guint i = 0; i < chan->ns; i++) {
+            gint expected = test_sample_value(
+                    c, nrec * chan->ns + i, SAMPLE_RANGE(sample_size)
+                    );
+            g_assert_cmpint(digital[i], ==, expected);
+            g_assert_cmpfloat_with_epsilon(
+                    physical[i], chan->gain * expected + chan->phys_offset, 1e-9
+                    );
+            g_assert_cmpfloat(physical[i], >=, chan->physical_min - 1e-9);
+            g_assert_cmpfloat(physical[i], <=, chan->physical_max + 1e-9);
+        }
+    }
+}
+
+static int
+reader_test_init(void)
+{
+    gchar template[1024] = "gedf_reader_test_XXXXXX";
+    GError *error = NULL;
+    char *temp_dir = g_dir_make_tmp(template, &error);
+
+    if (error) {
+        g_printerr("Unable to open temp dir: %s\n", error->message);
+        g_error_free(error);
+        return -1;
+    }
+    g_snprintf(g_reader_dir, sizeof(g_reader_dir), "%s", temp_dir);
+    g_free(temp_dir);
+
+    g_snprintf(g_edf_file, sizeof(g_edf_file), "%s/%s", g_reader_dir, "reader.edf");
+    g_snprintf(g_bdf_file, sizeof(g_bdf_file), "%s/%s", g_reader_dir, "reader.bdf");
+    g_snprintf(g_gz_file, sizeof(g_gz_file), "%s/%s", g_reader_dir, "reader.edf.gz");
+
+    write_file(g_edf_file, 2);
+    write_file(g_bdf_file, 3);
+    write_file(g_gz_file, 2);
+    return 0;
+}
+
+/* ******* tests ******** */
+
+static void
+reader_header(void)
+{
+    GError* error = NULL;
+    EdfReader* reader = edf_reader_open(g_bdf_file, &error);
+    g_assert_no_error(error);
+
+    g_assert_cmpstr(edf_reader_get_patient(reader), ==, "reader patient");
+    g_assert_cmpstr(edf_reader_get_recording(reader), ==, "reader recording");
+    g_assert_cmpint(edf_reader_get_num_records(reader), ==, NUM_RECORDS);
+    g_assert_cmpfloat(edf_reader_get_record_duration(reader), ==, 1.0);
+    g_assert_cmpuint(edf_reader_get_record_size(reader), ==, (NS + NS_SLOW) * 3);
+    g_assert_cmpint(edf_reader_get_record_index(reader), ==, -1);
+
+    g_assert_cmpuint(edf_reader_get_num_channels(reader), ==, 2);
+    const EdfReaderChannel* fz = edf_reader_get_channel(reader, 0);
+    const EdfReaderChannel* temp = edf_reader_get_channel(reader, 1);
+    g_assert_cmpstr(fz->label, ==, "Fz");
+    g_assert_cmpstr(fz->physical_dimension, ==, "uV");
+    g_assert_cmpstr(fz->prefiltering, ==, "HP:0.1Hz");
+    g_assert_cmpint(fz->digital_min, ==, -8388608);
+    g_assert_cmpint(fz->digital_max, ==, 8388607);
+    g_assert_cmpuint(fz->ns, ==, NS);
+    g_assert_cmpuint(fz->sample_size, ==, 3);
+    g_assert_cmpuint(fz->offset, ==, 0);
+    g_assert_cmpstr(temp->label, ==, "Temp");
+    g_assert_cmpuint(temp->offset, ==, NS * 3);
+
+    g_assert_cmpint(edf_reader_find_channel(reader, "Temp"), ==, 1);
+    g_assert_cmpint(edf_reader_find_channel(reader, "Cz"), ==, -1);
+
+    edf_reader_free(reader);
+}
+
+static void
+reader_stream(gconstpointer data)
+{
+    const gchar* path = data;
+    guint sample_size = g_str_has_suffix(path, ".bdf") ? 3 : 2;
+    GError* error = NULL;
+    EdfReader* reader = edf_reader_open(path, &error);
+    g_assert_no_error(error);
+
+    guint64 nrec = 0;
+    while (edf_reader_next_record(reader, &error)) {
+        g_assert_cmpint(edf_reader_get_record_index(reader), ==, (gint64) nrec);
+        check_record(reader, nrec, sample_size);
+        nrec++;
+    }
+    g_assert_no_error(error);
+    g_assert_cmpuint(nrec, ==, NUM_RECORDS);
+
+    edf_reader_free(reader);
+}
+
+static void
+reader_seek(void)
+{
+    GError* error = NULL;
+    EdfReader* reader = edf_reader_open(g_edf_file, &error);
+    g_assert_no_error(error);
+
+    const guint64 order[] = {3, 0, NUM_RECORDS - 1, 1};
+    for (guint i = 0; i < G_N_ELEMENTS(order); i++) {
+        g_assert_true(edf_reader_seek_record(reader, order[i], &error));
+        g_assert_no_error(error);
+        g_assert_cmpint(edf_reader_get_record_index(reader), ==, (gint64) order[i]);
+        check_record(reader, order[i], 2);
+    }
+
+    // reading continues after the record that was seeked
+    g_assert_true(edf_reader_next_record(reader, &error));
+    check_record(reader, 2, 2);
+
+    g_assert_false(edf_reader_seek_record(reader, NUM_RECORDS, &error));
+    g_assert_error(error, EDF_READER_ERROR, EDF_READER_ERROR_OUT_OF_RANGE);
+    g_clear_error(&error);
+
+    edf_reader_free(reader);
+
+    // A compressed file can only be streamed
+    reader = edf_reader_open(g_gz_file, &error);
+    g_assert_no_error(error);
+    g_assert_false(edf_reader_seek_record(reader, 1, &error));
+    g_assert_error(error, EDF_READER_ERROR, EDF_READER_ERROR_NOT_SEEKABLE);
+    g_clear_error(&error);
+    edf_reader_free(reader);
+}
+
+static void
+reader_truncated(void)
+{
+    GError* error = NULL;
+    gchar* contents = NULL;
+    gsize length = 0;
+    gchar* path = g_build_filename(g_reader_dir, "truncated.edf", NULL);
+
+    g_file_get_contents(g_edf_file, &contents, &length, &error);
+    g_assert_no_error(error);
+    g_file_set_contents(path, contents, length - 10, &error);
+    g_assert_no_error(error);
+
+    EdfReader* reader = edf_reader_open(path, &error);
+    g_assert_no_error(error);
+
+    guint nrec = 0;
+    while (edf_reader_next_record(reader, &error))
+        nrec++;
+    g_assert_cmpuint(nrec, ==, NUM_RECORDS - 1);
+    g_assert_error(error, EDF_READER_ERROR, EDF_READER_ERROR_TRUNCATED);
+    g_clear_error(&error);
+    edf_reader_free(reader);
+
+    // A failed seek leaves the reader at its current record
+    reader = edf_reader_open(path, &error);
+    g_assert_no_error(error);
+    g_assert_true(edf_reader_seek_record(reader, 2, &error));
+    g_assert_false(edf_reader_seek_record(reader, NUM_RECORDS - 1, &error));
+    g_assert_error(error, EDF_READER_ERROR, EDF_READER_ERROR_TRUNCATED);
+    g_clear_error(&error);
+    g_assert_cmpint(edf_reader_get_record_index(reader), ==, 2);
+    check_record(reader, 2, 2);
+
+    g_assert_true(edf_reader_next_record(reader, &error));
+    g_assert_cmpint(edf_reader_get_record_index(reader), ==, 3);
+    check_record(reader, 3, 2);
+    edf_reader_free(reader);
+
+    // Only a part of the header
+    g_file_set_contents(path, contents, 300, &error);
+    g_assert_no_error(error);
+    g_assert_null(edf_reader_open(path, &error));
+    g_assert_error(error, EDF_HEADER_ERROR, EDF_HEADER_ERROR_PARSE);
+    g_clear_error(&error);
+
+    g_free(contents);
+    g_free(path);
+}
+
+/*
+ * Only the header and the last record of the file are written, the rest is
+ * a hole. The offsets and sample indices of the last record don't fit in
+ * 32 bits.
+ */
+static void
+reader_large_file(void)
+{
+    GError* error = NULL;
+    gchar* path = g_build_filename(g_reader_dir, "large.edf", NULL);
+    GFile* gfile = g_file_new_for_path(path);
+    const gsize record_size = LARGE_NS * 2;
+    const guint64 last = LARGE_NUM_RECORDS - 1;
+
+    EdfHeader* header = edf_header_new();
+    GPtrArray* signals = g_ptr_array_new_full(1, g_object_unref);
+    g_ptr_array_add(
+            signals, test_create_signal("Fz", "active electrode", 2, LARGE_NS, -3200.0, 3200.0)
+            );
+    edf_header_set_signals(header, signals);
+    g_ptr_array_unref(signals);
+    edf_header_set_expected_num_records(header, LARGE_NUM_RECORDS);
+
+    GFileOutputStream* ostream = g_file_replace(
+            gfile, NULL, FALSE, G_FILE_CREATE_NONE, NULL, &error
+            );
+    g_assert_no_error(error);
+    gsize header_size = edf_header_write_to_ostream(
+            header, G_OUTPUT_STREAM(ostream), &error
+            );
+    g_assert_no_error(error);
+
+    guint64 file_size = header_size + LARGE_NUM_RECORDS * record_size;
+    if (!g_seekable_truncate(G_SEEKABLE(ostream), file_size, NULL, &error)) {
+        g_test_skip("The file system doesn't support large sparse files");
+        g_clear_error(&error);
+        goto out;
+    }
+
+    guint8* record = g_malloc(record_size);
+    for (guint i = 0; i < LARGE_NS; i++) {
+        guint16 v = (guint16) test_sample_value(0, last * LARGE_NS + i, SAMPLE_RANGE(2));
+        record[2 * i] = v & 0xff;
+        record[2 * i + 1] = v >> 8;
+    }
+    g_seekable_seek(
+            G_SEEKABLE(ostream), header_size + last * record_size, G_SEEK_SET,
+            NULL, &error
+            );
+    g_assert_no_error(error);
+    g_output_stream_write_all(
+            G_OUTPUT_STREAM(ostream), record, record_size, NULL, NULL, &error
+            );
+    g_assert_no_error(error);
+    g_output_stream_close(G_OUTPUT_STREAM(ostream), NULL, &error);
+    g_assert_no_error(error);
+    g_free(record);
+
+    // The structure follows from the size of the file
+    EdfFile* file = edf_file_new_for_path(path);
+    EdfFileReport report;
+    g_assert_true(edf_file_validate(file, &report, &error));
+    g_assert_no_error(error);
+    g_assert_cmpuint(report.file_size, ==, file_size);
+    g_assert_cmpuint(report.file_size, >, G_MAXUINT32);
+    g_assert_cmpuint(report.num_records, ==, LARGE_NUM_RECORDS);
+    g_assert_cmpint(report.declared_num_records, ==, (gint64) LARGE_NUM_RECORDS);
+    g_object_unref(file);
+
+    EdfReader* reader = edf_reader_open(path, &error);
+    g_assert_no_error(error);
+    g_assert_cmpint(edf_reader_get_num_records(reader), ==, (gint64) LARGE_NUM_RECORDS);
+
+    gint32* digital = g_new(gint32, LARGE_NS);
+    g_assert_true(edf_reader_seek_record(reader, last, &error));
+    g_assert_no_error(error);
+    g_assert_cmpint(edf_reader_get_record_index(reader), ==, (gint64) last);
+    edf_reader_get_digital(reader, 0, digital);
+    g_assert_cmpuint(last * LARGE_NS, >, G_MAXUINT32);
+    for (guint i = 0; i < LARGE_NS; i++)
+        g_assert_cmpint(
+                digital[i], ==, test_sample_value(0, last * LARGE_NS + i, SAMPLE_RANGE(2))
+                );
+
+    // A record in the hole reads as zeros
+    g_assert_true(edf_reader_seek_record(reader, last - 1, &error));
+    g_assert_no_error(error);
+    edf_reader_get_digital(reader, 0, digital);
+    g_assert_cmpint(digital[0], ==, 0);
+
+    g_assert_true(edf_reader_next_record(reader, &error));
+    g_assert_cmpint(edf_reader_get_record_index(reader), ==, (gint64) last);
+    g_assert_false(edf_reader_next_record(reader, &error));
+    g_assert_no_error(error);
+
+    g_free(digital);
+    edf_reader_free(reader);
+out:
+    g_object_unref(ostream);
+    g_file_delete(gfile, NULL, NULL);
+    g_object_unref(gfile);
+    g_object_unref(header);
+    g_free(path);
+}
+
+void add_reader_suite(void)
+{
+    g_assert_true(reader_test_init() == 0);
+
+    g_test_add_func("/EdfReader/header", reader_header);
+    g_test_add_data_func("/EdfReader/stream_edf", g_edf_file, reader_stream);
+    g_test_add_data_func("/EdfReader/stream_bdf", g_bdf_file, reader_stream);
+    g_test_add_data_func("/EdfReader/stream_gzip", g_gz_file, reader_stream);
+    g_test_add_func("/EdfReader/seek", reader_seek);
+    g_test_add_func("/EdfReader/truncated", reader_truncated);
+    g_test_add_func("/EdfReader/large_file", reader_large_file);
+}
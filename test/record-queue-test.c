@@ -0,0 +1,166 @@
+
+#include <gedf.h>
+#include <glib.h>
+#include <string.h>
+
+/* ******** global constants ********* */
+
+#define RECORD_SIZE     24
+#define NUM_RECORDS     200000
+
+/* ******* utility functions ************ */
+
+/* A record that contains its sequence number */
+static void
+fill_record(guint8* record, guint32 seq)
+{
+    for (guint i = 0; i < RECORD_SIZE; i += sizeof(seq))
+        memcpy(&record[i], &seq, sizeof(seq));
+}
+
+static guint32
+record_seq(const guint8* record)
+{
+    guint32 seq;
+    memcpy(&seq, record, sizeof(seq));
+    for (guint i = sizeof(seq); i < RECORD_SIZE; i += sizeof(seq))
+        g_assert_cmpmem(&record[i], sizeof(seq), &seq, sizeof(seq));
+    return seq;
+}
+
+typedef struct {
+    EdfRecordQueue *queue;
+    guint           num_pushed;
+} Producer;
+
+static gpointer
+produce(gpointer data)
+{
+    Producer* producer = data;
+    for (guint32 seq = 0; seq < NUM_RECORDS; seq++) {
+        guint8* record = edf_record_queue_acquire(producer->queue);
+        if (!record)
+            continue;
+        fill_record(record, seq);
+        edf_record_queue_publish(producer->queue);
+        producer->num_pushed++;
+    }
+    return NULL;
+}
+
+/* ******* tests ******** */
+
+static void
+record_queue_single_thread(void)
+{
+    EdfRecordQueue* queue = edf_record_queue_new(RECORD_SIZE, 3);
+    guint8 record[RECORD_SIZE];
+    guint n = 0;
+
+    g_assert_cmpuint(edf_record_queue_get_capacity(queue), ==, 4);
+    g_assert_null(edf_record_queue_peek(queue, &n));
+    g_assert_cmpuint(n, ==, 0);
+
+    for (guint32 seq = 0; seq < 6; seq++) {
+        fill_record(record, seq);
+        g_assert_true(edf_record_queue_push(queue, record) == (seq < 4));
+    }
+    g_assert_cmpuint(edf_record_queue_get_num_queued(queue), ==, 4);
+    g_assert_cmpuint(edf_record_queue_get_num_dropped(queue), ==, 2);
+    g_assert_cmpuint(edf_record_queue_get_high_water(queue), ==, 4);
+
+    const guint8* records = edf_record_queue_peek(queue, &n);
+    g_assert_cmpuint(n, ==, 4);
+    g_assert_cmpuint(record_seq(records), ==, 0);
+    edf_record_queue_release(queue, 3);
+
+    // The next records wrap around the end of the ring
+    for (guint32 seq = 10; seq < 13; seq++) {
+        fill_record(record, seq);
+        g_assert_true(edf_record_queue_push(queue, record));
+    }
+
+    records = edf_record_queue_peek(queue, &n);
+    g_assert_cmpuint(n, ==, 1);
+    g_assert_cmpuint(record_seq(records), ==, 3);
+    edf_record_queue_release(queue, n);
+
+    records = edf_record_queue_peek(queue, &n);
+    g_assert_cmpuint(n, ==, 3);
+    for (guint i = 0; i < n; i++)
+        g_assert_cmpuint(record_seq(&records[i * RECORD_SIZE]), ==, 10 + i);
+    edf_record_queue_release(queue, n);
+    g_assert_cmpuint(edf_record_queue_get_num_queued(queue), ==, 0);
+
+    edf_record_queue_free(queue);
+}
+
+static void
+record_queue_threads(void)
+{
+    EdfRecordQueue* queue = edf_record_queue_new(RECORD_SIZE, 64);
+    Producer producer = {queue, 0};
+    guint num_consumed = 0;
+    gint64 last = -1;
+
+    GThread* thread = g_thread_new("producer", produce, &producer);
+
+    // Every record arrives once and in order, the others are counted as dropped
+    while (num_consumed + edf_record_queue_get_num_dropped(queue) < NUM_RECORDS) {
+        guint n = 0;
+        const guint8* records = edf_record_queue_peek(queue, &n);
+        for (guint i = 0; i < n; i++) {
+            gint64 seq = record_seq(&records[i * RECORD_SIZE]);
+            g_assert_cmpint(seq, >, last);
+            last = seq;
+        }
+        edf_record_queue_release(queue, n);
+        num_consumed += n;
+    }
+    g_thread_join(thread);
+
+    g_assert_cmpuint(num_consumed, ==, producer.num_pushed);
+    g_assert_cmpuint(num_consumed + edf_record_queue_get_num_dropped(queue), ==, NUM_RECORDS);
+    g_assert_cmpuint(edf_record_queue_get_high_water(queue), <=, 64);
+
+    edf_record_queue_free(queue);
+}
+
+static void
+record_queue_writer(void)
+{
+    GError* error = NULL;
+    EdfRecordQueue* queue = edf_record_queue_new(RECORD_SIZE, 1024);
+    GOutputStream* ostream = g_memory_output_stream_new_resizable();
+    Producer producer = {queue, 0};
+    guint64 num_written = 0;
+
+    EdfRecordWriter* writer = edf_record_writer_new(queue, ostream);
+    produce(&producer);
+    g_assert_true(edf_record_writer_finish(writer, &num_written, &error));
+    g_assert_no_error(error);
+
+    g_assert_cmpuint(num_written, ==, producer.num_pushed);
+    g_assert_cmpuint(num_written + edf_record_queue_get_num_dropped(queue), ==, NUM_RECORDS);
+
+    GMemoryOutputStream* memstream = G_MEMORY_OUTPUT_STREAM(ostream);
+    const guint8* bytes = g_memory_output_stream_get_data(memstream);
+    g_assert_cmpuint(g_memory_output_stream_get_data_size(memstream), ==, num_written * RECORD_SIZE);
+
+    gint64 last = -1;
+    for (guint64 i = 0; i < num_written; i++) {
+        gint64 seq = record_seq(&bytes[i * RECORD_SIZE]);
+        g_assert_cmpint(seq, >, last);
+        last = seq;
+    }
+
+    g_object_unref(ostream);
+    edf_record_queue_free(queue);
+}
+
+void add_record_queue_suite(void)
+{
+    g_test_add_func("/EdfRecordQueue/single_thread", record_queue_single_thread);
+    g_test_add_func("/EdfRecordQueue/threads", record_queue_threads);
+    g_test_add_func("/EdfRecordQueue/writer", record_queue_writer);
+}
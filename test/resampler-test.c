@@ -0,0 +1,174 @@
+
+#include <gedf.h>
+#include <glib.h>
+#include <math.h>
+
+/* ******** global constants ********* */
+
+#define NUM_RECORDS     4
+
+/* ******* utility functions ************ */
+
+static gdouble
+sine(gdouble frequency, gdouble sample_rate, guint64 sample)
+{
+    return sin(2 * G_PI * frequency * sample / sample_rate);
+}
+
+/*
+ * Resamples NUM_RECORDS records of a sine of rate_in Hz, in pieces of
+ * chunk samples and checks the output away from the ends of the signal.
+ */
+static void
+check_sine(guint rate_in, guint rate_out, gdouble frequency, guint chunk)
+{
+    GError* error = NULL;
+    EdfResampler* resampler = edf_resampler_new(rate_out, rate_in, &error);
+    g_assert_no_error(error);
+
+    guint num_in = rate_in * NUM_RECORDS;
+    gdouble* input = g_new(gdouble, num_in);
+    for (guint i = 0; i < num_in; i++)
+        input[i] = sine(frequency, rate_in, i);
+
+    gsize max_out = edf_resampler_get_max_output(resampler, num_in);
+    g_assert_cmpuint(max_out, ==, rate_out * NUM_RECORDS);
+
+    gdouble* output = g_new(gdouble, max_out);
+    gsize num_out = 0;
+    for (guint start = 0; start < num_in; start += chunk) {
+        guint n = MIN(chunk, num_in - start);
+        num_out += edf_resampler_process(
+                resampler, &input[start], n, &output[num_out]
+                );
+        g_assert_cmpuint(num_out, <=, max_out);
+    }
+    num_out += edf_resampler_flush(resampler, &output[num_out]);
+    g_assert_cmpuint(num_out, ==, max_out);
+
+    for (gsize m = num_out / 10; m < num_out * 9 / 10; m++)
+        g_assert_cmpfloat_with_epsilon(output[m], sine(frequency, rate_out, m), 5e-3);
+
+    g_free(input);
+    g_free(output);
+    g_object_unref(resampler);
+}
+
+/* ******* tests ******** */
+
+static void
+resampler_ratio(void)
+{
+    GError* error = NULL;
+    EdfResampler* resampler = edf_resampler_new(256, 2048, &error);
+    g_assert_no_error(error);
+    g_assert_cmpuint(edf_resampler_get_up(resampler), ==, 1);
+    g_assert_cmpuint(edf_resampler_get_down(resampler), ==, 8);
+    g_assert_cmpuint(edf_resampler_get_num_taps(resampler), >, 8);
+    g_object_unref(resampler);
+
+    g_assert_null(edf_resampler_new(0, 2048, &error));
+    g_assert_error(error, EDF_RESAMPLER_ERROR, EDF_RESAMPLER_ERROR_RATIO);
+    g_clear_error(&error);
+
+    g_assert_null(edf_resampler_new(10007, 10009, &error));
+    g_assert_error(error, EDF_RESAMPLER_ERROR, EDF_RESAMPLER_ERROR_RATIO);
+    g_clear_error(&error);
+}
+
+static void
+resampler_downsample(void)
+{
+    check_sine(2048, 256, 10, 2048);
+    check_sine(2048, 256, 10, 37);
+}
+
+static void
+resampler_rational(void)
+{
+    check_sine(256, 384, 10, 256);
+    check_sine(300, 200, 7, 64);
+}
+
+static void
+resampler_chunks(void)
+{
+    GError* error = NULL;
+    EdfResampler* whole = edf_resampler_new(3, 2, &error);
+    EdfResampler* pieces = edf_resampler_new(3, 2, &error);
+    g_assert_no_error(error);
+
+    gdouble input[1000];
+    for (guint i = 0; i < G_N_ELEMENTS(input); i++)
+        input[i] = ((i * 7919) % 2001) / 100.0 - 10;
+
+    gdouble expected[1500], output[1500];
+    gsize n_expected = edf_resampler_process(whole, input, 1000, expected);
+    n_expected += edf_resampler_flush(whole, &expected[n_expected]);
+
+    // The history carries over, the output is identical
+    gsize n = 0;
+    for (guint start = 0; start < 1000; start += 13)
+        n += edf_resampler_process(pieces, &input[start], MIN(13, 1000 - start), &output[n]);
+    n += edf_resampler_flush(pieces, &output[n]);
+
+    g_assert_cmpuint(n, ==, n_expected);
+    g_assert_cmpuint(n, ==, 1500);
+    for (gsize i = 0; i < n; i++)
+        g_assert_cmpfloat(output[i], ==, expected[i]);
+
+    // after a flush the resampler starts over
+    n = edf_resampler_process(pieces, input, 1000, output);
+    n += edf_resampler_flush(pieces, &output[n]);
+    for (gsize i = 0; i < n; i++)
+        g_assert_cmpfloat(output[i], ==, expected[i]);
+
+    g_object_unref(whole);
+    g_object_unref(pieces);
+}
+
+static void
+resampler_signal(void)
+{
+    GError* error = NULL;
+    const guint ns = 200;
+    EdfSignal* signal = g_object_new(
+            EDF_TYPE_SIGNAL,
+            "label", "Fz",
+            "physical-dimension", "uV",
+            "physical-min", -3276.8,
+            "physical-max", 3276.7,
+            "digital-min", -32768,
+            "digital-max", 32767,
+            "ns", ns,
+            NULL
+            );
+
+    for (guint i = 0; i < ns * NUM_RECORDS; i++) {
+        edf_signal_append_digital(signal, (gint) round(10000 * sine(3, ns, i)), &error);
+        g_assert_no_error(error);
+    }
+
+    EdfSignal* resampled = edf_signal_resample(signal, 50, &error);
+    g_assert_no_error(error);
+    g_assert_cmpstr(edf_signal_get_label(resampled), ==, "Fz");
+    g_assert_cmpint(edf_signal_get_num_samples_per_record(resampled), ==, 50);
+    g_assert_cmpuint(edf_signal_get_num_records(resampled), ==, NUM_RECORDS);
+    g_assert_cmpint(edf_signal_get_digital_max(resampled), ==, 32767);
+
+    g_assert_null(edf_signal_resample(signal, 0, &error));
+    g_assert_error(error, EDF_RESAMPLER_ERROR, EDF_RESAMPLER_ERROR_RATIO);
+    g_clear_error(&error);
+
+    g_object_unref(resampled);
+    g_object_unref(signal);
+}
+
+void add_resampler_suite(void)
+{
+    g_test_add_func("/EdfResampler/ratio", resampler_ratio);
+    g_test_add_func("/EdfResampler/downsample", resampler_downsample);
+    g_test_add_func("/EdfResampler/rational", resampler_rational);
+    g_test_add_func("/EdfResampler/chunks", resampler_chunks);
+    g_test_add_func("/EdfResampler/signal", resampler_signal);
+}
@@ -158,6 +158,138 @@ signal_append_digital_range_error(void)
     g_object_unref(signal);
 }
 
+static void
+signal_get_values(void)
+{
+    GError *error = NULL;
+    EdfSignal* signal = edf_signal_new_full(
+            "Eeg", "Active Electrode", "uV", -100.0, 100.0, -1000, 1000, "", 10
+            );
+
+    for (gint s = -1000; s <= 1000; s += 100) {
+        edf_signal_append_digital(signal, s, &error);
+        g_assert_no_error(error);
+    }
+
+    GArray* values = edf_signal_get_values(signal);
+    for (guint i = 0; i <= 20; i++)
+        g_assert_cmpfloat_with_epsilon(
+                g_array_index(values, gdouble, i), -100.0 + 10.0 * i, 1e-9
+                );
+
+    g_array_unref(values);
+    g_object_unref(signal);
+}
+
+static void
+signal_copy_values(void)
+{
+    GError *error = NULL;
+    gdouble f64[32];
+    gfloat f32[32];
+    EdfSignal* signal = edf_signal_new_full(
+            "Eeg", "Active Electrode", "uV", -100.0, 100.0, -1000, 1000, "", 10
+            );
+
+    // 3 records of which the last holds one sample
+    for (gint s = -1000; s <= 1000; s += 100) {
+        edf_signal_append_digital(signal, s, &error);
+        g_assert_no_error(error);
+    }
+    g_assert_cmpuint(edf_signal_get_num_samples(signal), ==, 21);
+
+    g_assert_cmpuint(edf_signal_copy_values_f64(signal, 0, G_MAXSIZE, f64), ==, 21);
+    for (guint i = 0; i < 21; i++)
+        g_assert_cmpfloat_with_epsilon(f64[i], -100.0 + 10.0 * i, 1e-9);
+
+    // A range that crosses the boundaries of the records
+    g_assert_cmpuint(edf_signal_copy_values_f32(signal, 5, 12, f32), ==, 12);
+    for (guint i = 0; i < 12; i++)
+        g_assert_cmpfloat_with_epsilon(f32[i], -50.0 + 10.0 * i, 1e-4);
+
+    g_assert_cmpuint(edf_signal_copy_values_f32(signal, 18, 10, f32), ==, 3);
+    g_assert_cmpfloat_with_epsilon(f32[2], 100.0, 1e-4);
+    g_assert_cmpuint(edf_signal_copy_values_f32(signal, 21, 10, f32), ==, 0);
+
+    g_object_unref(signal);
+
+    // Single precision values are the rounded double precision ones
+    signal = g_object_new(
+            EDF_TYPE_SIGNAL,
+            "sample-size", 3,
+            "physical-min", -262144.0,
+            "physical-max", 262143.0,
+            "digital-min", -8388608,
+            "digital-max", 8388607,
+            "ns", 32,
+            NULL
+            );
+    for (gint i = 0; i < 32; i++) {
+        edf_signal_append_digital(signal, 8388607 - 524287 * i, &error);
+        g_assert_no_error(error);
+    }
+    edf_signal_copy_values_f64(signal, 0, 32, f64);
+    edf_signal_copy_values_f32(signal, 0, 32, f32);
+    for (guint i = 0; i < 32; i++)
+        g_assert_true(f32[i] == (gfloat) f64[i]);
+
+    g_object_unref(signal);
+}
+
+static void
+signal_ring_buffer(void)
+{
+    GError *error = NULL;
+    EdfSignalSpan spans[2];
+    gdouble values[100];
+    EdfSignal* signal = edf_signal_new_full(
+            "Eeg", "Active Electrode", "uV", -100.0, 100.0, -1000, 1000, "", 4
+            );
+
+    // The records that exist are kept
+    for (gint s = 0; s < 6; s++) {
+        edf_signal_append_digital(signal, s, &error);
+        g_assert_no_error(error);
+    }
+    edf_signal_set_ring_capacity(signal, 3);
+    g_assert_cmpuint(edf_signal_get_ring_capacity(signal), ==, 3);
+    g_assert_cmpuint(edf_signal_get_num_records(signal), ==, 2);
+    g_assert_cmpuint(edf_signal_copy_latest(signal, 100, values), ==, 6);
+    g_assert_cmpfloat_with_epsilon(values[5], 0.5, 1e-9);
+
+    // 7 records of which the last is incomplete, the latest 3 remain
+    for (gint s = 6; s < 26; s++) {
+        edf_signal_append_digital(signal, s, &error);
+        g_assert_no_error(error);
+    }
+    g_assert_cmpuint(edf_signal_get_num_records(signal), ==, 3);
+    g_assert_cmpuint(edf_signal_get_num_dropped_records(signal), ==, 4);
+
+    GArray* all = edf_signal_get_values(signal);
+    g_assert_cmpfloat_with_epsilon(g_array_index(all, gdouble, 0), 1.6, 1e-9);
+    g_array_unref(all);
+
+    // The window wraps around the end of the buffer
+    g_assert_cmpuint(edf_signal_get_latest_spans(signal, 100, spans), ==, 2);
+    g_assert_cmpuint(spans[0].num_samples, ==, 8);
+    g_assert_cmpuint(spans[1].num_samples, ==, 2);
+    g_assert_cmpuint(spans[0].bytes[0], ==, 16);
+    g_assert_cmpuint(spans[1].bytes[0], ==, 24);
+
+    g_assert_cmpuint(edf_signal_get_latest_spans(signal, 2, spans), ==, 1);
+    g_assert_cmpuint(spans[0].num_samples, ==, 2);
+    g_assert_null(spans[1].bytes);
+
+    g_assert_cmpuint(edf_signal_copy_latest(signal, 5, values), ==, 5);
+    for (guint i = 0; i < 5; i++)
+        g_assert_cmpfloat_with_epsilon(values[i], 0.1 * (21 + i), 1e-9);
+
+    g_assert_cmpuint(edf_signal_copy_latest(signal, 100, values), ==, 10);
+    for (guint i = 0; i < 10; i++)
+        g_assert_cmpfloat_with_epsilon(values[i], 0.1 * (16 + i), 1e-9);
+
+    g_object_unref(signal);
+}
 
 void add_signal_suite()
 {
@@ -166,4 +298,7 @@ void add_signal_suite()
     g_test_add_func("/EdfSignal/append_digital",signal_append_digital);
     g_test_add_func("/EdfSignal/append_digital_range_error",
                     signal_append_digital_range_error);
+    g_test_add_func("/EdfSignal/get_values", signal_get_values);
+    g_test_add_func("/EdfSignal/copy_values", signal_copy_values);
+    g_test_add_func("/EdfSignal/ring_buffer", signal_ring_buffer);
 }
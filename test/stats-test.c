@@ -0,0 +1,161 @@
+
+#include <gedf.h>
+#include <glib.h>
+#include <math.h>
+
+#include "test-util.h"
+
+/* ******** global constants ********* */
+
+#define NS              64
+#define NUM_SAMPLES     1000
+
+/* ******* utility functions ************ */
+
+/*
+ * A signal that saturates for 10 samples at the minimum and 5 at the
+ * maximum and is flat for a while.
+ */
+static gint32
+sample_value(guint i)
+{
+    if (i < 10)
+        return -100;
+    if (i < 15)
+        return 100;
+    if (i >= 500 && i < 700)
+        return 7;
+    return test_sample_value(0, i, 75);
+}
+
+static EdfSignal*
+create_signal(void)
+{
+    EdfSignal* signal = test_create_signal("Fz", "electrode", 2, NS, -10.0, 10.0);
+
+    // A small digital range, so that the signal saturates
+    edf_signal_set_digital_min(signal, -100);
+    edf_signal_set_digital_max(signal, 100);
+    for (guint i = 0; i < NUM_SAMPLES; i++)
+        test_append_digital(signal, sample_value(i));
+    return signal;
+}
+
+/* ******* tests ******** */
+
+static void
+stats_signal(void)
+{
+    EdfSignal* signal = create_signal();
+    EdfSignalStats stats;
+    gdouble sum = 0, sum2 = 0;
+    guint64 histogram_total = 0;
+
+    for (guint i = 0; i < NUM_SAMPLES; i++)
+        sum += 0.1 * sample_value(i);
+    for (guint i = 0; i < NUM_SAMPLES; i++)
+        sum2 += pow(0.1 * sample_value(i) - sum / NUM_SAMPLES, 2);
+
+    edf_signal_compute_stats(signal, &stats);
+
+    // The padding of the incomplete last record isn't counted
+    g_assert_cmpuint(stats.num_samples, ==, NUM_SAMPLES);
+    g_assert_cmpint(stats.digital_min, ==, -100);
+    g_assert_cmpint(stats.digital_max, ==, 100);
+    g_assert_cmpfloat_with_epsilon(stats.min, -10.0, 1e-9);
+    g_assert_cmpfloat_with_epsilon(stats.max, 10.0, 1e-9);
+    g_assert_cmpfloat_with_epsilon(stats.mean, sum / NUM_SAMPLES, 1e-9);
+    g_assert_cmpfloat_with_epsilon(stats.variance, sum2 / NUM_SAMPLES, 1e-9);
+    g_assert_cmpfloat_with_epsilon(
+            stats.rms, sqrt(pow(sum / NUM_SAMPLES, 2) + sum2 / NUM_SAMPLES), 1e-9
+            );
+    g_assert_cmpuint(stats.num_at_digital_min, ==, 10);
+    g_assert_cmpuint(stats.num_at_digital_max, ==, 5);
+    g_assert_cmpuint(stats.longest_flat_run, ==, 200);
+
+    for (guint b = 0; b < EDF_STATS_HISTOGRAM_BINS; b++)
+        histogram_total += stats.histogram[b];
+    g_assert_cmpuint(histogram_total, ==, NUM_SAMPLES);
+    g_assert_cmpuint(stats.histogram[0], >=, 10);
+    g_assert_cmpuint(stats.histogram[EDF_STATS_HISTOGRAM_BINS - 1], >=, 5);
+
+    // The same statistics from the digital values in one call
+    EdfSignalStats digital;
+    gint32 values[NUM_SAMPLES];
+    for (guint i = 0; i < NUM_SAMPLES; i++)
+        values[i] = sample_value(i);
+    edf_signal_stats_init(&digital, -100, 100, 0.1, 0.0);
+    edf_signal_stats_add_digital(&digital, values, NUM_SAMPLES);
+
+    g_assert_cmpuint(digital.num_samples, ==, stats.num_samples);
+    g_assert_cmpfloat_with_epsilon(digital.mean, stats.mean, 1e-9);
+    g_assert_cmpfloat_with_epsilon(digital.variance, stats.variance, 1e-9);
+    g_assert_cmpuint(digital.longest_flat_run, ==, stats.longest_flat_run);
+    for (guint b = 0; b < EDF_STATS_HISTOGRAM_BINS; b++)
+        g_assert_cmpuint(digital.histogram[b], ==, stats.histogram[b]);
+
+    g_object_unref(signal);
+}
+
+static void
+stats_offset(void)
+{
+    // A small signal on top of a large DC offset, spread over many blocks
+    const guint n = 100000;
+    gint32* values = g_new(gint32, n);
+    EdfSignalStats stats;
+
+    for (guint i = 0; i < n; i++)
+        values[i] = 8000000 + (i % 2);
+
+    edf_signal_stats_init(&stats, -8388608, 8388607, 1.0, 0.0);
+    edf_signal_stats_add_digital(&stats, values, n / 2);
+    edf_signal_stats_add_digital(&stats, &values[n / 2], n / 2);
+
+    g_assert_cmpuint(stats.num_samples, ==, n);
+    g_assert_cmpfloat_with_epsilon(stats.mean, 8000000.5, 1e-6);
+    g_assert_cmpfloat_with_epsilon(stats.variance, 0.25, 1e-6);
+    g_assert_cmpuint(stats.longest_flat_run, ==, 1);
+    g_assert_cmpuint(stats.num_at_digital_max, ==, 0);
+
+    g_free(values);
+}
+
+static void
+stats_file(void)
+{
+    GError* error = NULL;
+    EdfFile* file = edf_file_new();
+    EdfSignal* signal = create_signal();
+    EdfSignal* flat = edf_signal_new_full(
+            "Cz", "electrode", "uV", -10.0, 10.0, -100, 100, "", NS
+            );
+    guint num_signals = 0;
+
+    for (guint i = 0; i < NS; i++) {
+        edf_signal_append_digital(flat, 3, &error);
+        g_assert_no_error(error);
+    }
+    edf_file_add_signal(file, signal);
+    edf_file_add_signal(file, flat);
+
+    EdfSignalStats* stats = edf_file_compute_stats(file, &num_signals);
+    g_assert_cmpuint(num_signals, ==, 2);
+    g_assert_cmpuint(stats[0].num_samples, ==, NUM_SAMPLES);
+    g_assert_cmpuint(stats[1].num_samples, ==, NS);
+    g_assert_cmpuint(stats[1].longest_flat_run, ==, NS);
+    g_assert_cmpfloat_with_epsilon(stats[1].mean, 0.3, 1e-9);
+    g_assert_cmpfloat_with_epsilon(stats[1].variance, 0.0, 1e-9);
+
+    g_free(stats);
+    g_object_unref(signal);
+    g_object_unref(flat);
+    g_object_unref(file);
+}
+
+void add_stats_suite(void)
+{
+    g_test_add_func("/EdfStats/signal", stats_signal);
+    g_test_add_func("/EdfStats/offset", stats_offset);
+    g_test_add_func("/EdfStats/file", stats_file);
+}
@@ -2,8 +2,22 @@
 #ifndef SUITES_H
 #define SUITES_H
 
+void add_catalog_suite(void);
+void add_codec_suite(void);
+void add_cursor_suite(void);
+void add_epocher_suite(void);
 void add_file_suite(void);
+void add_filter_suite(void);
+void add_follower_suite(void);
+void add_header_cache_suite(void);
 void add_header_suite(void);
+void add_matrix_suite(void);
+void add_montage_suite(void);
+void add_reader_suite(void);
+void add_record_queue_suite(void);
+void add_resampler_suite(void);
 void add_signal_suite(void);
+void add_stats_suite(void);
+void add_trigger_index_suite(void);
 
 #endif
@@ -0,0 +1,80 @@
+
+#include "test-util.h"
+
+#include <stdarg.h>
+
+gint
+test_sample_value(guint channel, guint64 sample, gint range)
+{
+    guint64 modulus = 2 * (guint64) range + 1;
+    return (gint) ((sample * 7919 + channel * 104729) % modulus) - range;
+}
+
+EdfSignal*
+test_create_signal(
+        const gchar    *label,
+        const gchar    *transducer,
+        guint           sample_size,
+        guint           ns,
+        gdouble         physical_min,
+        gdouble         physical_max
+        )
+{
+    gint dmin = sample_size == 3 ? -8388608 : -32768;
+    gint dmax = sample_size == 3 ? 8388607 : 32767;
+    return g_object_new(
+            EDF_TYPE_SIGNAL,
+            "sample-size", sample_size,
+            "label", label,
+            "transducer", transducer,
+            "physical-dimension", "uV",
+            "physical-min", physical_min,
+            "physical-max", physical_max,
+            "digital-min", dmin,
+            "digital-max", dmax,
+            "ns", ns,
+            NULL
+            );
+}
+
+void
+test_append_digital(EdfSignal* signal, gint value)
+{
+    GError* error = NULL;
+    edf_signal_append_digital(signal, value, &error);
+    g_assert_no_error(error);
+}
+
+void
+test_fill_signal(EdfSignal* signal, guint channel, guint64 num_samples, gint range)
+{
+    for (guint64 i = 0; i < num_samples; i++)
+        test_append_digital(signal, test_sample_value(channel, i, range));
+}
+
+EdfFile*
+test_create_file(gdouble record_duration, ...)
+{
+    EdfFile* file = edf_file_new();
+    EdfSignal* signal;
+    va_list args;
+
+    g_object_set(edf_file_header(file), "duration-of-record", record_duration, NULL);
+
+    va_start(args, record_duration);
+    while ((signal = va_arg(args, EdfSignal*)))
+        edf_file_add_signal(file, signal);
+    va_end(args);
+
+    return file;
+}
+
+void
+test_write_file(EdfFile* file, const gchar* path)
+{
+    GError* error = NULL;
+
+    edf_file_set_path(file, path);
+    edf_file_replace(file, &error);
+    g_assert_no_error(error);
+}
@@ -0,0 +1,53 @@
+
+#ifndef TEST_UTIL_H
+#define TEST_UTIL_H
+
+#include <gedf.h>
+
+/*
+ * Fixtures that the test suites share. Failures are asserted here, so the
+ * tests don't check for errors themselves.
+ */
+
+/*
+ * A deterministic but irregular digital value of a sample of a channel,
+ * it lies within [-range, range].
+ */
+gint
+test_sample_value(guint channel, guint64 sample, gint range);
+
+/*
+ * A signal with samples of sample_size bytes, 2 for edf and 3 for bdf, that
+ * spans the whole digital range of the sample size. Its physical dimension
+ * is uV.
+ */
+EdfSignal*
+test_create_signal(
+        const gchar    *label,
+        const gchar    *transducer,
+        guint           sample_size,
+        guint           ns,
+        gdouble         physical_min,
+        gdouble         physical_max
+        );
+
+/* Appends one digital value to signal */
+void
+test_append_digital(EdfSignal* signal, gint value);
+
+/* Appends test_sample_value(channel, i, range) for i in [0, num_samples) */
+void
+test_fill_signal(EdfSignal* signal, guint channel, guint64 num_samples, gint range);
+
+/*
+ * Creates a file with records of record_duration seconds that holds the
+ * NULL terminated list of signals, the signals may be filled afterwards.
+ */
+EdfFile*
+test_create_file(gdouble record_duration, ...) G_GNUC_NULL_TERMINATED;
+
+/* Writes file to path */
+void
+test_write_file(EdfFile* file, const gchar* path);
+
+#endif
@@ -0,0 +1,248 @@
+
+#include <gedf.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "test-util.h"
+
+/* ******** global constants ********* */
+
+#define NS              512
+#define NUM_RECORDS     10
+#define STATUS_BITS     0x100000
+
+typedef struct {
+    guint64 sample;
+    guint32 code;
+} trigger_info;
+
+// The trigger code changes to code at sample
+static const trigger_info triggers[] = {
+    {0,     7},
+    {100,   1},
+    {612,   0},
+    {1024,  3},
+    {1500,  2},
+    {4000,  1},
+    {4001,  0},
+    {5119,  1},
+};
+
+static gchar g_trig_dir[1024] = "";
+static gchar g_bdf_file[1024] = "";
+static gchar g_edf_file[1024] = "";
+
+/* ******* utility functions ************ */
+
+static guint32
+trigger_code(guint64 sample)
+{
+    guint32 code = 0;
+    for (gsize i = 0; i < G_N_ELEMENTS(triggers); i++) {
+        if (triggers[i].sample > sample)
+            break;
+        code = triggers[i].code;
+    }
+    return code;
+}
+
+static void
+write_file(const gchar* path, gboolean with_trigger)
+{
+    guint      sample_size = with_trigger ? 3 : 2;
+    EdfSignal *eeg = test_create_signal(
+            "Fp1", "active electrode", sample_size, NS, -262144.0, 262143.0
+            );
+    EdfSignal *status = NULL;
+    EdfFile   *file = test_create_file(1.0, eeg, NULL);
+
+    if (with_trigger) {
+        status = test_create_signal(
+                "Status", "Triggers and Status", sample_size, NS, -262144.0, 262143.0
+                );
+        edf_file_add_signal(file, status);
+    }
+
+    for (guint64 i = 0; i < NS * NUM_RECORDS; i++) {
+        test_append_digital(eeg, (gint)(i % 200) - 100);
+        if (status)
+            test_append_digital(status, trigger_code(i) | STATUS_BITS);
+    }
+    test_write_file(file, path);
+
+    g_object_unref(eeg);
+    g_clear_object(&status);
+    g_object_unref(file);
+}
+
+static void
+check_events(EdfTriggerIndex* index)
+{
+    GArray* events = edf_trigger_index_get_events(index);
+
+    g_assert_cmpuint(edf_trigger_index_get_num_events(index), ==,
+                     G_N_ELEMENTS(triggers));
+    g_assert_cmpuint(events->len, ==, G_N_ELEMENTS(triggers));
+    for (guint i = 0; i < events->len; i++) {
+        EdfTriggerEvent* event = &g_array_index(events, EdfTriggerEvent, i);
+        g_assert_cmpuint(event->sample, ==, triggers[i].sample);
+        g_assert_cmpuint(event->code, ==, triggers[i].code);
+    }
+    g_assert_cmpfloat(edf_trigger_index_get_sample_rate(index), ==, NS);
+}
+
+static int
+trigger_index_test_init(void)
+{
+    gchar template[1024] = "gedf_trigger_test_XXXXXX";
+    GError *error = NULL;
+    char *temp_dir = g_dir_make_tmp(template, &error);
+
+    if (error) {
+        g_printerr("Unable to open temp dir: %s\n", error->message);
+        g_error_free(error);
+        return -1;
+    }
+    g_snprintf(g_trig_dir, sizeof(g_trig_dir), "%s", temp_dir);
+    g_snprintf(g_bdf_file, sizeof(g_bdf_file), "%s/%s", temp_dir, "trigger.bdf");
+    g_snprintf(g_edf_file, sizeof(g_edf_file), "%s/%s", temp_dir, "no-trigger.edf");
+    g_free(temp_dir);
+
+    write_file(g_bdf_file, TRUE);
+    write_file(g_edf_file, FALSE);
+    return 0;
+}
+
+/* ******* tests ******** */
+
+static void
+trigger_index_scan(void)
+{
+    GError *error = NULL;
+    EdfTriggerIndex* index = edf_trigger_index_scan(g_bdf_file, &error);
+
+    g_assert_no_error(error);
+    check_events(index);
+
+    g_object_unref(index);
+}
+
+static void
+trigger_index_signal(void)
+{
+    GError  *error = NULL;
+    EdfFile *file = edf_file_new_for_path(g_bdf_file);
+
+    edf_file_read(file, &error);
+    g_assert_no_error(error);
+
+    GPtrArray* signals = edf_file_get_signals(file);
+    g_assert_cmpuint(signals->len, ==, 2);
+
+    EdfSignal* status = g_ptr_array_index(signals, 1);
+    g_assert_cmpuint(edf_signal_get_sample_size(status), ==, 3);
+
+    EdfTriggerIndex* index = edf_trigger_index_new_for_signal(status, 1.0);
+    check_events(index);
+
+    g_object_unref(index);
+    g_object_unref(file);
+}
+
+static void
+trigger_index_no_trigger(void)
+{
+    GError *error = NULL;
+    EdfTriggerIndex* index = edf_trigger_index_scan(g_edf_file, &error);
+
+    g_assert_null(index);
+    g_assert_error(
+            error,
+            EDF_TRIGGER_INDEX_ERROR,
+            EDF_TRIGGER_INDEX_ERROR_NO_TRIGGER_SIGNAL
+            );
+    g_error_free(error);
+}
+
+static void
+trigger_index_sidecar(void)
+{
+    GError *error = NULL;
+    gchar  *sidecar = edf_trigger_index_sidecar_path(g_bdf_file);
+
+    g_remove(sidecar);
+
+    EdfTriggerIndex* index = edf_trigger_index_new_for_path(g_bdf_file, &error);
+    g_assert_no_error(error);
+    check_events(index);
+    g_object_unref(index);
+
+    g_assert_true(g_file_test(sidecar, G_FILE_TEST_EXISTS));
+
+    index = edf_trigger_index_load(sidecar, g_bdf_file, &error);
+    g_assert_no_error(error);
+    check_events(index);
+    g_object_unref(index);
+
+    // a sidecar that isn't an index is rejected
+    g_file_set_contents(sidecar, "Not an index", -1, &error);
+    g_assert_no_error(error);
+    index = edf_trigger_index_load(sidecar, g_bdf_file, &error);
+    g_assert_null(index);
+    g_assert_error(error, EDF_TRIGGER_INDEX_ERROR, EDF_TRIGGER_INDEX_ERROR_SIDECAR);
+    g_clear_error(&error);
+
+    // and replaced by new_for_path
+    index = edf_trigger_index_new_for_path(g_bdf_file, &error);
+    g_assert_no_error(error);
+    check_events(index);
+    g_object_unref(index);
+
+    g_remove(sidecar);
+    g_free(sidecar);
+}
+
+static void
+trigger_index_lookup(void)
+{
+    GError *error = NULL;
+    EdfTriggerIndex* index = edf_trigger_index_scan(g_bdf_file, &error);
+    g_assert_no_error(error);
+
+    GArray* events = edf_trigger_index_lookup(index, 1, 0, G_MAXUINT64);
+    g_assert_cmpuint(events->len, ==, 3);
+    g_assert_cmpuint(g_array_index(events, EdfTriggerEvent, 0).sample, ==, 100);
+    g_assert_cmpuint(g_array_index(events, EdfTriggerEvent, 1).sample, ==, 4000);
+    g_assert_cmpuint(g_array_index(events, EdfTriggerEvent, 2).sample, ==, 5119);
+    g_array_unref(events);
+
+    // the end of the range is exclusive
+    events = edf_trigger_index_lookup(index, EDF_TRIGGER_ANY_CODE, 612, 1500);
+    g_assert_cmpuint(events->len, ==, 2);
+    g_assert_cmpuint(g_array_index(events, EdfTriggerEvent, 0).code, ==, 0);
+    g_assert_cmpuint(g_array_index(events, EdfTriggerEvent, 1).code, ==, 3);
+    g_array_unref(events);
+
+    // the second record contains the samples [512, 1024)
+    events = edf_trigger_index_lookup_time(index, EDF_TRIGGER_ANY_CODE, 1.0, 2.0);
+    g_assert_cmpuint(events->len, ==, 1);
+    g_assert_cmpuint(g_array_index(events, EdfTriggerEvent, 0).sample, ==, 612);
+    g_array_unref(events);
+
+    events = edf_trigger_index_lookup(index, 42, 0, G_MAXUINT64);
+    g_assert_cmpuint(events->len, ==, 0);
+    g_array_unref(events);
+
+    g_object_unref(index);
+}
+
+void add_trigger_index_suite(void)
+{
+    g_assert_true(trigger_index_test_init() == 0);
+
+    g_test_add_func("/EdfTriggerIndex/scan", trigger_index_scan);
+    g_test_add_func("/EdfTriggerIndex/signal", trigger_index_signal);
+    g_test_add_func("/EdfTriggerIndex/no_trigger", trigger_index_no_trigger);
+    g_test_add_func("/EdfTriggerIndex/sidecar", trigger_index_sidecar);
+    g_test_add_func("/EdfTriggerIndex/lookup", trigger_index_lookup);
+}
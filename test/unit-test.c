@@ -24,6 +24,20 @@ void add_suites()
     add_file_suite();
     add_header_suite();
     add_signal_suite();
+    add_trigger_index_suite();
+    add_epocher_suite();
+    add_codec_suite();
+    add_catalog_suite();
+    add_reader_suite();
+    add_montage_suite();
+    add_filter_suite();
+    add_resampler_suite();
+    add_stats_suite();
+    add_follower_suite();
+    add_record_queue_suite();
+    add_cursor_suite();
+    add_matrix_suite();
+    add_header_cache_suite();
 }
 
 int main(int argc, char** argv) {
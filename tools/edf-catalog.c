@@ -0,0 +1,161 @@
+
+#include <gedf.h>
+#include <gio/gio.h>
+#include <stdlib.h>
+
+/*
+ * edf-catalog maintains a catalogue of the headers of the edf/bdf files in
+ * a directory tree and answers which files have a given channel.
+ */
+
+/* ************ options ************ */
+
+static gint         opt_jobs = 0;
+static gchar       *opt_label = NULL;
+static gdouble      opt_min_rate = 0.0;
+static gboolean     opt_list = FALSE;
+
+static GOptionEntry entries[] = {
+    {"jobs", 'j', 0, G_OPTION_ARG_INT, &opt_jobs,
+        "The number of threads that parse headers, default one per processor", "N"},
+    {"label", 'l', 0, G_OPTION_ARG_STRING, &opt_label,
+        "Print the files that have a channel with this label", "LABEL"},
+    {"min-rate", 'r', 0, G_OPTION_ARG_DOUBLE, &opt_min_rate,
+        "The minimal sample rate of the channel of --label", "HZ"},
+    {"list", 0, 0, G_OPTION_ARG_NONE, &opt_list,
+        "Print every catalogued file", NULL},
+    {NULL}
+};
+
+static void
+print_entry(const EdfCatalogEntry* entry)
+{
+    GDateTime* start = g_date_time_new_from_unix_utc(entry->start_time);
+    gchar* time = start ? g_date_time_format(start, "%Y-%m-%d %H:%M:%S") : NULL;
+
+    gchar* duration = entry->duration < 0 ?
+            g_strdup("?") : g_strdup_printf("%.1f s", entry->duration);
+
+    g_print("%s\t%s\t%s\t%u channels\n",
+            entry->path,
+            time ? time : "?",
+            duration,
+            entry->num_channels
+            );
+
+    g_free(duration);
+    g_free(time);
+    if (start)
+        g_date_time_unref(start);
+}
+
+/*
+ * Loads the catalogue when it exists, a broken one is rebuilt.
+ */
+static EdfCatalog*
+open_catalog(const gchar* path, gboolean create)
+{
+    GError* error = NULL;
+    EdfCatalog* catalog = edf_catalog_load(path, &error);
+
+    if (catalog)
+        return catalog;
+
+    if (!create) {
+        g_printerr("edf-catalog: %s\n", error->message);
+        g_error_free(error);
+        return NULL;
+    }
+
+    if (!g_error_matches(error, G_FILE_ERROR, G_FILE_ERROR_NOENT))
+        g_printerr("edf-catalog: warning: %s, it is rebuilt\n", error->message);
+    g_error_free(error);
+    return edf_catalog_new();
+}
+
+static gboolean
+update_catalog(EdfCatalog* catalog, const gchar* path, const gchar* root)
+{
+    GError* error = NULL;
+    guint parsed, skipped, failed, num_entries;
+
+    g_object_set(catalog, "num-threads", (guint) MAX(opt_jobs, 0), NULL);
+
+    if (!edf_catalog_scan(catalog, root, &error) ||
+        !edf_catalog_save(catalog, path, &error)) {
+        g_printerr("edf-catalog: %s\n", error->message);
+        g_error_free(error);
+        return FALSE;
+    }
+
+    g_object_get(
+            catalog,
+            "num-entries", &num_entries,
+            "num-parsed", &parsed,
+            "num-skipped", &skipped,
+            "num-failed", &failed,
+            NULL
+            );
+    g_printerr("%u files catalogued: %u parsed, %u unchanged, %u invalid\n",
+               num_entries, parsed, skipped, failed
+               );
+    return TRUE;
+}
+
+int
+main(int argc, char** argv)
+{
+    GError* error = NULL;
+    EdfCatalog* catalog = NULL;
+    int status = EXIT_FAILURE;
+
+    GOptionContext* context = g_option_context_new("CATALOG [ROOT]");
+    g_option_context_set_summary(
+            context,
+            "Updates CATALOG with the headers of the edf/bdf files below ROOT.\n"
+            "Only new or modified files are parsed. Without ROOT the existing\n"
+            "CATALOG is queried."
+            );
+    g_option_context_add_main_entries(context, entries, NULL);
+
+    if (!g_option_context_parse(context, &argc, &argv, &error)) {
+        g_printerr("edf-catalog: %s\n", error->message);
+        g_error_free(error);
+        goto done;
+    }
+
+    if (argc < 2 || argc > 3) {
+        gchar* help = g_option_context_get_help(context, TRUE, NULL);
+        g_printerr("%s", help);
+        g_free(help);
+        goto done;
+    }
+
+    catalog = open_catalog(argv[1], argc == 3);
+    if (!catalog)
+        goto done;
+
+    if (argc == 3 && !update_catalog(catalog, argv[1], argv[2]))
+        goto done;
+
+    if (opt_list) {
+        for (guint i = 0; i < edf_catalog_get_num_entries(catalog); i++)
+            print_entry(edf_catalog_get_entry(catalog, i));
+    }
+
+    if (opt_label) {
+        GPtrArray* found = edf_catalog_find(catalog, opt_label, opt_min_rate);
+        for (guint i = 0; i < found->len; i++) {
+            const EdfCatalogEntry* entry = g_ptr_array_index(found, i);
+            g_print("%s\n", entry->path);
+        }
+        g_ptr_array_unref(found);
+    }
+
+    status = EXIT_SUCCESS;
+
+done:
+    g_clear_object(&catalog);
+    g_option_context_free(context);
+    return status;
+}
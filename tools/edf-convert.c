@@ -0,0 +1,607 @@
+
+#include <gedf.h>
+#include <gio/gio.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "edf-sample-priv.h"
+#include "edf-size-priv.h"
+
+/*
+ * edf-convert streams an edf or bdf file record by record into a new file.
+ * Only one record of the input and one of the output are in memory, so
+ * the size of the input doesn't matter.
+ */
+
+#define EDF_DIGITAL_MIN     (-32768)
+#define EDF_DIGITAL_MAX     32767
+
+// the offset of the number of records in the header
+#define NUM_RECORDS_OFFSET (        \
+    EDF_VERSION_SZ              +   \
+    EDF_LOCAL_PATIENT_SZ        +   \
+    EDF_LOCAL_RECORDING_SZ      +   \
+    EDF_START_DATE_SZ           +   \
+    EDF_START_TIME_SZ           +   \
+    EDF_NUM_BYTES_IN_HEADER_SZ  +   \
+    EDF_RESERVED_SZ                 \
+)
+
+/* ************ options ************ */
+
+static gchar       *opt_channels = NULL;
+static gdouble      opt_start = 0.0;
+static gdouble      opt_duration = -1.0;
+static gboolean     opt_to_edf = FALSE;
+static gchar       *opt_range = NULL;
+static gchar       *opt_patient = NULL;
+static gchar       *opt_recording = NULL;
+static gchar       *opt_reserved = NULL;
+static gboolean     opt_force = FALSE;
+static gboolean     opt_quiet = FALSE;
+
+static GOptionEntry entries[] = {
+    {"channels", 'c', 0, G_OPTION_ARG_STRING, &opt_channels,
+        "Comma separated labels of the channels to keep", "LABELS"},
+    {"start", 's', 0, G_OPTION_ARG_DOUBLE, &opt_start,
+        "Skip the records before SECONDS", "SECONDS"},
+    {"duration", 'd', 0, G_OPTION_ARG_DOUBLE, &opt_duration,
+        "Keep the records that start within SECONDS", "SECONDS"},
+    {"to-edf", 'e', 0, G_OPTION_ARG_NONE, &opt_to_edf,
+        "Requantize 24 bit channels to 16 bit", NULL},
+    {"physical-range", 'r', 0, G_OPTION_ARG_STRING, &opt_range,
+        "The physical range of requantized channels, default the original range",
+        "MIN:MAX"},
+    {"patient", 0, 0, G_OPTION_ARG_STRING, &opt_patient,
+        "Replace the patient identification", "TEXT"},
+    {"recording", 0, 0, G_OPTION_ARG_STRING, &opt_recording,
+        "Replace the recording identification", "TEXT"},
+    {"reserved", 0, 0, G_OPTION_ARG_STRING, &opt_reserved,
+        "Replace the reserved field of the header", "TEXT"},
+    {"force", 'f', 0, G_OPTION_ARG_NONE, &opt_force,
+        "Replace the output when it exists", NULL},
+    {"quiet", 'q', 0, G_OPTION_ARG_NONE, &opt_quiet,
+        "Don't print statistics", NULL},
+    {NULL}
+};
+
+/* ************ conversion ************ */
+
+/* One channel of the output */
+typedef struct {
+    EdfSignal  *signal;         // the input signal
+    gsize       in_offset;      // offset in the input record
+    guint       in_size;
+    gsize       out_offset;     // offset in the output record
+    guint       out_size;
+    guint       ns;
+
+    gboolean    requantize;
+    gdouble     scale;          // out = in * scale + shift
+    gdouble     shift;
+    guint64     clipped_low;
+    guint64     clipped_high;
+} Channel;
+
+typedef struct {
+    GInputStream   *istream;
+    EdfHeader      *in_header;
+    gsize           in_record_size;
+
+    GOutputStream  *ostream;
+    EdfHeader      *out_header;
+    gsize           out_record_size;
+
+    Channel        *channels;
+    guint           num_channels;
+
+    guint64         first_record;
+    gint64          num_records;    // -1 until the end of the input
+    gint64          declared;       // the number in the output header
+} Converter;
+
+static void
+converter_clear(Converter* conv)
+{
+    g_clear_object(&conv->istream);
+    g_clear_object(&conv->ostream);
+    g_clear_object(&conv->in_header);
+    g_clear_object(&conv->out_header);
+    g_clear_pointer(&conv->channels, g_free);
+}
+
+static gboolean
+parse_range(gdouble* min, gdouble* max, GError** error)
+{
+    gchar** parts = g_strsplit(opt_range, ":", 2);
+    gchar* end1 = NULL, *end2 = NULL;
+    gboolean result = FALSE;
+
+    if (g_strv_length(parts) == 2) {
+        *min = g_ascii_strtod(parts[0], &end1);
+        *max = g_ascii_strtod(parts[1], &end2);
+        result = end1 != parts[0] && *end1 == '\0' &&
+                 end2 != parts[1] && *end2 == '\0' &&
+                 *min < *max;
+    }
+    g_strfreev(parts);
+
+    if (!result)
+        g_set_error(
+                error,
+                G_OPTION_ERROR,
+                G_OPTION_ERROR_BAD_VALUE,
+                "Invalid physical range '%s', expected MIN:MAX with MIN < MAX",
+                opt_range
+                );
+    return result;
+}
+
+static gboolean
+open_input(Converter* conv, const gchar* path, GError** error)
+{
+    GFile* file = g_file_new_for_path(path);
+    conv->istream = edf_file_open_input_stream(file, error);
+    g_object_unref(file);
+    if (!conv->istream)
+        return FALSE;
+
+    GPtrArray* signals = g_ptr_array_new_full(0, g_object_unref);
+    conv->in_header = edf_header_new();
+    edf_header_set_signals(conv->in_header, signals);
+    g_ptr_array_unref(signals);
+
+    edf_header_read_from_input_stream(conv->in_header, conv->istream, error);
+    return *error == NULL;
+}
+
+static void
+add_channel(Converter* conv, EdfSignal* signal, gsize in_offset)
+{
+    Channel* channel = &conv->channels[conv->num_channels++];
+
+    channel->signal = signal;
+    channel->in_offset = in_offset;
+    channel->in_size = edf_signal_get_sample_size(signal);
+    channel->ns = edf_signal_get_num_samples_per_record(signal);
+}
+
+/*
+ * Selects the channels of the output in the order of --channels.
+ */
+static gboolean
+select_channels(Converter* conv, GError** error)
+{
+    GPtrArray* signals = edf_header_get_signals(conv->in_header);
+    gsize* offsets = g_new(gsize, signals->len);
+
+    conv->in_record_size = 0;
+    for (guint i = 0; i < signals->len; i++) {
+        EdfSignal* signal = g_ptr_array_index(signals, i);
+        offsets[i] = conv->in_record_size;
+        conv->in_record_size += (gsize) edf_signal_get_num_samples_per_record(signal) *
+                                edf_signal_get_sample_size(signal);
+    }
+
+    if (!opt_channels) {
+        conv->channels = g_new0(Channel, signals->len);
+        for (guint i = 0; i < signals->len; i++)
+            add_channel(conv, g_ptr_array_index(signals, i), offsets[i]);
+        g_free(offsets);
+        return TRUE;
+    }
+
+    gchar** labels = g_strsplit(opt_channels, ",", -1);
+    conv->channels = g_new0(Channel, g_strv_length(labels));
+
+    for (gchar** label = labels; *label; label++) {
+        guint i;
+        g_strstrip(*label);
+        for (i = 0; i < signals->len; i++) {
+            EdfSignal* signal = g_ptr_array_index(signals, i);
+            if (g_strcmp0(edf_signal_get_label(signal), *label) == 0)
+                break;
+        }
+        if (i == signals->len) {
+            g_set_error(
+                    error,
+                    G_OPTION_ERROR,
+                    G_OPTION_ERROR_BAD_VALUE,
+                    "The input has no channel '%s'",
+                    *label
+                    );
+            break;
+        }
+        add_channel(conv, g_ptr_array_index(signals, i), offsets[i]);
+    }
+
+    g_strfreev(labels);
+    g_free(offsets);
+
+    if (*error)
+        return FALSE;
+
+    if (conv->num_channels == 0) {
+        g_set_error(
+                error,
+                G_OPTION_ERROR,
+                G_OPTION_ERROR_BAD_VALUE,
+                "No channels selected"
+                );
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static EdfSignal*
+create_output_signal(Channel* channel, gboolean have_range, gdouble pmin, gdouble pmax)
+{
+    EdfSignal* in = channel->signal;
+    gdouble phys_min = edf_signal_get_physical_min(in);
+    gdouble phys_max = edf_signal_get_physical_max(in);
+    gint dig_min = edf_signal_get_digital_min(in);
+    gint dig_max = edf_signal_get_digital_max(in);
+
+    channel->out_size = channel->in_size;
+    channel->requantize = opt_to_edf && channel->in_size == BDF_SAMPLE_SIZE;
+
+    if (channel->requantize) {
+        if (have_range) {
+            phys_min = pmin;
+            phys_max = pmax;
+        }
+        channel->out_size = EDF_SAMPLE_SIZE;
+        dig_min = EDF_DIGITAL_MIN;
+        dig_max = EDF_DIGITAL_MAX;
+
+        // physical = gain * digital + offset for both the in- and output
+        gdouble gain = (phys_max - phys_min) / (dig_max - dig_min);
+        gdouble offset = phys_min - gain * dig_min;
+        channel->scale = edf_signal_get_gain(in) / gain;
+        channel->shift = (edf_signal_get_offset(in) - offset) / gain;
+    }
+
+    return g_object_new(
+            EDF_TYPE_SIGNAL,
+            "sample-size", channel->out_size,
+            "label", edf_signal_get_label(in),
+            "transducer", edf_signal_get_transducer(in),
+            "physical-dimension", edf_signal_get_physical_dimension(in),
+            "physical-min", phys_min,
+            "physical-max", phys_max,
+            "digital-min", dig_min,
+            "digital-max", dig_max,
+            "prefilter", edf_signal_get_prefiltering(in),
+            "reserved", edf_signal_get_reserved(in),
+            "ns", channel->ns,
+            NULL
+            );
+}
+
+/*
+ * Whether --to-edf turned a bdf into an edf, every output channel has 16 bit
+ * samples and at least one of them was requantized.
+ */
+static gboolean
+is_requantized_to_edf(Converter* conv)
+{
+    gboolean requantized = FALSE;
+
+    for (guint i = 0; i < conv->num_channels; i++) {
+        if (conv->channels[i].out_size != EDF_SAMPLE_SIZE)
+            return FALSE;
+        requantized |= conv->channels[i].requantize;
+    }
+    return requantized;
+}
+
+static gboolean
+create_output_header(Converter* conv, GError** error)
+{
+    gdouble pmin = 0, pmax = 0;
+    gdouble duration = edf_header_get_record_duration(conv->in_header);
+    const gchar* reserved = edf_header_get_reserved(conv->in_header);
+    gint64 declared;
+
+    if (opt_range && !parse_range(&pmin, &pmax, error))
+        return FALSE;
+
+    GPtrArray* signals = g_ptr_array_new_full(conv->num_channels, g_object_unref);
+    conv->out_record_size = 0;
+    for (guint i = 0; i < conv->num_channels; i++) {
+        Channel* channel = &conv->channels[i];
+        g_ptr_array_add(
+                signals, create_output_signal(channel, opt_range != NULL, pmin, pmax)
+                );
+        channel->out_offset = conv->out_record_size;
+        conv->out_record_size += (gsize) channel->ns * channel->out_size;
+    }
+
+    // Crop at record boundaries
+    if (duration > 0) {
+        conv->first_record = (guint64) floor(opt_start / duration + 1e-9);
+        if (opt_duration >= 0)
+            conv->num_records = (gint64) ceil(opt_duration / duration - 1e-9);
+    }
+
+    g_object_get(conv->in_header, "num-data-records", &declared, NULL);
+    if (declared >= 0) {
+        gint64 available = MAX(declared - (gint64) conv->first_record, 0);
+        if (conv->num_records < 0 || conv->num_records > available)
+            conv->num_records = available;
+    }
+    conv->declared = conv->num_records >= 0 &&
+                     conv->num_records <= EDF_MAX_NUM_RECORDS ? conv->num_records : -1;
+
+    // The reserved field of a bdf, e.g. "24BIT", doesn't hold for an edf
+    if (opt_reserved)
+        reserved = opt_reserved;
+    else if (is_requantized_to_edf(conv))
+        reserved = "";
+
+    GDateTime* start = edf_header_get_time(conv->in_header);
+    GDateTime* out_start = g_date_time_add_seconds(
+            start, conv->first_record * duration
+            );
+
+    conv->out_header = edf_header_new();
+    edf_header_set_signals(conv->out_header, signals);
+    g_ptr_array_unref(signals);
+
+    g_object_set(
+            conv->out_header,
+            "patient-identification", opt_patient ? opt_patient :
+                edf_header_get_patient(conv->in_header),
+            "recording-identification", opt_recording ? opt_recording :
+                edf_header_get_recording(conv->in_header),
+            "reserved", reserved,
+            "date-time", out_start,
+            "duration-of-record", duration,
+            NULL
+            );
+    edf_header_set_expected_num_records(conv->out_header, conv->declared);
+    g_date_time_unref(out_start);
+    g_date_time_unref(start);
+    return TRUE;
+}
+
+static gboolean
+skip_records(Converter* conv, GError** error)
+{
+    guint64 remaining = conv->first_record * conv->in_record_size;
+
+    while (remaining > 0) {
+        gssize n = g_input_stream_skip(
+                conv->istream, MIN(remaining, G_MAXSSIZE), NULL, error
+                );
+        if (n < 0)
+            return FALSE;
+        if (n == 0)
+            break;
+        remaining -= n;
+    }
+    return TRUE;
+}
+
+static void
+convert_channel(Channel* channel, const guint8* in, guint8* out, gint32* samples)
+{
+    const guint8* src = &in[channel->in_offset];
+    guint8* dest = &out[channel->out_offset];
+
+    if (!channel->requantize) {
+        memcpy(dest, src, (gsize) channel->ns * channel->in_size);
+        return;
+    }
+
+    edf_samples_decode(src, channel->in_size, channel->ns, samples);
+    for (guint i = 0; i < channel->ns; i++) {
+        gdouble value = floor(samples[i] * channel->scale + channel->shift + 0.5);
+        if (value < EDF_DIGITAL_MIN) {
+            value = EDF_DIGITAL_MIN;
+            channel->clipped_low++;
+        }
+        else if (value > EDF_DIGITAL_MAX) {
+            value = EDF_DIGITAL_MAX;
+            channel->clipped_high++;
+        }
+        samples[i] = (gint32) value;
+    }
+    edf_samples_encode(dest, channel->out_size, channel->ns, samples);
+}
+
+/*
+ * Rewrites the number of records in the header of a seekable output.
+ */
+static gboolean
+patch_num_records(Converter* conv, guint64 written, GError** error)
+{
+    gchar field[EDF_NUM_DATA_REC_SZ + 1];
+
+    if (!G_IS_SEEKABLE(conv->ostream) ||
+        !g_seekable_can_seek(G_SEEKABLE(conv->ostream)) ||
+        written > EDF_MAX_NUM_RECORDS) {
+        g_printerr(
+                "edf-convert: warning: the header states %" G_GINT64_FORMAT " records, "
+                "%" G_GUINT64_FORMAT " were written\n",
+                conv->declared,
+                written
+                );
+        return TRUE;
+    }
+
+    g_snprintf(field, sizeof(field), "%-8" G_GUINT64_FORMAT, written);
+    return g_seekable_seek(
+                G_SEEKABLE(conv->ostream), NUM_RECORDS_OFFSET, G_SEEK_SET, NULL, error
+                ) &&
+           g_output_stream_write_all(
+                conv->ostream, field, EDF_NUM_DATA_REC_SZ, NULL, NULL, error
+                );
+}
+
+static gboolean
+convert(Converter* conv, const gchar* out_path, guint64* written, GError** error)
+{
+    GFile* file = g_file_new_for_path(out_path);
+    guint8* in = NULL, *out = NULL;
+    gint32* samples = NULL;
+    guint max_ns = 0;
+    gboolean result = FALSE;
+
+    conv->ostream = edf_file_open_output_stream(file, opt_force, error);
+    g_object_unref(file);
+    if (!conv->ostream)
+        return FALSE;
+
+    edf_header_write_to_ostream(conv->out_header, conv->ostream, error);
+    if (*error)
+        goto close;
+
+    if (!skip_records(conv, error))
+        goto close;
+
+    for (guint i = 0; i < conv->num_channels; i++)
+        max_ns = MAX(max_ns, conv->channels[i].ns);
+
+    in = g_malloc(conv->in_record_size);
+    out = g_malloc(conv->out_record_size);
+    samples = g_new(gint32, max_ns);
+
+    *written = 0;
+    while (conv->num_records < 0 || *written < (guint64) conv->num_records) {
+        gsize nread = 0;
+        if (!g_input_stream_read_all(
+                    conv->istream, in, conv->in_record_size, &nread, NULL, error
+                    )
+           )
+            break;
+        if (nread < conv->in_record_size) {
+            if (nread > 0)
+                g_printerr(
+                        "edf-convert: warning: the input ends with an incomplete "
+                        "record of %" G_GSIZE_FORMAT " bytes, it is dropped\n",
+                        nread
+                        );
+            break;
+        }
+
+        for (guint i = 0; i < conv->num_channels; i++)
+            convert_channel(&conv->channels[i], in, out, samples);
+
+        if (!g_output_stream_write_all(
+                    conv->ostream, out, conv->out_record_size, NULL, NULL, error
+                    )
+           )
+            break;
+        (*written)++;
+    }
+
+    g_free(in);
+    g_free(out);
+    g_free(samples);
+
+    if (*error)
+        goto close;
+
+    if ((gint64) *written != conv->declared && !patch_num_records(conv, *written, error))
+        goto close;
+
+    result = TRUE;
+
+close:
+    // Closing flushes a compressor, so it may fail as well.
+    if (result)
+        result = g_output_stream_close(conv->ostream, NULL, error);
+    else
+        g_output_stream_close(conv->ostream, NULL, NULL);
+    return result;
+}
+
+static void
+print_statistics(Converter* conv, guint64 written)
+{
+    gdouble duration = edf_header_get_record_duration(conv->out_header);
+
+    g_print("%" G_GUINT64_FORMAT " records (%.3f s) of %u channels written\n",
+            written,
+            written * duration,
+            conv->num_channels
+            );
+
+    for (guint i = 0; i < conv->num_channels; i++) {
+        Channel* channel = &conv->channels[i];
+        if (!channel->requantize)
+            continue;
+
+        guint64 total = written * channel->ns;
+        guint64 clipped = channel->clipped_low + channel->clipped_high;
+        g_print("%-16s clipped %" G_GUINT64_FORMAT " low, %" G_GUINT64_FORMAT
+                " high (%.4f%%)\n",
+                edf_signal_get_label(channel->signal),
+                channel->clipped_low,
+                channel->clipped_high,
+                total ? 100.0 * clipped / total : 0.0
+                );
+    }
+}
+
+int
+main(int argc, char** argv)
+{
+    GError* error = NULL;
+    Converter conv = {0,};
+    guint64 written = 0;
+    int status = EXIT_FAILURE;
+
+    conv.num_records = -1;
+
+    GOptionContext* context = g_option_context_new("INPUT OUTPUT");
+    g_option_context_set_summary(
+            context,
+            "Streams an edf or bdf file into a new one, optionally with a\n"
+            "subset of the channels, a part of the records, 16 bit samples\n"
+            "or a modified header. Files ending in .gz, .edfz or .bdfz are\n"
+            "written compressed."
+            );
+    g_option_context_add_main_entries(context, entries, NULL);
+
+    if (!g_option_context_parse(context, &argc, &argv, &error))
+        goto done;
+
+    if (argc != 3) {
+        gchar* help = g_option_context_get_help(context, TRUE, NULL);
+        g_printerr("%s", help);
+        g_free(help);
+        goto done;
+    }
+
+    if (opt_start < 0) {
+        g_set_error(
+                &error,
+                G_OPTION_ERROR,
+                G_OPTION_ERROR_BAD_VALUE,
+                "The start must not be negative"
+                );
+        goto done;
+    }
+
+    if (!open_input(&conv, argv[1], &error) ||
+        !select_channels(&conv, &error) ||
+        !create_output_header(&conv, &error) ||
+        !convert(&conv, argv[2], &written, &error))
+        goto done;
+
+    if (!opt_quiet)
+        print_statistics(&conv, written);
+    status = EXIT_SUCCESS;
+
+done:
+    if (error) {
+        g_printerr("edf-convert: %s\n", error->message);
+        g_error_free(error);
+    }
+    converter_clear(&conv);
+    g_option_context_free(context);
+    return status;
+}